@@ -6,12 +6,35 @@
  * 游戏包含完整的游戏逻辑、控制台图形界面和用户输入处理。
  *
  * 功能特性:
- * - 20x20游戏区域，带墙壁边界
+ * - 20x20游戏区域，带墙壁边界（穿墙规则下为没有边框、四边相连的环面）
+ * - 大游戏区域只显示跟随蛇头的视口，Z键缩小为每个字符显示8×8个单元格
  * - 支持WASD和方向键控制
- * - 增量渲染，消除闪烁
+ * - 增量渲染，消除闪烁；字形和颜色预先查表，支持虚拟终端时每帧只写一次控制台
  * - 游戏速度随得分增加
  * - 支持游戏重玩功能
  * - UTF-8编码，支持中文显示
+ * - 内存区域（Arena）分配，游戏循环中零堆分配
+ * - 无界面快进模式（--headless），用于吞吐量测试和批量回归检查
+ *
+ * 命令行参数:
+ *   --headless      不使用控制台界面、不休眠，连续运行若干局后输出统计信息
+ *   --ticks N       每局最多运行N帧（仅无界面模式，默认100000）
+ *   --seed S        随机数种子（第i局使用S + i），默认使用当前时间
+ *   --ai NAME       由自动策略控制蛇（random|greedy|mcts|nn），无界面模式默认greedy
+ *   --board WxH     游戏区域尺寸（控制台界面下超过视口时视口跟随蛇头滚动）
+ *   --games N       运行局数（仅无界面模式，默认1）
+ *   --load FILE     从存档继续（游戏区域尺寸由存档决定）
+ *   --rollouts N    MCTS每步的推演次数（默认按每帧时间预算）
+ *   --weights FILE  神经网络策略的权重文件（默认使用内置权重，见snake_nn.h）
+ *   --rules FILE    从规则文件加载游戏规则（穿墙、食物个数、障碍物、增长节数、速度曲线，见snake_rules.h）
+ *   --fast-start    快速启动：不调整控制台窗口和缓冲区、跳过开始界面，直接开局
+ *   --latency N     按键延迟测量：注入线程模拟N次按键，结束后输出按键到显示的延迟直方图和测量期间的每帧时长
+ *                   （按规则的速度曲线运行；测量最快速度时用初始速度等于最快速度的规则文件）
+ *
+ * 启动时记录各阶段用时（进程加载、参数、上下文、控制台、首帧），无界面模式输出在统计信息中，
+ * 控制台界面显示在右侧信息区域。
+ *
+ * 游戏逻辑位于与平台无关的snake_core.c，本文件只负责控制台界面和输入。
  *
  * 编码: UTF-8
  * 平台: Windows
@@ -20,25 +43,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <assert.h>
 #include <time.h>
 #include <conio.h>
 #include <windows.h>
-#include <locale.h>
 #include <wchar.h>
 #include <stdarg.h>
+#include <string.h>
+
+#include "snake_core.h"
+#include "snake_ai.h"
+#include "snake_render.h"
+#include "snake_mcts.h"
+#include "snake_nn.h"
+#include "snake_save.h"
+#include "snake_rules.h"
 
 // =============================================
 // 常量定义
 // =============================================
 
-// 游戏区域尺寸（内部可玩区域，不包含边框）
-#define GAME_WIDTH 20  ///< 游戏区域宽度（单元格数）
-#define GAME_HEIGHT 20 ///< 游戏区域高度（单元格数）
-
-// 游戏池尺寸（包括边框）
-#define POOL_WIDTH (GAME_WIDTH + 2)   ///< 游戏池宽度 = 游戏宽度 + 左右边框
-#define POOL_HEIGHT (GAME_HEIGHT + 2) ///< 游戏池高度 = 游戏高度 + 上下边框
-
 // 控制台显示常量
 #define CONSOLE_WIDTH 80  ///< 控制台缓冲区宽度（字符数）
 #define CONSOLE_HEIGHT 30 ///< 控制台缓冲区高度（行数）
@@ -47,98 +71,141 @@
 #define GAME_AREA_X 8 ///< 游戏区域起始X坐标（控制台列数）
 #define GAME_AREA_Y 4 ///< 游戏区域起始Y坐标（控制台行数）
 
+// 视口尺寸：游戏区域在控制台中占用的格数（恰好容纳默认的20x20游戏区域和边框）
+#define VIEW_WIDTH POOL_WIDTH   ///< 视口宽度（格数）
+#define VIEW_HEIGHT POOL_HEIGHT ///< 视口高度（格数）
+
 // 游戏标题
 #define GAME_TITLE L"贪吃蛇游戏 - 文字版" ///< 游戏标题（宽字符字符串）
 #define GAME_TITLE_LENGTH 10              ///< 标题字符数（用于居中计算）
 
+// 帧缓冲容量：足够容纳整个控制台缓冲区的全部单元格
+#define FRAME_CAPACITY (CONSOLE_WIDTH * CONSOLE_HEIGHT * FRAME_BYTES_PER_CELL)
+
+// 旧版Windows SDK没有定义虚拟终端模式标志
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
 /**
- * @enum Direction
- * @brief 蛇的移动方向枚举
- *
- * 定义蛇在游戏网格中可能移动的四个基本方向。
+ * @struct UiText
+ * @brief 界面文字（同时保存UTF-16和UTF-8编码，长度在编译时确定）
  */
-typedef enum
+typedef struct
 {
-    DIR_UP,   ///< 向上移动
-    DIR_DOWN, ///< 向下移动
-    DIR_LEFT, ///< 向左移动
-    DIR_RIGHT ///< 向右移动
-} Direction;
+    const uint16_t *utf16; ///< UTF-16编码（WriteConsoleW）
+    int utf16_length;      ///< UTF-16单元数
+    const char *utf8;      ///< UTF-8编码（虚拟终端）
+    int utf8_length;       ///< UTF-8字节数
+} UiText;
+
+/// 由字符串字面量生成UiText
+#define UI_TEXT(s) {u##s, (int)(sizeof(u##s) / sizeof(uint16_t)) - 1, u8##s, (int)sizeof(u8##s) - 1}
+
+static const UiText TEXT_SCORE = UI_TEXT("得分: ");          ///< 得分标签
+static const UiText TEXT_SPEED = UI_TEXT("速度: ");          ///< 速度标签
+static const UiText TEXT_MS = UI_TEXT("ms");               ///< 速度单位
+static const UiText TEXT_HIGHEST_SCORE = UI_TEXT("最高分: "); ///< 最高分标签
+static const UiText TEXT_PAUSED = UI_TEXT("状态: 暂停  ");     ///< 暂停状态
+static const UiText TEXT_RUNNING = UI_TEXT("状态: 进行中");     ///< 进行中状态
+
+// 无界面模式默认值
+#define HEADLESS_DEFAULT_TICKS 100000 ///< 每局最大帧数（防止策略绕圈导致一局永不结束）
+#define HEADLESS_DEFAULT_GAMES 1      ///< 默认局数
+#define SAVE_FILE_NAME "snake_save.dat" ///< 游戏中按K键保存的存档文件
+
+// 按键延迟测量常量
+#define LATENCY_MAX_KEYS 4096  ///< 最多测量的按键数
+#define LATENCY_MIN_GAP_MS 45  ///< 注入按键的最短间隔（毫秒）
+#define LATENCY_MAX_GAP_MS 200 ///< 注入按键的最长间隔（毫秒），间隔随机，按键到达时刻与帧边界无关
+#define LATENCY_DRAIN_MS 500   ///< 最后一次按键后等待多久注入退出键（毫秒）
+#define LATENCY_BUCKET_MS 2    ///< 直方图每桶宽度（毫秒）
+#define LATENCY_BUCKETS 64     ///< 直方图桶数（最后一桶包含所有更长的延迟）
+#define LATENCY_BAR_WIDTH 40   ///< 直方图最长条形的字符数
 
 /**
- * @enum CellType
- * @brief 游戏池单元格类型枚举
- *
- * 定义游戏网格中每个单元格可能的状态类型，用于渲染和碰撞检测。
- * 使用特殊十六进制值便于调试识别。
+ * @struct LaunchOptions
+ * @brief 命令行参数
  */
-typedef enum
+typedef struct
 {
-    CELL_EMPTY = -0x66,         ///< 空单元格（可通行区域）
-    CELL_FOOD = 0xcc,           ///< 食物（蛇的目标）
-    CELL_SNAKE_HEAD = 0xff,     ///< 蛇头（蛇的头部，控制移动方向）
-    CELL_SNAKE_BODY_UP = 0x0,   ///< 蛇身（向上移动方向）
-    CELL_SNAKE_BODY_DOWN,       ///< 蛇身（向下移动方向）
-    CELL_SNAKE_BODY_LEFT,       ///< 蛇身（向左移动方向）
-    CELL_SNAKE_BODY_RIGHT,      ///< 蛇身（向右移动方向）
-    CELL_SNAKE_TAIL = 0x66ccff, ///< 蛇尾（蛇的尾部，最后一段）
-    CELL_WALL = 0x325           ///< 墙壁（不可通行的边界）
-} CellType;
+    bool headless;       ///< 无界面快进模式
+    long long ticks;     ///< 每局最大帧数（仅无界面模式）
+    uint64_t seed;       ///< 随机数种子
+    bool seed_given;     ///< 是否指定了种子（否则使用当前时间）
+    AiPolicy ai;         ///< 自动策略（NULL表示由键盘控制）
+    const char *ai_name; ///< 自动策略名称
+    int board_width;     ///< 游戏区域宽度
+    int board_height;    ///< 游戏区域高度
+    int games;           ///< 运行局数（仅无界面模式）
+    const char *load;    ///< 存档文件（NULL表示从新局开始）
+    int rollouts;        ///< MCTS每步的推演次数（0表示按每帧时间预算）
+    const char *weights; ///< 神经网络策略的权重文件（NULL表示内置权重）
+    Ruleset rules;       ///< 游戏规则（未指定--rules时为默认规则）
+    bool fast_start;     ///< 快速启动（不调整控制台尺寸、跳过开始界面）
+    int latency_keys;    ///< 按键延迟测量模式注入的按键数（0表示不测量）
+} LaunchOptions;
 
 /**
- * @struct Position
- * @brief 二维坐标位置结构体
- *
- * 表示游戏池或控制台中的坐标位置，用于定位单元格和渲染位置。
+ * @enum StartupPhase
+ * @brief 启动阶段（按发生顺序）
  */
-typedef struct
+typedef enum
 {
-    int x; ///< X坐标（水平方向）
-    int y; ///< Y坐标（垂直方向）
-} Position;
+    STARTUP_LOADER = 0,  ///< 进程创建 → 进入main（加载器和C运行库初始化）
+    STARTUP_OPTIONS,     ///< 解析命令行参数、读取规则文件和存档头
+    STARTUP_CONTEXT,     ///< 申请内存区域、应用规则
+    STARTUP_CONSOLE,     ///< 控制台设置（无界面模式没有这一阶段）
+    STARTUP_FIRST_FRAME, ///< 开局并画出第一帧（无界面模式：算完第一帧）
+    STARTUP_PHASE_COUNT  ///< 阶段数
+} StartupPhase;
 
 /**
- * @struct Snake
- * @brief 蛇状态结构体
- *
- * 简化的蛇状态管理，只存储头尾位置和方向信息，基于游戏池单元格跟踪身体连接。
- * 使用输入缓冲机制防止蛇连续反向移动。
+ * @struct KeyTiming
+ * @brief 一次按键的时间戳（QueryPerformanceCounter计数）
  */
 typedef struct
 {
-    Position head;            ///< 蛇头位置（当前头部坐标）
-    Position tail;            ///< 蛇尾位置（当前尾部坐标）
-    int length;               ///< 蛇的长度（包括头、身、尾）
-    Direction direction;      ///< 当前移动方向（正在执行的方向）
-    Direction next_direction; ///< 下一个方向（用于输入缓冲，防止连续转向）
-    Direction tail_direction; ///< 蛇尾移动方向（用于更新蛇尾位置）
-} Snake;
+    LONGLONG injected;   ///< 注入线程写入输入队列
+    LONGLONG read;       ///< handle_input读到按键
+    LONGLONG applied;    ///< 应用转向的update_game结束
+    LONGLONG displayed;  ///< 转向后的蛇头写到控制台（draw_game返回）
+    Direction direction; ///< 按键对应的方向
+    int speed;           ///< 应用时的速度（之后Sleep的每帧毫秒数）
+} KeyTiming;
 
 /**
- * @struct GameState
- * @brief 游戏全局状态结构体
+ * @struct LatencyProbe
+ * @brief 按键延迟测量
  *
- * 包含游戏运行所需的所有状态信息，作为游戏的主数据结构。
+ * 注入线程按顺序写入按键，主线程按同样的顺序读到，第k个读到的按键就是第k个注入的按键。
+ * 一帧之内读到多个按键时只有最后一个生效，之前的记为被覆盖；
+ * 被turn_snake拒绝（反方向）或应用时没有改变方向的记为拒绝；应用之前游戏结束的记为丢失。
  */
 typedef struct
 {
-    Snake snake;       ///< 蛇的状态（位置、长度、方向等）
-    Position food;     ///< 食物位置
-    int score;         ///< 当前得分
-    bool game_over;    ///< 游戏结束标志（true表示游戏结束）
-    bool paused;       ///< 游戏暂停标志（true表示游戏暂停）
-    int speed;         ///< 游戏速度（毫秒，控制蛇移动的延迟时间）
-    int highest_score; ///< 最高得分（历史最高分）
-} GameState;
+    KeyTiming keys[LATENCY_MAX_KEYS]; ///< 各按键的时间戳（下标为注入顺序）
+    volatile LONG injected;           ///< 已注入的按键数（注入线程递增）
+    int read;                         ///< 已读到的按键数
+    int awaiting_tick;                ///< 等待update_game应用的按键（-1表示没有）
+    int awaiting_display;             ///< 等待画出的按键（-1表示没有）
+    int measured;                     ///< 完成测量的按键数
+    int rejected;                     ///< 被拒绝的按键数
+    int superseded;                   ///< 被同一帧内后来的按键覆盖的按键数
+    int lost;                         ///< 应用之前游戏结束的按键数
+    uint64_t seed;                    ///< 注入间隔的随机数种子
+} LatencyProbe;
+
+static const char *const STARTUP_PHASE_NAMES[STARTUP_PHASE_COUNT] = {"加载", "参数", "上下文", "控制台", "首帧"}; ///< 阶段名称
 
 // =============================================
 // 全局变量
 // =============================================
 
 static HANDLE hConsole = NULL;                 ///< Windows控制台句柄，用于所有控制台输出操作
-static CellType pool[POOL_HEIGHT][POOL_WIDTH]; ///< 游戏池二维数组，存储每个单元格的当前状态
-static bool dirty[POOL_HEIGHT][POOL_WIDTH];    ///< 脏标记数组，标记需要重新绘制的单元格（增量渲染）
-static GameState game;                         ///< 游戏状态实例，包含蛇、食物、分数等所有游戏数据
+static HANDLE hInput = NULL;                   ///< 控制台输入句柄，空闲时在其上阻塞等待按键
+static GameContext context;                    ///< 游戏上下文实例，包含游戏状态、游戏池和内存区域
+static LaunchOptions options;                  ///< 命令行参数
 static int console_width = CONSOLE_WIDTH / 2;  ///< 实际控制台宽度（字符数，考虑宽字符显示）
 static int console_height = CONSOLE_HEIGHT;    ///< 实际控制台高度（行数）
 static int last_score = -1;                    ///< 上一次绘制的得分，用于增量更新
@@ -146,6 +213,15 @@ static int last_speed = -1;                    ///< 上一次绘制的速度，
 static bool last_paused = true;                ///< 上一次绘制的暂停状态，用于增量更新（初始为true确保第一次绘制）
 static int last_highest_score = -1;            ///< 上一次绘制的最高分，用于增量更新
 static bool ui_initialized = false;            ///< 界面是否已初始化（静态元素是否已绘制）
+static bool vt_enabled = false;                ///< 控制台是否支持虚拟终端序列（支持时每帧合成后一次写出）
+static Frame frame;                            ///< 帧缓冲（仅虚拟终端模式）
+static NumberCache number_cache;               ///< 分数、速度等数字的文本缓存
+static Camera camera;                          ///< 游戏区域视口（跟随蛇头，可缩小显示）
+static double startup_ms[STARTUP_PHASE_COUNT]; ///< 各启动阶段用时（毫秒）
+static unsigned startup_phases = 0;            ///< 已经历的启动阶段（位集合）
+static LARGE_INTEGER startup_mark;             ///< 上一个启动计时点
+static bool highest_score_loaded = false;      ///< 最高分文件是否已读取（推迟到第一帧之后）
+static LatencyProbe latency;                   ///< 按键延迟测量（仅--latency模式）
 
 // =============================================
 // 函数原型声明
@@ -155,32 +231,391 @@ static bool ui_initialized = false;            ///< 界面是否已初始化（
 static void init_console(void);
 static void printf_at(int x, int y, WORD attributes, const wchar_t *fmt, ...);
 static void clear_screen(void);
+static void present_frame(void);
+static void put_text(int x, int y, WORD attributes, const uint16_t *utf16, int utf16_length,
+                     const char *utf8, int utf8_length);
+static void put_number_line(int x, int y, WORD attributes, const UiText *label, int value, const UiText *suffix);
 
 // 游戏池定位和绘制函数
-static Position get_cell_console_position(Position pool_pos);
-static void draw_cell(Position pool_pos);
-
-// 游戏池初始化和管理
-static void init_pool(void);
-static void set_cell_type(Position pos, CellType type);
-static CellType get_cell_type(Position pos);
-
-// 游戏逻辑函数
-static void init_game_state(void);
-static void generate_food(void);
-static void draw_game(void);
-static CellType direction_to_body_type(Direction dir);
-static Direction body_type_to_direction(CellType type);
-static void update_game(void);
-static bool handle_input(void);
+static Position get_cell_console_position(Position view_pos);
+static void draw_cell(Position view_pos, const CellGlyph *glyph);
+
+// 游戏界面和输入函数
+static void draw_game(GameContext *ctx);
+static bool handle_input(GameContext *ctx);
+static void wait_for_key(void);
 
 // 游戏重置函数
-static void reset_game(void);
+static void start_game(GameContext *ctx);
+static void reset_game(GameContext *ctx);
 
 // 最高分管理函数
-static void load_highest_score(void);
-static void save_highest_score(void);
-static void update_highest_score(void);
+static void load_highest_score(GameContext *ctx);
+static void save_highest_score(GameContext *ctx);
+static void update_highest_score(GameContext *ctx);
+
+// 命令行和无界面模式函数
+static bool parse_options(int argc, char **argv, LaunchOptions *options);
+static int run_headless(GameContext *ctx, const LaunchOptions *options);
+
+// 启动计时函数
+static void startup_begin(void);
+static void startup_phase_done(StartupPhase phase);
+static double startup_total_ms(void);
+static void print_startup_times(void);
+static void draw_startup_time(void);
+
+// 按键延迟测量函数
+static void steer(GameContext *ctx, Direction dir);
+static void latency_start(uint64_t seed);
+static void latency_tick_done(const GameContext *ctx, Direction before);
+static void latency_frame_presented(void);
+static void print_latency_report(const GameContext *ctx);
+
+// =============================================
+// 启动计时函数
+// =============================================
+
+/**
+ * @brief 开始启动计时（main的第一条语句）
+ *
+ * 进程创建到进入main的时间（加载器、DLL初始化、C运行库初始化）由进程创建时刻计算，
+ * 之后各阶段用QueryPerformanceCounter计时。
+ * 进程创建时刻是系统时间，只能与系统时间相减：GetSystemTimePreciseAsFileTime从Windows 8开始才有，
+ * 运行时从kernel32查找，找不到时（Windows 7）退回精度为一个时钟中断（约1～16毫秒）的GetSystemTimeAsFileTime。
+ */
+static void startup_begin(void)
+{
+    QueryPerformanceCounter(&startup_mark);
+
+    FILETIME created, exited, kernel, user, now;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+    {
+        typedef VOID(WINAPI * SystemTimeFunction)(LPFILETIME);
+        SystemTimeFunction get_system_time = GetSystemTimeAsFileTime;
+        HMODULE kernel32 = GetModuleHandleW(L"kernel32.dll");
+        FARPROC precise = kernel32 != NULL ? GetProcAddress(kernel32, "GetSystemTimePreciseAsFileTime") : NULL;
+        if (precise != NULL)
+        {
+            get_system_time = (SystemTimeFunction)(void (*)(void))precise; // 经由通用函数指针转换，避免-Wcast-function-type
+        }
+        get_system_time(&now);
+        ULONGLONG created_ticks = ((ULONGLONG)created.dwHighDateTime << 32) | created.dwLowDateTime;
+        ULONGLONG now_ticks = ((ULONGLONG)now.dwHighDateTime << 32) | now.dwLowDateTime;
+        startup_ms[STARTUP_LOADER] = now_ticks > created_ticks ? (double)(now_ticks - created_ticks) / 10000.0 : 0.0; // 100纳秒为单位
+        startup_phases |= 1u << STARTUP_LOADER;
+    }
+}
+
+/**
+ * @brief 结束一个启动阶段，记录从上一个计时点到现在的用时
+ */
+static void startup_phase_done(StartupPhase phase)
+{
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    startup_ms[phase] += (double)(now.QuadPart - startup_mark.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+    startup_phases |= 1u << phase;
+    startup_mark = now;
+}
+
+/**
+ * @brief 进程创建到第一帧的总用时（毫秒）
+ */
+static double startup_total_ms(void)
+{
+    double total = 0.0;
+    for (int phase = 0; phase < STARTUP_PHASE_COUNT; phase++)
+    {
+        total += startup_ms[phase];
+    }
+    return total;
+}
+
+/**
+ * @brief 输出启动用时到stdout（无界面模式的统计信息）
+ */
+static void print_startup_times(void)
+{
+    printf("启动:     首帧 %.2f ms（", startup_total_ms());
+    const char *separator = "";
+    for (int phase = 0; phase < STARTUP_PHASE_COUNT; phase++)
+    {
+        if (startup_phases & (1u << phase))
+        {
+            printf("%s%s %.2f", separator, STARTUP_PHASE_NAMES[phase], startup_ms[phase]);
+            separator = "，";
+        }
+    }
+    printf("）\n");
+}
+
+/**
+ * @brief 在右侧信息区域显示首帧用时（第一帧画出之后才有数值）
+ */
+static void draw_startup_time(void)
+{
+    if (startup_phases & (1u << STARTUP_FIRST_FRAME))
+    {
+        printf_at(console_width / 2 + 9, GAME_AREA_Y + 14,
+                  FOREGROUND_BLUE | FOREGROUND_GREEN,
+                  L"首帧: %.1fms", startup_total_ms());
+    }
+}
+
+// =============================================
+// 按键延迟测量函数
+// =============================================
+
+/**
+ * @brief 读取当前QueryPerformanceCounter计数
+ */
+static LONGLONG performance_now(void)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+/**
+ * @brief 注入线程：以随机间隔向控制台输入队列写入按键，最后写入退出键
+ *
+ * 按键依次为下、左、上、右（每次都与上一次垂直，从初始方向向右开始每次都是合法的转向），
+ * 以WASD字符的形式写入，_getch()读到的与键盘输入完全相同。
+ */
+static DWORD WINAPI latency_injector(LPVOID param)
+{
+    static const WCHAR KEYS[] = {L's', L'a', L'w', L'd'};
+    static const WORD VIRTUAL_KEYS[] = {'S', 'A', 'W', 'D'};
+    static const Direction DIRECTIONS[] = {DIR_DOWN, DIR_LEFT, DIR_UP, DIR_RIGHT};
+    uint64_t rng = latency.seed | 1;
+    int count = *(const int *)param;
+
+    for (int k = 0; k <= count; k++)
+    {
+        // xorshift64，与引擎的随机数生成器相同
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        Sleep(k < count ? LATENCY_MIN_GAP_MS + (DWORD)(rng % (LATENCY_MAX_GAP_MS - LATENCY_MIN_GAP_MS + 1))
+                        : LATENCY_DRAIN_MS);
+
+        INPUT_RECORD record;
+        memset(&record, 0, sizeof(record));
+        record.EventType = KEY_EVENT;
+        record.Event.KeyEvent.bKeyDown = TRUE;
+        record.Event.KeyEvent.wRepeatCount = 1;
+        record.Event.KeyEvent.uChar.UnicodeChar = k < count ? KEYS[k % 4] : L'q';
+        record.Event.KeyEvent.wVirtualKeyCode = k < count ? VIRTUAL_KEYS[k % 4] : (WORD)'Q';
+
+        // 时间戳先于按键到达输入队列写入，主线程读到按键时一定能看到
+        if (k < count)
+        {
+            latency.keys[k].direction = DIRECTIONS[k % 4];
+            latency.keys[k].injected = performance_now();
+            InterlockedIncrement(&latency.injected);
+        }
+        DWORD written;
+        WriteConsoleInputW(hInput, &record, 1, &written);
+    }
+    return 0;
+}
+
+/**
+ * @brief 开始按键延迟测量：启动注入线程
+ *
+ * @param seed 注入间隔的随机数种子（相同种子得到相同的按键间隔）
+ */
+static void latency_start(uint64_t seed)
+{
+    memset(&latency, 0, sizeof(latency));
+    latency.awaiting_tick = -1;
+    latency.awaiting_display = -1;
+    latency.seed = seed;
+    HANDLE thread = CreateThread(NULL, 0, latency_injector, &options.latency_keys, 0, NULL);
+    if (thread != NULL)
+    {
+        CloseHandle(thread); // 线程结束时自行退出，不需要等待
+    }
+}
+
+/**
+ * @brief 键盘转向：请求转向，延迟测量模式下记录读到按键的时刻
+ *
+ * @param ctx 游戏上下文
+ * @param dir 按键对应的方向
+ */
+static void steer(GameContext *ctx, Direction dir)
+{
+    turn_snake(ctx, dir);
+    if (options.latency_keys == 0)
+    {
+        return;
+    }
+
+    // 只统计注入的按键（测量期间的真实按键无法与注入顺序对应，忽略）
+    int k = latency.read;
+    if (k >= (int)InterlockedCompareExchange(&latency.injected, 0, 0) || latency.keys[k].direction != dir)
+    {
+        return;
+    }
+    latency.read++;
+    latency.keys[k].read = performance_now();
+
+    if (ctx->game.snake.next_direction != dir)
+    {
+        latency.rejected++;
+        return;
+    }
+    if (latency.awaiting_tick >= 0)
+    {
+        latency.superseded++;
+    }
+    latency.awaiting_tick = k;
+}
+
+/**
+ * @brief 一帧update_game结束后调用：等待中的按键在这一帧生效时记录应用时刻
+ *
+ * @param ctx 游戏上下文
+ * @param before 这一帧开始前蛇的移动方向
+ */
+static void latency_tick_done(const GameContext *ctx, Direction before)
+{
+    int k = latency.awaiting_tick;
+    if (k < 0)
+    {
+        return;
+    }
+    latency.awaiting_tick = -1;
+
+    const Snake *snake = &ctx->game.snake;
+    if (ctx->game.game_over)
+    {
+        latency.lost++;
+    }
+    else if (snake->direction == latency.keys[k].direction && before != snake->direction)
+    {
+        latency.keys[k].applied = performance_now();
+        latency.keys[k].speed = ctx->game.speed;
+        latency.awaiting_display = k;
+    }
+    else
+    {
+        latency.rejected++;
+    }
+}
+
+/**
+ * @brief draw_game返回后调用：转向后的蛇头已经写到控制台，记录显示时刻
+ */
+static void latency_frame_presented(void)
+{
+    int k = latency.awaiting_display;
+    if (k >= 0)
+    {
+        latency.keys[k].displayed = performance_now();
+        latency.awaiting_display = -1;
+        latency.measured++;
+    }
+}
+
+/**
+ * @brief 比较两个double（qsort用）
+ */
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 输出按键延迟报告到stdout：按键到显示的延迟直方图、分位数和各段平均用时
+ *
+ * 各段：注入 → 读到（主要是Sleep(速度)期间按键在队列中等待），读到 → 应用（等待下一帧），
+ * 应用 → 显示（绘制和写出）。每帧时长是各按键应用时实际生效的速度（没有测量到按键时为当前速度）。
+ */
+static void print_latency_report(const GameContext *ctx)
+{
+    static double totals[LATENCY_MAX_KEYS];
+    uint32_t histogram[LATENCY_BUCKETS] = {0};
+    double wait_sum = 0.0, tick_sum = 0.0, draw_sum = 0.0;
+    int samples = 0;
+    int fastest = ctx->game.speed, slowest = ctx->game.speed;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double ms_per_count = 1000.0 / (double)frequency.QuadPart;
+
+    for (int k = 0; k < latency.read; k++)
+    {
+        const KeyTiming *key = &latency.keys[k];
+        if (key->displayed == 0)
+        {
+            continue;
+        }
+        double total = (double)(key->displayed - key->injected) * ms_per_count;
+        wait_sum += (double)(key->read - key->injected) * ms_per_count;
+        tick_sum += (double)(key->applied - key->read) * ms_per_count;
+        draw_sum += (double)(key->displayed - key->applied) * ms_per_count;
+        int bucket = (int)(total / LATENCY_BUCKET_MS);
+        histogram[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+        fastest = samples == 0 || key->speed < fastest ? key->speed : fastest;
+        slowest = samples == 0 || key->speed > slowest ? key->speed : slowest;
+        totals[samples++] = total;
+    }
+
+    SetConsoleOutputCP(CP_UTF8);
+    printf("按键延迟: 注入 %d 个，测量 %d 个（拒绝 %d，被覆盖 %d，丢失 %d），",
+           (int)latency.injected, samples, latency.rejected, latency.superseded, latency.lost);
+    if (fastest == slowest)
+    {
+        printf("每帧 %d ms\n", fastest);
+    }
+    else
+    {
+        printf("每帧 %d～%d ms\n", fastest, slowest);
+    }
+    if (samples == 0)
+    {
+        return;
+    }
+
+    qsort(totals, (size_t)samples, sizeof(double), compare_double);
+    printf("总延迟:   平均 %.1f ms，P50 %.1f，P90 %.1f，P99 %.1f，最大 %.1f\n",
+           (wait_sum + tick_sum + draw_sum) / samples, totals[samples / 2], totals[samples * 9 / 10],
+           totals[samples * 99 / 100], totals[samples - 1]);
+    printf("分段平均: 等待读取 %.1f ms，等待下一帧 %.1f ms，绘制 %.2f ms\n",
+           wait_sum / samples, tick_sum / samples, draw_sum / samples);
+
+    uint32_t peak = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        peak = histogram[b] > peak ? histogram[b] : peak;
+    }
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        if (histogram[b] == 0)
+        {
+            continue;
+        }
+        char bar[LATENCY_BAR_WIDTH + 1];
+        int width = (int)((histogram[b] * LATENCY_BAR_WIDTH + peak - 1) / peak);
+        memset(bar, '#', (size_t)width);
+        bar[width] = '\0';
+        if (b < LATENCY_BUCKETS - 1)
+        {
+            printf("  %3d-%3d ms |%-*s %u\n", b * LATENCY_BUCKET_MS, (b + 1) * LATENCY_BUCKET_MS,
+                   LATENCY_BAR_WIDTH, bar, histogram[b]);
+        }
+        else
+        {
+            printf("  %3d+    ms |%-*s %u\n", b * LATENCY_BUCKET_MS, LATENCY_BAR_WIDTH, bar, histogram[b]);
+        }
+    }
+}
 
 // =============================================
 // Windows API控制台输出函数
@@ -191,6 +626,8 @@ static void update_highest_score(void);
  *
  * 获取控制台句柄、设置UTF-8编码、调整控制台窗口和缓冲区大小、隐藏光标。
  * 此函数必须在任何控制台输出操作之前调用，确保控制台处于正确的初始状态。
+ * 控制台已经是80x30时不调用任何调整尺寸的API（调整窗口会触发重绘，是启动时最慢的调用）；
+ * 快速启动时完全不调整，按控制台当前尺寸布局。
  *
  * @note 如果无法获取控制台句柄，程序将显示错误消息并退出。
  *
@@ -198,9 +635,10 @@ static void update_highest_score(void);
  * 1. 获取标准输出句柄
  * 2. 设置控制台代码页为UTF-8以支持中文显示
  * 3. 获取当前控制台尺寸作为参考
- * 4. 设置控制台缓冲区大小（80x30）
- * 5. 设置控制台窗口大小（如果失败则尝试最大允许尺寸）
+ * 4. 设置控制台缓冲区大小（80x30，已经是或快速启动时跳过）
+ * 5. 设置控制台窗口大小（如果失败则尝试最大允许尺寸；已经是或快速启动时跳过）
  * 6. 隐藏光标以提高视觉体验
+ * 7. 开启虚拟终端模式（不支持时退回逐单元格调用控制台API）
  */
 static void init_console(void)
 {
@@ -211,14 +649,16 @@ static void init_console(void)
         MessageBoxW(NULL, L"无法获取控制台句柄", L"错误", MB_OK | MB_ICONERROR);
         exit(1);
     }
+    hInput = GetStdHandle(STD_INPUT_HANDLE);
 
     // 设置控制台代码页为UTF-8以支持中文显示
+    // （文字都以UTF-16经WriteConsoleW或以UTF-8经虚拟终端写出，不依赖C运行库的区域设置，不调用setlocale）
     SetConsoleOutputCP(CP_UTF8);
-    setlocale(LC_ALL, "zh_CN.UTF-8");
 
     // 获取当前控制台信息
     CONSOLE_SCREEN_BUFFER_INFO csbi;
-    if (!GetConsoleScreenBufferInfo(hConsole, &csbi))
+    bool have_info = GetConsoleScreenBufferInfo(hConsole, &csbi);
+    if (!have_info)
     {
         // 如果无法获取信息，使用默认值
         console_width = CONSOLE_WIDTH / 2;
@@ -231,9 +671,17 @@ static void init_console(void)
         console_height = csbi.dwSize.Y;
     }
 
+    bool buffer_ready = have_info && csbi.dwSize.X == CONSOLE_WIDTH && csbi.dwSize.Y == CONSOLE_HEIGHT;
+    bool window_ready = have_info && csbi.srWindow.Left == 0 && csbi.srWindow.Top == 0 &&
+                        csbi.srWindow.Right == CONSOLE_WIDTH - 1 && csbi.srWindow.Bottom == CONSOLE_HEIGHT - 1;
+    if (options.fast_start)
+    {
+        buffer_ready = window_ready = true;
+    }
+
     // 设置控制台缓冲区大小（80列 × 30行）
     COORD bufferSize = {CONSOLE_WIDTH, CONSOLE_HEIGHT};
-    if (!SetConsoleScreenBufferSize(hConsole, bufferSize))
+    if (!buffer_ready && !SetConsoleScreenBufferSize(hConsole, bufferSize))
     {
         // 如果设置失败，尝试使用当前缓冲区大小
         if (GetConsoleScreenBufferInfo(hConsole, &csbi))
@@ -247,7 +695,7 @@ static void init_console(void)
 
     // 设置控制台窗口大小（80列 × 30行）
     SMALL_RECT windowSize = {0, 0, CONSOLE_WIDTH - 1, CONSOLE_HEIGHT - 1}; // 从(0,0)到(79,29)
-    if (!SetConsoleWindowInfo(hConsole, TRUE, &windowSize))
+    if (!window_ready && !SetConsoleWindowInfo(hConsole, TRUE, &windowSize))
     {
         // 如果设置窗口大小失败，尝试调整到合适的尺寸
         // 首先获取最大允许的窗口尺寸
@@ -274,6 +722,14 @@ static void init_console(void)
     GetConsoleCursorInfo(hConsole, &cursorInfo);
     cursorInfo.bVisible = FALSE;
     SetConsoleCursorInfo(hConsole, &cursorInfo);
+
+    // 尝试开启虚拟终端模式（Windows 10及以上），成功后每帧的输出合成为一次写入
+    DWORD mode;
+    if (GetConsoleMode(hConsole, &mode) && SetConsoleMode(hConsole, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+    {
+        vt_enabled = frame_init(&frame, FRAME_CAPACITY);
+    }
+    render_init();
 }
 
 /**
@@ -295,6 +751,9 @@ static void init_console(void)
  */
 static void printf_at(int x, int y, WORD attributes, const wchar_t *fmt, ...)
 {
+    // 先写出帧缓冲中尚未输出的内容，保证输出顺序
+    present_frame();
+
     // 设置光标位置
     COORD coord = {x * 2, y};
     SetConsoleCursorPosition(hConsole, coord);
@@ -302,28 +761,140 @@ static void printf_at(int x, int y, WORD attributes, const wchar_t *fmt, ...)
     // 设置文本属性（颜色）
     SetConsoleTextAttribute(hConsole, attributes);
 
-    // 格式化输出
+    // 格式化后直接写出UTF-16（不经过C运行库的stdout和区域设置）
+    wchar_t text[CONSOLE_WIDTH + 1];
     va_list args;
     va_start(args, fmt);
-    vwprintf(fmt, args);
+    int length = vswprintf(text, sizeof(text) / sizeof(text[0]), fmt, args);
     va_end(args);
+    if (length > 0)
+    {
+        DWORD written;
+        WriteConsoleW(hConsole, text, (DWORD)length, &written, NULL);
+    }
+
+    // 颜色已经通过控制台API改变，帧缓冲下一次必须重新输出颜色序列
+    frame.attributes = -1;
+}
+
+/**
+ * @brief 写出帧缓冲（虚拟终端模式下一帧只调用一次控制台API）
+ */
+static void present_frame(void)
+{
+    if (vt_enabled && frame.length > 0)
+    {
+        DWORD written;
+        WriteConsoleA(hConsole, frame.data, (DWORD)frame.length, &written, NULL);
+        frame_reset(&frame);
+    }
+}
+
+/**
+ * @brief 在控制台指定位置输出预先编码的文字（不经过格式解析）
+ *
+ * 虚拟终端模式下追加到帧缓冲（光标移动、颜色序列和UTF-8文字），由present_frame统一写出；
+ * 否则直接调用控制台API输出UTF-16文字。
+ *
+ * @param x 输出位置的X坐标（与printf_at相同，实际列数为x*2）
+ * @param y 输出位置的Y坐标
+ * @param attributes 文本属性
+ * @param utf16 UTF-16文字
+ * @param utf16_length UTF-16单元数
+ * @param utf8 UTF-8文字
+ * @param utf8_length UTF-8字节数
+ */
+static void put_text(int x, int y, WORD attributes, const uint16_t *utf16, int utf16_length,
+                     const char *utf8, int utf8_length)
+{
+    if (vt_enabled)
+    {
+        if (frame_available(&frame) < FRAME_BYTES_PER_CELL + (size_t)utf8_length)
+        {
+            present_frame();
+        }
+        frame_move_to(&frame, x * 2, y);
+        frame_set_attributes(&frame, attributes);
+        frame_put(&frame, utf8, (size_t)utf8_length);
+        return;
+    }
+
+    COORD coord = {x * 2, y};
+    DWORD written;
+    SetConsoleCursorPosition(hConsole, coord);
+    SetConsoleTextAttribute(hConsole, attributes);
+    WriteConsoleW(hConsole, (const WCHAR *)utf16, (DWORD)utf16_length, &written, NULL); // Windows下wchar_t为16位
+}
+
+/**
+ * @brief 输出"标签 + 数字 + 后缀"形式的信息行
+ *
+ * 数字文本取自number_cache，整行用memcpy拼接后一次输出。
+ *
+ * @param x 输出位置的X坐标
+ * @param y 输出位置的Y坐标
+ * @param attributes 文本属性
+ * @param label 标签
+ * @param value 数字
+ * @param suffix 后缀（可为NULL）
+ */
+static void put_number_line(int x, int y, WORD attributes, const UiText *label, int value, const UiText *suffix)
+{
+    uint16_t line16[64];
+    char line8[128];
+    const NumberText *number = number_text(&number_cache, value);
+    int suffix16 = suffix != NULL ? suffix->utf16_length : 0;
+    int suffix8 = suffix != NULL ? suffix->utf8_length : 0;
+    int length16 = 0, length8 = 0;
+
+    memcpy(line16, label->utf16, (size_t)label->utf16_length * sizeof(uint16_t));
+    length16 += label->utf16_length;
+    memcpy(line16 + length16, number->utf16, (size_t)number->length * sizeof(uint16_t));
+    length16 += number->length;
+    if (suffix16 > 0)
+    {
+        memcpy(line16 + length16, suffix->utf16, (size_t)suffix16 * sizeof(uint16_t));
+        length16 += suffix16;
+    }
+
+    memcpy(line8, label->utf8, (size_t)label->utf8_length);
+    length8 += label->utf8_length;
+    memcpy(line8 + length8, number->utf8, number->length);
+    length8 += number->length;
+    if (suffix8 > 0)
+    {
+        memcpy(line8 + length8, suffix->utf8, (size_t)suffix8);
+        length8 += suffix8;
+    }
+
+    put_text(x, y, attributes, line16, length16, line8, length8);
 }
 
 /**
  * @brief 清空控制台屏幕
  *
  * 清除控制台中的所有内容，并将光标重置到左上角(0,0)位置。
- * 使用系统命令"cls"实现清屏操作，然后设置光标位置。
+ * 直接用控制台API填充整个缓冲区（效果与"cls"相同，但不创建cmd子进程）。
  *
  * @note 此函数会清除控制台中的所有输出，包括游戏界面。
  */
 static void clear_screen(void)
 {
-    // 使用系统命令清屏
-    system("cls");
-    // 设置光标到左上角
+    // 先写出帧缓冲中尚未输出的内容，保证输出顺序
+    present_frame();
+
     COORD coord = {0, 0};
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (GetConsoleScreenBufferInfo(hConsole, &csbi))
+    {
+        DWORD cells = (DWORD)csbi.dwSize.X * (DWORD)csbi.dwSize.Y;
+        DWORD written;
+        FillConsoleOutputCharacterW(hConsole, L' ', cells, coord, &written);
+        FillConsoleOutputAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE, cells, coord, &written);
+    }
+    // 设置光标到左上角
     SetConsoleCursorPosition(hConsole, coord);
+    frame.attributes = -1;
 }
 
 // =============================================
@@ -331,27 +902,28 @@ static void clear_screen(void)
 // =============================================
 
 /**
- * 获取游戏池单元格的控制台位置
+ * 获取视口中一格的控制台位置
  *
- * 功能：将游戏池坐标转换为控制台屏幕坐标。
- * 游戏池坐标以(0,0)为左上角，控制台坐标以GAME_AREA_X和GAME_AREA_Y为偏移基准。
+ * 功能：将视口坐标转换为控制台屏幕坐标。
+ * 视口坐标以(0,0)为左上角，控制台坐标以GAME_AREA_X和GAME_AREA_Y为偏移基准。
+ * 视口中的一格对应游戏池的哪个单元格（或哪个块）由camera_cell决定。
  *
- * @param pool_pos 游戏池中的位置（包含x和y坐标，单元格索引）
+ * @param view_pos 视口中的位置（列和行）
  * @return Position 对应的控制台坐标位置
  */
-static Position get_cell_console_position(Position pool_pos)
+static Position get_cell_console_position(Position view_pos)
 {
     Position pos;
-    pos.x = GAME_AREA_X + pool_pos.x;
-    pos.y = GAME_AREA_Y + pool_pos.y;
+    pos.x = GAME_AREA_X + view_pos.x;
+    pos.y = GAME_AREA_Y + view_pos.y;
     return pos;
 }
 
 /**
- * 绘制游戏池中的一个单元格
+ * 绘制视口中的一格
  *
- * 功能：根据单元格类型在控制台对应位置绘制相应的字符和颜色。
- * 此函数将游戏池中的抽象单元格状态转换为可视化的控制台输出。
+ * 功能：在控制台对应位置绘制单元格（或缩小显示时一个块）的字符和颜色。
+ * 字形和颜色来自snake_render.c中按CELL_HASH下标的字形表，不再逐单元格switch。
  *
  * 支持的单元格类型和显示方式：
  *   - CELL_EMPTY: 空白（两个空格）
@@ -361,256 +933,50 @@ static Position get_cell_console_position(Position pool_pos)
  *   - CELL_SNAKE_TAIL: 绿色"尾"字
  *   - CELL_WALL:   白色背景黑色"墙"字
  *
- * @param pool_pos 游戏池中的位置（包含x和y坐标，单元格索引）
+ * @param view_pos 视口中的位置（列和行）
+ * @param glyph 字形（CELL_GLYPH或block_glyph的结果）
  */
-static void draw_cell(Position pool_pos)
+static void draw_cell(Position view_pos, const CellGlyph *glyph)
 {
-    CellType cell = pool[pool_pos.y][pool_pos.x];
-    Position console_pos = get_cell_console_position(pool_pos);
-    WORD attributes = 0;
-    const wchar_t *wstr = L"  "; // 默认两个空格
-
-    switch (cell)
-    {
-    case CELL_EMPTY:
-        wstr = L"  ";
-        attributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
-        break;
-    case CELL_FOOD:
-        wstr = L"★"; // 星号作为食物
-        attributes = FOREGROUND_RED | FOREGROUND_INTENSITY;
-        break;
-    case CELL_SNAKE_HEAD:
-        wstr = L"头"; // 用"头"字表示蛇头
-        attributes = FOREGROUND_GREEN | FOREGROUND_INTENSITY;
-        break;
-    case CELL_SNAKE_BODY_UP:
-    case CELL_SNAKE_BODY_DOWN:
-    case CELL_SNAKE_BODY_LEFT:
-    case CELL_SNAKE_BODY_RIGHT:
-        wstr = L"蛇";
-        attributes = FOREGROUND_GREEN;
-        break;
-    case CELL_SNAKE_TAIL:
-        wstr = L"尾"; // 用"尾"字表示蛇尾
-        attributes = FOREGROUND_GREEN;
-        break;
-    case CELL_WALL:
-        wstr = L"墙"; // 用"墙"字表示墙壁
-        // 白底黑字：白色背景，黑色前景（前景色为0表示黑色）
-        attributes = BACKGROUND_RED | BACKGROUND_GREEN | BACKGROUND_BLUE | BACKGROUND_INTENSITY;
-        break;
-    }
-
-    // 绘制单元格
-    printf_at(console_pos.x, console_pos.y, attributes, L"%ls", wstr);
+    Position console_pos = get_cell_console_position(view_pos);
+
+    // 绘制单元格（字形和颜色已预先编码，不做任何转换）
+    put_text(console_pos.x, console_pos.y, glyph->attributes,
+             glyph->utf16, glyph->utf16_length, glyph->utf8, glyph->utf8_length);
 }
 
 // =============================================
-// 游戏池初始化和管理
+// 游戏界面和输入函数
 // =============================================
 
 /**
- * 初始化游戏池
+ * 绘制游戏界面
  *
- * 功能：将游戏池二维数组所有单元格初始化为CELL_EMPTY，并设置四周边框为CELL_WALL。
- * 此函数在游戏开始时调用，创建游戏的基本网格结构。
+ * 功能：绘制完整的游戏界面，包括标题、游戏池、分数信息、控制说明和制作人信息。
+ * 此函数负责将所有游戏状态可视化为控制台输出。
  *
- * 实现步骤：
- *   1. 遍历所有单元格，设置为CELL_EMPTY
- *   2. 设置上边框和下边框为CELL_WALL
- *   3. 设置左边框和右边框为CELL_WALL
+ * 绘制内容：
+ *   1. 清空控制台并绘制居中标题
+ *   2. 视口跟随蛇头，绘制视口内的脏格（视口移动或缩放改变时重绘整个视口）
+ *   3. 在右侧信息区域显示分数、速度、控制说明
+ *   4. 显示制作人信息
+ *   5. 如果游戏结束，显示游戏结束信息和最终得分
+ *
+ * 注意：此函数会频繁调用（每次游戏循环），应保持高效：
+ * 每帧只做查表和memcpy，虚拟终端模式下整帧只调用一次控制台API；
+ * 只检查视口内的格，绘制代价与游戏池大小无关。
  */
-static void init_pool(void)
+static void draw_game(GameContext *ctx)
 {
-    // 清空所有单元格
-    for (int y = 0; y < POOL_HEIGHT; y++)
-    {
-        for (int x = 0; x < POOL_WIDTH; x++)
-        {
-            pool[y][x] = CELL_EMPTY;
-            dirty[y][x] = false;
-        }
-    }
+    GameState *game = &ctx->game;
 
-    // 设置墙壁
-    for (int x = 0; x < POOL_WIDTH; x++)
-    {
-        set_cell_type((Position){x, 0}, CELL_WALL);               // 上边框
-        set_cell_type((Position){x, POOL_HEIGHT - 1}, CELL_WALL); // 下边框
-    }
-    for (int y = 0; y < POOL_HEIGHT; y++)
-    {
-        set_cell_type((Position){0, y}, CELL_WALL);              // 左边框
-        set_cell_type((Position){POOL_WIDTH - 1, y}, CELL_WALL); // 右边框
-    }
-}
+    // 游戏结束绘制状态（静态变量，需要在游戏重置时重置）
+    static bool game_over_drawn = false;
 
-/**
- * 在游戏池中设置单元格类型
- *
- * 功能：将游戏池中指定坐标的单元格设置为指定的类型。
- * 此函数包含边界检查，确保坐标在有效范围内。
- *
- * @param pos  目标单元格的位置（包含x和y坐标）
- * @param type 要设置的单元格类型（CellType枚举值）
- */
-static void set_cell_type(Position pos, CellType type)
-{
-    if (pos.x >= 0 && pos.x < POOL_WIDTH && pos.y >= 0 && pos.y < POOL_HEIGHT)
+    // 如果游戏没有结束但game_over_drawn为true，重置它（用于重玩）
+    if (!game->game_over && game_over_drawn)
     {
-        pool[pos.y][pos.x] = type;
-        dirty[pos.y][pos.x] = true;
-    }
-}
-
-/**
- * 获取游戏池中单元格类型
- *
- * 功能：获取游戏池中指定坐标的单元格当前类型。
- * 此函数包含边界检查，如果坐标越界则返回CELL_WALL（视为墙壁）。
- *
- * @param pos 目标单元格的位置（包含x和y坐标）
- * @return CellType 指定坐标的单元格类型，如果越界则返回CELL_WALL
- */
-static CellType get_cell_type(Position pos)
-{
-    if (pos.x >= 0 && pos.x < POOL_WIDTH && pos.y >= 0 && pos.y < POOL_HEIGHT)
-    {
-        return pool[pos.y][pos.x];
-    }
-    return CELL_WALL; // 越界视为墙壁
-}
-
-// =============================================
-// 游戏逻辑函数
-// =============================================
-
-/**
- * @brief 初始化游戏状态（用于首次启动和重玩）
- *
- * 只初始化游戏状态，不包括控制台初始化。
- * 用于在游戏结束后重新开始游戏，保持相同的控制台环境。
- *
- * 实现步骤：
- * 1. 初始化游戏状态变量（分数、速度、游戏结束标志）
- * 2. 初始化蛇的状态（长度、方向、初始位置）
- * 3. 初始化游戏池（清空所有单元格并设置边框）
- * 4. 在游戏池中设置蛇的初始位置（头、身、尾）
- * 5. 生成第一个食物
- *
- * @note 每次调用都会重新初始化随机数种子，确保食物生成随机性。
- */
-static void init_game_state(void)
-{
-    // 重新初始化随机数种子（每次重玩都应该重新种子）
-    srand((unsigned int)time(NULL) + 325u);
-
-    // 初始化游戏状态变量
-    game.score = 0;
-    game.game_over = false;
-    game.paused = false;
-    game.speed = 150; // 初始速度150毫秒
-
-    // 加载最高分记录
-    load_highest_score();
-
-    // 初始化蛇
-    game.snake.length = 3;
-    game.snake.direction = DIR_RIGHT;
-    game.snake.next_direction = DIR_RIGHT;
-    game.snake.tail_direction = DIR_RIGHT;
-
-    // 蛇的初始位置（在游戏区域中央）
-    int start_x = POOL_WIDTH / 2 + 1;
-    int start_y = POOL_HEIGHT / 2;
-
-    // 设置蛇头和蛇尾位置
-    game.snake.head.x = start_x;
-    game.snake.head.y = start_y;
-    game.snake.tail.x = start_x - (game.snake.length - 1);
-    game.snake.tail.y = start_y;
-
-    // 初始化游戏池
-    init_pool();
-
-    // 在游戏池中设置蛇的位置
-    // 设置蛇头
-    set_cell_type(game.snake.head, CELL_SNAKE_HEAD);
-
-    // 设置蛇身
-    set_cell_type((Position){game.snake.head.x - 1, game.snake.head.y}, CELL_SNAKE_BODY_RIGHT);
-
-    // 设置蛇尾
-    set_cell_type(game.snake.tail, CELL_SNAKE_TAIL);
-
-    // 生成第一个食物
-    generate_food();
-}
-
-/**
- * 生成食物
- *
- * 功能：在游戏池的随机空单元格中生成食物。
- * 使用随机数生成器选择坐标，确保不会在蛇身体或墙壁上生成食物。
- *
- * 实现步骤：
- *   1. 随机生成X和Y坐标
- *   2. 检查该位置是否为CELL_EMPTY
- *   3. 如果不是空单元格，则重试（最多尝试POOL_WIDTH * POOL_HEIGHT * 2次）
- *   4. 如果找不到合适位置，游戏结束（视为胜利）
- *   5. 在找到的空单元格设置CELL_FOOD类型，并更新game.food位置
- */
-static void generate_food(void)
-{
-    int x, y;
-    int attempts = 0;
-    const int max_attempts = POOL_WIDTH * POOL_HEIGHT * 2;
-
-    do
-    {
-        x = rand() % POOL_WIDTH;
-        y = rand() % POOL_HEIGHT;
-        attempts++;
-
-        if (attempts > max_attempts)
-        {
-            // 如果找不到合适的位置，游戏胜利
-            game.game_over = true;
-            update_highest_score(); // 更新最高分
-            return;
-        }
-    } while (get_cell_type((Position){x, y}) != CELL_EMPTY);
-
-    game.food.x = x;
-    game.food.y = y;
-    set_cell_type((Position){x, y}, CELL_FOOD);
-}
-
-/**
- * 绘制游戏界面
- *
- * 功能：绘制完整的游戏界面，包括标题、游戏池、分数信息、控制说明和制作人信息。
- * 此函数负责将所有游戏状态可视化为控制台输出。
- *
- * 绘制内容：
- *   1. 清空控制台并绘制居中标题
- *   2. 遍历游戏池所有单元格，调用draw_cell绘制每个单元格
- *   3. 在右侧信息区域显示分数、速度、控制说明
- *   4. 显示制作人信息
- *   5. 如果游戏结束，显示游戏结束信息和最终得分
- *
- * 注意：此函数会频繁调用（每次游戏循环），应保持高效。
- */
-static void draw_game(void)
-{
-    // 游戏结束绘制状态（静态变量，需要在游戏重置时重置）
-    static bool game_over_drawn = false;
-
-    // 如果游戏没有结束但game_over_drawn为true，重置它（用于重玩）
-    if (!game.game_over && game_over_drawn)
-    {
-        game_over_drawn = false;
+        game_over_drawn = false;
     }
 
     // 如果界面未初始化，清屏并绘制静态元素
@@ -635,6 +1001,12 @@ static void draw_game(void)
         printf_at(right_info_x, info_y + 7,
                   FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
                   L"暂停: 空格键或P键");
+        printf_at(right_info_x, info_y + 8,
+                  FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+                  L"存档: K键");
+        printf_at(right_info_x, info_y + 9,
+                  FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+                  L"缩放: Z键");
 
         // 绘制制作人信息（静态）
         printf_at(right_info_x, info_y + 16,
@@ -646,20 +1018,47 @@ static void draw_game(void)
         printf_at(right_info_x, info_y + 18,
                   FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_INTENSITY,
                   L"      贾国威");
+        draw_startup_time();
 
         ui_initialized = true;
+        camera.redraw = true;
     }
 
-    // 绘制游戏池中所有脏单元格
-    for (int y = 0; y < POOL_HEIGHT; y++)
+    // 绘制视口内的脏格；视口外的单元格保留脏标记，滚动到视口内时整个视口重绘
+    bool redraw = camera_follow(&camera, ctx);
+    for (int row = 0; row < camera.height; row++)
     {
-        for (int x = 0; x < POOL_WIDTH; x++)
+        for (int column = 0; column < camera.width; column++)
         {
-            if (dirty[y][x])
+            Position view_pos = {column, row};
+            if (row >= camera.rows || column >= camera.columns)
             {
-                Position pos = {x, y};
-                draw_cell(pos);
-                dirty[y][x] = false;
+                // 网格比视口小：重绘时清除视口中网格以外的部分（缩小显示后残留的字符）
+                if (redraw)
+                {
+                    draw_cell(view_pos, CELL_GLYPH(CELL_EMPTY));
+                }
+                continue;
+            }
+
+            Position cell = camera_cell(&camera, ctx, column, row);
+            if (camera.shift == 0)
+            {
+                int index = cell.y * ctx->pool_width + cell.x;
+                if (redraw || ctx->dirty[index])
+                {
+                    draw_cell(view_pos, CELL_GLYPH(ctx->pool[index]));
+                    ctx->dirty[index] = false;
+                }
+            }
+            else
+            {
+                BlockCounts *block = &ctx->lod.blocks[cell.y * ctx->lod.blocks_x + cell.x];
+                if (redraw || block->dirty)
+                {
+                    draw_cell(view_pos, block_glyph(ctx, cell));
+                    block->dirty = false;
+                }
             }
         }
     }
@@ -669,45 +1068,47 @@ static void draw_game(void)
     int info_y = GAME_AREA_Y + 2;
 
     // 如果分数变化，更新分数信息
-    if (game.score != last_score)
+    if (game->score != last_score)
     {
-        printf_at(right_info_x, info_y + 0, FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-                  L"得分: %d", game.score);
-        last_score = game.score;
+        put_number_line(right_info_x, info_y + 0, FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+                        &TEXT_SCORE, game->score, NULL);
+        last_score = game->score;
     }
 
     // 如果速度变化，更新速度信息
-    if (game.speed != last_speed)
+    if (game->speed != last_speed)
     {
-        printf_at(right_info_x, info_y + 1, FOREGROUND_BLUE | FOREGROUND_INTENSITY,
-                  L"速度: %dms", game.speed);
-        last_speed = game.speed;
+        put_number_line(right_info_x, info_y + 1, FOREGROUND_BLUE | FOREGROUND_INTENSITY,
+                        &TEXT_SPEED, game->speed, &TEXT_MS);
+        last_speed = game->speed;
     }
 
     // 如果最高分变化，更新最高分信息
-    if (game.highest_score != last_highest_score)
+    if (game->highest_score != last_highest_score)
     {
-        printf_at(right_info_x, info_y + 2, FOREGROUND_RED | FOREGROUND_INTENSITY,
-                  L"最高分: %d", game.highest_score);
-        last_highest_score = game.highest_score;
+        put_number_line(right_info_x, info_y + 2, FOREGROUND_RED | FOREGROUND_INTENSITY,
+                        &TEXT_HIGHEST_SCORE, game->highest_score, NULL);
+        last_highest_score = game->highest_score;
     }
 
     // 如果暂停状态变化，更新暂停信息
-    if (game.paused != last_paused)
+    if (game->paused != last_paused)
     {
-        printf_at(right_info_x, info_y + 3, game.paused ? FOREGROUND_RED | FOREGROUND_INTENSITY : FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-                  L"状态: %ls", game.paused ? L"暂停  " : L"进行中");
-        last_paused = game.paused;
+        const UiText *status = game->paused ? &TEXT_PAUSED : &TEXT_RUNNING;
+        put_text(right_info_x, info_y + 3,
+                 game->paused ? FOREGROUND_RED | FOREGROUND_INTENSITY : FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+                 status->utf16, status->utf16_length, status->utf8, status->utf8_length);
+        last_paused = game->paused;
     }
 
     // 如果游戏结束，显示游戏结束信息（游戏结束时只绘制一次）
-    if (game.game_over)
+    if (game->game_over)
     {
         if (!game_over_drawn)
         {
-            // 计算游戏池中心位置
-            int pool_center_x = GAME_AREA_X + POOL_WIDTH / 2;
-            int pool_center_y = GAME_AREA_Y + POOL_HEIGHT / 2;
+            // 计算视口中显示区域的中心位置
+            int pool_center_x = GAME_AREA_X + camera.columns / 2;
+            int pool_center_y = GAME_AREA_Y + camera.rows / 2;
 
             printf_at(pool_center_x - 2, pool_center_y - 1,
                       FOREGROUND_RED | FOREGROUND_INTENSITY,
@@ -715,7 +1116,7 @@ static void draw_game(void)
 
             printf_at(pool_center_x - 3, pool_center_y,
                       FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-                      L"最终得分: %d", game.score);
+                      L"最终得分: %d", game->score);
 
             printf_at(pool_center_x - 6, pool_center_y + 1,
                       FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
@@ -724,171 +1125,9 @@ static void draw_game(void)
             game_over_drawn = true;
         }
     }
-}
-
-/**
- * 根据方向获取对应的蛇身类型
- *
- * 功能：将Direction枚举值转换为对应的蛇身单元格类型（CellType）。
- * 此函数用于在蛇移动时将旧蛇头转换为对应方向的蛇身部分。
- *
- * @param dir 方向枚举值（DIR_UP/DIR_DOWN/DIR_LEFT/DIR_RIGHT）
- * @return CellType 对应的蛇身类型（CELL_SNAKE_BODY_*）
- */
-static CellType direction_to_body_type(Direction dir)
-{
-    switch (dir)
-    {
-    case DIR_UP:
-        return CELL_SNAKE_BODY_UP;
-    case DIR_DOWN:
-        return CELL_SNAKE_BODY_DOWN;
-    case DIR_LEFT:
-        return CELL_SNAKE_BODY_LEFT;
-    case DIR_RIGHT:
-        return CELL_SNAKE_BODY_RIGHT;
-    default:
-        return CELL_SNAKE_BODY_RIGHT; // 默认
-    }
-}
-
-static Direction body_type_to_direction(CellType type)
-{
-    if (type >= CELL_SNAKE_BODY_UP && type <= CELL_SNAKE_BODY_RIGHT)
-    {
-        return (Direction)(type - CELL_SNAKE_BODY_UP);
-    }
-    return DIR_RIGHT; // 默认
-}
-
-/**
- * 更新游戏逻辑 - 新版本，只使用头尾位置
- *
- * 功能：更新游戏状态，包括蛇的移动、碰撞检测、食物检测和分数更新。
- * 此函数在每次游戏循环中调用，是实现游戏核心逻辑的关键函数。
- *
- * 实现步骤：
- *   1. 如果游戏已结束，直接返回
- *   2. 应用输入的方向缓冲（game.snake.next_direction）
- *   3. 根据当前方向计算新蛇头位置
- *   4. 检查碰撞（墙壁、蛇身体）
- *   5. 检查是否吃到食物
- *   6. 如果没吃到食物，移动蛇尾（清除旧蛇尾，找到新蛇尾）
- *   7. 如果吃到食物，增加长度、分数和速度，生成新食物
- *   8. 将旧蛇头变为蛇身，设置新蛇头位置
- *
- * 注意：此函数使用简化算法，只跟踪蛇头和蛇尾位置，通过游戏池单元格方向确定身体连接。
- */
-static void update_game(void)
-{
-    if (game.game_over)
-    {
-        return;
-    }
-
-    // 应用输入的方向
-    game.snake.direction = game.snake.next_direction;
-
-    // 获取当前蛇头位置
-    Position head = game.snake.head;
-    Position new_head = head;
-
-    // 根据方向计算新蛇头位置
-    switch (game.snake.direction)
-    {
-    case DIR_UP:
-        new_head.y--;
-        break;
-    case DIR_DOWN:
-        new_head.y++;
-        break;
-    case DIR_LEFT:
-        new_head.x--;
-        break;
-    case DIR_RIGHT:
-        new_head.x++;
-        break;
-    }
-
-    // 检查碰撞
-    CellType cell_ahead = get_cell_type(new_head);
-
-    if (cell_ahead != CELL_EMPTY && cell_ahead != CELL_FOOD)
-    {
-        // 撞墙或撞到自己身体，游戏结束
-        game.game_over = true;
-        update_highest_score(); // 更新最高分
-        return;
-    }
-
-    // 检查是否吃到食物
-    bool ate_food = (cell_ahead == CELL_FOOD);
-
-    // 更新游戏池和蛇的位置
-    if (!ate_food)
-    {
-        // 没吃到食物，需要移动蛇尾
-        // 根据蛇尾方向计算下一个位置
-        Position next_tail = game.snake.tail;
-        switch (game.snake.tail_direction)
-        {
-        case DIR_UP:
-            next_tail.y--;
-            break;
-        case DIR_DOWN:
-            next_tail.y++;
-            break;
-        case DIR_LEFT:
-            next_tail.x--;
-            break;
-        case DIR_RIGHT:
-            next_tail.x++;
-            break;
-        }
-
-        // 获取下一个位置的单元格类型（应该是蛇身）
-        CellType next_cell_type = get_cell_type(next_tail);
-
-        // 如果下一个位置是蛇身，更新蛇尾方向为该蛇身的方向
-        if (next_cell_type >= CELL_SNAKE_BODY_UP && next_cell_type <= CELL_SNAKE_BODY_RIGHT)
-        {
-            game.snake.tail_direction = body_type_to_direction(next_cell_type);
-        }
-
-        // 清除当前蛇尾
-        set_cell_type(game.snake.tail, CELL_EMPTY);
-
-        // 将下一个位置设为新的蛇尾
-        set_cell_type(next_tail, CELL_SNAKE_TAIL);
-
-        // 更新蛇尾位置
-        game.snake.tail = next_tail;
-    }
-    else
-    {
-        // 吃到食物，蛇长度增加，蛇尾不动
-        game.snake.length++;
-        game.score += 10;
 
-        // 每得50分增加速度
-        if (game.score % 50 == 0 && game.speed > 30)
-        {
-            game.speed -= 10;
-        }
-
-        // 生成新的食物
-        generate_food();
-    }
-
-    // 将旧蛇头变为蛇身（根据移动方向）
-    CellType old_head_type = direction_to_body_type(game.snake.direction);
-    set_cell_type(head, old_head_type);
-
-    // 设置新蛇头
-    set_cell_type(new_head, CELL_SNAKE_HEAD);
-
-    // 更新蛇头位置
-    game.snake.head = new_head;
+    // 一帧的全部输出一次写出
+    present_frame();
 }
 
 /**
@@ -901,13 +1140,16 @@ static void update_game(void)
  * - 方向键：上(72)、下(80)、左(75)、右(77)
  * - WASD键：W(上)、S(下)、A(左)、D(右)（不区分大小写）
  * - 退出键：ESC(27)、Q（不区分大小写）
+ * - 缩放键：Z（不区分大小写），在正常显示和缩小显示之间切换
  *
- * @note 输入缓冲机制：只允许垂直于当前方向的新方向（防止蛇直接反向移动）
+ * @note 输入缓冲机制：只允许垂直于当前方向的新方向（防止蛇直接反向移动），见turn_snake
  * @return true 继续游戏
  * @return false 退出游戏（用户按Q或ESC）
  */
-static bool handle_input(void)
+static bool handle_input(GameContext *ctx)
 {
+    GameState *game = &ctx->game;
+
     if (_kbhit())
     {
         int ch = _getch();
@@ -919,20 +1161,16 @@ static bool handle_input(void)
             switch (ch)
             {
             case 72: ///< 上箭头
-                if (game.snake.direction != DIR_DOWN)
-                    game.snake.next_direction = DIR_UP;
+                steer(ctx, DIR_UP);
                 break;
             case 80: ///< 下箭头
-                if (game.snake.direction != DIR_UP)
-                    game.snake.next_direction = DIR_DOWN;
+                steer(ctx, DIR_DOWN);
                 break;
             case 75: ///< 左箭头
-                if (game.snake.direction != DIR_RIGHT)
-                    game.snake.next_direction = DIR_LEFT;
+                steer(ctx, DIR_LEFT);
                 break;
             case 77: ///< 右箭头
-                if (game.snake.direction != DIR_LEFT)
-                    game.snake.next_direction = DIR_RIGHT;
+                steer(ctx, DIR_RIGHT);
                 break;
             }
         }
@@ -943,33 +1181,45 @@ static bool handle_input(void)
             {
             case 'w':
             case 'W':
-                if (game.snake.direction != DIR_DOWN)
-                    game.snake.next_direction = DIR_UP;
+                steer(ctx, DIR_UP);
                 break;
             case 's':
             case 'S':
-                if (game.snake.direction != DIR_UP)
-                    game.snake.next_direction = DIR_DOWN;
+                steer(ctx, DIR_DOWN);
                 break;
             case 'a':
             case 'A':
-                if (game.snake.direction != DIR_RIGHT)
-                    game.snake.next_direction = DIR_LEFT;
+                steer(ctx, DIR_LEFT);
                 break;
             case 'd':
             case 'D':
-                if (game.snake.direction != DIR_LEFT)
-                    game.snake.next_direction = DIR_RIGHT;
+                steer(ctx, DIR_RIGHT);
                 break;
             case ' ':
             case 'p':
             case 'P':
                 // 切换暂停状态（只有在游戏未结束时）
-                if (!game.game_over)
+                if (!game->game_over)
                 {
-                    game.paused = !game.paused;
+                    game->paused = !game->paused;
                 }
                 break;
+            case 'k':
+            case 'K':
+                // 保存当前游戏（游戏结束后不再保存）
+                if (!game->game_over)
+                {
+                    bool saved = save_game(ctx, SAVE_FILE_NAME) == SAVE_OK;
+                    printf_at(console_width / 2 + 9, GAME_AREA_Y + 12,
+                              saved ? FOREGROUND_GREEN | FOREGROUND_INTENSITY : FOREGROUND_RED | FOREGROUND_INTENSITY,
+                              saved ? L"已保存: snake_save.dat" : L"保存失败            ");
+                }
+                break;
+            case 'z':
+            case 'Z':
+                // 切换缩小显示（下一帧重绘整个视口）
+                camera_toggle_zoom(&camera);
+                break;
             case 'q':
             case 'Q':
             case 27:          // ESC
@@ -981,6 +1231,49 @@ static bool handle_input(void)
     return true; // 继续游戏
 }
 
+/**
+ * @brief 阻塞等待按键（不定期唤醒）
+ *
+ * 用于暂停、开始界面和游戏结束界面：线程在控制台输入句柄上睡眠，按键到达时立即返回，
+ * 之后的_getch()不会阻塞。
+ *
+ * 控制台输入句柄在缓冲区中有任何输入事件时都处于有信号状态，包括不产生字符的按键抬起、
+ * 修饰键、鼠标、焦点和窗口大小事件。这些事件不会被_getch()取走，必须在这里丢弃，
+ * 否则WaitForSingleObject会立即返回而变成忙等。
+ */
+static void wait_for_key(void)
+{
+    if (hInput == NULL || hInput == INVALID_HANDLE_VALUE)
+    {
+        return; // 没有控制台输入（例如被重定向），由调用方的_getch()阻塞
+    }
+
+    for (;;)
+    {
+        // 先取得当前缓冲区中的事件，再检查按键：如果_kbhit()仍为false，
+        // 说明这些事件都不会产生字符，可以安全地丢弃（之后到达的按键排在它们后面）
+        INPUT_RECORD records[32];
+        DWORD count = 0;
+        if (!PeekConsoleInputW(hInput, records, 32, &count))
+        {
+            return;
+        }
+        if (_kbhit())
+        {
+            return;
+        }
+        if (count > 0)
+        {
+            ReadConsoleInputW(hInput, records, count, &count);
+            continue; // 缓冲区中可能还有超过32个事件
+        }
+        if (WaitForSingleObject(hInput, INFINITE) != WAIT_OBJECT_0)
+        {
+            return;
+        }
+    }
+}
+
 // =============================================
 // 游戏重置函数
 // =============================================
@@ -988,21 +1281,30 @@ static bool handle_input(void)
 /**
  * 加载最高分
  *
- * 功能：从文件中读取最高分记录，如果文件不存在则创建并初始化为0。
+ * 功能：从文件中读取最高分记录，如果文件不存在则最高分为0（文件在第一次打破记录时创建）。
+ * 每个进程只读取一次，并且推迟到第一帧画出之后：启动时不做任何文件读写。
+ * 之后最高分只在内存中更新（重玩不会改变game.highest_score）。
  */
-static void load_highest_score(void)
+static void load_highest_score(GameContext *ctx)
 {
+    GameState *game = &ctx->game;
+
+    if (highest_score_loaded)
+    {
+        return;
+    }
+    highest_score_loaded = true;
+
     FILE *file = fopen("snake_highest_score.dat", "rb");
     if (file != NULL)
     {
-        fread(&game.highest_score, sizeof(int), 1, file);
+        fread(&game->highest_score, sizeof(int), 1, file);
         fclose(file);
     }
     else
     {
         // 文件不存在，初始化最高分为0
-        game.highest_score = 0;
-        save_highest_score(); // 保存初始文件
+        game->highest_score = 0;
     }
 }
 
@@ -1011,12 +1313,14 @@ static void load_highest_score(void)
  *
  * 功能：将当前最高分保存到文件中，以便下次游戏加载。
  */
-static void save_highest_score(void)
+static void save_highest_score(GameContext *ctx)
 {
+    GameState *game = &ctx->game;
+
     FILE *file = fopen("snake_highest_score.dat", "wb");
     if (file != NULL)
     {
-        fwrite(&game.highest_score, sizeof(int), 1, file);
+        fwrite(&game->highest_score, sizeof(int), 1, file);
         fclose(file);
     }
 }
@@ -1026,12 +1330,39 @@ static void save_highest_score(void)
  *
  * 功能：检查当前得分是否超过最高分，如果是则更新最高分并保存到文件。
  */
-static void update_highest_score(void)
+static void update_highest_score(GameContext *ctx)
 {
-    if (game.score > game.highest_score)
+    GameState *game = &ctx->game;
+
+    if (game->score > game->highest_score)
     {
-        game.highest_score = game.score;
-        save_highest_score();
+        game->highest_score = game->score;
+        save_highest_score(ctx);
+    }
+}
+
+/**
+ * 开始新的一局
+ *
+ * 功能：以当前时间为种子初始化游戏状态。
+ * 首次启动和重玩都通过此函数开始新的一局。指定了--load时第一局从存档继续。
+ * 最高分记录不在这里读取，见load_highest_score。
+ */
+static void start_game(GameContext *ctx)
+{
+    // 重新初始化随机数种子（每次重玩都应该重新种子；指定种子时第i局使用seed + i，可复现）
+    static uint64_t games_started = 0;
+    uint64_t seed = options.seed_given ? options.seed + games_started : (uint64_t)time(NULL) + 325u;
+    bool loaded = games_started == 0 && options.load != NULL &&
+                  load_game(ctx, options.load, SAVE_VERIFY_POOL) == SAVE_OK;
+    games_started++;
+    if (!loaded)
+    {
+        init_game_state(ctx, seed);
+    }
+    else if (options.seed_given)
+    {
+        seed_game_random(ctx, seed); // 从存档继续，但之后的食物位置由指定的种子决定
     }
 }
 
@@ -1040,11 +1371,12 @@ static void update_highest_score(void)
  *
  * 功能：重置游戏状态到初始状态，但不重新初始化控制台。
  * 用于在游戏结束后重新开始游戏，保持相同的控制台环境。
+ * 上一局的单局内存区域在init_game_state中一次性释放。
  */
-static void reset_game(void)
+static void reset_game(GameContext *ctx)
 {
     // 重置游戏状态但不重新初始化控制台
-    init_game_state();
+    start_game(ctx);
 
     // 重置UI状态
     ui_initialized = false;
@@ -1054,6 +1386,269 @@ static void reset_game(void)
     last_highest_score = -1;
 }
 
+// =============================================
+// 命令行和无界面模式
+// =============================================
+
+/**
+ * @brief 解析命令行参数
+ *
+ * 未知参数或参数值非法时向stderr输出用法并返回false。
+ *
+ * @param argc 参数个数
+ * @param argv 参数数组
+ * @param options 输出：解析结果
+ * @return true 解析成功
+ */
+static bool parse_options(int argc, char **argv, LaunchOptions *options)
+{
+    options->headless = false;
+    options->ticks = HEADLESS_DEFAULT_TICKS;
+    options->seed = 0;
+    options->seed_given = false;
+    options->ai = NULL;
+    options->ai_name = NULL;
+    options->board_width = GAME_WIDTH;
+    options->board_height = GAME_HEIGHT;
+    options->games = HEADLESS_DEFAULT_GAMES;
+    options->load = NULL;
+    options->rollouts = 0;
+    options->weights = NULL;
+    options->fast_start = false;
+    options->latency_keys = 0;
+    default_ruleset(&options->rules);
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--headless") == 0)
+        {
+            options->headless = true;
+            continue;
+        }
+        if (strcmp(arg, "--fast-start") == 0)
+        {
+            options->fast_start = true;
+            continue;
+        }
+        if (value == NULL)
+        {
+            ok = false;
+            break;
+        }
+
+        if (strcmp(arg, "--ticks") == 0)
+        {
+            ok = sscanf(value, "%lld", &options->ticks) == 1 && options->ticks > 0;
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            unsigned long long seed;
+            ok = sscanf(value, "%llu", &seed) == 1;
+            options->seed = (uint64_t)seed;
+            options->seed_given = true;
+        }
+        else if (strcmp(arg, "--games") == 0)
+        {
+            ok = sscanf(value, "%d", &options->games) == 1 && options->games > 0;
+        }
+        else if (strcmp(arg, "--board") == 0)
+        {
+            ok = sscanf(value, "%dx%d", &options->board_width, &options->board_height) == 2 &&
+                 options->board_width >= 3 && options->board_height >= 3;
+        }
+        else if (strcmp(arg, "--rollouts") == 0)
+        {
+            ok = sscanf(value, "%d", &options->rollouts) == 1 && options->rollouts > 0;
+        }
+        else if (strcmp(arg, "--latency") == 0)
+        {
+            ok = sscanf(value, "%d", &options->latency_keys) == 1 && options->latency_keys > 0 &&
+                 options->latency_keys <= LATENCY_MAX_KEYS;
+            options->fast_start = true; // 无人值守：跳过开始界面
+        }
+        else if (strcmp(arg, "--load") == 0)
+        {
+            options->load = value;
+        }
+        else if (strcmp(arg, "--weights") == 0)
+        {
+            options->weights = value;
+        }
+        else if (strcmp(arg, "--rules") == 0)
+        {
+            char error[RULES_MAX_LINE * 2];
+            if (!load_ruleset(value, &options->rules, error, sizeof(error)))
+            {
+                fprintf(stderr, "%s\n", error);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--ai") == 0)
+        {
+            options->ai = ai_policy_from_name(value);
+            options->ai_name = value;
+            ok = options->ai != NULL;
+        }
+        else
+        {
+            ok = false;
+        }
+        i++;
+    }
+
+    // 游戏区域尺寸和布局（是否穿墙）由存档决定
+    if (ok && options->load != NULL)
+    {
+        SaveHeader header;
+        SaveStatus status = read_save_header(options->load, &header);
+        if (status != SAVE_OK)
+        {
+            fprintf(stderr, "无法加载存档%s: %s\n", options->load, save_status_message(status));
+            return false;
+        }
+        options->board_width = header.pool_width - (header.torus ? 0 : 2);
+        options->board_height = header.pool_height - (header.torus ? 0 : 2);
+        options->rules = header.rules; // 存档中的规则优先于--rules
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr,
+                "用法: Snake [--headless] [--ticks N] [--seed S] [--ai %s] [--board WxH] [--games N] [--load FILE] [--rollouts N] [--weights FILE] [--rules FILE] [--fast-start] [--latency N]\n",
+                ai_policy_names());
+    }
+
+    if (options->headless && options->ai == NULL)
+    {
+        options->ai = ai_greedy;
+        options->ai_name = "greedy";
+    }
+
+    // 固定推演次数时MCTS的结果与运行速度无关，可复现
+    if (options->ai == ai_mcts)
+    {
+        MctsConfig config;
+        mcts_default_config(&config);
+        config.rollouts = options->rollouts;
+        ai_mcts_configure(&config);
+    }
+
+    // 权重文件在开局前加载，失败时不开始游戏
+    if (ok && options->ai == ai_nn)
+    {
+        NnStatus status;
+        if (!ai_nn_configure(options->weights, &status))
+        {
+            fprintf(stderr, "无法加载权重文件%s: %s\n", options->weights != NULL ? options->weights : "（内置）",
+                    nn_status_message(status));
+            return false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief 无界面快进模式
+ *
+ * 不初始化控制台、不等待按键、不休眠，连续运行options->games局，
+ * 每局在游戏结束或达到options->ticks帧后停止，最后向stdout输出统计信息。
+ * 输出中的校验和由每局的帧数和得分计算，相同参数下必须不变，可用于回归检查。
+ * 指定了--load时每局都从同一个存档开始（第g局的随机数种子为seed + g）。
+ * 不读写最高分文件。统计信息的最后一行是启动用时（进程创建到算完第一帧，见StartupPhase）。
+ *
+ * @param ctx 游戏上下文（已初始化）
+ * @param options 命令行参数
+ * @return int 程序退出码
+ */
+static int run_headless(GameContext *ctx, const LaunchOptions *options)
+{
+    GameState *game = &ctx->game;
+    uint64_t seed = options->seed_given ? options->seed : (uint64_t)time(NULL) + 325u;
+
+    long long total_ticks = 0;
+    long long total_score = 0;
+    int min_score = -1, max_score = 0, max_length = 0, capped_games = 0;
+    uint64_t checksum = 0xcbf29ce484222325ull; // FNV-1a
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    for (int g = 0; g < options->games; g++)
+    {
+        if (options->load == NULL)
+        {
+            init_game_state(ctx, seed + (uint64_t)g);
+        }
+        else
+        {
+            // 只有第一局校验整个游戏池，之后每局直接重新映射
+            SaveStatus status = load_game(ctx, options->load, g == 0 ? SAVE_VERIFY_POOL : 0);
+            if (status != SAVE_OK)
+            {
+                fprintf(stderr, "无法加载存档%s: %s\n", options->load, save_status_message(status));
+                return 1;
+            }
+            seed_game_random(ctx, seed + (uint64_t)g);
+        }
+
+        long long ticks = 0;
+        while (!game->game_over && ticks < options->ticks)
+        {
+            turn_snake(ctx, options->ai(ctx));
+#ifndef NDEBUG
+            size_t heap_allocs_before = heap_alloc_count;
+#endif
+            update_game(ctx);
+            assert(heap_alloc_count == heap_allocs_before); // 每帧零堆分配
+            ticks++;
+            if (g == 0 && ticks == 1)
+            {
+                startup_phase_done(STARTUP_FIRST_FRAME);
+            }
+        }
+
+        total_ticks += ticks;
+        total_score += game->score;
+        capped_games += !game->game_over;
+        if (min_score < 0 || game->score < min_score)
+            min_score = game->score;
+        if (game->score > max_score)
+            max_score = game->score;
+        if (game->snake.length > max_length)
+            max_length = game->snake.length;
+
+        checksum = (checksum ^ (uint64_t)ticks) * 0x100000001b3ull;
+        checksum = (checksum ^ (uint64_t)game->score) * 0x100000001b3ull;
+    }
+
+    QueryPerformanceCounter(&end);
+    double seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+
+    SetConsoleOutputCP(CP_UTF8);
+    printf("策略:     %s，游戏区域 %dx%d，种子 %llu\n",
+           options->ai_name, options->board_width, options->board_height, (unsigned long long)seed);
+    printf("局数:     %d（%d 局达到 %lld 帧上限）\n", options->games, capped_games, options->ticks);
+    printf("帧数:     %lld，用时 %.3f 秒，%.0f 帧/秒\n",
+           total_ticks, seconds, seconds > 0 ? (double)total_ticks / seconds : 0.0);
+    printf("得分:     平均 %.1f，最低 %d，最高 %d，最长 %d\n",
+           (double)total_score / options->games, min_score, max_score, max_length);
+    printf("校验和:   %016llx\n", (unsigned long long)checksum);
+    print_startup_times();
+    if (options->ai == ai_mcts)
+    {
+        MctsStats stats = ai_mcts_stats();
+        printf("推演:     %lld 次，%.0f 次/秒，平均每步 %.0f 次，最长决策 %.1f ms\n", stats.rollouts,
+               stats.seconds > 0 ? (double)stats.rollouts / stats.seconds : 0.0,
+               stats.decisions > 0 ? (double)stats.rollouts / (double)stats.decisions : 0.0, stats.max_seconds * 1000.0);
+    }
+    return 0;
+}
+
 // =============================================
 // 主函数
 // =============================================
@@ -1064,10 +1659,11 @@ static void reset_game(void)
  * 控制游戏的整体流程，负责初始化、游戏循环和重玩功能管理。
  *
  * 程序流程：
- * 1. 初始化控制台环境
+ * 0. 解析命令行参数，无界面模式下直接运行并输出统计信息
+ * 1. 初始化控制台环境和游戏上下文（唯一的堆分配）
  * 2. 初始化游戏状态（包括随机数种子）
- * 3. 显示开始界面（标题和提示信息）
- * 4. 等待用户按任意键开始游戏
+ * 3. 显示开始界面（标题和提示信息），这是第一帧，之后才读取最高分文件
+ * 4. 等待用户按任意键开始游戏（快速启动时跳过3、4，直接画出游戏画面）
  * 5. 游戏主循环（处理输入、更新游戏状态、绘制界面）
  * 6. 游戏结束后显示最终得分和重玩选项
  * 7. 等待用户选择重玩（R键）或退出（Q键）
@@ -1075,69 +1671,178 @@ static void reset_game(void)
  * @note 支持无限次重玩，每次重玩都会重新初始化游戏状态。
  * @return int 程序退出码（0表示正常退出）
  */
-int main()
+int main(int argc, char **argv)
 {
     bool play_again = true;
+    GameContext *ctx = &context;
+    GameState *game = &ctx->game;
+
+    startup_begin();
+    if (!parse_options(argc, argv, &options))
+    {
+        return 2;
+    }
+    startup_phase_done(STARTUP_OPTIONS);
+
+    // 初始化游戏上下文（申请内存区域）
+    if (!init_game_context(ctx, options.board_width, options.board_height))
+    {
+        if (options.headless)
+        {
+            fprintf(stderr, "内存不足，无法创建%dx%d的游戏\n", options.board_width, options.board_height);
+            return 1;
+        }
+        MessageBoxW(NULL, L"内存不足，无法创建游戏", L"错误", MB_OK | MB_ICONERROR);
+        return 1;
+    }
+    if (!apply_ruleset(ctx, &options.rules))
+    {
+        fprintf(stderr, "穿墙规则要求游戏区域至少为%dx%d\n", TORUS_MIN_SIZE, TORUS_MIN_SIZE);
+        destroy_game_context(ctx);
+        return 2;
+    }
+    startup_phase_done(STARTUP_CONTEXT);
+
+    if (options.headless)
+    {
+        int status = run_headless(ctx, &options);
+        ai_mcts_release();
+        ai_nn_release();
+        destroy_game_context(ctx);
+        return status;
+    }
 
     // 初始化控制台
     init_console();
+    camera_init(&camera, VIEW_WIDTH, VIEW_HEIGHT);
+    startup_phase_done(STARTUP_CONSOLE);
 
     // 初始化游戏状态（包括随机数种子）
-    init_game_state();
-
-    // 显示开始界面
-    clear_screen();
-    printf_at(console_width / 2 - GAME_TITLE_LENGTH / 2, console_height / 2 - 6,
-              FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-              GAME_TITLE);
-    printf_at(console_width / 2 - 5, console_height / 2 - 3,
-              FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
-              L"按任意键开始游戏...");
-    _getch();
+    start_game(ctx);
+
+    if (options.fast_start)
+    {
+        // 快速启动：第一帧就是游戏画面
+        draw_game(ctx);
+        startup_phase_done(STARTUP_FIRST_FRAME);
+        draw_startup_time();
+        load_highest_score(ctx); // 第一帧之后再读文件，下一帧显示
+        if (options.latency_keys > 0)
+        {
+            latency_start(options.seed_given ? options.seed : (uint64_t)time(NULL));
+        }
+    }
+    else
+    {
+        // 显示开始界面（第一帧）
+        clear_screen();
+        printf_at(console_width / 2 - GAME_TITLE_LENGTH / 2, console_height / 2 - 6,
+                  FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+                  GAME_TITLE);
+        printf_at(console_width / 2 - 5, console_height / 2 - 3,
+                  FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
+                  L"按任意键开始游戏...");
+        startup_phase_done(STARTUP_FIRST_FRAME);
+        load_highest_score(ctx); // 等待按键期间读文件，不推迟第一帧
+        _getch();
+    }
 
     while (play_again)
     {
         // 游戏主循环
-        while (!game.game_over && handle_input())
+        while (!game->game_over && handle_input(ctx))
         {
-            if (!game.paused)
+            if (!game->paused)
+            {
+                // 自动演示：策略代替键盘选择方向
+                if (options.ai != NULL)
+                {
+                    turn_snake(ctx, options.ai(ctx));
+                }
+#ifndef NDEBUG
+                size_t heap_allocs_before = heap_alloc_count;
+#endif
+                Direction before = game->snake.direction;
+                update_game(ctx);
+                assert(heap_alloc_count == heap_allocs_before); // 每帧零堆分配
+                if (options.latency_keys > 0)
+                {
+                    latency_tick_done(ctx, before);
+                }
+
+                // 游戏结束时更新最高分（引擎不做文件读写）
+                if (game->game_over)
+                {
+                    update_highest_score(ctx);
+                }
+            }
+            draw_game(ctx);
+            if (options.latency_keys > 0)
             {
-                update_game();
+                latency_frame_presented();
             }
-            draw_game();
 
-            // 控制游戏速度（暂停时使用较短的延迟以减少CPU占用）
-            Sleep(game.paused ? 50 : game.speed);
+            // 控制游戏速度（延迟测量模式同样按当前速度，报告的每帧时长即测量时实际生效的速度）；
+            // 暂停时没有任何东西需要更新，阻塞到下一次按键
+            if (game->paused)
+            {
+                wait_for_key();
+            }
+            else
+            {
+                Sleep(game->speed);
+            }
+        }
+
+        // 延迟测量模式：游戏结束后立即重玩，注入线程最后注入的Q键结束测量
+        if (options.latency_keys > 0)
+        {
+            if (game->game_over)
+            {
+                reset_game(ctx);
+            }
+            else
+            {
+                play_again = false;
+            }
+            continue;
         }
 
         // 显示最终画面（包含游戏结束信息）
-        draw_game();
+        draw_game(ctx);
 
         // 等待用户选择重玩或退出
         bool choice_made = false;
         while (!choice_made)
         {
-            if (_kbhit())
+            wait_for_key(); // 阻塞到按键，不定期唤醒
+            int ch = _getch();
+            if (ch == 'r' || ch == 'R')
             {
-                int ch = _getch();
-                if (ch == 'r' || ch == 'R')
-                {
-                    // 重玩游戏
-                    reset_game();
-                    choice_made = true;
-                    // play_again保持true，继续外层循环
-                }
-                else if (ch == 'q' || ch == 'Q' || ch == 27) // Q键或ESC
-                {
-                    // 退出游戏
-                    play_again = false;
-                    choice_made = true;
-                }
-                // 其他按键忽略
+                // 重玩游戏
+                reset_game(ctx);
+                choice_made = true;
+                // play_again保持true，继续外层循环
+            }
+            else if (ch == 'q' || ch == 'Q' || ch == 27) // Q键或ESC
+            {
+                // 退出游戏
+                play_again = false;
+                choice_made = true;
             }
-            Sleep(50); // 短暂休眠，减少CPU占用
+            // 其他按键忽略
         }
     }
 
+    if (options.latency_keys > 0)
+    {
+        clear_screen();
+        print_latency_report(ctx);
+    }
+
+    ai_mcts_release();
+    ai_nn_release();
+    frame_destroy(&frame);
+    destroy_game_context(ctx);
     return 0;
 }
@@ -0,0 +1,162 @@
+/**
+ * @file snake_ai.c
+ * @brief 贪吃蛇自动控制策略实现
+ *
+ * 编码: UTF-8
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_ai.h"
+#include "snake_mcts.h"
+#include "snake_nn.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+static const Direction opposite[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT}; ///< 各方向的反方向
+
+/**
+ * @struct AiPolicyEntry
+ * @brief 策略注册表项
+ */
+typedef struct
+{
+    const char *name; ///< 策略名称（命令行--ai参数）
+    AiPolicy policy;  ///< 策略函数
+} AiPolicyEntry;
+
+static const AiPolicyEntry policies[] = {
+    {"random", ai_random},
+    {"greedy", ai_greedy},
+    {"mcts", ai_mcts},
+    {"nn", ai_nn},
+};
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 判断蛇头朝某个方向移动一步是否安全（不会立即撞墙或撞到自己）
+ */
+static bool is_safe_move(const GameContext *ctx, Direction dir)
+{
+    Position next = neighbor_position(ctx, ctx->game.snake.head, dir);
+    CellType cell = get_cell_type(ctx, next);
+    return cell == CELL_EMPTY || cell == CELL_FOOD;
+}
+
+// =============================================
+// 策略注册表
+// =============================================
+
+/**
+ * @brief 按名称查找策略
+ *
+ * @param name 策略名称
+ * @return AiPolicy 策略函数，名称未知时返回NULL
+ */
+AiPolicy ai_policy_from_name(const char *name)
+{
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++)
+    {
+        if (strcmp(policies[i].name, name) == 0)
+        {
+            return policies[i].policy;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 获取所有策略名称（用于命令行帮助）
+ *
+ * @return const char* 以"|"分隔的策略名称
+ */
+const char *ai_policy_names(void)
+{
+    return "random|greedy|mcts|nn";
+}
+
+// =============================================
+// 策略实现
+// =============================================
+
+/**
+ * @brief 随机策略：在不会立即死亡的方向中随机选择
+ *
+ * 没有安全方向时保持当前方向（游戏在下一帧结束）。
+ */
+Direction ai_random(GameContext *ctx)
+{
+    Direction current = ctx->game.snake.direction;
+    Direction safe[4];
+    int safe_count = 0;
+
+    for (int d = DIR_UP; d <= DIR_RIGHT; d++)
+    {
+        if ((Direction)d != opposite[current] && is_safe_move(ctx, (Direction)d))
+        {
+            safe[safe_count++] = (Direction)d;
+        }
+    }
+
+    if (safe_count == 0)
+    {
+        return current;
+    }
+    return safe[game_random(ctx) % (uint32_t)safe_count];
+}
+
+/**
+ * @brief 贪心策略：在不会把自己困住的方向中选择离食物曼哈顿距离最近的方向
+ *
+ * 走进去之后的可达区域能容纳整条蛇才算不会困住（可达区域大小为O(1)查询）；
+ * 所有方向都会困住时选择可达区域最大的方向，尽量拖延。
+ * 距离相同时优先保持当前方向，减少无谓的转弯。
+ */
+Direction ai_greedy(GameContext *ctx)
+{
+    const GameState *game = &ctx->game;
+    Direction current = game->snake.direction;
+    Direction best = current;
+    int best_distance = -1;
+    Direction roomiest = current;
+    int roomiest_area = 0;
+    Position target = game->food;
+    food_nearest(ctx, game->snake.head, &target);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // 从当前方向开始检查，距离相同时当前方向胜出
+        Direction d = (Direction)((current + i) % 4);
+        if (d == opposite[current] || !is_safe_move(ctx, d))
+        {
+            continue;
+        }
+
+        Position next = neighbor_position(ctx, game->snake.head, d);
+        int area = reach_region_size(ctx, next);
+        if (area > roomiest_area)
+        {
+            roomiest = d;
+            roomiest_area = area;
+        }
+        if (area < game->snake.length)
+        {
+            continue;
+        }
+
+        int distance = cell_distance(ctx, target, next);
+        if (best_distance < 0 || distance < best_distance)
+        {
+            best = d;
+            best_distance = distance;
+        }
+    }
+
+    return best_distance >= 0 ? best : roomiest;
+}
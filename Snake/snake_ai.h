@@ -0,0 +1,33 @@
+/**
+ * @file snake_ai.h
+ * @brief 贪吃蛇自动控制策略
+ *
+ * 策略根据当前游戏上下文选择下一步方向，调用方再通过turn_snake提交。
+ * 策略只读取游戏池，不做任何输入输出，可用于控制台自动演示和无界面批量运行。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_AI_H
+#define SNAKE_AI_H
+
+#include "snake_core.h"
+
+/**
+ * @brief 策略函数：返回下一步希望的方向
+ *
+ * 随机性一律来自game_random(ctx)，同一种子下的整局游戏可以完全复现。
+ */
+typedef Direction (*AiPolicy)(GameContext *ctx);
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+AiPolicy ai_policy_from_name(const char *name);
+const char *ai_policy_names(void);
+
+Direction ai_random(GameContext *ctx);
+Direction ai_greedy(GameContext *ctx);
+
+#endif // SNAKE_AI_H
@@ -0,0 +1,1076 @@
+/**
+ * @file snake_analyze.c
+ * @brief 录像分析工具：并行重新模拟一个目录中的全部录像并汇总统计
+ *
+ * 目录中每个*.snakerpl文件只读映射，先顺序扫描记录头建立索引（不读取方向），
+ * 再由线程池按记录分片重新模拟。每个线程只写自己的累加器（热力图、吃到食物的间隔直方图、结束原因计数），
+ * 全部完成后合并，模拟过程中线程之间不共享任何可写数据。统计内容：
+ * - 访问热力图：每帧蛇头所在单元格的计数，以及每局结束时蛇头所在的单元格
+ * - 吃到食物的间隔：从开局或上一次吃到食物起，到下一次吃到食物经过的帧数
+ * - 结束原因：撞墙、撞到自身、放满（没有空单元格放置食物）、录制时未结束
+ * - 校验：重新模拟的最终得分和结束原因必须与录制时一致（规则或引擎改变后可据此发现不兼容的录像）
+ *
+ * 热力图按对数刻度着色，通过控制台单元格渲染器（snake_render.h的字形和帧缓冲）输出ANSI彩色文本；
+ * 只统计与第一局游戏池尺寸和布局相同的录像。另可输出CSV供其他工具绘图。
+ *
+ * 用法: snake_analyze DIR [--threads N] [--parallel serial|openmp|spin] [--csv PREFIX] [--no-heatmap]
+ *       snake_analyze DIR --generate GAMES [--files K] [--ai NAME] [--weights FILE] [--board WxH]
+ *                         [--rules FILE] [--seed S] [--ticks N] [--threads N]
+ *
+ * --generate由自动策略对局并录制到DIR（不存在时创建），分成K个文件，用于生成测试数据和测量吞吐量。
+ *
+ * 编码: UTF-8
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "snake_ai.h"
+#include "snake_core.h"
+#include "snake_mcts.h"
+#include "snake_nn.h"
+#include "snake_parallel.h"
+#include "snake_render.h"
+#include "snake_replay.h"
+#include "snake_rules.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define ANALYZE_MAX_PATH 1024          ///< 文件路径的最大长度
+#define ANALYZE_DEFAULT_FILES 16       ///< --generate默认的文件数
+#define ANALYZE_DEFAULT_TICKS 100000   ///< --generate每局的最大帧数
+#define LATENCY_BUCKETS 1024           ///< 吃到食物间隔直方图的桶数（每桶1帧，最后一桶包含所有更长的间隔）
+#define DEATH_CAUSES (DEATH_BOARD_FULL + 1) ///< 结束原因数（DEATH_NONE表示录制时未结束）
+#define HEAT_LEVELS 7                  ///< 热力图的颜色级数（0级表示没有访问）
+
+/**
+ * @struct AnalyzeOptions
+ * @brief 命令行参数
+ */
+typedef struct
+{
+    const char *directory; ///< 录像目录
+    int threads;           ///< 线程数（0表示全部逻辑CPU）
+    ParallelMode mode;     ///< 并行方式
+    const char *csv;       ///< CSV输出文件名前缀（NULL表示不输出）
+    bool heatmap;          ///< 是否输出彩色热力图
+    long long generate;    ///< 生成的局数（0表示分析）
+    int files;             ///< 生成的文件数
+    AiPolicy ai;           ///< 生成时使用的自动策略
+    const char *weights;   ///< 神经网络策略的权重文件（NULL表示内置权重）
+    int board_width;       ///< 生成时的游戏区域宽度
+    int board_height;      ///< 生成时的游戏区域高度
+    Ruleset rules;         ///< 生成时的游戏规则
+    uint64_t seed;         ///< 生成时第一局的随机数种子（第i局使用seed + i）
+    long long ticks;       ///< 生成时每局的最大帧数
+} AnalyzeOptions;
+
+/**
+ * @struct ReplayRef
+ * @brief 录像索引项：第几个文件的哪个偏移处
+ */
+typedef struct
+{
+    int file;      ///< 文件下标
+    size_t offset; ///< 记录在文件中的偏移
+} ReplayRef;
+
+/**
+ * @struct HeatShape
+ * @brief 热力图对应的游戏池尺寸和布局（取自第一局）
+ */
+typedef struct
+{
+    int pool_width;  ///< 游戏池宽度（包括边框，环面布局没有边框）
+    int pool_height; ///< 游戏池高度
+    bool torus;      ///< 环面布局
+} HeatShape;
+
+/**
+ * @struct Worker
+ * @brief 线程私有的模拟上下文和累加器（每个线程单独分配，累加时不会与其他线程共享缓存行）
+ */
+typedef struct
+{
+    GameContext ctx;                   ///< 重新模拟用的游戏上下文
+    bool ready;                        ///< ctx是否已初始化
+    ReplayRecorder recorder;           ///< 录制器（--generate）
+    uint64_t *visits;                  ///< 热力图：每个单元格作为蛇头的帧数
+    uint64_t *ends;                    ///< 每个单元格作为结束时蛇头位置的局数
+    uint64_t latency[LATENCY_BUCKETS]; ///< 吃到食物间隔直方图
+    uint64_t deaths[DEATH_CAUSES];     ///< 各结束原因的局数
+    uint64_t games;                    ///< 局数
+    uint64_t ticks;                    ///< 帧数
+    uint64_t foods;                    ///< 吃到的食物数
+    uint64_t score;                    ///< 得分合计
+    uint64_t mismatches;               ///< 最终得分或结束原因与录制时不一致的局数
+    uint64_t off_shape;                ///< 游戏池尺寸或布局与热力图不同的局数（不计入热力图）
+    uint64_t errors;                   ///< 记录不合法或内存不足而跳过的局数
+} Worker;
+
+/**
+ * @struct AnalyzeTask
+ * @brief 并行任务参数
+ */
+typedef struct
+{
+    const ReplayFile *files; ///< 映射的录像文件
+    const ReplayRef *refs;   ///< 录像索引
+    HeatShape shape;         ///< 热力图的游戏池尺寸和布局
+    char **paths;            ///< --generate：各文件路径
+    long long per_file;      ///< --generate：每个文件的局数（最后一个文件可能更少）
+} AnalyzeTask;
+
+// =============================================
+// 全局变量
+// =============================================
+
+static AnalyzeOptions options; ///< 命令行参数
+static Worker **workers;       ///< 线程私有数据（线程池每个线程一个）
+static int worker_count;       ///< 线程数
+
+/**
+ * @brief 热力图各级的字形（两个空格，背景色由冷到热）
+ */
+static const CellGlyph heat_glyphs[HEAT_LEVELS] = {
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_FG_RED | ATTR_FG_GREEN | ATTR_FG_BLUE},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_BLUE},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_BLUE | ATTR_BG_GREEN},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_GREEN},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_RED | ATTR_BG_GREEN},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_RED},
+    {{0x0020, 0x0020}, 2, "  ", 2, ATTR_BG_RED | ATTR_BG_INTENSITY},
+};
+
+static const char *const death_names[DEATH_CAUSES] = {"未结束", "撞墙", "撞到自身", "放满"};          ///< 结束原因名称
+static const char *const death_keys[DEATH_CAUSES] = {"unfinished", "wall", "self", "board_full"}; ///< 结束原因（CSV）
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 获取单调时间（秒）
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief 比较两个字符串指针（qsort，文件按名称排序使结果与目录遍历顺序无关）
+ */
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief 文件名是否以录像扩展名结尾
+ */
+static bool has_replay_extension(const char *name)
+{
+    size_t length = strlen(name);
+    size_t extension = strlen(REPLAY_FILE_EXTENSION);
+    return length > extension && strcmp(name + length - extension, REPLAY_FILE_EXTENSION) == 0;
+}
+
+/**
+ * @brief 列出目录中的录像文件（按名称排序）
+ *
+ * @param directory 目录
+ * @param count 输出：文件数
+ * @return char** 路径数组（每项和数组本身都需要free），失败返回NULL
+ */
+static char **list_replays(const char *directory, int *count)
+{
+    int capacity = 16;
+    char **paths = (char **)heap_alloc((size_t)capacity * sizeof(char *));
+    *count = 0;
+    if (paths == NULL)
+    {
+        return NULL;
+    }
+
+#ifdef _WIN32
+    char pattern[ANALYZE_MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*%s", directory, REPLAY_FILE_EXTENSION);
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(pattern, &entry);
+    bool more = find != INVALID_HANDLE_VALUE;
+    if (!more && GetLastError() != ERROR_FILE_NOT_FOUND)
+    {
+        free(paths);
+        return NULL;
+    }
+    for (; more; more = FindNextFileA(find, &entry) != 0)
+    {
+        const char *name = entry.cFileName;
+        if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 || !has_replay_extension(name))
+        {
+            continue;
+        }
+#else
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+    {
+        free(paths);
+        return NULL;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        const char *name = entry->d_name;
+        if (!has_replay_extension(name))
+        {
+            continue;
+        }
+#endif
+        if (*count == capacity)
+        {
+            char **grown = (char **)heap_alloc((size_t)capacity * 2 * sizeof(char *));
+            if (grown == NULL)
+            {
+                break;
+            }
+            memcpy(grown, paths, (size_t)capacity * sizeof(char *));
+            free(paths);
+            paths = grown;
+            capacity *= 2;
+        }
+        size_t length = strlen(directory) + 1 + strlen(name) + 1;
+        char *path = (char *)heap_alloc(length);
+        if (path == NULL)
+        {
+            break;
+        }
+        snprintf(path, length, "%s/%s", directory, name);
+        paths[(*count)++] = path;
+    }
+#ifdef _WIN32
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        FindClose(find);
+    }
+#else
+    closedir(dir);
+#endif
+
+    qsort(paths, (size_t)*count, sizeof(char *), compare_paths);
+    return paths;
+}
+
+/**
+ * @brief 创建目录（已存在时成功）
+ */
+static bool make_directory(const char *directory)
+{
+#ifdef _WIN32
+    return CreateDirectoryA(directory, NULL) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    struct stat st;
+    return mkdir(directory, 0777) == 0 || (stat(directory, &st) == 0 && S_ISDIR(st.st_mode));
+#endif
+}
+
+/**
+ * @brief 释放路径数组
+ */
+static void free_paths(char **paths, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+// =============================================
+// 线程私有数据
+// =============================================
+
+/**
+ * @brief 为线程池的每个线程分配累加器（热力图按shape分配，生成模式下不分配）
+ */
+static bool create_workers(int count, const HeatShape *shape)
+{
+    size_t cells = shape != NULL ? (size_t)shape->pool_width * (size_t)shape->pool_height : 0;
+    workers = (Worker **)heap_alloc((size_t)count * sizeof(Worker *));
+    if (workers == NULL)
+    {
+        return false;
+    }
+    worker_count = count;
+    memset(workers, 0, (size_t)count * sizeof(Worker *));
+    for (int i = 0; i < count; i++)
+    {
+        Worker *worker = (Worker *)heap_alloc(sizeof(Worker));
+        if (worker == NULL)
+        {
+            return false;
+        }
+        memset(worker, 0, sizeof(*worker));
+        replay_recorder_init(&worker->recorder);
+        workers[i] = worker;
+        if (cells > 0)
+        {
+            worker->visits = (uint64_t *)heap_alloc(cells * sizeof(uint64_t));
+            worker->ends = (uint64_t *)heap_alloc(cells * sizeof(uint64_t));
+            if (worker->visits == NULL || worker->ends == NULL)
+            {
+                return false;
+            }
+            memset(worker->visits, 0, cells * sizeof(uint64_t));
+            memset(worker->ends, 0, cells * sizeof(uint64_t));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 释放所有线程私有数据
+ */
+static void destroy_workers(void)
+{
+    for (int i = 0; workers != NULL && i < worker_count; i++)
+    {
+        Worker *worker = workers[i];
+        if (worker == NULL)
+        {
+            continue;
+        }
+        if (worker->ready)
+        {
+            destroy_game_context(&worker->ctx);
+        }
+        replay_recorder_destroy(&worker->recorder);
+        free(worker->visits);
+        free(worker->ends);
+        free(worker);
+    }
+    free(workers);
+    workers = NULL;
+    worker_count = 0;
+}
+
+/**
+ * @brief 把所有线程的累加器合并到第0个线程
+ */
+static void merge_workers(const HeatShape *shape)
+{
+    Worker *total = workers[0];
+    size_t cells = (size_t)shape->pool_width * (size_t)shape->pool_height;
+    for (int i = 1; i < worker_count; i++)
+    {
+        const Worker *worker = workers[i];
+        for (size_t c = 0; c < cells; c++)
+        {
+            total->visits[c] += worker->visits[c];
+            total->ends[c] += worker->ends[c];
+        }
+        for (int b = 0; b < LATENCY_BUCKETS; b++)
+        {
+            total->latency[b] += worker->latency[b];
+        }
+        for (int d = 0; d < DEATH_CAUSES; d++)
+        {
+            total->deaths[d] += worker->deaths[d];
+        }
+        total->games += worker->games;
+        total->ticks += worker->ticks;
+        total->foods += worker->foods;
+        total->score += worker->score;
+        total->mismatches += worker->mismatches;
+        total->off_shape += worker->off_shape;
+        total->errors += worker->errors;
+    }
+}
+
+// =============================================
+// 重新模拟
+// =============================================
+
+/**
+ * @brief 重新模拟一局并累加统计
+ *
+ * 每帧只做三件事：写入方向、update_game、累加蛇头所在单元格；吃到食物由得分变化判断。
+ */
+static void replay_one(Worker *worker, const ReplayInfo *info, const uint8_t *moves, const HeatShape *shape)
+{
+    GameContext *ctx = &worker->ctx;
+    if (!worker->ready)
+    {
+        worker->ready = init_game_context(ctx, info->width, info->height);
+    }
+    if (!worker->ready || !replay_prepare(ctx, info))
+    {
+        worker->ready = false;
+        worker->errors++;
+        return;
+    }
+
+    bool heat = ctx->pool_width == shape->pool_width && ctx->pool_height == shape->pool_height &&
+                ctx->torus == shape->torus;
+    uint64_t *visits = heat ? worker->visits : NULL;
+    int width = ctx->pool_width;
+    int score = ctx->game.score;
+    uint32_t last_food = 0;
+    uint32_t tick = 0;
+    while (tick < info->ticks && !ctx->game.game_over)
+    {
+        ctx->game.snake.next_direction = REPLAY_MOVE(moves, tick);
+        update_game(ctx);
+        tick++;
+        if (ctx->game.score != score)
+        {
+            uint32_t latency = tick - last_food;
+            worker->latency[latency < LATENCY_BUCKETS ? latency : LATENCY_BUCKETS - 1]++;
+            worker->foods++;
+            last_food = tick;
+            score = ctx->game.score;
+        }
+        if (visits != NULL)
+        {
+            visits[ctx->game.snake.head.y * width + ctx->game.snake.head.x]++;
+        }
+    }
+
+    worker->games++;
+    worker->ticks += tick;
+    worker->score += (uint64_t)ctx->game.score;
+    worker->deaths[ctx->game.death]++;
+    if (heat)
+    {
+        worker->ends[ctx->game.snake.head.y * width + ctx->game.snake.head.x]++;
+    }
+    else
+    {
+        worker->off_shape++;
+    }
+    if (ctx->game.score != info->score || ctx->game.death != info->death)
+    {
+        worker->mismatches++;
+    }
+}
+
+/**
+ * @brief 并行任务：重新模拟索引区间[begin, end)内的录像
+ */
+static void analyze_task(void *arg, int begin, int end, int worker_index)
+{
+    const AnalyzeTask *task = (const AnalyzeTask *)arg;
+    Worker *worker = workers[worker_index];
+    for (int i = begin; i < end; i++)
+    {
+        size_t offset = task->refs[i].offset;
+        ReplayInfo info;
+        const uint8_t *moves;
+        if (replay_file_next(&task->files[task->refs[i].file], &offset, &info, &moves) != REPLAY_OK)
+        {
+            worker->errors++;
+            continue;
+        }
+        replay_one(worker, &info, moves, &task->shape);
+    }
+}
+
+// =============================================
+// 生成录像
+// =============================================
+
+/**
+ * @brief 并行任务：对局并录制第[begin, end)个文件
+ */
+static void generate_task(void *arg, int begin, int end, int worker_index)
+{
+    const AnalyzeTask *task = (const AnalyzeTask *)arg;
+    Worker *worker = workers[worker_index];
+    GameContext *ctx = &worker->ctx;
+    if (!worker->ready)
+    {
+        worker->ready = init_game_context(ctx, options.board_width, options.board_height) &&
+                        apply_ruleset(ctx, &options.rules);
+        if (!worker->ready)
+        {
+            worker->errors += (uint64_t)(end - begin);
+            return;
+        }
+    }
+
+    for (int f = begin; f < end; f++)
+    {
+        FILE *file = fopen(task->paths[f], "wb");
+        if (file == NULL)
+        {
+            worker->errors++;
+            continue;
+        }
+        long long first = (long long)f * task->per_file;
+        long long last = first + task->per_file < options.generate ? first + task->per_file : options.generate;
+        for (long long g = first; g < last; g++)
+        {
+            uint64_t seed = options.seed + (uint64_t)g;
+            init_game_state(ctx, seed);
+            replay_recorder_begin(&worker->recorder, ctx, seed);
+            for (long long t = 0; t < options.ticks && !ctx->game.game_over; t++)
+            {
+                turn_snake(ctx, options.ai(ctx));
+                if (!replay_recorder_tick(&worker->recorder, ctx))
+                {
+                    break;
+                }
+                update_game(ctx);
+            }
+            if (replay_recorder_write(&worker->recorder, ctx, file) != REPLAY_OK)
+            {
+                worker->errors++;
+                break;
+            }
+            worker->games++;
+            worker->ticks += worker->recorder.info.ticks;
+            worker->deaths[ctx->game.death]++;
+        }
+        if (fclose(file) != 0)
+        {
+            worker->errors++;
+        }
+    }
+}
+
+/**
+ * @brief 生成录像目录
+ */
+static int run_generate(ThreadPool *pool)
+{
+    if (!make_directory(options.directory))
+    {
+        fprintf(stderr, "无法创建目录%s\n", options.directory);
+        return 1;
+    }
+    int files = options.files < options.generate ? options.files : (int)options.generate;
+    char **paths = (char **)heap_alloc((size_t)files * sizeof(char *));
+    if (paths == NULL || !create_workers(thread_pool_size(pool), NULL))
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+    for (int f = 0; f < files; f++)
+    {
+        paths[f] = (char *)heap_alloc(ANALYZE_MAX_PATH);
+        if (paths[f] == NULL)
+        {
+            fprintf(stderr, "内存不足\n");
+            return 1;
+        }
+        snprintf(paths[f], ANALYZE_MAX_PATH, "%s/replay_%04d%s", options.directory, f, REPLAY_FILE_EXTENSION);
+    }
+
+    AnalyzeTask task;
+    memset(&task, 0, sizeof(task));
+    task.paths = paths;
+    task.per_file = (options.generate + files - 1) / files;
+    double start = now_seconds();
+    thread_pool_run(pool, files, 1, generate_task, &task);
+    double seconds = now_seconds() - start;
+
+    uint64_t games = 0, ticks = 0, errors = 0, deaths[DEATH_CAUSES] = {0};
+    for (int i = 0; i < worker_count; i++)
+    {
+        games += workers[i]->games;
+        ticks += workers[i]->ticks;
+        errors += workers[i]->errors;
+        for (int d = 0; d < DEATH_CAUSES; d++)
+        {
+            deaths[d] += workers[i]->deaths[d];
+        }
+    }
+    printf("生成:     %llu 局，%llu 帧，%d 个文件，%.3f 秒\n", (unsigned long long)games, (unsigned long long)ticks,
+           files, seconds);
+    printf("结束原因: 撞墙 %llu，撞到自身 %llu，放满 %llu，未结束 %llu\n", (unsigned long long)deaths[DEATH_WALL],
+           (unsigned long long)deaths[DEATH_SELF], (unsigned long long)deaths[DEATH_BOARD_FULL],
+           (unsigned long long)deaths[DEATH_NONE]);
+
+    destroy_workers();
+    free_paths(paths, files);
+    if (errors != 0)
+    {
+        fprintf(stderr, "错误: %llu 个文件或对局无法写出\n", (unsigned long long)errors);
+        return 1;
+    }
+    return 0;
+}
+
+// =============================================
+// 输出
+// =============================================
+
+/**
+ * @brief 直方图的百分位数（帧数）
+ */
+static int latency_percentile(const uint64_t *histogram, uint64_t total, double fraction)
+{
+    uint64_t target = (uint64_t)ceil((double)total * fraction);
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += histogram[b];
+        if (seen >= target && seen > 0)
+        {
+            return b;
+        }
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief 热力图的颜色级别（对数刻度，最少到最多访问的单元格平均分成HEAT_LEVELS - 1级）
+ */
+static int heat_level(uint64_t visits, double low, double scale)
+{
+    if (visits == 0)
+    {
+        return 0;
+    }
+    int level = 1 + (int)((log((double)visits) - low) * scale);
+    return level < HEAT_LEVELS ? level : HEAT_LEVELS - 1;
+}
+
+/**
+ * @brief 用控制台单元格渲染器输出热力图（墙壁使用游戏中的字形）
+ */
+static void print_heatmap(const Worker *total, const HeatShape *shape)
+{
+    size_t cells = (size_t)shape->pool_width * (size_t)shape->pool_height;
+    uint64_t least = UINT64_MAX, peak = 0;
+    for (size_t c = 0; c < cells; c++)
+    {
+        uint64_t visits = total->visits[c];
+        peak = visits > peak ? visits : peak;
+        least = visits > 0 && visits < least ? visits : least;
+    }
+    if (peak == 0)
+    {
+        return;
+    }
+    double low = log((double)least);
+    double range = log((double)peak) - low;
+    double scale = range > 0.0 ? (HEAT_LEVELS - 1) / range : 0.0;
+
+    // 每个单元格最多一个颜色序列加一个字形，每行末尾恢复颜色并换行
+    Frame frame;
+    size_t row_bytes = (size_t)shape->pool_width * (SGR_MAX_LENGTH + GLYPH_MAX_UTF8) + SGR_MAX_LENGTH + 1;
+    if (!frame_init(&frame, row_bytes * (size_t)shape->pool_height))
+    {
+        fprintf(stderr, "内存不足，不输出热力图\n");
+        return;
+    }
+    for (int y = 0; y < shape->pool_height; y++)
+    {
+        for (int x = 0; x < shape->pool_width; x++)
+        {
+            bool border = !shape->torus &&
+                          (x == 0 || y == 0 || x == shape->pool_width - 1 || y == shape->pool_height - 1);
+            uint64_t visits = total->visits[(size_t)y * (size_t)shape->pool_width + (size_t)x];
+            const CellGlyph *glyph = &heat_glyphs[range > 0.0 ? heat_level(visits, low, scale) : HEAT_LEVELS - 1];
+            frame_put_glyph(&frame, border ? CELL_GLYPH(CELL_WALL) : glyph);
+        }
+        frame_set_attributes(&frame, ATTR_FG_RED | ATTR_FG_GREEN | ATTR_FG_BLUE);
+        frame_put(&frame, "\n", 1);
+    }
+    fwrite(frame.data, 1, frame.length, stdout);
+    frame_destroy(&frame);
+
+    const AnsiSgr *plain = ansi_sgr(ATTR_FG_RED | ATTR_FG_GREEN | ATTR_FG_BLUE);
+    printf("刻度:     ");
+    for (int level = 1; level < HEAT_LEVELS && range > 0.0; level++)
+    {
+        const AnsiSgr *sgr = ansi_sgr(heat_glyphs[level].attributes);
+        printf("%.*s  %.*s≥%.0f ", sgr->length, sgr->bytes, plain->length, plain->bytes,
+               ceil(exp(low + (level - 1) / scale)));
+    }
+    printf("（最少 %llu 帧，最多 %llu 帧）\n", (unsigned long long)least, (unsigned long long)peak);
+}
+
+/**
+ * @brief 写出CSV：PREFIX_heatmap.csv、PREFIX_latency.csv、PREFIX_deaths.csv
+ */
+static bool write_csv(const char *prefix, const Worker *total, const HeatShape *shape)
+{
+    char path[ANALYZE_MAX_PATH];
+    bool ok = true;
+
+    snprintf(path, sizeof(path), "%s_heatmap.csv", prefix);
+    FILE *file = fopen(path, "w");
+    ok = file != NULL && ok;
+    if (file != NULL)
+    {
+        fprintf(file, "x,y,visits,ends\n");
+        for (int y = 0; y < shape->pool_height; y++)
+        {
+            for (int x = 0; x < shape->pool_width; x++)
+            {
+                size_t c = (size_t)y * (size_t)shape->pool_width + (size_t)x;
+                fprintf(file, "%d,%d,%llu,%llu\n", x, y, (unsigned long long)total->visits[c],
+                        (unsigned long long)total->ends[c]);
+            }
+        }
+        ok = fclose(file) == 0 && ok;
+    }
+
+    snprintf(path, sizeof(path), "%s_latency.csv", prefix);
+    file = fopen(path, "w");
+    ok = file != NULL && ok;
+    if (file != NULL)
+    {
+        fprintf(file, "ticks,count\n");
+        for (int b = 1; b < LATENCY_BUCKETS; b++)
+        {
+            if (total->latency[b] != 0)
+            {
+                fprintf(file, "%d%s,%llu\n", b, b == LATENCY_BUCKETS - 1 ? "+" : "",
+                        (unsigned long long)total->latency[b]);
+            }
+        }
+        ok = fclose(file) == 0 && ok;
+    }
+
+    snprintf(path, sizeof(path), "%s_deaths.csv", prefix);
+    file = fopen(path, "w");
+    ok = file != NULL && ok;
+    if (file != NULL)
+    {
+        fprintf(file, "cause,games\n");
+        for (int d = 0; d < DEATH_CAUSES; d++)
+        {
+            fprintf(file, "%s,%llu\n", death_keys[d], (unsigned long long)total->deaths[d]);
+        }
+        ok = fclose(file) == 0 && ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief 输出汇总统计
+ */
+static void print_summary(const Worker *total, int files, size_t records, double seconds)
+{
+    printf("录像:     %d 个文件，%zu 局\n", files, records);
+    printf("模拟:     %llu 帧，%.3f 秒，%.1f 百万帧/秒（%.0f 百万帧/分钟），%d 线程\n",
+           (unsigned long long)total->ticks, seconds, (double)total->ticks / seconds / 1e6,
+           (double)total->ticks / seconds * 60.0 / 1e6, worker_count);
+    printf("得分:     平均每局 %.1f，吃到食物 %llu 次\n",
+           total->games > 0 ? (double)total->score / (double)total->games : 0.0, (unsigned long long)total->foods);
+    if (total->foods > 0)
+    {
+        double sum = 0.0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++)
+        {
+            sum += (double)b * (double)total->latency[b];
+        }
+        printf("食物间隔: 平均 %.1f 帧，P50 %d，P90 %d，P99 %d（超过%d帧的计为%d）\n", sum / (double)total->foods,
+               latency_percentile(total->latency, total->foods, 0.50),
+               latency_percentile(total->latency, total->foods, 0.90),
+               latency_percentile(total->latency, total->foods, 0.99), LATENCY_BUCKETS - 1, LATENCY_BUCKETS - 1);
+    }
+    printf("结束原因:");
+    for (int d = DEATH_WALL; d < DEATH_CAUSES + DEATH_WALL; d++)
+    {
+        int cause = d % DEATH_CAUSES; // 未结束放在最后
+        printf(" %s %llu（%.1f%%）", death_names[cause], (unsigned long long)total->deaths[cause],
+               total->games > 0 ? 100.0 * (double)total->deaths[cause] / (double)total->games : 0.0);
+    }
+    printf("\n");
+    if (total->off_shape > 0)
+    {
+        printf("热力图:   %llu 局的游戏池尺寸或布局与第一局不同，未计入\n", (unsigned long long)total->off_shape);
+    }
+}
+
+// =============================================
+// 分析
+// =============================================
+
+/**
+ * @brief 映射目录中的所有录像，建立索引，并行重新模拟并输出统计
+ */
+static int run_analyze(ThreadPool *pool)
+{
+    int file_count;
+    char **paths = list_replays(options.directory, &file_count);
+    if (paths == NULL)
+    {
+        fprintf(stderr, "无法读取目录%s\n", options.directory);
+        return 1;
+    }
+    ReplayFile *files = (ReplayFile *)heap_alloc((size_t)(file_count > 0 ? file_count : 1) * sizeof(ReplayFile));
+    if (files == NULL)
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+    memset(files, 0, (size_t)(file_count > 0 ? file_count : 1) * sizeof(ReplayFile));
+
+    // 扫描记录头建立索引（只读每局的记录头，方向留给各线程在重新模拟时读取）
+    size_t capacity = 1024;
+    size_t records = 0;
+    ReplayRef *refs = (ReplayRef *)heap_alloc(capacity * sizeof(ReplayRef));
+    HeatShape shape = {0, 0, false};
+    int status = 0;
+    for (int f = 0; f < file_count && refs != NULL; f++)
+    {
+        ReplayStatus result = replay_file_open(paths[f], &files[f]);
+        size_t offset = 0;
+        ReplayInfo info;
+        const uint8_t *moves;
+        while (result == REPLAY_OK)
+        {
+            size_t current = offset;
+            result = replay_file_next(&files[f], &offset, &info, &moves);
+            if (result != REPLAY_OK)
+            {
+                break;
+            }
+            if (records == 0)
+            {
+                shape.torus = info.rules.wrap;
+                shape.pool_width = info.width + (shape.torus ? 0 : 2);
+                shape.pool_height = info.height + (shape.torus ? 0 : 2);
+            }
+            if (records == capacity)
+            {
+                ReplayRef *grown = (ReplayRef *)heap_alloc(capacity * 2 * sizeof(ReplayRef));
+                if (grown == NULL)
+                {
+                    result = REPLAY_ERROR_MEMORY;
+                    break;
+                }
+                memcpy(grown, refs, capacity * sizeof(ReplayRef));
+                free(refs);
+                refs = grown;
+                capacity *= 2;
+            }
+            refs[records].file = f;
+            refs[records].offset = current;
+            records++;
+        }
+        if (result != REPLAY_END)
+        {
+            // 损坏的文件只跳过出错位置之后的部分，之前的记录照常分析
+            fprintf(stderr, "%s: %s\n", paths[f], replay_status_message(result));
+            status = 1;
+        }
+    }
+    if (refs == NULL || records == 0 || records > (size_t)INT32_MAX)
+    {
+        fprintf(stderr, records == 0 ? "%s中没有录像\n" : "内存不足或录像过多: %s\n", options.directory);
+        return 1;
+    }
+    if (!create_workers(thread_pool_size(pool), &shape))
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+
+    AnalyzeTask task;
+    memset(&task, 0, sizeof(task));
+    task.files = files;
+    task.refs = refs;
+    task.shape = shape;
+    double start = now_seconds();
+    thread_pool_run(pool, (int)records, 1, analyze_task, &task);
+    double seconds = now_seconds() - start;
+
+    merge_workers(&shape);
+    const Worker *total = workers[0];
+    if (options.heatmap)
+    {
+        print_heatmap(total, &shape);
+    }
+    print_summary(total, file_count, records, seconds);
+    if (options.csv != NULL && !write_csv(options.csv, total, &shape))
+    {
+        fprintf(stderr, "无法写出CSV: %s_*.csv\n", options.csv);
+        status = 1;
+    }
+    if (total->mismatches != 0 || total->errors != 0)
+    {
+        fprintf(stderr, "错误: %llu 局的重新模拟结果与录制时不一致，%llu 局无法重新模拟\n",
+                (unsigned long long)total->mismatches, (unsigned long long)total->errors);
+        status = 1;
+    }
+
+    destroy_workers();
+    for (int f = 0; f < file_count; f++)
+    {
+        replay_file_close(&files[f]);
+    }
+    free(files);
+    free(refs);
+    free_paths(paths, file_count);
+    return status;
+}
+
+// =============================================
+// 命令行
+// =============================================
+
+/**
+ * @brief 解析命令行参数
+ *
+ * @return true 参数合法
+ */
+static bool parse_options(int argc, char **argv)
+{
+    options.directory = argc > 1 ? argv[1] : NULL;
+    options.threads = 0;
+    options.mode = PARALLEL_SPIN_POOL;
+    options.csv = NULL;
+    options.heatmap = true;
+    options.generate = 0;
+    options.files = ANALYZE_DEFAULT_FILES;
+    options.ai = ai_greedy;
+    options.weights = NULL;
+    options.board_width = GAME_WIDTH;
+    options.board_height = GAME_HEIGHT;
+    default_ruleset(&options.rules);
+    options.seed = 1;
+    options.ticks = ANALYZE_DEFAULT_TICKS;
+
+    bool ok = options.directory != NULL && options.directory[0] != '-';
+    for (int i = 2; i < argc && ok; i += 2)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--no-heatmap") == 0)
+        {
+            options.heatmap = false;
+            i--; // 没有参数值
+        }
+        else if (value == NULL)
+        {
+            ok = false;
+        }
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            ok = sscanf(value, "%d", &options.threads) == 1 && options.threads >= 0;
+        }
+        else if (strcmp(arg, "--parallel") == 0)
+        {
+            ok = parallel_mode_from_name(value, &options.mode);
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            options.csv = value;
+        }
+        else if (strcmp(arg, "--generate") == 0)
+        {
+            ok = sscanf(value, "%lld", &options.generate) == 1 && options.generate > 0;
+        }
+        else if (strcmp(arg, "--files") == 0)
+        {
+            ok = sscanf(value, "%d", &options.files) == 1 && options.files > 0;
+        }
+        else if (strcmp(arg, "--ai") == 0)
+        {
+            // MCTS策略使用进程级的搜索状态，不能在多个线程之间共用
+            options.ai = ai_policy_from_name(value);
+            ok = options.ai != NULL && options.ai != ai_mcts;
+        }
+        else if (strcmp(arg, "--weights") == 0)
+        {
+            options.weights = value;
+        }
+        else if (strcmp(arg, "--board") == 0)
+        {
+            ok = sscanf(value, "%dx%d", &options.board_width, &options.board_height) == 2 &&
+                 options.board_width >= 4 && options.board_height >= 3;
+        }
+        else if (strcmp(arg, "--rules") == 0)
+        {
+            char error[RULES_MAX_LINE * 2];
+            if (!load_ruleset(value, &options.rules, error, sizeof(error)))
+            {
+                fprintf(stderr, "%s\n", error);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            unsigned long long seed;
+            ok = sscanf(value, "%llu", &seed) == 1;
+            options.seed = (uint64_t)seed;
+        }
+        else if (strcmp(arg, "--ticks") == 0)
+        {
+            ok = sscanf(value, "%lld", &options.ticks) == 1 && options.ticks > 0;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    // 网络在启动线程之前加载，之后各线程只读共享
+    if (ok && options.ai == ai_nn)
+    {
+        NnStatus status;
+        if (!ai_nn_configure(options.weights, &status))
+        {
+            fprintf(stderr, "无法加载权重文件%s: %s\n", options.weights != NULL ? options.weights : "（内置）",
+                    nn_status_message(status));
+            return false;
+        }
+    }
+    if (!ok)
+    {
+        fprintf(stderr,
+                "用法: snake_analyze DIR [--threads N] [--parallel serial|openmp|spin] [--csv PREFIX] [--no-heatmap]\n"
+                "      snake_analyze DIR --generate GAMES [--files K] [--ai %s] [--weights FILE] [--board WxH]\n"
+                "                        [--rules FILE] [--seed S] [--ticks N] [--threads N]\n",
+                ai_policy_names());
+    }
+    return ok;
+}
+
+// =============================================
+// 主函数
+// =============================================
+
+int main(int argc, char **argv)
+{
+    if (!parse_options(argc, argv))
+    {
+        return 2;
+    }
+    render_init();
+
+    ThreadPool *pool = thread_pool_create(options.mode, options.threads);
+    if (pool == NULL)
+    {
+        fprintf(stderr, "无法创建线程池\n");
+        return 1;
+    }
+    int status = options.generate > 0 ? run_generate(pool) : run_analyze(pool);
+    thread_pool_destroy(pool);
+    ai_nn_release();
+    return status;
+}
@@ -0,0 +1,814 @@
+/**
+ * @file snake_api.c
+ * @brief libsnake 公共C接口实现
+ *
+ * 把游戏引擎（snake_core.c）包装成稳定的C ABI：创建/重置/单步/观测，以及批量版本。
+ * 批量版本可通过线程池（snake_parallel.c）在多个线程上并行推进和编码，
+ * 并可把每一步导出为训练数据（snake_export.c，每个线程入队到自己的队列），
+ * 或由神经网络策略（snake_nn.c）批量决定所有环境的动作。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_api.h"
+#include "snake_core.h"
+#include "snake_export.h"
+#include "snake_nn.h"
+#include "snake_parallel.h"
+#include "snake_save.h"
+#include "snake_rules.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================
+// 类型定义
+// =============================================
+
+// 批量环境的分片粒度：64个环境的dones（uint8）恰好占满一个缓存行，rewards（float）占满4个，
+// 分片边界对齐到该粒度后，不同线程写入的输出不会落在同一缓存行上
+#define BATCH_SHARD_GRAIN CACHE_LINE_SIZE
+
+/**
+ * @struct SnakeEnv
+ * @brief 单局游戏环境，只包装一个游戏上下文
+ *
+ * 大小补齐到缓存行的整数倍，批量环境中相邻两局的状态不会共享缓存行。
+ */
+struct SnakeEnv
+{
+    union
+    {
+        GameContext ctx; ///< 游戏上下文
+        unsigned char cache_lines[(sizeof(GameContext) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE];
+    };
+};
+
+/**
+ * @struct SnakeBatch
+ * @brief 批量游戏环境，count个尺寸相同的单局环境
+ */
+struct SnakeBatch
+{
+    int count;                  ///< 环境数量
+    SnakeEnv *envs;             ///< 环境数组（创建时一次性分配，按缓存行对齐）
+    void *allocation;           ///< 环境数组的原始分配地址
+    ThreadPool *pool;           ///< 并行执行批量操作的线程池（NULL表示顺序执行）
+    TrainingExporter *exporter; ///< 训练数据导出器（NULL表示不导出）
+    uint32_t tick;              ///< 批次步号（snake_batch_step的调用次数，导出时记录）
+};
+
+/**
+ * @struct BatchTask
+ * @brief 批量操作的并行任务参数
+ */
+typedef struct
+{
+    SnakeBatch *batch;      ///< 批量环境
+    const int32_t *actions; ///< 动作（NULL表示不推进，只编码观测）
+    float *rewards;         ///< 输出：得分增量，可为NULL
+    uint8_t *dones;         ///< 输出：是否结束，可为NULL
+    uint8_t *obs;           ///< 输出：观测（NULL表示不编码）
+    ptrdiff_t stride_n;     ///< 观测环境步长
+    ptrdiff_t stride_c;     ///< 观测通道步长
+    ptrdiff_t stride_h;     ///< 观测行步长
+    ptrdiff_t stride_w;     ///< 观测列步长
+} BatchTask;
+
+/**
+ * @struct NetTask
+ * @brief 批量决策的并行任务参数
+ */
+typedef struct
+{
+    SnakeBatch *batch; ///< 批量环境
+    const NnNet *net;  ///< 网络
+    int32_t *actions;  ///< 输出：每个环境的动作
+} NetTask;
+
+// =============================================
+// 观测编码
+// =============================================
+
+/**
+ * @brief 单元格类型 → 观测通道查找表（按CELL_HASH索引，存储通道号+1，0表示不属于任何通道）
+ */
+static const unsigned char cell_channel[CELL_HASH_SIZE] = {
+    [CELL_HASH(CELL_SNAKE_HEAD)] = SNAKE_OBS_HEAD + 1,
+    [CELL_HASH(CELL_SNAKE_BODY_UP)] = SNAKE_OBS_BODY + 1,
+    [CELL_HASH(CELL_SNAKE_BODY_DOWN)] = SNAKE_OBS_BODY + 1,
+    [CELL_HASH(CELL_SNAKE_BODY_LEFT)] = SNAKE_OBS_BODY + 1,
+    [CELL_HASH(CELL_SNAKE_BODY_RIGHT)] = SNAKE_OBS_BODY + 1,
+    [CELL_HASH(CELL_SNAKE_TAIL)] = SNAKE_OBS_TAIL + 1,
+    [CELL_HASH(CELL_FOOD)] = SNAKE_OBS_FOOD + 1,
+    [CELL_HASH(CELL_WALL)] = SNAKE_OBS_WALL + 1,
+};
+
+/**
+ * @brief 将一个平面清零
+ *
+ * 行连续（stride_w == 1）时按行memset，整个平面连续时一次memset。
+ */
+static void clear_plane(uint8_t *plane, int height, int width, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    if (stride_w == 1 && stride_h == width)
+    {
+        memset(plane, 0, (size_t)width * (size_t)height);
+        return;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t *row = plane + y * stride_h;
+        if (stride_w == 1)
+        {
+            memset(row, 0, (size_t)width);
+        }
+        else
+        {
+            for (int x = 0; x < width; x++)
+            {
+                row[x * stride_w] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 观测编码（快速版本）
+ *
+ * 先用memset清零所有平面，再单遍扫描游戏池：每个非空单元格通过查找表得到通道，只写一个字节。
+ * 相比逐通道逐单元格判断类型，内存写入量从C×H×W次分散写降为C次连续清零加少量分散写。
+ */
+static void encode_observation(const GameContext *ctx, uint8_t *out,
+                               ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    int width = ctx->pool_width;
+    int height = ctx->pool_height;
+
+    for (int c = 0; c < SNAKE_OBS_CHANNELS; c++)
+    {
+        clear_plane(out + c * stride_c, height, width, stride_h, stride_w);
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const CellType *row = ctx->pool + y * width;
+        uint8_t *out_row = out + y * stride_h;
+        for (int x = 0; x < width; x++)
+        {
+            int channel = cell_channel[CELL_HASH(row[x])];
+            if (channel != 0)
+            {
+                out_row[(channel - 1) * stride_c + x * stride_w] = 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 单元格类型 → 观测通道（参考实现使用的switch版本）
+ */
+static int cell_type_to_channel(CellType cell)
+{
+    switch (cell)
+    {
+    case CELL_SNAKE_HEAD:
+        return SNAKE_OBS_HEAD;
+    case CELL_SNAKE_BODY_UP:
+    case CELL_SNAKE_BODY_DOWN:
+    case CELL_SNAKE_BODY_LEFT:
+    case CELL_SNAKE_BODY_RIGHT:
+        return SNAKE_OBS_BODY;
+    case CELL_SNAKE_TAIL:
+        return SNAKE_OBS_TAIL;
+    case CELL_FOOD:
+        return SNAKE_OBS_FOOD;
+    case CELL_WALL:
+        return SNAKE_OBS_WALL;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 随机数种子混合（splitmix64），为批量环境中的每一局派生独立种子
+ */
+static uint64_t mix_seed(uint64_t seed, uint64_t index)
+{
+    uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// =============================================
+// 版本和调试
+// =============================================
+
+/**
+ * @brief 获取ABI版本号（调用方应检查是否等于自己编译时的SNAKE_ABI_VERSION）
+ */
+SNAKE_API int snake_abi_version(void)
+{
+    return SNAKE_ABI_VERSION;
+}
+
+/**
+ * @brief 获取累计堆分配次数
+ *
+ * 调试构建下返回引擎的堆分配计数，基准测试据此断言每帧零堆分配；发布构建恒为0。
+ */
+SNAKE_API uint64_t snake_debug_heap_allocs(void)
+{
+#ifndef NDEBUG
+    return (uint64_t)heap_alloc_count;
+#else
+    return 0;
+#endif
+}
+
+// =============================================
+// 单局环境
+// =============================================
+
+/**
+ * @brief 创建单局环境
+ *
+ * @param width 游戏区域宽度（不包含边框）
+ * @param height 游戏区域高度（不包含边框）
+ * @return SnakeEnv* 新环境（需先调用snake_reset），参数无效或内存不足时返回NULL
+ */
+SNAKE_API SnakeEnv *snake_env_create(int width, int height)
+{
+    if (width < 4 || height < 1)
+    {
+        return NULL; // 初始蛇长3格，横向至少需要4格
+    }
+
+    SnakeEnv *env = (SnakeEnv *)heap_alloc(sizeof(SnakeEnv));
+    if (env == NULL)
+    {
+        return NULL;
+    }
+    if (!init_game_context(&env->ctx, width, height))
+    {
+        free(env);
+        return NULL;
+    }
+    return env;
+}
+
+/**
+ * @brief 销毁单局环境
+ */
+SNAKE_API void snake_env_destroy(SnakeEnv *env)
+{
+    if (env != NULL)
+    {
+        destroy_game_context(&env->ctx);
+        free(env);
+    }
+}
+
+/**
+ * @brief 获取观测形状（C, H, W），H和W包括墙壁边框
+ */
+SNAKE_API void snake_env_shape(const SnakeEnv *env, int *channels, int *height, int *width)
+{
+    *channels = SNAKE_OBS_CHANNELS;
+    *height = env->ctx.pool_height;
+    *width = env->ctx.pool_width;
+}
+
+/**
+ * @brief 以指定种子开始新的一局
+ */
+SNAKE_API void snake_reset(SnakeEnv *env, uint64_t seed)
+{
+    init_game_state(&env->ctx, seed);
+}
+
+/**
+ * @brief 执行一步
+ *
+ * 按动作转向（与当前方向相反的动作被忽略，和键盘操作一致），然后推进一帧。
+ * 游戏已结束时不再推进，奖励为0。
+ *
+ * @param env 环境
+ * @param action 动作（SNAKE_ACTION_*）
+ * @param reward 输出：本步得分增量，可为NULL
+ * @param done 输出：游戏是否已结束，可为NULL
+ * @return int 0表示成功，-1表示动作无效（状态不变）
+ */
+SNAKE_API int snake_step(SnakeEnv *env, int action, float *reward, uint8_t *done)
+{
+    GameContext *ctx = &env->ctx;
+    if (action < SNAKE_ACTION_UP || action > SNAKE_ACTION_RIGHT)
+    {
+        return -1;
+    }
+
+    int score_before = ctx->game.score;
+    if (!ctx->game.game_over)
+    {
+        turn_snake(ctx, (Direction)action);
+        update_game(ctx);
+    }
+
+    if (reward != NULL)
+    {
+        *reward = (float)(ctx->game.score - score_before);
+    }
+    if (done != NULL)
+    {
+        *done = ctx->game.game_over ? 1 : 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief 获取当前得分
+ */
+SNAKE_API int snake_score(const SnakeEnv *env)
+{
+    return env->ctx.game.score;
+}
+
+/**
+ * @brief 查找离蛇头最近（曼哈顿距离）的食物
+ *
+ * 坐标与观测相同（包括边框）。第一次查询时建立食物索引，此后每次查询只扫描蛇头附近的非空桶。
+ *
+ * @param env 环境
+ * @param x 输出：食物X坐标，可为NULL
+ * @param y 输出：食物Y坐标，可为NULL
+ * @return int 到最近食物的距离，没有食物时返回-1（x、y不修改）
+ */
+SNAKE_API int snake_nearest_food(SnakeEnv *env, int *x, int *y)
+{
+    Position food;
+    int distance = food_nearest(&env->ctx, env->ctx.game.snake.head, &food);
+    if (distance >= 0)
+    {
+        if (x != NULL)
+        {
+            *x = food.x;
+        }
+        if (y != NULL)
+        {
+            *y = food.y;
+        }
+    }
+    return distance;
+}
+
+/**
+ * @brief 将当前游戏池编码为one-hot观测，写入调用方缓冲区
+ *
+ * @param env 环境
+ * @param out 输出缓冲区，至少容纳(C, H, W)按给定步长排布的全部元素
+ * @param stride_c 通道步长（字节）
+ * @param stride_h 行步长（字节）
+ * @param stride_w 列步长（字节）
+ */
+SNAKE_API void snake_observe(const SnakeEnv *env, uint8_t *out,
+                             ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    encode_observation(&env->ctx, out, stride_c, stride_h, stride_w);
+}
+
+/**
+ * @brief 观测编码的逐单元格参考实现
+ *
+ * 对每个通道的每个单元格单独判断类型并写入0或1。结果与snake_observe完全相同，
+ * 仅用于基准对比和正确性校验。
+ */
+SNAKE_API void snake_observe_reference(const SnakeEnv *env, uint8_t *out,
+                                       ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    const GameContext *ctx = &env->ctx;
+    for (int c = 0; c < SNAKE_OBS_CHANNELS; c++)
+    {
+        for (int y = 0; y < ctx->pool_height; y++)
+        {
+            for (int x = 0; x < ctx->pool_width; x++)
+            {
+                CellType cell = get_cell_type(ctx, (Position){x, y});
+                out[c * stride_c + y * stride_h + x * stride_w] = (cell_type_to_channel(cell) == c) ? 1 : 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 把当前游戏保存到存档文件（格式见snake_save.h）
+ *
+ * @return int 0表示成功，否则为SaveStatus错误码
+ */
+SNAKE_API int snake_save(const SnakeEnv *env, const char *path)
+{
+    return (int)save_game(&env->ctx, path);
+}
+
+/**
+ * @brief 从存档文件加载游戏（代替snake_reset）
+ *
+ * 存档的游戏区域尺寸必须与环境一致。游戏池直接映射存档文件，不逐单元格解析。
+ *
+ * @param env 环境
+ * @param path 存档文件路径
+ * @param verify 非0时校验整个游戏池（读取全部数据）；为0时只检查蛇头、蛇尾、食物和边框，
+ *               其余单元格按存档原样信任，来源不可信的存档必须传非0
+ * @return int 0表示成功，否则为SaveStatus错误码（环境保持不变）
+ */
+SNAKE_API int snake_load(SnakeEnv *env, const char *path, int verify)
+{
+    return (int)load_game(&env->ctx, path, verify ? SAVE_VERIFY_POOL : 0);
+}
+
+/**
+ * @brief 从规则文件加载游戏规则（格式见snake_rules.h）
+ *
+ * 增长节数立即生效；初始速度、障碍物和食物个数从下一次snake_reset开始生效。
+ * 穿墙规则使用没有边框的环面游戏池，观测尺寸随之改变（见snake_env_shape），当前一局以上一次snake_reset的种子按新布局重新开始；
+ * 批量环境中的环境应当全部使用相同的规则。
+ *
+ * @param env 环境
+ * @param path 规则文件路径
+ * @return int 0表示成功，-1表示文件无法读取、内容不合法或游戏区域太小不能穿墙（环境保持不变）
+ */
+SNAKE_API int snake_load_rules(SnakeEnv *env, const char *path)
+{
+    Ruleset rules;
+    if (!load_ruleset(path, &rules, NULL, 0) || !apply_ruleset(&env->ctx, &rules))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// =============================================
+// 批量环境
+// =============================================
+
+/**
+ * @brief 创建批量环境
+ *
+ * @param count 环境数量
+ * @param width 游戏区域宽度（不包含边框）
+ * @param height 游戏区域高度（不包含边框）
+ * @return SnakeBatch* 新批量环境（需先调用snake_batch_reset），失败返回NULL
+ */
+SNAKE_API SnakeBatch *snake_batch_create(int count, int width, int height)
+{
+    if (count < 1 || width < 4 || height < 1)
+    {
+        return NULL;
+    }
+
+    SnakeBatch *batch = (SnakeBatch *)heap_alloc(sizeof(SnakeBatch));
+    if (batch == NULL)
+    {
+        return NULL;
+    }
+    batch->count = 0;
+    batch->pool = NULL;
+    batch->exporter = NULL;
+    batch->tick = 0;
+    batch->allocation = heap_alloc((size_t)count * sizeof(SnakeEnv) + CACHE_LINE_SIZE);
+    if (batch->allocation == NULL)
+    {
+        free(batch);
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)batch->allocation + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    batch->envs = (SnakeEnv *)aligned;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!init_game_context(&batch->envs[i].ctx, width, height))
+        {
+            snake_batch_destroy(batch);
+            return NULL;
+        }
+        batch->count++;
+    }
+    return batch;
+}
+
+/**
+ * @brief 销毁批量环境
+ */
+SNAKE_API void snake_batch_destroy(SnakeBatch *batch)
+{
+    if (batch == NULL)
+    {
+        return;
+    }
+    snake_batch_export_close(batch, NULL, NULL);
+    thread_pool_destroy(batch->pool);
+    for (int i = 0; i < batch->count; i++)
+    {
+        destroy_game_context(&batch->envs[i].ctx);
+    }
+    free(batch->allocation);
+    free(batch);
+}
+
+/**
+ * @brief 获取批量环境中的环境数量
+ */
+SNAKE_API int snake_batch_size(const SnakeBatch *batch)
+{
+    return batch->count;
+}
+
+/**
+ * @brief 获取批量环境中的第index个环境（归批量环境所有，不可单独销毁）
+ */
+SNAKE_API SnakeEnv *snake_batch_env(SnakeBatch *batch, int index)
+{
+    return (index >= 0 && index < batch->count) ? &batch->envs[index] : NULL;
+}
+
+/**
+ * @brief 重置所有环境，第i个环境使用由seed和i派生的独立种子
+ */
+SNAKE_API void snake_batch_reset(SnakeBatch *batch, uint64_t seed)
+{
+    for (int i = 0; i < batch->count; i++)
+    {
+        init_game_state(&batch->envs[i].ctx, mix_seed(seed, (uint64_t)i));
+    }
+}
+
+/**
+ * @brief 重置单个环境（常用于某一局结束后单独重开）
+ */
+SNAKE_API void snake_batch_reset_one(SnakeBatch *batch, int index, uint64_t seed)
+{
+    if (index >= 0 && index < batch->count)
+    {
+        init_game_state(&batch->envs[index].ctx, seed);
+    }
+}
+
+/**
+ * @brief 设置批量操作的并行方式
+ *
+ * 替换批量环境的线程池。自旋线程池的工作线程常驻并在两次调用之间自旋等待，
+ * 适合每步耗时很短的小批量；OpenMP适合大批量；顺序执行没有任何线程开销。
+ *
+ * @param batch 批量环境
+ * @param mode 并行方式（SNAKE_PARALLEL_*）
+ * 导出训练数据时不能改变（每个线程对应导出器的一个队列），先关闭导出。
+ *
+ * @param threads 线程数（包括调用线程），<=0表示使用全部逻辑CPU
+ * @return int 实际使用的线程数，参数无效、正在导出或失败返回-1
+ */
+SNAKE_API int snake_batch_set_parallel(SnakeBatch *batch, int mode, int threads)
+{
+    if (mode < SNAKE_PARALLEL_SERIAL || mode > SNAKE_PARALLEL_SPIN || batch->exporter != NULL)
+    {
+        return -1;
+    }
+
+    thread_pool_destroy(batch->pool);
+    batch->pool = NULL;
+    if (mode == SNAKE_PARALLEL_SERIAL)
+    {
+        return 1;
+    }
+
+    batch->pool = thread_pool_create((ParallelMode)mode, threads);
+    return batch->pool != NULL ? thread_pool_size(batch->pool) : -1;
+}
+
+/**
+ * @brief 并行任务：推进并/或编码区间[begin, end)内的环境
+ */
+static void batch_task(void *arg, int begin, int end, int worker)
+{
+    const BatchTask *task = (const BatchTask *)arg;
+    TrainingExporter *exporter = task->batch->exporter;
+
+    for (int i = begin; i < end; i++)
+    {
+        SnakeEnv *env = &task->batch->envs[i];
+        if (task->actions != NULL)
+        {
+            int action = task->actions[i];
+            if (action < SNAKE_ACTION_UP || action > SNAKE_ACTION_RIGHT)
+            {
+                action = (int)env->ctx.game.snake.direction;
+            }
+
+            // 导出时单步之前把游戏池复制到本线程的队列（已结束的局不推进，也不导出）
+            bool recording = exporter != NULL && !env->ctx.game.game_over && exporter_begin(exporter, worker, &env->ctx);
+            float reward;
+            uint8_t done;
+            snake_step(env, action, &reward, &done);
+            if (recording)
+            {
+                exporter_commit(exporter, worker, (uint32_t)i, task->batch->tick, (Direction)action, reward, done != 0);
+            }
+            if (task->rewards != NULL)
+            {
+                task->rewards[i] = reward;
+            }
+            if (task->dones != NULL)
+            {
+                task->dones[i] = done;
+            }
+        }
+        if (task->obs != NULL)
+        {
+            encode_observation(&env->ctx, task->obs + i * task->stride_n,
+                               task->stride_c, task->stride_h, task->stride_w);
+        }
+    }
+}
+
+/**
+ * @brief 所有环境各执行一步
+ *
+ * 奖励（吃到食物的得分增量）和结束标志（撞墙或撞到自身）由各环境的update_game计算，
+ * 按缓存行对齐的分片并行执行。
+ *
+ * @param batch 批量环境
+ * @param actions 每个环境的动作（count个），无效动作视为保持当前方向
+ * @param rewards 输出：每个环境本步得分增量（count个），可为NULL
+ * @param dones 输出：每个环境是否已结束（count个），可为NULL
+ */
+SNAKE_API void snake_batch_step(SnakeBatch *batch, const int32_t *actions, float *rewards, uint8_t *dones)
+{
+    BatchTask task = {batch, actions, rewards, dones, NULL, 0, 0, 0, 0};
+    thread_pool_run(batch->pool, batch->count, BATCH_SHARD_GRAIN, batch_task, &task);
+    batch->tick++;
+}
+
+/**
+ * @brief 一次调用填充整个[N, C, H, W]观测数组
+ *
+ * @param batch 批量环境
+ * @param out 输出缓冲区
+ * @param stride_n 环境步长（字节）
+ * @param stride_c 通道步长（字节）
+ * @param stride_h 行步长（字节）
+ * @param stride_w 列步长（字节）
+ */
+SNAKE_API void snake_batch_observe(const SnakeBatch *batch, uint8_t *out, ptrdiff_t stride_n,
+                                   ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    BatchTask task = {(SnakeBatch *)batch, NULL, NULL, NULL, out, stride_n, stride_c, stride_h, stride_w};
+    thread_pool_run(batch->pool, batch->count, BATCH_SHARD_GRAIN, batch_task, &task);
+}
+
+/**
+ * @brief 推进一步并编码观测（一次并行调度完成两件事）
+ *
+ * 等价于snake_batch_step后接snake_batch_observe，但每个环境推进后立即在同一线程上编码，
+ * 只需一次线程同步，状态仍在该线程缓存中。
+ */
+SNAKE_API void snake_batch_step_observe(SnakeBatch *batch, const int32_t *actions, float *rewards, uint8_t *dones,
+                                        uint8_t *out, ptrdiff_t stride_n,
+                                        ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w)
+{
+    BatchTask task = {batch, actions, rewards, dones, out, stride_n, stride_c, stride_h, stride_w};
+    thread_pool_run(batch->pool, batch->count, BATCH_SHARD_GRAIN, batch_task, &task);
+    batch->tick++;
+}
+
+// =============================================
+// 训练数据导出
+// =============================================
+
+/**
+ * @brief 开始导出训练数据：此后每次snake_batch_step（或snake_batch_step_observe）中
+ *        每个未结束的环境都记录（步前观测，动作，奖励，是否结束）
+ *
+ * 每个线程池线程入队到自己的无锁队列，后台线程压缩并写出，单步不会等待磁盘；
+ * 后台跟不上时丢弃的步数由snake_batch_export_close返回。
+ * 所有环境的游戏池尺寸必须与0号环境相同（不同的步被丢弃）。
+ *
+ * @param batch 批量环境
+ * @param path 输出文件路径（已存在时覆盖）
+ * @param chunk_steps 每块步数（<=0使用默认值）
+ * @return int 0表示成功，-1表示已在导出或无法创建文件
+ */
+SNAKE_API int snake_batch_export_open(SnakeBatch *batch, const char *path, int chunk_steps)
+{
+    if (batch->exporter != NULL)
+    {
+        return -1;
+    }
+    const GameContext *ctx = &batch->envs[0].ctx;
+    int producers = batch->pool != NULL ? thread_pool_size(batch->pool) : 1;
+    batch->exporter = exporter_create(path, producers, ctx->pool_width, ctx->pool_height, chunk_steps, 0, NULL);
+    return batch->exporter != NULL ? 0 : -1;
+}
+
+/**
+ * @brief 结束导出：写出队列中剩余的步、块索引和文件尾
+ *
+ * @param batch 批量环境
+ * @param written 输出：写出的步数，可为NULL
+ * @param dropped 输出：因后台跟不上而丢弃的步数，可为NULL
+ * @return int 0表示成功，-1表示没有在导出或写出失败
+ */
+SNAKE_API int snake_batch_export_close(SnakeBatch *batch, uint64_t *written, uint64_t *dropped)
+{
+    if (batch->exporter == NULL)
+    {
+        return -1;
+    }
+    ExportStats stats;
+    ExportStatus status = exporter_close(batch->exporter, &stats);
+    batch->exporter = NULL;
+    if (written != NULL)
+    {
+        *written = stats.written;
+    }
+    if (dropped != NULL)
+    {
+        *dropped = stats.dropped;
+    }
+    return status == EXPORT_OK ? 0 : -1;
+}
+
+// =============================================
+// 神经网络策略
+// =============================================
+
+// SnakeNet只是NnNet的公开名称，两者之间直接转换指针
+
+/**
+ * @brief 加载网络
+ *
+ * @param path 权重文件路径，NULL表示使用内置权重
+ * @return SnakeNet* 网络，文件无法读取、格式不合法或内存不足时返回NULL
+ */
+SNAKE_API SnakeNet *snake_net_load(const char *path)
+{
+    return (SnakeNet *)(path != NULL ? nn_load(path, NULL) : nn_create_builtin());
+}
+
+/**
+ * @brief 销毁网络（NULL时什么也不做）
+ */
+SNAKE_API void snake_net_destroy(SnakeNet *net)
+{
+    nn_destroy((NnNet *)net);
+}
+
+/**
+ * @brief 启用或关闭SIMD内核（加载时已按CPU自动启用；关闭后使用标量内核，结果逐位相同）
+ *
+ * @return int 1表示使用SIMD内核，0表示使用标量内核（CPU不支持时无法启用）
+ */
+SNAKE_API int snake_net_set_simd(SnakeNet *net, int enabled)
+{
+    nn_set_kernel((NnNet *)net, enabled ? NN_KERNEL_AVX2 : NN_KERNEL_SCALAR);
+    return nn_get_kernel((NnNet *)net) == NN_KERNEL_AVX2;
+}
+
+/**
+ * @brief 并行任务：为区间[begin, end)内的环境决策，每NN_BATCH_TILE个环境一起前向计算
+ */
+static void net_task(void *arg, int begin, int end, int worker)
+{
+    (void)worker;
+    const NetTask *task = (const NetTask *)arg;
+    GameContext *ctxs[NN_BATCH_TILE];
+    Direction directions[NN_BATCH_TILE];
+    for (int tile = begin; tile < end; tile += NN_BATCH_TILE)
+    {
+        int n = end - tile < NN_BATCH_TILE ? end - tile : NN_BATCH_TILE;
+        for (int i = 0; i < n; i++)
+        {
+            ctxs[i] = &task->batch->envs[tile + i].ctx;
+        }
+        nn_decide_batch(task->net, ctxs, n, directions);
+        for (int i = 0; i < n; i++)
+        {
+            const GameContext *ctx = ctxs[i];
+            task->actions[tile + i] = (int32_t)(ctx->game.game_over ? ctx->game.snake.direction : directions[i]);
+        }
+    }
+}
+
+/**
+ * @brief 由网络决定所有环境的动作（与snake_batch_step一样按分片并行）
+ *
+ * 输出可以直接传给snake_batch_step；已结束的环境输出当前方向。
+ *
+ * @param batch 批量环境
+ * @param net 网络
+ * @param actions 输出：每个环境的动作（count个）
+ */
+SNAKE_API void snake_batch_net_actions(SnakeBatch *batch, const SnakeNet *net, int32_t *actions)
+{
+    NetTask task = {batch, (const NnNet *)net, actions};
+    thread_pool_run(batch->pool, batch->count, BATCH_SHARD_GRAIN, net_task, &task);
+}
@@ -0,0 +1,130 @@
+/**
+ * @file snake_api.h
+ * @brief libsnake 公共C接口（稳定ABI）
+ *
+ * 供Python（ctypes/cffi）等外部程序调用的贪吃蛇环境接口。
+ * 所有函数只使用基本C类型，结构体均为不透明指针，ABI变化时递增SNAKE_ABI_VERSION。
+ *
+ * 观测为one-hot平面编码：每个单元格在SNAKE_OBS_CHANNELS个uint8平面中最多有一个为1
+ * （空单元格全为0）。观测直接写入调用方提供的缓冲区，步长以字节为单位，
+ * 与NumPy的strides含义一致，因此任意布局的uint8数组都可以零拷贝填充：
+ *
+ *     obs = np.zeros((n, 5, h, w), np.uint8)
+ *     lib.snake_batch_observe(batch, obs.ctypes.data, *obs.strides)
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_API_H
+#define SNAKE_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 导出符号声明
+#if defined(_WIN32)
+#ifdef SNAKE_BUILDING_LIBRARY
+#define SNAKE_API __declspec(dllexport)
+#else
+#define SNAKE_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define SNAKE_API __attribute__((visibility("default")))
+#else
+#define SNAKE_API
+#endif
+
+#define SNAKE_ABI_VERSION 1 ///< ABI版本号，接口或观测编码不兼容变化时递增
+
+/**
+ * @brief 观测通道（one-hot平面下标）
+ */
+enum
+{
+    SNAKE_OBS_HEAD = 0, ///< 蛇头
+    SNAKE_OBS_BODY,     ///< 蛇身（不区分方向）
+    SNAKE_OBS_TAIL,     ///< 蛇尾
+    SNAKE_OBS_FOOD,     ///< 食物
+    SNAKE_OBS_WALL,     ///< 墙壁
+    SNAKE_OBS_CHANNELS  ///< 通道数
+};
+
+/**
+ * @brief 动作（取值与引擎的Direction一致）
+ */
+enum
+{
+    SNAKE_ACTION_UP = 0, ///< 向上
+    SNAKE_ACTION_DOWN,   ///< 向下
+    SNAKE_ACTION_LEFT,   ///< 向左
+    SNAKE_ACTION_RIGHT   ///< 向右
+};
+
+/**
+ * @brief 批量操作的并行方式
+ */
+enum
+{
+    SNAKE_PARALLEL_SERIAL = 0, ///< 顺序执行
+    SNAKE_PARALLEL_OPENMP,     ///< OpenMP parallel for（未启用OpenMP编译时为顺序执行）
+    SNAKE_PARALLEL_SPIN        ///< 常驻自旋线程池（小批量时没有线程唤醒延迟）
+};
+
+typedef struct SnakeEnv SnakeEnv;     ///< 单局游戏环境（不透明）
+typedef struct SnakeBatch SnakeBatch; ///< 批量游戏环境（不透明）
+typedef struct SnakeNet SnakeNet;     ///< 自动控制网络（不透明，创建后只读）
+
+// 版本和调试
+SNAKE_API int snake_abi_version(void);
+SNAKE_API uint64_t snake_debug_heap_allocs(void);
+
+// 单局环境
+SNAKE_API SnakeEnv *snake_env_create(int width, int height);
+SNAKE_API void snake_env_destroy(SnakeEnv *env);
+SNAKE_API void snake_env_shape(const SnakeEnv *env, int *channels, int *height, int *width);
+SNAKE_API void snake_reset(SnakeEnv *env, uint64_t seed);
+SNAKE_API int snake_step(SnakeEnv *env, int action, float *reward, uint8_t *done);
+SNAKE_API int snake_score(const SnakeEnv *env);
+SNAKE_API int snake_nearest_food(SnakeEnv *env, int *x, int *y);
+SNAKE_API void snake_observe(const SnakeEnv *env, uint8_t *out,
+                             ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w);
+SNAKE_API void snake_observe_reference(const SnakeEnv *env, uint8_t *out,
+                                       ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w);
+SNAKE_API int snake_save(const SnakeEnv *env, const char *path);
+SNAKE_API int snake_load(SnakeEnv *env, const char *path, int verify);
+SNAKE_API int snake_load_rules(SnakeEnv *env, const char *path);
+
+// 批量环境
+SNAKE_API SnakeBatch *snake_batch_create(int count, int width, int height);
+SNAKE_API void snake_batch_destroy(SnakeBatch *batch);
+SNAKE_API int snake_batch_size(const SnakeBatch *batch);
+SNAKE_API SnakeEnv *snake_batch_env(SnakeBatch *batch, int index);
+SNAKE_API void snake_batch_reset(SnakeBatch *batch, uint64_t seed);
+SNAKE_API void snake_batch_reset_one(SnakeBatch *batch, int index, uint64_t seed);
+SNAKE_API int snake_batch_set_parallel(SnakeBatch *batch, int mode, int threads);
+SNAKE_API void snake_batch_step(SnakeBatch *batch, const int32_t *actions, float *rewards, uint8_t *dones);
+SNAKE_API void snake_batch_observe(const SnakeBatch *batch, uint8_t *out, ptrdiff_t stride_n,
+                                   ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w);
+SNAKE_API void snake_batch_step_observe(SnakeBatch *batch, const int32_t *actions, float *rewards, uint8_t *dones,
+                                        uint8_t *out, ptrdiff_t stride_n,
+                                        ptrdiff_t stride_c, ptrdiff_t stride_h, ptrdiff_t stride_w);
+
+// 训练数据导出（批量环境的每一步写入文件，格式见snake_export.h）
+SNAKE_API int snake_batch_export_open(SnakeBatch *batch, const char *path, int chunk_steps);
+SNAKE_API int snake_batch_export_close(SnakeBatch *batch, uint64_t *written, uint64_t *dropped);
+
+// 神经网络策略（int8量化的两层感知机，权重文件格式见snake_nn.h）
+SNAKE_API SnakeNet *snake_net_load(const char *path);
+SNAKE_API void snake_net_destroy(SnakeNet *net);
+SNAKE_API int snake_net_set_simd(SnakeNet *net, int enabled);
+SNAKE_API void snake_batch_net_actions(SnakeBatch *batch, const SnakeNet *net, int32_t *actions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNAKE_API_H
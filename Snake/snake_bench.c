@@ -0,0 +1,348 @@
+/**
+ * @file snake_bench.c
+ * @brief libsnake 基准测试
+ *
+ * 只通过公共C接口（snake_api.h）测量：
+ * - 批量环境单步吞吐量（步/秒），调试构建下同时断言单步过程零堆分配
+ * - 观测编码吞吐量：快速版本snake_batch_observe与逐单元格参考实现对比，并校验结果一致
+ * - 推进+编码（snake_batch_step_observe）在所选并行方式下的吞吐量
+ * - 指定--export时：导出训练数据的同时单步的吞吐量，以及写出和丢弃的步数
+ * - 指定--net时：神经网络策略的决策吞吐量（标量内核与SIMD内核对比）、两个内核的动作是否逐步一致，
+ *   以及由网络控制所有环境时的对局得分（builtin表示内置权重）
+ *
+ * 用法: snake_bench [--envs N] [--steps S] [--board WxH] [--seed S]
+ *                   [--parallel serial|openmp|spin] [--threads N] [--export FILE] [--net FILE|builtin]
+ *
+ * 编码: UTF-8
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snake_api.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define BENCH_DEFAULT_ENVS 256   ///< 默认环境数量
+#define BENCH_DEFAULT_STEPS 2000 ///< 默认步数（每个环境）
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 获取单调时间（秒）
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief 基准测试用的简单随机数（与引擎无关，只用于产生动作）
+ */
+static unsigned int bench_random(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 16;
+}
+
+// =============================================
+// 主函数
+// =============================================
+
+int main(int argc, char **argv)
+{
+    int env_count = BENCH_DEFAULT_ENVS;
+    int steps = BENCH_DEFAULT_STEPS;
+    int width = 20, height = 20;
+    unsigned long long seed = 325;
+    int parallel = SNAKE_PARALLEL_SERIAL;
+    int threads = 0;
+    const char *export_path = NULL;
+    const char *net_path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--envs") == 0 && i + 1 < argc)
+            env_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            steps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            parallel = strcmp(name, "spin") == 0     ? SNAKE_PARALLEL_SPIN
+                       : strcmp(name, "openmp") == 0 ? SNAKE_PARALLEL_OPENMP
+                                                     : SNAKE_PARALLEL_SERIAL;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+            export_path = argv[++i];
+        else if (strcmp(argv[i], "--net") == 0 && i + 1 < argc)
+            net_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "用法: %s [--envs N] [--steps S] [--board WxH] [--seed S] "
+                            "[--parallel serial|openmp|spin] [--threads N] [--export FILE] [--net FILE|builtin]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (snake_abi_version() != SNAKE_ABI_VERSION)
+    {
+        fprintf(stderr, "libsnake ABI版本不匹配: %d != %d\n", snake_abi_version(), SNAKE_ABI_VERSION);
+        return 1;
+    }
+
+    SnakeBatch *batch = snake_batch_create(env_count, width, height);
+    if (batch == NULL)
+    {
+        fprintf(stderr, "无法创建批量环境（%d × %dx%d）\n", env_count, width, height);
+        return 1;
+    }
+    snake_batch_reset(batch, seed);
+    int used_threads = snake_batch_set_parallel(batch, parallel, threads);
+    printf("并行:     %s，%d 线程\n",
+           parallel == SNAKE_PARALLEL_SPIN ? "spin" : parallel == SNAKE_PARALLEL_OPENMP ? "openmp" : "serial",
+           used_threads);
+
+    int channels, obs_h, obs_w;
+    snake_env_shape(snake_batch_env(batch, 0), &channels, &obs_h, &obs_w);
+    size_t obs_per_env = (size_t)channels * (size_t)obs_h * (size_t)obs_w;
+
+    int32_t *actions = (int32_t *)malloc((size_t)env_count * sizeof(int32_t));
+    float *rewards = (float *)malloc((size_t)env_count * sizeof(float));
+    uint8_t *dones = (uint8_t *)malloc((size_t)env_count);
+    uint8_t *obs_fast = (uint8_t *)malloc(obs_per_env * (size_t)env_count);
+    uint8_t *obs_ref = (uint8_t *)malloc(obs_per_env * (size_t)env_count);
+    if (!actions || !rewards || !dones || !obs_fast || !obs_ref)
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+
+    // 1. 单步吞吐量（结束的局立即重开，保证每步都在推进游戏）
+    unsigned int rng = (unsigned int)seed;
+    unsigned long long resets = 0;
+    uint64_t heap_before = snake_debug_heap_allocs();
+    double start = now_seconds();
+    for (int s = 0; s < steps; s++)
+    {
+        for (int i = 0; i < env_count; i++)
+        {
+            actions[i] = (int32_t)(bench_random(&rng) & 3u);
+        }
+        snake_batch_step(batch, actions, rewards, dones);
+        for (int i = 0; i < env_count; i++)
+        {
+            if (dones[i])
+            {
+                snake_batch_reset_one(batch, i, seed + (++resets));
+            }
+        }
+    }
+    double step_time = now_seconds() - start;
+    uint64_t heap_allocs = snake_debug_heap_allocs() - heap_before;
+
+    double total_steps = (double)steps * (double)env_count;
+    printf("单步:     %.0f 步/秒（%d 个环境 × %d 步，%.3f 秒，重开 %llu 局）\n",
+           total_steps / step_time, env_count, steps, step_time, resets);
+    printf("堆分配:   %llu 次（调试构建下必须为0，发布构建不统计）\n", (unsigned long long)heap_allocs);
+    if (heap_allocs != 0)
+    {
+        fprintf(stderr, "错误: 游戏循环中发生了堆分配\n");
+        return 1;
+    }
+
+    // 2. 观测编码吞吐量：快速版本 vs 逐单元格参考实现
+    ptrdiff_t stride_w = 1;
+    ptrdiff_t stride_h = obs_w;
+    ptrdiff_t stride_c = (ptrdiff_t)obs_h * obs_w;
+    ptrdiff_t stride_n = (ptrdiff_t)obs_per_env;
+    int rounds = steps / 10 > 0 ? steps / 10 : 1;
+
+    start = now_seconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        snake_batch_observe(batch, obs_fast, stride_n, stride_c, stride_h, stride_w);
+    }
+    double fast_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < env_count; i++)
+        {
+            snake_observe_reference(snake_batch_env(batch, i), obs_ref + i * stride_n, stride_c, stride_h, stride_w);
+        }
+    }
+    double ref_time = now_seconds() - start;
+
+    double observations = (double)rounds * (double)env_count;
+    printf("观测编码: 快速 %.0f 次/秒，逐单元格 %.0f 次/秒，加速 %.2fx（%dx%dx%d）\n",
+           observations / fast_time, observations / ref_time, ref_time / fast_time, channels, obs_h, obs_w);
+
+    if (memcmp(obs_fast, obs_ref, obs_per_env * (size_t)env_count) != 0)
+    {
+        fprintf(stderr, "错误: 快速观测编码与参考实现结果不一致\n");
+        return 1;
+    }
+
+    // 3. 推进+编码（一次并行调度）
+    start = now_seconds();
+    for (int s = 0; s < steps; s++)
+    {
+        for (int i = 0; i < env_count; i++)
+        {
+            actions[i] = (int32_t)(bench_random(&rng) & 3u);
+        }
+        snake_batch_step_observe(batch, actions, rewards, dones, obs_fast, stride_n, stride_c, stride_h, stride_w);
+        for (int i = 0; i < env_count; i++)
+        {
+            if (dones[i])
+            {
+                snake_batch_reset_one(batch, i, seed + (++resets));
+            }
+        }
+    }
+    double fused_time = now_seconds() - start;
+    printf("推进+编码: %.0f 步/秒（每次调用 %.2f 微秒）\n",
+           total_steps / fused_time, fused_time * 1e6 / steps);
+
+    // 4. 导出训练数据时的单步吞吐量（与1对比即为导出对模拟线程的开销）
+    if (export_path != NULL)
+    {
+        if (snake_batch_export_open(batch, export_path, 0) != 0)
+        {
+            fprintf(stderr, "无法创建导出文件%s\n", export_path);
+            return 1;
+        }
+        heap_before = snake_debug_heap_allocs();
+        start = now_seconds();
+        for (int s = 0; s < steps; s++)
+        {
+            for (int i = 0; i < env_count; i++)
+            {
+                actions[i] = (int32_t)(bench_random(&rng) & 3u);
+            }
+            snake_batch_step(batch, actions, rewards, dones);
+            for (int i = 0; i < env_count; i++)
+            {
+                if (dones[i])
+                {
+                    snake_batch_reset_one(batch, i, seed + (++resets));
+                }
+            }
+        }
+        double export_time = now_seconds() - start;
+        heap_allocs = snake_debug_heap_allocs() - heap_before;
+
+        uint64_t written = 0, dropped = 0;
+        start = now_seconds();
+        int status = snake_batch_export_close(batch, &written, &dropped);
+        double close_time = now_seconds() - start;
+        printf("导出:     %.0f 步/秒，写出 %llu 步，丢弃 %llu 步，关闭用时 %.3f 秒\n",
+               total_steps / export_time, (unsigned long long)written, (unsigned long long)dropped, close_time);
+        if (status != 0 || heap_allocs != 0)
+        {
+            fprintf(stderr, "错误: %s\n", status != 0 ? "导出文件写出失败" : "导出时单步发生了堆分配");
+            return 1;
+        }
+    }
+
+    // 5. 神经网络策略
+    if (net_path != NULL)
+    {
+        SnakeNet *net = snake_net_load(strcmp(net_path, "builtin") == 0 ? NULL : net_path);
+        int32_t *simd_actions = (int32_t *)malloc((size_t)env_count * sizeof(int32_t));
+        double *episode = (double *)calloc((size_t)env_count, sizeof(double));
+        if (net == NULL || simd_actions == NULL || episode == NULL)
+        {
+            fprintf(stderr, "无法加载网络%s\n", net_path);
+            return 1;
+        }
+        int simd = snake_net_set_simd(net, 1);
+        snake_batch_reset(batch, seed);
+
+        // 决策吞吐量：同一批局面反复决策，只计网络（编码 + 前向 + 选择）的时间
+        double decide_time[2] = {0.0, 0.0};
+        for (int kernel = 0; kernel < (simd ? 2 : 1); kernel++)
+        {
+            snake_net_set_simd(net, kernel);
+            start = now_seconds();
+            for (int r = 0; r < rounds; r++)
+            {
+                snake_batch_net_actions(batch, net, actions);
+            }
+            decide_time[kernel] = now_seconds() - start;
+        }
+        double decisions = (double)rounds * (double)env_count;
+        if (simd)
+        {
+            printf("网络决策: 标量 %.0f 次/秒，SIMD %.0f 次/秒，加速 %.2fx\n", decisions / decide_time[0],
+                   decisions / decide_time[1], decide_time[0] / decide_time[1]);
+        }
+        else
+        {
+            printf("网络决策: 标量 %.0f 次/秒（CPU不支持SIMD内核）\n", decisions / decide_time[0]);
+        }
+
+        // 对局：每步两个内核各决策一次并比较，按标量内核的动作推进
+        unsigned long long mismatches = 0, games = 0;
+        double finished_score = 0.0, total_score = 0.0;
+        for (int s = 0; s < steps; s++)
+        {
+            snake_net_set_simd(net, 0);
+            snake_batch_net_actions(batch, net, actions);
+            if (simd)
+            {
+                snake_net_set_simd(net, 1);
+                snake_batch_net_actions(batch, net, simd_actions);
+                mismatches += memcmp(actions, simd_actions, (size_t)env_count * sizeof(int32_t)) != 0;
+            }
+            snake_batch_step(batch, actions, rewards, dones);
+            for (int i = 0; i < env_count; i++)
+            {
+                episode[i] += rewards[i];
+                total_score += rewards[i];
+                if (dones[i])
+                {
+                    finished_score += episode[i];
+                    episode[i] = 0.0;
+                    games++;
+                    snake_batch_reset_one(batch, i, seed + (++resets));
+                }
+            }
+        }
+        printf("网络对局: 结束 %llu 局，平均每局得分 %.1f，每千步得分 %.1f，内核动作不一致 %llu 步\n", games,
+               games > 0 ? finished_score / (double)games : 0.0, total_score * 1000.0 / total_steps, mismatches);
+        free(simd_actions);
+        free(episode);
+        snake_net_destroy(net);
+        if (mismatches != 0)
+        {
+            fprintf(stderr, "错误: SIMD内核与标量内核的决策不一致\n");
+            return 1;
+        }
+    }
+
+    free(actions);
+    free(rewards);
+    free(dones);
+    free(obs_fast);
+    free(obs_ref);
+    snake_batch_destroy(batch);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file snake_blocks.c
+ * @brief 分块占用摘要：按8×8网格分块的各类单元格计数
+ *
+ * 缩小显示时每个8×8单元格的块只显示一个字符，按"蛇头 > 蛇 > 食物 > 墙壁 > 空"取块内优先级最高的一类。
+ * 每块保存蛇、食物、墙壁的单元格个数（最多64，一个字节即可），判断一类是否存在只看计数是否非零：
+ * - 单元格改变：旧类型的计数减一、新类型的计数加一，并标记块需要重新绘制，O(1)
+ * - 绘制一个块：读一个BlockCounts，与块内单元格数无关
+ *
+ * 因此缩小显示的绘制代价只取决于屏幕上显示的块数，与游戏池大小无关。
+ * 与食物索引一样，第一次使用时才建立（扫描整个游戏池），此后由set_cell_type增量维护；
+ * 不绘制的上下文（无界面模式、搜索副本）没有任何额外开销。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_core.h"
+
+#include <assert.h>
+#include <string.h>
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 单元格坐标 → 所在块
+ */
+static BlockCounts *block_of(BlockSummary *lod, int x, int y)
+{
+    return &lod->blocks[(y >> BLOCK_SHIFT) * lod->blocks_x + (x >> BLOCK_SHIFT)];
+}
+
+/**
+ * @brief 按单元格类型增减块计数（空单元格不计数）
+ */
+static void count_cell(BlockCounts *block, CellType type, int delta)
+{
+    if (type == CELL_EMPTY)
+    {
+        return;
+    }
+    uint8_t *counter = type == CELL_FOOD ? &block->food : type == CELL_WALL ? &block->wall : &block->snake;
+    *counter = (uint8_t)(*counter + delta);
+}
+
+// =============================================
+// 建立和维护
+// =============================================
+
+/**
+ * @brief 扫描整个游戏池重新建立分块占用摘要，所有块都标记为需要重新绘制
+ *
+ * @param ctx 游戏上下文（摘要数组必须已分配）
+ */
+void block_summary_rebuild(GameContext *ctx)
+{
+    BlockSummary *lod = &ctx->lod;
+    memset(lod->blocks, 0, (size_t)lod->blocks_x * (size_t)lod->blocks_y * sizeof(BlockCounts));
+    for (int y = 0; y < ctx->pool_height; y++)
+    {
+        const CellType *row = ctx->pool + (size_t)y * (size_t)ctx->pool_width;
+        for (int x = 0; x < ctx->pool_width; x++)
+        {
+            count_cell(block_of(lod, x, y), row[x], 1);
+        }
+    }
+    for (int i = 0; i < lod->blocks_x * lod->blocks_y; i++)
+    {
+        lod->blocks[i].dirty = true;
+    }
+    lod->ready = true;
+}
+
+/**
+ * @brief 单元格改变后更新所在块的计数（由set_cell_type调用，O(1)）
+ *
+ * 类型不变的写入（如蛇头变为蛇身）也标记块需要重新绘制：蛇头所在的块显示为蛇头。
+ *
+ * @param ctx 游戏上下文
+ * @param pos 单元格位置
+ * @param old_type 原来的单元格类型
+ * @param new_type 新的单元格类型
+ */
+void block_cell_changed(GameContext *ctx, Position pos, CellType old_type, CellType new_type)
+{
+    BlockCounts *block = block_of(&ctx->lod, pos.x, pos.y);
+    count_cell(block, old_type, -1);
+    count_cell(block, new_type, 1);
+    assert(block->snake <= BLOCK_SIZE * BLOCK_SIZE && block->food <= BLOCK_SIZE * BLOCK_SIZE &&
+           block->wall <= BLOCK_SIZE * BLOCK_SIZE);
+    block->dirty = true;
+}
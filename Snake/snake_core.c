@@ -0,0 +1,977 @@
+/**
+ * @file snake_core.c
+ * @brief 贪吃蛇游戏引擎实现
+ *
+ * 内存区域、游戏上下文、游戏池管理和每帧更新逻辑。
+ * 本文件不依赖任何平台API，也不做文件和控制台读写。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_core.h"
+#include "snake_save.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// =============================================
+// 常量定义
+// =============================================
+
+// 单步函数模板需要内联进每个特化版本，规则开关才会成为编译期常量
+#if defined(_MSC_VER)
+#define FORCE_INLINE __forceinline
+#elif defined(__GNUC__)
+#define FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define FORCE_INLINE inline
+#endif
+
+#define OBSTACLE_CLEARANCE 3 ///< 开局时蛇头正前方不放障碍物的格数
+
+static const int dir_dx[] = {0, 0, -1, 1}; ///< 各方向的X偏移
+static const int dir_dy[] = {-1, 1, 0, 0}; ///< 各方向的Y偏移
+
+// =============================================
+// 全局变量
+// =============================================
+
+#ifndef NDEBUG
+size_t heap_alloc_count = 0; ///< 堆分配次数（仅调试构建），用于断言每帧零堆分配
+#endif
+
+// =============================================
+// 内存区域管理函数
+// =============================================
+
+/**
+ * @brief 从堆上申请内存
+ *
+ * 程序中所有malloc调用的唯一入口。调试构建下会累计分配次数，
+ * 以便断言游戏循环（每次update_game）中没有发生堆分配。
+ *
+ * @param size 申请的字节数
+ * @return void* 申请到的内存，失败返回NULL
+ */
+void *heap_alloc(size_t size)
+{
+#ifndef NDEBUG
+    heap_alloc_count++;
+#endif
+    return malloc(size);
+}
+
+/**
+ * @brief 将字节数向上对齐到ARENA_ALIGNMENT
+ */
+static size_t arena_align(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief 初始化内存区域
+ *
+ * 一次性从堆上申请capacity字节作为内存区域的后备存储，此后的分配都不再访问堆。
+ *
+ * @param arena 要初始化的内存区域
+ * @param capacity 内存区域容量（字节）
+ * @return true 初始化成功
+ * @return false 堆内存不足
+ */
+bool arena_init(Arena *arena, size_t capacity)
+{
+    arena->capacity = arena_align(capacity);
+    arena->used = 0;
+#ifndef NDEBUG
+    arena->alloc_count = 0;
+#endif
+    arena->base = (unsigned char *)heap_alloc(arena->capacity);
+    return arena->base != NULL;
+}
+
+/**
+ * @brief 销毁内存区域，归还后备存储
+ */
+void arena_destroy(Arena *arena)
+{
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+/**
+ * @brief 从内存区域中分配内存
+ *
+ * 只移动偏移量，返回的地址按ARENA_ALIGNMENT对齐。内存不会被清零。
+ *
+ * @param arena 内存区域
+ * @param size 申请的字节数
+ * @return void* 分配到的内存，容量不足时返回NULL
+ */
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = arena_align(size);
+    if (size > arena->capacity - arena->used)
+    {
+        return NULL;
+    }
+
+    void *ptr = arena->base + arena->used;
+    arena->used += size;
+#ifndef NDEBUG
+    arena->alloc_count++;
+#endif
+    return ptr;
+}
+
+/**
+ * @brief 重置内存区域（O(1)）
+ *
+ * 一次性释放内存区域中的所有分配，之前返回的指针全部失效。
+ */
+void arena_reset(Arena *arena)
+{
+    arena->used = 0;
+#ifndef NDEBUG
+    arena->alloc_count = 0;
+#endif
+}
+
+/**
+ * @brief 记录内存区域当前的分配位置
+ *
+ * 与arena_restore配对使用，用于在一帧之内多次申请和归还临时内存。
+ *
+ * @param arena 内存区域
+ * @return size_t 当前分配位置
+ */
+size_t arena_save(const Arena *arena)
+{
+    return arena->used;
+}
+
+/**
+ * @brief 归还arena_save之后的所有分配（O(1)）
+ *
+ * @param arena 内存区域
+ * @param saved arena_save的返回值
+ */
+void arena_restore(Arena *arena, size_t saved)
+{
+    assert(saved <= arena->used);
+    arena->used = saved;
+}
+
+// =============================================
+// 游戏上下文管理函数
+// =============================================
+
+/**
+ * @brief 初始化游戏上下文
+ *
+ * 根据游戏区域尺寸计算游戏池尺寸，并为两个内存区域申请后备存储。
+ * 除可达区域第一次查询时的一次申请外（见snake_reach.c），这是游戏上下文生命周期内仅有的堆分配，
+ * 之后的重玩和游戏循环都不再申请堆内存。
+ *
+ * @param ctx 游戏上下文
+ * @param game_width 游戏区域宽度（不包含边框）
+ * @param game_height 游戏区域高度（不包含边框）
+ * @return true 初始化成功
+ * @return false 堆内存不足
+ */
+bool init_game_context(GameContext *ctx, int game_width, int game_height)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->pool_width = game_width + 2;
+    ctx->pool_height = game_height + 2;
+
+    Ruleset rules;
+    default_ruleset(&rules);
+    apply_ruleset(ctx, &rules);
+
+    // 单局内存区域：游戏池 + 脏标记数组 + 食物索引的桶掩码 + 分块占用摘要 + 邻居坐标表
+    // （可达区域的数组和搜索队列在第一次查询时另行申请，见snake_reach.c）
+    // （按有边框的布局计算，环面布局的游戏池更小，之后改变穿墙规则也不会超出容量）
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    size_t bucket_count = (size_t)((ctx->pool_width + FOOD_BUCKET_SIZE - 1) >> FOOD_BUCKET_SHIFT) *
+                          (size_t)((ctx->pool_height + FOOD_BUCKET_SIZE - 1) >> FOOD_BUCKET_SHIFT);
+    size_t block_count = (size_t)((ctx->pool_width + BLOCK_SIZE - 1) >> BLOCK_SHIFT) *
+                         (size_t)((ctx->pool_height + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
+    size_t game_bytes = arena_align(cell_count * sizeof(CellType)) + arena_align(cell_count * sizeof(bool)) +
+                        arena_align(bucket_count * sizeof(uint64_t)) + arena_align(block_count * sizeof(BlockCounts)) +
+                        arena_align((size_t)(ctx->pool_width + 2) * sizeof(int32_t)) +
+                        arena_align((size_t)(ctx->pool_height + 2) * sizeof(int32_t));
+
+    if (!arena_init(&ctx->game_arena, game_bytes) || !arena_init(&ctx->tick_arena, TICK_ARENA_MIN_SIZE))
+    {
+        destroy_game_context(ctx);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 销毁游戏上下文，归还内存区域（包括可达区域的）的后备存储和存档映射
+ */
+void destroy_game_context(GameContext *ctx)
+{
+    release_saved_game(ctx);
+    arena_destroy(&ctx->game_arena);
+    arena_destroy(&ctx->tick_arena);
+    arena_destroy(&ctx->reach.arena);
+    ctx->reach.label = NULL;
+    ctx->reach.ready = false;
+    ctx->pool = NULL;
+    ctx->dirty = NULL;
+}
+
+/**
+ * @brief 重置单局内存区域并重新分配单局数组
+ *
+ * 释放上一局的全部单局内存和存档映射，重新分配脏标记数组、食物索引和分块占用摘要（都在第一次使用时建立），
+ * 作废可达区域（下次查询时按当前布局重新分配和建立），并按当前布局重新填写邻居坐标表。
+ *
+ * @param ctx 游戏上下文
+ * @param allocate_pool 是否同时分配游戏池（从存档加载时游戏池直接使用文件映射，不需要分配）
+ */
+void reset_game_arena(GameContext *ctx, bool allocate_pool)
+{
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    release_saved_game(ctx);
+    arena_reset(&ctx->game_arena);
+
+    ctx->pool = allocate_pool ? (CellType *)arena_alloc(&ctx->game_arena, cell_count * sizeof(CellType)) : NULL;
+    ctx->dirty = (bool *)arena_alloc(&ctx->game_arena, cell_count * sizeof(bool));
+    assert((ctx->pool != NULL || !allocate_pool) && ctx->dirty != NULL); // 容量在init_game_context中按游戏池尺寸计算
+
+    ctx->reach.ready = false;
+    ctx->reach.label = NULL;
+
+    FoodIndex *food = &ctx->food;
+    food->ready = false;
+    food->buckets_x = (ctx->pool_width + FOOD_BUCKET_SIZE - 1) >> FOOD_BUCKET_SHIFT;
+    food->buckets_y = (ctx->pool_height + FOOD_BUCKET_SIZE - 1) >> FOOD_BUCKET_SHIFT;
+    food->mask = (uint64_t *)arena_alloc(&ctx->game_arena, (size_t)food->buckets_x * (size_t)food->buckets_y * sizeof(uint64_t));
+    assert(food->mask != NULL);
+
+    BlockSummary *lod = &ctx->lod;
+    lod->ready = false;
+    lod->blocks_x = (ctx->pool_width + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+    lod->blocks_y = (ctx->pool_height + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+    lod->blocks = (BlockCounts *)arena_alloc(&ctx->game_arena, (size_t)lod->blocks_x * (size_t)lod->blocks_y * sizeof(BlockCounts));
+    assert(lod->blocks != NULL);
+
+    // 邻居坐标表：环面布局下越界的-1和pool_width（pool_height）回到对边，有边框的布局下原样保留
+    ctx->wrap_x = (int32_t *)arena_alloc(&ctx->game_arena, (size_t)(ctx->pool_width + 2) * sizeof(int32_t));
+    ctx->wrap_y = (int32_t *)arena_alloc(&ctx->game_arena, (size_t)(ctx->pool_height + 2) * sizeof(int32_t));
+    assert(ctx->wrap_x != NULL && ctx->wrap_y != NULL);
+    for (int x = -1; x <= ctx->pool_width; x++)
+    {
+        ctx->wrap_x[x + 1] = ctx->torus ? (x + ctx->pool_width) % ctx->pool_width : x;
+    }
+    for (int y = -1; y <= ctx->pool_height; y++)
+    {
+        ctx->wrap_y[y + 1] = ctx->torus ? (y + ctx->pool_height) % ctx->pool_height : y;
+    }
+}
+
+/**
+ * @brief 复制一局游戏（游戏池、游戏状态、随机数状态和规则）
+ *
+ * 供搜索类策略在副本上推演，不申请内存。两个上下文的游戏池尺寸和布局必须相同，
+ * 目标上下文必须已经开始过一局（游戏池已分配）。
+ * 源上下文的食物索引已建立时一起复制（桶掩码每个单元格1位，只有游戏池的1/32），
+ * 目标的可达区域作废，下次查询时重建；脏标记不复制（副本不用于绘制）。
+ *
+ * @param dst 目标上下文
+ * @param src 源上下文
+ */
+void copy_game_state(GameContext *dst, const GameContext *src)
+{
+    assert(dst->pool_width == src->pool_width && dst->pool_height == src->pool_height && dst->torus == src->torus);
+    assert(dst->pool != NULL);
+    memcpy(dst->pool, src->pool, (size_t)src->pool_width * (size_t)src->pool_height * sizeof(CellType));
+    dst->game = src->game;
+    dst->rng = src->rng;
+    dst->rules = src->rules;
+    dst->step = src->step;
+    dst->reach.ready = false;
+    dst->lod.ready = false;
+    dst->food.ready = src->food.ready;
+    if (src->food.ready)
+    {
+        memcpy(dst->food.mask, src->food.mask, (size_t)src->food.buckets_x * (size_t)src->food.buckets_y * sizeof(uint64_t));
+        dst->food.count = src->food.count;
+    }
+}
+
+/**
+ * @brief 设置随机数种子
+ *
+ * 相同种子得到相同的随机序列；xorshift状态不能为0。
+ *
+ * @param ctx 游戏上下文
+ * @param seed 随机数种子
+ */
+void seed_game_random(GameContext *ctx, uint64_t seed)
+{
+    ctx->rng = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (ctx->rng == 0)
+    {
+        ctx->rng = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+/**
+ * @brief 生成一个32位随机数
+ *
+ * 使用上下文自带的xorshift64*生成器，替代全局的rand()。
+ * 每个上下文的随机序列只取决于init_game_state传入的种子，多局并行时互不干扰且可复现。
+ *
+ * @param ctx 游戏上下文
+ * @return uint32_t 随机数
+ */
+uint32_t game_random(GameContext *ctx)
+{
+    uint64_t x = ctx->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    ctx->rng = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// =============================================
+// 游戏池初始化和管理
+// =============================================
+
+/**
+ * 初始化游戏池
+ *
+ * 功能：将游戏池二维数组所有单元格初始化为CELL_EMPTY，并设置四周边框为CELL_WALL。
+ * 此函数在游戏开始时调用，创建游戏的基本网格结构。
+ *
+ * 实现步骤：
+ *   1. 遍历所有单元格，设置为CELL_EMPTY
+ *   2. 设置上边框和下边框为CELL_WALL
+ *   3. 设置左边框和右边框为CELL_WALL
+ *   （环面布局没有边框，只做第1步）
+ *
+ * @param ctx 游戏上下文（pool和dirty必须已分配）
+ */
+void init_pool(GameContext *ctx)
+{
+    // 清空所有单元格
+    int cell_count = ctx->pool_width * ctx->pool_height;
+    for (int i = 0; i < cell_count; i++)
+    {
+        ctx->pool[i] = CELL_EMPTY;
+        ctx->dirty[i] = false;
+    }
+    if (ctx->torus)
+    {
+        return;
+    }
+
+    // 设置墙壁
+    for (int x = 0; x < ctx->pool_width; x++)
+    {
+        set_cell_type(ctx, (Position){x, 0}, CELL_WALL);                    // 上边框
+        set_cell_type(ctx, (Position){x, ctx->pool_height - 1}, CELL_WALL); // 下边框
+    }
+    for (int y = 0; y < ctx->pool_height; y++)
+    {
+        set_cell_type(ctx, (Position){0, y}, CELL_WALL);                   // 左边框
+        set_cell_type(ctx, (Position){ctx->pool_width - 1, y}, CELL_WALL); // 右边框
+    }
+}
+
+/**
+ * @brief 写入单元格并维护脏标记、可达区域、食物索引和分块占用摘要（不做边界检查）
+ *
+ * set_cell_type和单步函数共用；单步函数算出的坐标总在游戏池内，不需要逐次检查。
+ */
+static FORCE_INLINE void store_cell(GameContext *ctx, Position pos, CellType type)
+{
+    int index = pos.y * ctx->pool_width + pos.x;
+    CellType old_type = ctx->pool[index];
+    bool was_open = CELL_IS_OPEN(old_type);
+    bool was_food = old_type == CELL_FOOD;
+    ctx->pool[index] = type;
+    ctx->dirty[index] = true;
+
+    // 开放状态改变时增量维护可达区域（空单元格与食物之间的变化不影响连通性）
+    if (ctx->reach.ready && was_open != CELL_IS_OPEN(type))
+    {
+        reach_cell_changed(ctx, index, !was_open);
+    }
+    if (ctx->food.ready && was_food != (type == CELL_FOOD))
+    {
+        food_cell_changed(ctx, pos, !was_food);
+    }
+    if (ctx->lod.ready)
+    {
+        block_cell_changed(ctx, pos, old_type, type);
+    }
+}
+
+/**
+ * 在游戏池中设置单元格类型
+ *
+ * 功能：将游戏池中指定坐标的单元格设置为指定的类型。
+ * 此函数包含边界检查，确保坐标在有效范围内。
+ * 单元格在开放（空单元格、食物）和关闭之间变化时同步更新可达区域，
+ * 变为食物或不再是食物时同步更新食物索引，分块占用摘要已建立时同步更新所在块的计数。
+ *
+ * @param ctx  游戏上下文
+ * @param pos  目标单元格的位置（包含x和y坐标）
+ * @param type 要设置的单元格类型（CellType枚举值）
+ */
+void set_cell_type(GameContext *ctx, Position pos, CellType type)
+{
+    if (pos.x >= 0 && pos.x < ctx->pool_width && pos.y >= 0 && pos.y < ctx->pool_height)
+    {
+        store_cell(ctx, pos, type);
+    }
+}
+
+/**
+ * 获取游戏池中单元格类型
+ *
+ * 功能：获取游戏池中指定坐标的单元格当前类型。
+ * 此函数包含边界检查，如果坐标越界则返回CELL_WALL（视为墙壁）。
+ *
+ * @param ctx 游戏上下文
+ * @param pos 目标单元格的位置（包含x和y坐标）
+ * @return CellType 指定坐标的单元格类型，如果越界则返回CELL_WALL
+ */
+CellType get_cell_type(const GameContext *ctx, Position pos)
+{
+    if (pos.x >= 0 && pos.x < ctx->pool_width && pos.y >= 0 && pos.y < ctx->pool_height)
+    {
+        return ctx->pool[pos.y * ctx->pool_width + pos.x];
+    }
+    return CELL_WALL; // 越界视为墙壁
+}
+
+/**
+ * @brief 沿方向移动一格后的位置
+ *
+ * 环面布局下越过游戏池边缘时从对边进入（查邻居坐标表，不做比较）；
+ * 有边框的布局下原样加上方向偏移（从游戏区域内出发最多走到边框上）。
+ * 自动策略用它代替自己计算蛇头前方的单元格，两种布局都不需要关心边缘。
+ *
+ * @param ctx 游戏上下文
+ * @param pos 起点（在游戏池内）
+ * @param dir 方向
+ * @return Position 相邻单元格的位置
+ */
+Position neighbor_position(const GameContext *ctx, Position pos, Direction dir)
+{
+    return (Position){ctx->wrap_x[pos.x + dir_dx[dir] + 1], ctx->wrap_y[pos.y + dir_dy[dir] + 1]};
+}
+
+/**
+ * @brief 两个单元格之间的曼哈顿距离（环面布局下每个方向取绕行和不绕行中较短的一段）
+ */
+int cell_distance(const GameContext *ctx, Position a, Position b)
+{
+    int dx = abs(a.x - b.x);
+    int dy = abs(a.y - b.y);
+    if (ctx->torus)
+    {
+        dx = dx < ctx->pool_width - dx ? dx : ctx->pool_width - dx;
+        dy = dy < ctx->pool_height - dy ? dy : ctx->pool_height - dy;
+    }
+    return dx + dy;
+}
+
+// =============================================
+// 游戏逻辑函数
+// =============================================
+
+/**
+ * @brief 按规则在游戏区域内随机放置障碍物（墙壁）
+ *
+ * 障碍物只放在空单元格上，并避开蛇头正前方的几格（沿neighbor_position前进，环面布局下越过边缘回到对边），
+ * 开局不会立即撞上。游戏区域太挤放不下时少放几个。
+ */
+static void place_obstacles(GameContext *ctx)
+{
+    const GameState *game = &ctx->game;
+    int attempts = ctx->pool_width * ctx->pool_height * 2;
+
+    // 蛇头正前方的空单元格（遇到边框或蛇身为止）
+    Position ahead[OBSTACLE_CLEARANCE];
+    int clear = 0;
+    for (Position pos = game->snake.head; clear < OBSTACLE_CLEARANCE; clear++)
+    {
+        pos = neighbor_position(ctx, pos, game->snake.direction);
+        if (get_cell_type(ctx, pos) != CELL_EMPTY)
+        {
+            break;
+        }
+        ahead[clear] = pos;
+    }
+
+    for (int placed = 0; placed < ctx->rules.obstacles && attempts > 0; attempts--)
+    {
+        // 两次取随机数分开写：初始化列表中各表达式的求值顺序不确定，不同编译器得到的局面会不同
+        Position pos;
+        pos.x = (int)(game_random(ctx) % (uint32_t)ctx->pool_width);
+        pos.y = (int)(game_random(ctx) % (uint32_t)ctx->pool_height);
+        bool protected = false;
+        for (int i = 0; i < clear; i++)
+        {
+            protected = protected || (pos.x == ahead[i].x && pos.y == ahead[i].y);
+        }
+        if (!protected && get_cell_type(ctx, pos) == CELL_EMPTY)
+        {
+            set_cell_type(ctx, pos, CELL_WALL);
+            placed++;
+        }
+    }
+}
+
+/**
+ * @brief 初始化游戏状态（用于首次启动和重玩）
+ *
+ * 只初始化游戏状态，不包括控制台初始化。
+ * 用于在游戏结束后重新开始游戏，保持相同的控制台环境。
+ *
+ * 实现步骤：
+ * 1. 初始化游戏状态变量（分数、速度、游戏结束标志）
+ * 2. 初始化蛇的状态（长度、方向、初始位置）
+ * 3. 重置单局内存区域（释放存档映射），重新分配游戏池和脏标记数组
+ * 4. 初始化游戏池（清空所有单元格并设置边框）
+ * 5. 在游戏池中设置蛇的初始位置（头、身、尾）
+ * 6. 按规则放置障碍物，生成规则规定个数的食物
+ *
+ * @param ctx 游戏上下文（必须已通过init_game_context初始化）
+ * @param seed 随机数种子（相同种子和相同输入序列得到完全相同的一局游戏）
+ *
+ * @note 每次调用都会重新初始化随机数种子，确保食物生成随机性。
+ * @note 最高分不在此处理：引擎不做文件读写，由调用方负责加载和保存。
+ * @note 上一局从单局内存区域分配的所有内存在此一次性释放。
+ */
+void init_game_state(GameContext *ctx, uint64_t seed)
+{
+    GameState *game = &ctx->game;
+
+    // 重新初始化随机数种子（每次重玩都应该重新种子）
+    ctx->seed = seed;
+    seed_game_random(ctx, seed);
+
+    // 初始化游戏状态变量
+    game->score = 0;
+    game->game_over = false;
+    game->death = DEATH_NONE;
+    game->paused = false;
+    game->speed = ctx->rules.initial_speed;
+
+    // 初始化蛇
+    game->snake.length = 3;
+    game->snake.direction = DIR_RIGHT;
+    game->snake.next_direction = DIR_RIGHT;
+    game->snake.tail_direction = DIR_RIGHT;
+    game->snake.pending_growth = 0;
+
+    // 蛇的初始位置（在游戏区域中央）
+    int start_x = ctx->pool_width / 2 + 1;
+    int start_y = ctx->pool_height / 2;
+
+    // 设置蛇头和蛇尾位置
+    game->snake.head.x = start_x;
+    game->snake.head.y = start_y;
+    game->snake.tail.x = start_x - (game->snake.length - 1);
+    game->snake.tail.y = start_y;
+    game->food = game->snake.head; // 放不下任何食物时（游戏区域太挤）仍指向游戏区域内
+
+    // 释放上一局的单局内存（包括存档映射），重新分配游戏池和脏标记数组
+    reset_game_arena(ctx, true);
+
+    // 初始化游戏池
+    init_pool(ctx);
+
+    // 在游戏池中设置蛇的位置
+    // 设置蛇头
+    set_cell_type(ctx, game->snake.head, CELL_SNAKE_HEAD);
+
+    // 设置蛇身
+    set_cell_type(ctx, (Position){game->snake.head.x - 1, game->snake.head.y}, CELL_SNAKE_BODY_RIGHT);
+
+    // 设置蛇尾
+    set_cell_type(ctx, game->snake.tail, CELL_SNAKE_TAIL);
+
+    // 障碍物和食物（默认规则没有障碍物、只有一个食物，不额外消耗随机数）
+    place_obstacles(ctx);
+    for (int i = 0; i < ctx->rules.food_count && !game->game_over; i++)
+    {
+        generate_food(ctx);
+    }
+}
+
+/**
+ * 生成食物
+ *
+ * 功能：在游戏池的随机空单元格中生成食物。
+ * 使用随机数生成器选择坐标，确保不会在蛇身体或墙壁上生成食物。
+ *
+ * 实现步骤：
+ *   1. 随机生成X和Y坐标
+ *   2. 检查该位置是否为CELL_EMPTY
+ *   3. 如果不是空单元格，则重试（最多尝试游戏池单元格数 * 2次）
+ *   4. 如果找不到合适位置，游戏结束（视为胜利）
+ *   5. 在找到的空单元格设置CELL_FOOD类型，并更新game.food位置
+ */
+void generate_food(GameContext *ctx)
+{
+    GameState *game = &ctx->game;
+
+    int x, y;
+    int attempts = 0;
+    const int max_attempts = ctx->pool_width * ctx->pool_height * 2;
+
+    do
+    {
+        x = (int)(game_random(ctx) % (uint32_t)ctx->pool_width);
+        y = (int)(game_random(ctx) % (uint32_t)ctx->pool_height);
+        attempts++;
+
+        if (attempts > max_attempts)
+        {
+            // 如果找不到合适的位置，游戏胜利
+            game->game_over = true;
+            game->death = DEATH_BOARD_FULL;
+            return;
+        }
+    } while (get_cell_type(ctx, (Position){x, y}) != CELL_EMPTY);
+
+    game->food.x = x;
+    game->food.y = y;
+    set_cell_type(ctx, (Position){x, y}, CELL_FOOD);
+}
+
+/**
+ * 根据方向获取对应的蛇身类型
+ *
+ * 功能：将Direction枚举值转换为对应的蛇身单元格类型（CellType）。
+ * 此函数用于在蛇移动时将旧蛇头转换为对应方向的蛇身部分。
+ *
+ * @param dir 方向枚举值（DIR_UP/DIR_DOWN/DIR_LEFT/DIR_RIGHT）
+ * @return CellType 对应的蛇身类型（CELL_SNAKE_BODY_*）
+ */
+CellType direction_to_body_type(Direction dir)
+{
+    switch (dir)
+    {
+    case DIR_UP:
+        return CELL_SNAKE_BODY_UP;
+    case DIR_DOWN:
+        return CELL_SNAKE_BODY_DOWN;
+    case DIR_LEFT:
+        return CELL_SNAKE_BODY_LEFT;
+    case DIR_RIGHT:
+        return CELL_SNAKE_BODY_RIGHT;
+    default:
+        return CELL_SNAKE_BODY_RIGHT; // 默认
+    }
+}
+
+/**
+ * 根据蛇身类型获取对应的方向
+ *
+ * 功能：direction_to_body_type的逆运算，用于移动蛇尾时沿蛇身方向找到下一节。
+ *
+ * @param type 蛇身单元格类型（CELL_SNAKE_BODY_*）
+ * @return Direction 对应的方向，非蛇身类型返回DIR_RIGHT
+ */
+Direction body_type_to_direction(CellType type)
+{
+    if (type >= CELL_SNAKE_BODY_UP && type <= CELL_SNAKE_BODY_RIGHT)
+    {
+        return (Direction)(type - CELL_SNAKE_BODY_UP);
+    }
+    return DIR_RIGHT; // 默认
+}
+
+/**
+ * @brief 请求蛇转向
+ *
+ * 把方向写入输入缓冲（next_direction），在下一次update_game时生效。
+ * 只允许不与当前方向相反的新方向，防止蛇直接反向移动。
+ *
+ * @param ctx 游戏上下文
+ * @param dir 请求的方向
+ */
+void turn_snake(GameContext *ctx, Direction dir)
+{
+    static const Direction opposite[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+    if (ctx->game.snake.direction != opposite[dir])
+    {
+        ctx->game.snake.next_direction = dir;
+    }
+}
+
+/**
+ * @brief 沿方向移动一格（环面布局查邻居坐标表，有边框的布局直接相加）
+ */
+static FORCE_INLINE Position step_position(const GameContext *ctx, Position pos, Direction dir, bool wrap)
+{
+    pos.x += dir_dx[dir];
+    pos.y += dir_dy[dir];
+    if (wrap)
+    {
+        pos.x = ctx->wrap_x[pos.x + 1];
+        pos.y = ctx->wrap_y[pos.y + 1];
+    }
+    return pos;
+}
+
+/**
+ * @brief 读取单元格（不做边界检查，坐标由单步函数保证在游戏池内）
+ */
+static FORCE_INLINE CellType load_cell(const GameContext *ctx, Position pos)
+{
+    return ctx->pool[pos.y * ctx->pool_width + pos.x];
+}
+
+/**
+ * 更新游戏逻辑（单步函数模板）
+ *
+ * 功能：更新游戏状态，包括蛇的移动、碰撞检测、食物检测和分数更新。
+ * wrap和variable_growth在每个特化版本中都是常量，内联后对应的分支被编译器消除，
+ * 默认规则的特化版本与规则可配置之前写死的update_game执行相同的操作。
+ *
+ * 实现步骤：
+ *   0. 重置每帧临时内存区域（O(1)）
+ *   1. 如果游戏已结束，直接返回
+ *   2. 应用输入的方向缓冲（game.snake.next_direction）
+ *   3. 根据当前方向计算新蛇头位置（环面布局下越过边缘回到对边）
+ *   4. 检查碰撞（墙壁、障碍物、蛇身体）
+ *   5. 检查是否吃到食物，吃到时按规则增加分数、速度和待长出的节数
+ *   6. 需要增长时蛇尾不动、长度加1，否则移动蛇尾（清除旧蛇尾，找到新蛇尾）
+ *   7. 吃到食物时生成新食物
+ *   8. 将旧蛇头变为蛇身，设置新蛇头位置
+ *
+ * 注意：此函数使用简化算法，只跟踪蛇头和蛇尾位置，通过游戏池单元格方向确定身体连接。
+ * 注意：此函数不得申请堆内存，每帧临时数据一律从ctx->tick_arena分配。
+ * 注意：读写单元格不做边界检查：有边框时蛇头在游戏区域内，前方最多是边框；环面布局下坐标查表回绕。
+ *
+ * @param ctx 游戏上下文
+ * @param wrap 穿墙规则（环面布局）
+ * @param variable_growth 每个食物增长的节数不是1（需要维护待长出的节数）
+ */
+static FORCE_INLINE void step_template(GameContext *ctx, bool wrap, bool variable_growth)
+{
+    GameState *game = &ctx->game;
+
+    // 上一帧的临时数据全部作废
+    arena_reset(&ctx->tick_arena);
+    if (game->game_over)
+    {
+        return;
+    }
+
+    // 应用输入的方向
+    game->snake.direction = game->snake.next_direction;
+
+    // 根据方向计算新蛇头位置
+    Position head = game->snake.head;
+    Position new_head = step_position(ctx, head, game->snake.direction, wrap);
+
+    // 检查碰撞
+    CellType cell_ahead = load_cell(ctx, new_head);
+
+    if (cell_ahead != CELL_EMPTY && cell_ahead != CELL_FOOD)
+    {
+        // 撞墙或撞到自己身体，游戏结束（最高分由调用方更新）
+        game->game_over = true;
+        game->death = cell_ahead == CELL_WALL ? DEATH_WALL : DEATH_SELF;
+        return;
+    }
+
+    // 检查是否吃到食物
+    bool ate_food = (cell_ahead == CELL_FOOD);
+    if (ate_food)
+    {
+        game->score += ctx->rules.food_score;
+        game->speed = ruleset_speed(&ctx->rules, game->score);
+        if (variable_growth)
+        {
+            game->snake.pending_growth += ctx->rules.growth;
+        }
+    }
+
+    // 默认规则下吃到食物的这一帧长出一节；否则每帧长出一节待长出的节数
+    bool grow = variable_growth ? game->snake.pending_growth > 0 : ate_food;
+
+    // 更新游戏池和蛇的位置
+    if (!grow)
+    {
+        // 不增长，需要移动蛇尾
+        // 根据蛇尾方向计算下一个位置
+        Position next_tail = step_position(ctx, game->snake.tail, game->snake.tail_direction, wrap);
+
+        // 获取下一个位置的单元格类型（应该是蛇身）
+        CellType next_cell_type = load_cell(ctx, next_tail);
+
+        // 如果下一个位置是蛇身，更新蛇尾方向为该蛇身的方向
+        if (next_cell_type >= CELL_SNAKE_BODY_UP && next_cell_type <= CELL_SNAKE_BODY_RIGHT)
+        {
+            game->snake.tail_direction = body_type_to_direction(next_cell_type);
+        }
+
+        // 清除当前蛇尾
+        store_cell(ctx, game->snake.tail, CELL_EMPTY);
+
+        // 将下一个位置设为新的蛇尾
+        store_cell(ctx, next_tail, CELL_SNAKE_TAIL);
+
+        // 更新蛇尾位置
+        game->snake.tail = next_tail;
+    }
+    else
+    {
+        // 蛇长度增加，蛇尾不动
+        game->snake.length++;
+        if (variable_growth)
+        {
+            game->snake.pending_growth--;
+        }
+    }
+
+    // 生成新的食物（新蛇头所在的单元格此时仍是被吃掉的食物，不会被选中）
+    if (ate_food)
+    {
+        generate_food(ctx);
+    }
+
+    // 将旧蛇头变为蛇身（根据移动方向）
+    CellType old_head_type = direction_to_body_type(game->snake.direction);
+    store_cell(ctx, head, old_head_type);
+
+    // 设置新蛇头
+    store_cell(ctx, new_head, CELL_SNAKE_HEAD);
+
+    // 更新蛇头位置
+    game->snake.head = new_head;
+}
+
+// 单步函数的特化版本
+static void step_classic(GameContext *ctx)
+{
+    step_template(ctx, false, false);
+}
+
+static void step_torus(GameContext *ctx)
+{
+    step_template(ctx, true, false);
+}
+
+static void step_growth(GameContext *ctx)
+{
+    step_template(ctx, false, true);
+}
+
+static void step_torus_growth(GameContext *ctx)
+{
+    step_template(ctx, true, true);
+}
+
+/**
+ * 更新游戏逻辑
+ *
+ * 功能：推进一帧，调用apply_ruleset按规则选择的单步函数（见step_template）。
+ *
+ * @param ctx 游戏上下文
+ */
+void update_game(GameContext *ctx)
+{
+    ctx->step(ctx);
+}
+
+// =============================================
+// 游戏规则
+// =============================================
+
+/**
+ * @brief 获取默认规则（每个食物10分、长1节，每50分加速10毫秒直到30毫秒，撞墙和撞到自己死亡）
+ */
+void default_ruleset(Ruleset *rules)
+{
+    rules->food_score = FOOD_SCORE;
+    rules->growth = 1;
+    rules->food_count = 1;
+    rules->obstacles = 0;
+    rules->wrap = false;
+    rules->initial_speed = INITIAL_SPEED;
+    rules->speed_step = SPEED_STEP;
+    rules->speed_interval = SPEED_INTERVAL;
+    rules->min_speed = MIN_SPEED;
+}
+
+/**
+ * @brief 把规则编译进游戏上下文
+ *
+ * 按穿墙和增长节数选择单步函数的特化版本，之后每帧不再判断这些开关。
+ * 穿墙规则同时决定游戏池布局（环面或有边框，游戏区域尺寸不变）；
+ * 布局改变时当前一局以同一个种子（ctx->seed）按新布局重新开始，结果只取决于种子，与之前消耗了多少随机数无关；
+ * 还没有开始过的上下文只改变尺寸。
+ * 其余规则中，初始速度、障碍物和食物个数从下一次init_game_state开始生效。
+ *
+ * @param ctx 游戏上下文
+ * @param rules 规则（参数范围由调用方保证，见load_ruleset）
+ * @return true 成功
+ * @return false 游戏区域小于TORUS_MIN_SIZE × TORUS_MIN_SIZE时不能使用穿墙规则（上下文不变）
+ */
+bool apply_ruleset(GameContext *ctx, const Ruleset *rules)
+{
+    static const StepKernel kernels[2][2] = {
+        {step_classic, step_growth},
+        {step_torus, step_torus_growth},
+    };
+    int border = ctx->torus ? 0 : 2;
+    int game_width = ctx->pool_width - border;
+    int game_height = ctx->pool_height - border;
+    if (rules->wrap && (game_width < TORUS_MIN_SIZE || game_height < TORUS_MIN_SIZE))
+    {
+        return false;
+    }
+
+    ctx->rules = *rules;
+    ctx->step = kernels[rules->wrap ? 1 : 0][rules->growth != 1 ? 1 : 0];
+    if (rules->wrap != ctx->torus)
+    {
+        ctx->torus = rules->wrap;
+        ctx->pool_width = game_width + (ctx->torus ? 0 : 2);
+        ctx->pool_height = game_height + (ctx->torus ? 0 : 2);
+        if (ctx->pool != NULL)
+        {
+            init_game_state(ctx, ctx->seed);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按速度曲线计算某个得分对应的速度
+ *
+ * 速度 = max(最快速度, 初始速度 - 每次减少的毫秒数 × ⌊得分 / 加速间隔⌋)，只在吃到食物时计算。
+ *
+ * @param rules 规则
+ * @param score 得分
+ * @return int 每帧毫秒数
+ */
+int ruleset_speed(const Ruleset *rules, int score)
+{
+    if (rules->speed_interval <= 0 || rules->initial_speed <= rules->min_speed)
+    {
+        return rules->initial_speed;
+    }
+    long long speed = (long long)rules->initial_speed - (long long)rules->speed_step * (score / rules->speed_interval);
+    return speed > rules->min_speed ? (int)speed : rules->min_speed;
+}
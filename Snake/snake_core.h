@@ -0,0 +1,378 @@
+/**
+ * @file snake_core.h
+ * @brief 贪吃蛇游戏引擎
+ *
+ * 与平台无关的游戏核心：游戏状态、游戏池、内存区域和每帧更新逻辑。
+ * 不包含任何控制台输入输出，供控制台游戏（Snake.c）和libsnake动态库共用。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_CORE_H
+#define SNAKE_CORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================
+// 常量定义
+// =============================================
+
+// 游戏区域尺寸（内部可玩区域，不包含边框）
+#define GAME_WIDTH 20  ///< 游戏区域宽度（单元格数）
+#define GAME_HEIGHT 20 ///< 游戏区域高度（单元格数）
+
+// 游戏池尺寸（包括边框）
+#define POOL_WIDTH (GAME_WIDTH + 2)   ///< 游戏池宽度 = 游戏宽度 + 左右边框
+#define POOL_HEIGHT (GAME_HEIGHT + 2) ///< 游戏池高度 = 游戏高度 + 上下边框
+
+// 默认游戏规则（见Ruleset）
+#define FOOD_SCORE 10     ///< 每个食物的得分
+#define INITIAL_SPEED 150 ///< 初始速度（每帧毫秒数）
+#define SPEED_STEP 10     ///< 每次加速减少的毫秒数
+#define SPEED_INTERVAL 50 ///< 每得多少分加速一次
+#define MIN_SPEED 30      ///< 最快速度（每帧最少毫秒数）
+
+// 内存区域（Arena）常量
+#define ARENA_ALIGNMENT 16              ///< 内存区域分配对齐字节数
+#define TICK_ARENA_MIN_SIZE (64 * 1024) ///< 每帧临时区域的最小容量（字节）
+
+// 单元格类型散列：CellType取值稀疏，按无符号值对13取模后恰好互不相同，可用作查找表下标
+#define CELL_HASH_SIZE 13                                      ///< 单元格类型查找表大小
+#define CELL_HASH(cell) ((unsigned int)(uint32_t)(cell) % 13u) ///< 单元格类型 → 查找表下标
+
+// 开放单元格：蛇头可以进入的单元格（空单元格和食物），可达区域只在开放单元格之间连通
+#define CELL_IS_OPEN(cell) ((cell) == CELL_EMPTY || (cell) == CELL_FOOD) ///< 单元格是否开放
+#define REACH_MAX_SEARCHES 4                                            ///< 分裂检查时同时进行的最大搜索数（邻居数）
+
+// 食物索引常量
+#define FOOD_BUCKET_SHIFT 3                       ///< 食物索引桶边长的对数
+#define FOOD_BUCKET_SIZE (1 << FOOD_BUCKET_SHIFT) ///< 食物索引桶边长（8×8个单元格对应一个64位掩码）
+
+// 分块占用摘要常量
+#define BLOCK_SHIFT 3                 ///< 摘要块边长的对数
+#define BLOCK_SIZE (1 << BLOCK_SHIFT) ///< 摘要块边长（缩小显示时8×8个单元格显示为一个字符）
+
+// 环面布局常量
+#define TORUS_MIN_SIZE 3 ///< 环面布局的最小游戏区域边长（更小时上下或左右邻居是同一个单元格）
+
+/**
+ * @enum Direction
+ * @brief 蛇的移动方向枚举
+ *
+ * 定义蛇在游戏网格中可能移动的四个基本方向。
+ */
+typedef enum
+{
+    DIR_UP,   ///< 向上移动
+    DIR_DOWN, ///< 向下移动
+    DIR_LEFT, ///< 向左移动
+    DIR_RIGHT ///< 向右移动
+} Direction;
+
+/**
+ * @enum DeathCause
+ * @brief 一局游戏的结束原因
+ *
+ * 单步函数在设置game_over的同时记录原因，供回放分析按原因统计。
+ */
+typedef enum
+{
+    DEATH_NONE = 0,  ///< 游戏未结束
+    DEATH_WALL,      ///< 撞到墙壁（边框或障碍物）
+    DEATH_SELF,      ///< 撞到自身（包括本帧还没有移走的蛇尾）
+    DEATH_BOARD_FULL ///< 没有空单元格可以放置食物（视为胜利）
+} DeathCause;
+
+/**
+ * @enum CellType
+ * @brief 游戏池单元格类型枚举
+ *
+ * 定义游戏网格中每个单元格可能的状态类型，用于渲染和碰撞检测。
+ * 使用特殊十六进制值便于调试识别。
+ */
+typedef enum
+{
+    CELL_EMPTY = -0x66,         ///< 空单元格（可通行区域）
+    CELL_FOOD = 0xcc,           ///< 食物（蛇的目标）
+    CELL_SNAKE_HEAD = 0xff,     ///< 蛇头（蛇的头部，控制移动方向）
+    CELL_SNAKE_BODY_UP = 0x0,   ///< 蛇身（向上移动方向）
+    CELL_SNAKE_BODY_DOWN,       ///< 蛇身（向下移动方向）
+    CELL_SNAKE_BODY_LEFT,       ///< 蛇身（向左移动方向）
+    CELL_SNAKE_BODY_RIGHT,      ///< 蛇身（向右移动方向）
+    CELL_SNAKE_TAIL = 0x66ccff, ///< 蛇尾（蛇的尾部，最后一段）
+    CELL_WALL = 0x325           ///< 墙壁（不可通行的边界）
+} CellType;
+
+/**
+ * @struct Position
+ * @brief 二维坐标位置结构体
+ *
+ * 表示游戏池或控制台中的坐标位置，用于定位单元格和渲染位置。
+ */
+typedef struct
+{
+    int x; ///< X坐标（水平方向）
+    int y; ///< Y坐标（垂直方向）
+} Position;
+
+/**
+ * @struct Snake
+ * @brief 蛇状态结构体
+ *
+ * 简化的蛇状态管理，只存储头尾位置和方向信息，基于游戏池单元格跟踪身体连接。
+ * 使用输入缓冲机制防止蛇连续反向移动。
+ */
+typedef struct
+{
+    Position head;            ///< 蛇头位置（当前头部坐标）
+    Position tail;            ///< 蛇尾位置（当前尾部坐标）
+    int length;               ///< 蛇的长度（包括头、身、尾）
+    Direction direction;      ///< 当前移动方向（正在执行的方向）
+    Direction next_direction; ///< 下一个方向（用于输入缓冲，防止连续转向）
+    Direction tail_direction; ///< 蛇尾移动方向（用于更新蛇尾位置）
+    int pending_growth;       ///< 尚未长出的节数（规则的growth不为1时使用，每帧长出一节）
+} Snake;
+
+/**
+ * @struct GameState
+ * @brief 游戏全局状态结构体
+ *
+ * 包含游戏运行所需的所有状态信息，作为游戏的主数据结构。
+ */
+typedef struct
+{
+    Snake snake;       ///< 蛇的状态（位置、长度、方向等）
+    Position food;     ///< 最近一次生成的食物位置（同时有多个食物时用food_nearest查询）
+    int score;         ///< 当前得分
+    bool game_over;    ///< 游戏结束标志（true表示游戏结束）
+    DeathCause death;  ///< 结束原因（游戏未结束时为DEATH_NONE）
+    bool paused;       ///< 游戏暂停标志（true表示游戏暂停）
+    int speed;         ///< 游戏速度（毫秒，控制蛇移动的延迟时间）
+    int highest_score; ///< 最高得分（历史最高分）
+} GameState;
+
+/**
+ * @struct Arena
+ * @brief 线性内存区域（Arena）分配器
+ *
+ * 创建时一次性申请整块内存，之后每次分配只移动偏移量，释放时整体重置偏移量（O(1)）。
+ * 游戏循环中的所有内存都从内存区域中分配，不再调用malloc/free。
+ */
+typedef struct
+{
+    unsigned char *base; ///< 内存块起始地址
+    size_t capacity;     ///< 内存块总容量（字节）
+    size_t used;         ///< 已使用字节数（即下一次分配的偏移量）
+#ifndef NDEBUG
+    size_t alloc_count; ///< 自上次重置以来的分配次数（仅调试构建）
+#endif
+} Arena;
+
+/**
+ * @struct Reachability
+ * @brief 开放单元格的增量连通分量（可达区域）
+ *
+ * 每个开放单元格记录所属连通分量的编号，每个编号记录分量大小，
+ * 因此"从某个单元格出发能到达多少个单元格"是O(1)查询，不再需要洪水填充。
+ * 每局第一次查询时建立，数组和搜索队列也在上下文第一次查询时才申请
+ * （从不查询的上下文，如强化学习环境、多会话主机和回放分析，没有任何额外的内存和计算开销），
+ * 此后set_cell_type改变单元格开放状态时增量维护：
+ * - 单元格开放：与相邻分量合并，只重新编号较小的分量
+ * - 单元格关闭：先检查周围8个单元格能否局部绕过该单元格（常见情况O(1)），
+ *   否则从各邻居交替进行广度优先搜索，只重新编号分裂出的较小部分
+ */
+typedef struct
+{
+    Arena arena;          ///< 下面4个数组和搜索队列的后备存储（第一次查询时申请，上下文销毁时归还）
+    int32_t *label;       ///< 各单元格所属分量编号（非开放单元格为-1），与pool同布局（NULL表示本局尚未分配）
+    int32_t *size;        ///< 各编号分量的单元格数
+    int32_t *free_labels; ///< 未使用的编号栈
+    int free_count;       ///< 未使用的编号个数
+    uint32_t *mark;       ///< 搜索标记：(epoch << 2) | 搜索序号
+    uint32_t epoch;       ///< 当前搜索代数，递增后旧标记全部失效
+    bool ready;           ///< 是否已建立（未建立时set_cell_type不做增量维护）
+} Reachability;
+
+/**
+ * @struct FoodIndex
+ * @brief 食物位置的网格分桶索引（实现见snake_food.c）
+ *
+ * 每个8×8单元格的桶用一个64位掩码记录哪些单元格是食物，生成和吃掉食物都是O(1)，
+ * 最近食物查询只扫描附近的非空桶。与可达区域一样在第一次查询时建立，此后由set_cell_type增量维护。
+ */
+typedef struct
+{
+    uint64_t *mask; ///< 各桶的食物掩码（行优先，buckets_y × buckets_x），位序号为(y % 8) × 8 + x % 8
+    int buckets_x;  ///< 每行桶数
+    int buckets_y;  ///< 桶的行数
+    int count;      ///< 食物总数
+    bool ready;     ///< 是否已建立（未建立时set_cell_type不做增量维护）
+} FoodIndex;
+
+/**
+ * @struct BlockCounts
+ * @brief 一个摘要块内各类单元格的个数
+ */
+typedef struct
+{
+    uint8_t snake; ///< 蛇（头、身、尾）单元格数
+    uint8_t food;  ///< 食物单元格数
+    uint8_t wall;  ///< 墙壁单元格数
+    bool dirty;    ///< 块内有单元格改变，需要重新绘制（缩小显示时使用）
+} BlockCounts;
+
+/**
+ * @struct BlockSummary
+ * @brief 分块占用摘要（实现见snake_blocks.c）
+ *
+ * 每个8×8单元格的块记录各类单元格的个数，缩小显示时每块只绘制一个字符，
+ * 不需要读块内的单元格。第一次使用时建立，此后由set_cell_type增量维护。
+ */
+typedef struct
+{
+    BlockCounts *blocks; ///< 各块的计数（行优先，blocks_y × blocks_x）
+    int blocks_x;        ///< 每行块数
+    int blocks_y;        ///< 块的行数
+    bool ready;          ///< 是否已建立（未建立时set_cell_type不做增量维护）
+} BlockSummary;
+
+/**
+ * @struct SaveMapping
+ * @brief 存档文件的内存映射（写时复制，由snake_save.c管理）
+ *
+ * 从存档加载的游戏直接使用映射中的游戏池，修改只影响本进程的私有页面，不会写回文件。
+ */
+typedef struct
+{
+    void *view;   ///< 映射起始地址（NULL表示没有映射）
+    size_t size;  ///< 映射字节数
+    void *handle; ///< 平台句柄（Windows的文件映射对象，其他平台不使用）
+} SaveMapping;
+
+/**
+ * @struct Ruleset
+ * @brief 游戏规则
+ *
+ * 由apply_ruleset编译进游戏上下文：每帧都要判断的开关（穿墙、增长节数）用来选择单步函数，
+ * 只在吃到食物或开局时用到的数值直接保存。默认规则与最初写死在update_game中的规则相同。
+ */
+typedef struct
+{
+    int food_score;     ///< 每个食物的得分
+    int growth;         ///< 每个食物使蛇增长的节数（0表示不增长）
+    int food_count;     ///< 游戏池中同时存在的食物个数
+    int obstacles;      ///< 开局时随机放置在游戏区域内的障碍物（墙壁）个数
+    bool wrap;          ///< 穿墙：游戏池改为环面布局（没有边框，四边相连），障碍物仍然致命
+    int initial_speed;  ///< 初始速度（每帧毫秒数）
+    int speed_step;     ///< 每次加速减少的毫秒数
+    int speed_interval; ///< 每得多少分加速一次（0表示不加速）
+    int min_speed;      ///< 最快速度（每帧最少毫秒数）
+} Ruleset;
+
+struct GameContext;
+
+/**
+ * @brief 单步函数：按规则特化的update_game实现
+ */
+typedef void (*StepKernel)(struct GameContext *ctx);
+
+/**
+ * @struct GameContext
+ * @brief 游戏上下文结构体
+ *
+ * 一局游戏所需的全部数据：游戏状态、游戏池、可达区域以及两个内存区域。
+ * 从存档加载时游戏池直接指向存档文件的映射（见snake_save.h），不在game_arena中。
+ * 游戏池有两种布局：默认四周是一圈墙壁（游戏池比游戏区域宽高各多2）；
+ * 穿墙规则下是环面（游戏池就是游戏区域，四边相连，不存储边框）。
+ * - game_arena: 单局内存区域，存放游戏池等单局数据，重置游戏时整体释放
+ * - tick_arena: 每帧临时内存区域，每次update_game开始时O(1)重置
+ */
+typedef struct GameContext
+{
+    GameState game;     ///< 游戏状态（蛇、食物、分数等）
+    int pool_width;     ///< 游戏池宽度（包括边框，环面布局没有边框）
+    int pool_height;    ///< 游戏池高度（包括边框，环面布局没有边框）
+    bool torus;         ///< 环面布局（由穿墙规则决定）
+    CellType *pool;     ///< 游戏池单元格数组（行优先，pool_height × pool_width），分配自game_arena
+    int32_t *wrap_x;    ///< 邻居坐标表：wrap_x[x + 1]是x（-1～pool_width）在游戏池中的坐标，分配自game_arena
+    int32_t *wrap_y;    ///< 邻居坐标表：wrap_y[y + 1]是y（-1～pool_height）在游戏池中的坐标，分配自game_arena
+    bool *dirty;        ///< 脏标记数组（与pool同布局），标记需要重新绘制的单元格，分配自game_arena
+    Arena game_arena;   ///< 单局内存区域
+    Arena tick_arena;   ///< 每帧临时内存区域
+    uint64_t rng;       ///< 随机数生成器状态（每个上下文独立，保证多局并行时结果可复现）
+    uint64_t seed;      ///< 本局的随机数种子（最近一次init_game_state的参数，改变布局时按它重新开局）
+    Reachability reach; ///< 可达区域（开放单元格的连通分量），使用自己的内存区域
+    FoodIndex food;     ///< 食物索引，分配自game_arena
+    BlockSummary lod;   ///< 分块占用摘要（缩小显示用），分配自game_arena
+    SaveMapping save;   ///< 游戏池所在的存档映射（游戏不是从存档加载时为空）
+    Ruleset rules;      ///< 游戏规则
+    StepKernel step;    ///< 按规则选择的单步函数（由update_game调用）
+} GameContext;
+
+// =============================================
+// 全局变量
+// =============================================
+
+#ifndef NDEBUG
+extern size_t heap_alloc_count; ///< 堆分配次数（仅调试构建），用于断言每帧零堆分配
+#endif
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+// 内存区域管理函数
+void *heap_alloc(size_t size);
+bool arena_init(Arena *arena, size_t capacity);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+void arena_reset(Arena *arena);
+size_t arena_save(const Arena *arena);
+void arena_restore(Arena *arena, size_t saved);
+
+// 游戏上下文管理函数
+bool init_game_context(GameContext *ctx, int game_width, int game_height);
+void destroy_game_context(GameContext *ctx);
+void reset_game_arena(GameContext *ctx, bool allocate_pool);
+void copy_game_state(GameContext *dst, const GameContext *src);
+void default_ruleset(Ruleset *rules);
+bool apply_ruleset(GameContext *ctx, const Ruleset *rules);
+int ruleset_speed(const Ruleset *rules, int score);
+void seed_game_random(GameContext *ctx, uint64_t seed);
+uint32_t game_random(GameContext *ctx);
+
+// 游戏池初始化和管理
+void init_pool(GameContext *ctx);
+void set_cell_type(GameContext *ctx, Position pos, CellType type);
+CellType get_cell_type(const GameContext *ctx, Position pos);
+Position neighbor_position(const GameContext *ctx, Position pos, Direction dir);
+int cell_distance(const GameContext *ctx, Position a, Position b);
+
+// 游戏逻辑函数
+void init_game_state(GameContext *ctx, uint64_t seed);
+void generate_food(GameContext *ctx);
+CellType direction_to_body_type(Direction dir);
+Direction body_type_to_direction(CellType type);
+void turn_snake(GameContext *ctx, Direction dir);
+void update_game(GameContext *ctx);
+
+// 可达区域（实现见snake_reach.c）
+bool reach_rebuild(GameContext *ctx);
+void reach_cell_changed(GameContext *ctx, int index, bool now_open);
+int reach_region_size(GameContext *ctx, Position pos);
+bool reach_connected(GameContext *ctx, Position a, Position b);
+int reach_flood_fill(GameContext *ctx, Position pos);
+
+// 食物索引（实现见snake_food.c）
+void food_index_rebuild(GameContext *ctx);
+void food_cell_changed(GameContext *ctx, Position pos, bool now_food);
+int food_count(GameContext *ctx);
+int food_nearest(GameContext *ctx, Position from, Position *out);
+
+// 分块占用摘要（实现见snake_blocks.c）
+void block_summary_rebuild(GameContext *ctx);
+void block_cell_changed(GameContext *ctx, Position pos, CellType old_type, CellType new_type);
+
+#endif // SNAKE_CORE_H
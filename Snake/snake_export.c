@@ -0,0 +1,1292 @@
+/**
+ * @file snake_export.c
+ * @brief 训练数据导出实现
+ *
+ * 三级流水线：
+ * - 模拟线程：exporter_begin把步前的游戏池复制到自己队列的下一个槽，exporter_commit填写动作、奖励后发布，
+ *   只有一次memcpy和一次原子写；队列满时立即返回false（丢弃计数），从不等待
+ * - 打包线程：轮流取出各队列的记录，按列组装，游戏池编码为位平面；凑满一块后整列游程编码，
+ *   交给写出线程，然后在另一个缓冲区中组装下一块（写出线程还没写完上一块时只有打包线程等待）
+ * - 写出线程：顺序写出数据块并记录块索引；关闭时由调用线程写出块索引和文件尾
+ *
+ * 队列是单生产者单消费者环形缓冲：生产者只写head，消费者只写tail，两者位于不同缓存行；
+ * 生产者缓存上一次读到的tail，队列不满时不读取消费者的缓存行。
+ *
+ * Windows使用Win32线程、SRW锁和条件变量，其他平台使用pthread（与snake_parallel.c相同）。
+ * 后台线程中的分配（块索引增长）直接使用realloc：heap_alloc的调试计数只统计模拟线程，
+ * 用于断言单步零堆分配，不能被后台线程改变。
+ *
+ * 编码: UTF-8
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "snake_export.h"
+#include "snake_parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// =============================================
+// 平台抽象：原子操作、线程、互斥锁、条件变量和文件偏移
+// =============================================
+
+#if defined(_MSC_VER)
+typedef volatile LONG atomic_index;
+#define index_load(p) ((uint32_t)InterlockedCompareExchange((p), 0, 0))
+#define index_store(p, v) ((void)InterlockedExchange((p), (LONG)(v)))
+#else
+#include <stdatomic.h>
+typedef atomic_uint atomic_index;
+#define index_load(p) atomic_load_explicit((p), memory_order_acquire)
+#define index_store(p, v) atomic_store_explicit((p), (v), memory_order_release)
+#endif
+
+#ifdef _WIN32
+typedef HANDLE thread_handle;
+typedef SRWLOCK mutex_type;
+typedef CONDITION_VARIABLE cond_type;
+#define mutex_init(m) InitializeSRWLock(m)
+#define mutex_destroy(m) ((void)(m))
+#define mutex_lock(m) AcquireSRWLockExclusive(m)
+#define mutex_unlock(m) ReleaseSRWLockExclusive(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_destroy(c) ((void)(c))
+#define cond_wait(c, m) SleepConditionVariableSRW((c), (m), INFINITE, 0)
+#define cond_broadcast(c) WakeAllConditionVariable(c)
+#define sleep_briefly() Sleep(1)
+#define file_seek(f, offset) _fseeki64((f), (__int64)(offset), SEEK_SET)
+#define file_seek_end(f) _fseeki64((f), 0, SEEK_END)
+#define file_tell(f) ((uint64_t)_ftelli64(f))
+#else
+typedef pthread_t thread_handle;
+typedef pthread_mutex_t mutex_type;
+typedef pthread_cond_t cond_type;
+#define mutex_init(m) pthread_mutex_init((m), NULL)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init((c), NULL)
+#define cond_destroy(c) pthread_cond_destroy(c)
+#define cond_wait(c, m) pthread_cond_wait((c), (m))
+#define cond_broadcast(c) pthread_cond_broadcast(c)
+#define sleep_briefly() nanosleep(&(struct timespec){0, 1000000}, NULL)
+#define file_seek(f, offset) fseeko((f), (off_t)(offset), SEEK_SET)
+#define file_seek_end(f) fseeko((f), 0, SEEK_END)
+#define file_tell(f) ((uint64_t)ftello(f))
+#endif
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define EXPORT_MAGIC_LENGTH 8            ///< 文件魔数长度
+#define CHUNK_MAGIC "CHNK"               ///< 数据块魔数（4字节）
+#define CHUNK_HEADER_SIZE 16             ///< 数据块头大小（字节）
+#define CHUNK_STEP_BYTES 14              ///< 每步的标量列字节数：环境4 + 步号4 + 动作1 + 奖励4 + 结束1
+#define INDEX_ENTRY_SIZE 24              ///< 每个块索引项的字节数
+#define TRAILER_MAGIC "SNKINDEX"         ///< 文件尾魔数（8字节）
+#define TRAILER_SIZE 24                  ///< 文件尾大小（字节）
+#define QUEUE_MIN_SLOTS 16               ///< 每个生产者队列的最少槽数
+#define RLE_MIN_RUN 3                    ///< 游程编码：最短的重复段（更短的按字面量存储）
+#define RLE_MAX_RUN (0x7F + RLE_MIN_RUN) ///< 游程编码：一个控制字节表示的最长重复段
+#define RLE_MAX_LITERAL 0x80             ///< 游程编码：一个控制字节表示的最长字面量段
+
+// =============================================
+// 类型定义
+// =============================================
+
+/**
+ * @struct StepRecord
+ * @brief 队列槽的记录头，后面紧跟步前的游戏池（pool_width × pool_height个CellType）
+ */
+typedef struct
+{
+    uint32_t env;   ///< 环境编号
+    uint32_t tick;  ///< 批次步号
+    float reward;   ///< 奖励
+    uint8_t action; ///< 动作
+    uint8_t done;   ///< 是否结束
+} StepRecord;
+
+/**
+ * @struct ProducerQueue
+ * @brief 单生产者单消费者环形队列（每个模拟线程一个）
+ *
+ * 生产者一侧和消费者一侧的字段之间填充一个缓存行，两个线程各自频繁写的位置不在同一缓存行上。
+ */
+typedef struct
+{
+    // 生产者一侧
+    atomic_index head;    ///< 下一个写入的槽（只由生产者写）
+    uint32_t cached_tail; ///< 生产者上一次读到的tail
+    uint64_t pushed;      ///< 进入队列的步数
+    uint64_t dropped;     ///< 丢弃的步数
+    unsigned char *slots; ///< 槽数组（创建后不变）
+    char producer_padding[CACHE_LINE_SIZE];
+    // 消费者一侧
+    atomic_index tail; ///< 下一个读取的槽（只由打包线程写）
+    char consumer_padding[CACHE_LINE_SIZE];
+} ProducerQueue;
+
+/**
+ * @struct ChunkBuffer
+ * @brief 编码好的数据块（打包线程和写出线程之间的双缓冲之一）
+ */
+typedef struct
+{
+    unsigned char *data; ///< 数据块字节
+    size_t length;       ///< 数据块字节数
+    uint32_t steps;      ///< 步数
+    bool full;           ///< 已交给写出线程，写出后清除
+} ChunkBuffer;
+
+/**
+ * @struct ChunkIndexEntry
+ * @brief 块索引项
+ */
+typedef struct
+{
+    uint64_t offset;     ///< 数据块在文件中的偏移
+    uint64_t first_step; ///< 数据块第一步在整个文件中的序号
+    uint32_t steps;      ///< 步数
+} ChunkIndexEntry;
+
+/**
+ * @struct TrainingExporter
+ * @brief 导出器
+ */
+struct TrainingExporter
+{
+    FILE *file;              ///< 输出文件
+    int pool_width;          ///< 游戏池宽度
+    int pool_height;         ///< 游戏池高度
+    size_t cells;            ///< 单元格数
+    size_t plane_bytes;      ///< 每个位平面的字节数
+    size_t step_plane_bytes; ///< 每步所有位平面的字节数
+    int chunk_steps;         ///< 每块步数
+
+    // 队列
+    int producer_count;         ///< 生产者数（模拟线程数）
+    ProducerQueue *queues;      ///< 队列数组
+    size_t slot_size;           ///< 每个槽的字节数（缓存行的整数倍）
+    uint32_t queue_slots;       ///< 每个队列的槽数（2的幂）
+    unsigned char *slot_memory; ///< 所有队列的槽
+
+    // 打包线程独占：正在组装的块（按列）
+    uint32_t *env;   ///< 环境编号列
+    uint32_t *tick;  ///< 批次步号列
+    uint8_t *action; ///< 动作列
+    float *reward;   ///< 奖励列
+    uint8_t *done;   ///< 是否结束列
+    uint8_t *planes; ///< 位平面列（未压缩）
+    uint32_t filled; ///< 已组装的步数
+    int fill_index;  ///< 下一个组装到的缓冲区
+
+    // 打包线程与写出线程共享（由mutex保护）
+    ChunkBuffer buffers[2]; ///< 双缓冲
+    bool packer_done;       ///< 打包线程已交出最后一块
+    mutex_type mutex;       ///< 保护buffers和packer_done
+    cond_type changed;      ///< buffers或packer_done改变时广播
+
+    // 写出线程独占（线程结束后由调用线程读取）
+    ChunkIndexEntry *index; ///< 块索引
+    size_t index_count;     ///< 块数
+    size_t index_capacity;  ///< 块索引容量
+    uint64_t file_offset;   ///< 已写出的字节数
+    uint64_t written;       ///< 已写出的步数
+    bool io_error;          ///< 写出失败（此后的块全部丢弃）
+
+    atomic_index closing; ///< 非0时打包线程取完所有队列后退出
+    thread_handle packer; ///< 打包线程
+    thread_handle writer; ///< 写出线程
+    bool packer_started;  ///< 打包线程已启动
+    bool writer_started;  ///< 写出线程已启动
+};
+
+/**
+ * @struct ExportReader
+ * @brief 导出文件读取器
+ */
+struct ExportReader
+{
+    FILE *file;              ///< 输入文件
+    int pool_width;          ///< 游戏池宽度
+    int pool_height;         ///< 游戏池高度
+    size_t plane_bytes;      ///< 每个位平面的字节数
+    ChunkIndexEntry *index;  ///< 块索引
+    int chunk_count;         ///< 块数
+    uint64_t steps;          ///< 总步数
+    unsigned char *raw;      ///< 当前块的原始字节
+    size_t raw_capacity;     ///< raw的容量
+    uint32_t *env;           ///< 解码后的环境编号列
+    uint32_t *tick;          ///< 解码后的批次步号列
+    uint8_t *action;         ///< 解码后的动作列
+    float *reward;           ///< 解码后的奖励列
+    uint8_t *done;           ///< 解码后的是否结束列
+    uint8_t *planes;         ///< 解压后的位平面列
+    uint32_t capacity_steps; ///< 各列的容量（步数）
+};
+
+/**
+ * @brief 单元格类型 → 观测通道查找表（按CELL_HASH索引，存储通道号+1，0表示空单元格）
+ */
+static const unsigned char cell_channel[CELL_HASH_SIZE] = {
+    [CELL_HASH(CELL_SNAKE_HEAD)] = 1,
+    [CELL_HASH(CELL_SNAKE_BODY_UP)] = 2,
+    [CELL_HASH(CELL_SNAKE_BODY_DOWN)] = 2,
+    [CELL_HASH(CELL_SNAKE_BODY_LEFT)] = 2,
+    [CELL_HASH(CELL_SNAKE_BODY_RIGHT)] = 2,
+    [CELL_HASH(CELL_SNAKE_TAIL)] = 3,
+    [CELL_HASH(CELL_FOOD)] = 4,
+    [CELL_HASH(CELL_WALL)] = 5,
+};
+
+// =============================================
+// 辅助函数
+// =============================================
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+/**
+ * @brief 队列中第index个槽（按槽数取模）
+ */
+static unsigned char *queue_slot(const TrainingExporter *exporter, const ProducerQueue *queue, uint32_t index)
+{
+    return queue->slots + (size_t)(index & (exporter->queue_slots - 1)) * exporter->slot_size;
+}
+
+/**
+ * @brief 数据块字节数的上限（位平面按游程编码的最坏情况计算）
+ */
+static size_t chunk_bound(const TrainingExporter *exporter)
+{
+    size_t steps = (size_t)exporter->chunk_steps;
+    return CHUNK_HEADER_SIZE + steps * CHUNK_STEP_BYTES + export_rle_bound(steps * exporter->step_plane_bytes);
+}
+
+// =============================================
+// 游程编码
+// =============================================
+
+/**
+ * @brief 游程编码输出字节数的上限
+ */
+size_t export_rle_bound(size_t length)
+{
+    return length + length / RLE_MAX_LITERAL + 1;
+}
+
+/**
+ * @brief 游程编码（PackBits格式的变体）
+ *
+ * 控制字节c < 0x80：后面是c + 1个字面量字节；c >= 0x80：下一个字节重复c - 0x80 + 3次。
+ * 位平面中绝大部分字节是0（每个平面只有少数单元格属于该通道），编码和解码都只是逐字节比较和memcpy/memset，
+ * 打包线程每秒可以压缩数百MB，不需要任何外部压缩库。
+ *
+ * @param src 输入
+ * @param length 输入字节数
+ * @param dst 输出（至少export_rle_bound(length)字节）
+ * @return size_t 输出字节数
+ */
+size_t export_rle_encode(const uint8_t *src, size_t length, uint8_t *dst)
+{
+    size_t in = 0, out = 0;
+    while (in < length)
+    {
+        size_t run = 1;
+        while (in + run < length && run < RLE_MAX_RUN && src[in + run] == src[in])
+        {
+            run++;
+        }
+        if (run >= RLE_MIN_RUN)
+        {
+            dst[out++] = (uint8_t)(0x80 + run - RLE_MIN_RUN);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        // 字面量段：直到下一个足够长的重复段开始
+        size_t start = in, literal = 0;
+        while (in < length && literal < RLE_MAX_LITERAL)
+        {
+            if (in + 2 < length && src[in] == src[in + 1] && src[in] == src[in + 2])
+            {
+                break;
+            }
+            in++;
+            literal++;
+        }
+        dst[out++] = (uint8_t)(literal - 1);
+        memcpy(dst + out, src + start, literal);
+        out += literal;
+    }
+    return out;
+}
+
+/**
+ * @brief 游程解码
+ *
+ * @param src 输入
+ * @param length 输入字节数
+ * @param dst 输出
+ * @param expected 解码后应有的字节数
+ * @return true 输入合法且解码后恰好expected字节
+ */
+bool export_rle_decode(const uint8_t *src, size_t length, uint8_t *dst, size_t expected)
+{
+    size_t in = 0, out = 0;
+    while (in < length)
+    {
+        uint8_t control = src[in++];
+        if (control < 0x80)
+        {
+            size_t literal = (size_t)control + 1;
+            if (in + literal > length || out + literal > expected)
+            {
+                return false;
+            }
+            memcpy(dst + out, src + in, literal);
+            in += literal;
+            out += literal;
+        }
+        else
+        {
+            size_t run = (size_t)control - 0x80 + RLE_MIN_RUN;
+            if (in >= length || out + run > expected)
+            {
+                return false;
+            }
+            memset(dst + out, src[in++], run);
+            out += run;
+        }
+    }
+    return out == expected;
+}
+
+// =============================================
+// 模拟线程：入队
+// =============================================
+
+/**
+ * @brief 为一步预留队列槽并复制步前的游戏池（在单步之前调用）
+ *
+ * 不加锁、不分配内存、不做系统调用。队列满或游戏池尺寸与导出文件不一致时丢弃这一步（计数）并返回false，
+ * 此时不能调用exporter_commit。
+ *
+ * @param exporter 导出器
+ * @param producer 生产者编号（调用线程独占的队列，0～producers-1）
+ * @param ctx 游戏上下文（单步之前）
+ * @return true 已预留，单步之后必须调用exporter_commit
+ */
+bool exporter_begin(TrainingExporter *exporter, int producer, const GameContext *ctx)
+{
+    ProducerQueue *queue = &exporter->queues[producer];
+    if (ctx->pool_width != exporter->pool_width || ctx->pool_height != exporter->pool_height)
+    {
+        queue->dropped++;
+        return false;
+    }
+
+    uint32_t head = index_load(&queue->head);
+    if (head - queue->cached_tail >= exporter->queue_slots)
+    {
+        queue->cached_tail = index_load(&queue->tail);
+        if (head - queue->cached_tail >= exporter->queue_slots)
+        {
+            queue->dropped++;
+            return false;
+        }
+    }
+    memcpy(queue_slot(exporter, queue, head) + sizeof(StepRecord), ctx->pool, exporter->cells * sizeof(CellType));
+    return true;
+}
+
+/**
+ * @brief 填写预留的一步并发布给打包线程
+ *
+ * @param exporter 导出器
+ * @param producer 生产者编号（与exporter_begin相同）
+ * @param env 环境编号
+ * @param tick 批次步号
+ * @param action 动作
+ * @param reward 奖励
+ * @param done 这一步之后游戏是否结束
+ */
+void exporter_commit(TrainingExporter *exporter, int producer, uint32_t env, uint32_t tick,
+                     Direction action, float reward, bool done)
+{
+    ProducerQueue *queue = &exporter->queues[producer];
+    uint32_t head = index_load(&queue->head);
+    StepRecord *record = (StepRecord *)queue_slot(exporter, queue, head);
+    record->env = env;
+    record->tick = tick;
+    record->reward = reward;
+    record->action = (uint8_t)action;
+    record->done = done ? 1 : 0;
+    index_store(&queue->head, head + 1);
+    queue->pushed++;
+}
+
+// =============================================
+// 打包线程
+// =============================================
+
+/**
+ * @brief 把组装好的列编码成数据块交给写出线程
+ *
+ * 目标缓冲区还在等待写出时在这里等待：只有打包线程会因为磁盘慢而停下，队列继续缓冲模拟线程的记录。
+ */
+static void emit_chunk(TrainingExporter *exporter)
+{
+    ChunkBuffer *buffer = &exporter->buffers[exporter->fill_index];
+    mutex_lock(&exporter->mutex);
+    while (buffer->full)
+    {
+        cond_wait(&exporter->changed, &exporter->mutex);
+    }
+    mutex_unlock(&exporter->mutex);
+
+    uint32_t steps = exporter->filled;
+    unsigned char *p = buffer->data + CHUNK_HEADER_SIZE;
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        put_u32(p, exporter->env[i]);
+    }
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        put_u32(p, exporter->tick[i]);
+    }
+    memcpy(p, exporter->action, steps);
+    p += steps;
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        uint32_t bits;
+        memcpy(&bits, &exporter->reward[i], sizeof(bits));
+        put_u32(p, bits);
+    }
+    memcpy(p, exporter->done, steps);
+    p += steps;
+    size_t compressed = export_rle_encode(exporter->planes, (size_t)steps * exporter->step_plane_bytes, p);
+
+    memcpy(buffer->data, CHUNK_MAGIC, 4);
+    put_u32(buffer->data + 4, steps);
+    put_u32(buffer->data + 8, (uint32_t)compressed);
+    put_u32(buffer->data + 12, 0);
+    buffer->length = (size_t)(p - buffer->data) + compressed;
+    buffer->steps = steps;
+
+    mutex_lock(&exporter->mutex);
+    buffer->full = true;
+    cond_broadcast(&exporter->changed);
+    mutex_unlock(&exporter->mutex);
+
+    exporter->filled = 0;
+    exporter->fill_index ^= 1;
+}
+
+/**
+ * @brief 把一条记录追加到正在组装的块：标量写入各列，游戏池编码为位平面
+ */
+static void pack_record(TrainingExporter *exporter, const unsigned char *slot)
+{
+    const StepRecord *record = (const StepRecord *)slot;
+    const CellType *pool = (const CellType *)(slot + sizeof(StepRecord));
+    uint32_t i = exporter->filled++;
+    exporter->env[i] = record->env;
+    exporter->tick[i] = record->tick;
+    exporter->action[i] = record->action;
+    exporter->reward[i] = record->reward;
+    exporter->done[i] = record->done;
+
+    uint8_t *planes = exporter->planes + (size_t)i * exporter->step_plane_bytes;
+    memset(planes, 0, exporter->step_plane_bytes);
+    for (size_t cell = 0; cell < exporter->cells; cell++)
+    {
+        int channel = cell_channel[CELL_HASH(pool[cell])];
+        if (channel != 0)
+        {
+            planes[(size_t)(channel - 1) * exporter->plane_bytes + (cell >> 3)] |= (uint8_t)(1u << (cell & 7));
+        }
+    }
+
+    if (exporter->filled == (uint32_t)exporter->chunk_steps)
+    {
+        emit_chunk(exporter);
+    }
+}
+
+/**
+ * @brief 取出一个队列中当前所有的记录
+ *
+ * @return uint32_t 取出的记录数
+ */
+static uint32_t drain_queue(TrainingExporter *exporter, ProducerQueue *queue)
+{
+    uint32_t head = index_load(&queue->head);
+    uint32_t tail = index_load(&queue->tail);
+    uint32_t taken = head - tail;
+    for (; tail != head; tail++)
+    {
+        pack_record(exporter, queue_slot(exporter, queue, tail));
+        index_store(&queue->tail, tail + 1); // 逐条释放槽，生产者尽早可以复用
+    }
+    return taken;
+}
+
+/**
+ * @brief 打包线程主循环：轮流取出各队列，所有队列都空时休眠1毫秒
+ *
+ * 关闭时先读取关闭标志再取一遍队列：标志之前发布的记录一定能在这一遍中取到，取空后交出最后一块并退出。
+ */
+static void packer_loop(TrainingExporter *exporter)
+{
+    for (;;)
+    {
+        bool closing = index_load(&exporter->closing) != 0;
+        uint32_t taken = 0;
+        for (int p = 0; p < exporter->producer_count; p++)
+        {
+            taken += drain_queue(exporter, &exporter->queues[p]);
+        }
+        if (taken == 0)
+        {
+            if (closing)
+            {
+                break;
+            }
+            sleep_briefly();
+        }
+    }
+
+    if (exporter->filled > 0)
+    {
+        emit_chunk(exporter);
+    }
+    mutex_lock(&exporter->mutex);
+    exporter->packer_done = true;
+    cond_broadcast(&exporter->changed);
+    mutex_unlock(&exporter->mutex);
+}
+
+// =============================================
+// 写出线程
+// =============================================
+
+/**
+ * @brief 写出一个数据块并记录块索引（写出失败后丢弃所有后续数据块）
+ */
+static void write_chunk(TrainingExporter *exporter, const ChunkBuffer *buffer)
+{
+    if (exporter->io_error)
+    {
+        return;
+    }
+    if (exporter->index_count == exporter->index_capacity)
+    {
+        size_t capacity = exporter->index_capacity * 2;
+        ChunkIndexEntry *grown = (ChunkIndexEntry *)realloc(exporter->index, capacity * sizeof(ChunkIndexEntry));
+        if (grown == NULL)
+        {
+            exporter->io_error = true;
+            return;
+        }
+        exporter->index = grown;
+        exporter->index_capacity = capacity;
+    }
+    if (fwrite(buffer->data, 1, buffer->length, exporter->file) != buffer->length)
+    {
+        exporter->io_error = true;
+        return;
+    }
+
+    ChunkIndexEntry *entry = &exporter->index[exporter->index_count++];
+    entry->offset = exporter->file_offset;
+    entry->first_step = exporter->written;
+    entry->steps = buffer->steps;
+    exporter->file_offset += buffer->length;
+    exporter->written += buffer->steps;
+}
+
+/**
+ * @brief 写出线程主循环：按组装顺序轮流写出两个缓冲区，打包线程结束且没有待写的块时退出
+ */
+static void writer_loop(TrainingExporter *exporter)
+{
+    int next = 0;
+    mutex_lock(&exporter->mutex);
+    for (;;)
+    {
+        ChunkBuffer *buffer = &exporter->buffers[next];
+        while (!buffer->full && !exporter->packer_done)
+        {
+            cond_wait(&exporter->changed, &exporter->mutex);
+        }
+        if (!buffer->full)
+        {
+            break;
+        }
+        mutex_unlock(&exporter->mutex);
+        write_chunk(exporter, buffer);
+        mutex_lock(&exporter->mutex);
+        buffer->full = false;
+        cond_broadcast(&exporter->changed);
+        next ^= 1;
+    }
+    mutex_unlock(&exporter->mutex);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI packer_entry(LPVOID param)
+{
+    packer_loop((TrainingExporter *)param);
+    return 0;
+}
+
+static DWORD WINAPI writer_entry(LPVOID param)
+{
+    writer_loop((TrainingExporter *)param);
+    return 0;
+}
+
+static bool start_thread(thread_handle *handle, LPTHREAD_START_ROUTINE entry, TrainingExporter *exporter)
+{
+    *handle = CreateThread(NULL, 0, entry, exporter, 0, NULL);
+    return *handle != NULL;
+}
+
+static void join_thread(thread_handle handle)
+{
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+}
+#else
+static void *packer_entry(void *param)
+{
+    packer_loop((TrainingExporter *)param);
+    return NULL;
+}
+
+static void *writer_entry(void *param)
+{
+    writer_loop((TrainingExporter *)param);
+    return NULL;
+}
+
+static bool start_thread(thread_handle *handle, void *(*entry)(void *), TrainingExporter *exporter)
+{
+    return pthread_create(handle, NULL, entry, exporter) == 0;
+}
+
+static void join_thread(thread_handle handle)
+{
+    pthread_join(handle, NULL);
+}
+#endif
+
+// =============================================
+// 创建和关闭
+// =============================================
+
+/**
+ * @brief 释放导出器的内存（线程必须已经结束）
+ */
+static void free_exporter(TrainingExporter *exporter)
+{
+    free(exporter->queues);
+    free(exporter->slot_memory);
+    free(exporter->env);
+    free(exporter->tick);
+    free(exporter->action);
+    free(exporter->reward);
+    free(exporter->done);
+    free(exporter->planes);
+    free(exporter->buffers[0].data);
+    free(exporter->buffers[1].data);
+    free(exporter->index);
+    mutex_destroy(&exporter->mutex);
+    cond_destroy(&exporter->changed);
+    free(exporter);
+}
+
+/**
+ * @brief 结束后台线程，写出块索引和文件尾，关闭文件
+ *
+ * 调用前所有生产者必须已经停止入队。队列中剩余的记录全部写出后才返回。
+ *
+ * @param exporter 导出器（返回后失效）
+ * @param stats 输出：统计，可为NULL
+ * @return ExportStatus 写出结果
+ */
+ExportStatus exporter_close(TrainingExporter *exporter, ExportStats *stats)
+{
+    index_store(&exporter->closing, 1);
+    if (exporter->packer_started)
+    {
+        join_thread(exporter->packer);
+    }
+    else
+    {
+        mutex_lock(&exporter->mutex);
+        exporter->packer_done = true;
+        cond_broadcast(&exporter->changed);
+        mutex_unlock(&exporter->mutex);
+    }
+    if (exporter->writer_started)
+    {
+        join_thread(exporter->writer);
+    }
+
+    bool ok = !exporter->io_error && exporter->packer_started && exporter->writer_started;
+    uint64_t index_offset = exporter->file_offset;
+    unsigned char entry[INDEX_ENTRY_SIZE];
+    for (size_t i = 0; i < exporter->index_count && ok; i++)
+    {
+        memset(entry, 0, sizeof(entry));
+        put_u64(entry, exporter->index[i].offset);
+        put_u64(entry + 8, exporter->index[i].first_step);
+        put_u32(entry + 16, exporter->index[i].steps);
+        ok = fwrite(entry, 1, sizeof(entry), exporter->file) == sizeof(entry);
+    }
+    unsigned char trailer[TRAILER_SIZE];
+    put_u64(trailer, index_offset);
+    put_u32(trailer + 8, (uint32_t)exporter->index_count);
+    put_u32(trailer + 12, 0);
+    memcpy(trailer + 16, TRAILER_MAGIC, 8);
+    ok = ok && fwrite(trailer, 1, sizeof(trailer), exporter->file) == sizeof(trailer);
+    ok = fclose(exporter->file) == 0 && ok;
+
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+        for (int p = 0; p < exporter->producer_count; p++)
+        {
+            stats->pushed += exporter->queues[p].pushed;
+            stats->dropped += exporter->queues[p].dropped;
+        }
+        stats->written = exporter->written;
+        stats->chunks = exporter->index_count;
+        stats->bytes = index_offset + exporter->index_count * INDEX_ENTRY_SIZE + TRAILER_SIZE;
+    }
+    free_exporter(exporter);
+    return ok ? EXPORT_OK : EXPORT_ERROR_IO;
+}
+
+/**
+ * @brief 创建导出器：打开输出文件，写出文件头，分配队列和双缓冲，启动打包线程和写出线程
+ *
+ * @param path 输出文件路径（已存在时覆盖）
+ * @param producers 生产者数（同时入队的线程数，每个线程使用自己的编号）
+ * @param pool_width 游戏池宽度（包括边框）
+ * @param pool_height 游戏池高度（包括边框）
+ * @param chunk_steps 每块步数（<=0使用EXPORT_DEFAULT_CHUNK_STEPS）
+ * @param queue_bytes 每个生产者队列的容量（字节，0使用EXPORT_DEFAULT_QUEUE_BYTES）
+ * @param status 输出：失败原因，可为NULL
+ * @return TrainingExporter* 导出器，失败返回NULL
+ */
+TrainingExporter *exporter_create(const char *path, int producers, int pool_width, int pool_height,
+                                  int chunk_steps, size_t queue_bytes, ExportStatus *status)
+{
+    ExportStatus result = EXPORT_ERROR_MEMORY;
+    if (producers < 1 || producers > PARALLEL_MAX_THREADS || pool_width < 1 || pool_height < 1)
+    {
+        result = EXPORT_ERROR_FORMAT;
+        goto fail;
+    }
+    TrainingExporter *exporter = (TrainingExporter *)heap_alloc(sizeof(TrainingExporter));
+    if (exporter == NULL)
+    {
+        goto fail;
+    }
+    memset(exporter, 0, sizeof(*exporter));
+    mutex_init(&exporter->mutex);
+    cond_init(&exporter->changed);
+    exporter->pool_width = pool_width;
+    exporter->pool_height = pool_height;
+    exporter->cells = (size_t)pool_width * (size_t)pool_height;
+    exporter->plane_bytes = (exporter->cells + 7) / 8;
+    exporter->step_plane_bytes = exporter->plane_bytes * EXPORT_CHANNELS;
+    exporter->chunk_steps = chunk_steps > 0 ? chunk_steps : EXPORT_DEFAULT_CHUNK_STEPS;
+    exporter->producer_count = producers;
+
+    // 队列：槽大小补齐到缓存行，槽数取不超过容量的2的幂
+    exporter->slot_size = (sizeof(StepRecord) + exporter->cells * sizeof(CellType) + CACHE_LINE_SIZE - 1) /
+                          CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    size_t wanted = (queue_bytes > 0 ? queue_bytes : EXPORT_DEFAULT_QUEUE_BYTES) / exporter->slot_size;
+    exporter->queue_slots = QUEUE_MIN_SLOTS;
+    while ((size_t)exporter->queue_slots * 2 <= wanted && exporter->queue_slots < (1u << 30))
+    {
+        exporter->queue_slots *= 2;
+    }
+    exporter->queues = (ProducerQueue *)heap_alloc((size_t)producers * sizeof(ProducerQueue));
+    exporter->slot_memory = (unsigned char *)heap_alloc((size_t)producers * exporter->queue_slots * exporter->slot_size);
+
+    size_t steps = (size_t)exporter->chunk_steps;
+    exporter->env = (uint32_t *)heap_alloc(steps * sizeof(uint32_t));
+    exporter->tick = (uint32_t *)heap_alloc(steps * sizeof(uint32_t));
+    exporter->action = (uint8_t *)heap_alloc(steps);
+    exporter->reward = (float *)heap_alloc(steps * sizeof(float));
+    exporter->done = (uint8_t *)heap_alloc(steps);
+    exporter->planes = (uint8_t *)heap_alloc(steps * exporter->step_plane_bytes);
+    exporter->buffers[0].data = (unsigned char *)heap_alloc(chunk_bound(exporter));
+    exporter->buffers[1].data = (unsigned char *)heap_alloc(chunk_bound(exporter));
+    exporter->index_capacity = 64;
+    exporter->index = (ChunkIndexEntry *)heap_alloc(exporter->index_capacity * sizeof(ChunkIndexEntry));
+    if (exporter->queues == NULL || exporter->slot_memory == NULL || exporter->env == NULL || exporter->tick == NULL ||
+        exporter->action == NULL || exporter->reward == NULL || exporter->done == NULL || exporter->planes == NULL ||
+        exporter->buffers[0].data == NULL || exporter->buffers[1].data == NULL || exporter->index == NULL)
+    {
+        free_exporter(exporter);
+        goto fail;
+    }
+    memset(exporter->queues, 0, (size_t)producers * sizeof(ProducerQueue));
+    for (int p = 0; p < producers; p++)
+    {
+        exporter->queues[p].slots = exporter->slot_memory + (size_t)p * exporter->queue_slots * exporter->slot_size;
+    }
+
+    unsigned char header[EXPORT_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, EXPORT_MAGIC, EXPORT_MAGIC_LENGTH);
+    put_u32(header + 8, EXPORT_VERSION);
+    put_u32(header + 12, EXPORT_HEADER_SIZE);
+    put_u32(header + 16, (uint32_t)pool_width);
+    put_u32(header + 20, (uint32_t)pool_height);
+    put_u32(header + 24, EXPORT_CHANNELS);
+    exporter->file = fopen(path, "wb");
+    if (exporter->file == NULL || fwrite(header, 1, sizeof(header), exporter->file) != sizeof(header))
+    {
+        if (exporter->file != NULL)
+        {
+            fclose(exporter->file);
+        }
+        free_exporter(exporter);
+        result = EXPORT_ERROR_IO;
+        goto fail;
+    }
+    exporter->file_offset = EXPORT_HEADER_SIZE;
+
+    exporter->packer_started = start_thread(&exporter->packer, packer_entry, exporter);
+    exporter->writer_started = start_thread(&exporter->writer, writer_entry, exporter);
+    if (!exporter->packer_started || !exporter->writer_started)
+    {
+        exporter_close(exporter, NULL);
+        result = EXPORT_ERROR_THREAD;
+        goto fail;
+    }
+
+    if (status != NULL)
+    {
+        *status = EXPORT_OK;
+    }
+    return exporter;
+
+fail:
+    if (status != NULL)
+    {
+        *status = result;
+    }
+    return NULL;
+}
+
+// =============================================
+// 读取
+// =============================================
+
+/**
+ * @brief 没有文件尾时顺序扫描数据块头重建块索引（截断的最后一块不计入）
+ */
+static ExportStatus scan_chunks(ExportReader *reader, uint64_t file_size)
+{
+    size_t capacity = 64;
+    reader->index = (ChunkIndexEntry *)heap_alloc(capacity * sizeof(ChunkIndexEntry));
+    if (reader->index == NULL)
+    {
+        return EXPORT_ERROR_MEMORY;
+    }
+
+    uint64_t offset = EXPORT_HEADER_SIZE;
+    unsigned char header[CHUNK_HEADER_SIZE];
+    while (offset + CHUNK_HEADER_SIZE <= file_size && file_seek(reader->file, offset) == 0 &&
+           fread(header, 1, sizeof(header), reader->file) == sizeof(header) && memcmp(header, CHUNK_MAGIC, 4) == 0)
+    {
+        uint32_t steps = get_u32(header + 4);
+        uint64_t size = CHUNK_HEADER_SIZE + (uint64_t)steps * CHUNK_STEP_BYTES + get_u32(header + 8);
+        if (offset + size > file_size)
+        {
+            break;
+        }
+        if ((size_t)reader->chunk_count == capacity)
+        {
+            ChunkIndexEntry *grown = (ChunkIndexEntry *)heap_alloc(capacity * 2 * sizeof(ChunkIndexEntry));
+            if (grown == NULL)
+            {
+                return EXPORT_ERROR_MEMORY;
+            }
+            memcpy(grown, reader->index, capacity * sizeof(ChunkIndexEntry));
+            free(reader->index);
+            reader->index = grown;
+            capacity *= 2;
+        }
+        ChunkIndexEntry *entry = &reader->index[reader->chunk_count++];
+        entry->offset = offset;
+        entry->first_step = reader->steps;
+        entry->steps = steps;
+        reader->steps += steps;
+        offset += size;
+    }
+    return EXPORT_OK;
+}
+
+/**
+ * @brief 由文件尾读取块索引
+ *
+ * @return ExportStatus 文件尾不存在时返回EXPORT_ERROR_FORMAT（调用方改为顺序扫描）
+ */
+static ExportStatus read_index(ExportReader *reader, uint64_t file_size)
+{
+    unsigned char trailer[TRAILER_SIZE];
+    if (file_size < EXPORT_HEADER_SIZE + TRAILER_SIZE || file_seek(reader->file, file_size - TRAILER_SIZE) != 0 ||
+        fread(trailer, 1, sizeof(trailer), reader->file) != sizeof(trailer) ||
+        memcmp(trailer + 16, TRAILER_MAGIC, 8) != 0)
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+    uint64_t index_offset = get_u64(trailer);
+    uint32_t count = get_u32(trailer + 8);
+    if (index_offset < EXPORT_HEADER_SIZE ||
+        index_offset + (uint64_t)count * INDEX_ENTRY_SIZE + TRAILER_SIZE != file_size)
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+
+    reader->index = (ChunkIndexEntry *)heap_alloc(((size_t)count + 1) * sizeof(ChunkIndexEntry));
+    if (reader->index == NULL)
+    {
+        return EXPORT_ERROR_MEMORY;
+    }
+    file_seek(reader->file, index_offset);
+    unsigned char entry[INDEX_ENTRY_SIZE];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (fread(entry, 1, sizeof(entry), reader->file) != sizeof(entry))
+        {
+            return EXPORT_ERROR_FORMAT;
+        }
+        reader->index[i].offset = get_u64(entry);
+        reader->index[i].first_step = get_u64(entry + 8);
+        reader->index[i].steps = get_u32(entry + 16);
+        if (reader->index[i].offset >= index_offset)
+        {
+            return EXPORT_ERROR_FORMAT;
+        }
+        reader->steps += reader->index[i].steps;
+    }
+    reader->chunk_count = (int)count;
+    return EXPORT_OK;
+}
+
+/**
+ * @brief 打开导出文件：校验文件头，读取块索引（没有文件尾时顺序扫描重建）
+ *
+ * @param path 文件路径
+ * @param status 输出：失败原因，可为NULL
+ * @return ExportReader* 读取器，失败返回NULL
+ */
+ExportReader *export_reader_open(const char *path, ExportStatus *status)
+{
+    ExportStatus result = EXPORT_ERROR_MEMORY;
+    ExportReader *reader = (ExportReader *)heap_alloc(sizeof(ExportReader));
+    if (reader == NULL)
+    {
+        goto fail;
+    }
+    memset(reader, 0, sizeof(*reader));
+
+    unsigned char header[EXPORT_HEADER_SIZE];
+    reader->file = fopen(path, "rb");
+    if (reader->file == NULL || fread(header, 1, sizeof(header), reader->file) != sizeof(header))
+    {
+        result = reader->file == NULL ? EXPORT_ERROR_IO : EXPORT_ERROR_FORMAT;
+        goto fail;
+    }
+    if (memcmp(header, EXPORT_MAGIC, EXPORT_MAGIC_LENGTH) != 0)
+    {
+        result = EXPORT_ERROR_FORMAT;
+        goto fail;
+    }
+    if (get_u32(header + 8) != EXPORT_VERSION)
+    {
+        result = EXPORT_ERROR_VERSION;
+        goto fail;
+    }
+    reader->pool_width = (int)get_u32(header + 16);
+    reader->pool_height = (int)get_u32(header + 20);
+    if (get_u32(header + 12) != EXPORT_HEADER_SIZE || get_u32(header + 24) != EXPORT_CHANNELS ||
+        reader->pool_width < 1 || reader->pool_height < 1 || reader->pool_width > 65536 || reader->pool_height > 65536)
+    {
+        result = EXPORT_ERROR_FORMAT;
+        goto fail;
+    }
+    reader->plane_bytes = ((size_t)reader->pool_width * (size_t)reader->pool_height + 7) / 8;
+
+    if (file_seek_end(reader->file) != 0)
+    {
+        result = EXPORT_ERROR_IO;
+        goto fail;
+    }
+    uint64_t file_size = file_tell(reader->file);
+    result = read_index(reader, file_size);
+    if (result == EXPORT_ERROR_FORMAT)
+    {
+        free(reader->index);
+        reader->index = NULL;
+        reader->chunk_count = 0;
+        reader->steps = 0;
+        result = scan_chunks(reader, file_size);
+    }
+    if (result != EXPORT_OK)
+    {
+        goto fail;
+    }
+
+    if (status != NULL)
+    {
+        *status = EXPORT_OK;
+    }
+    return reader;
+
+fail:
+    export_reader_close(reader);
+    if (status != NULL)
+    {
+        *status = result;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 关闭读取器并释放内存（NULL时什么也不做）
+ */
+void export_reader_close(ExportReader *reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+    if (reader->file != NULL)
+    {
+        fclose(reader->file);
+    }
+    free(reader->index);
+    free(reader->raw);
+    free(reader->env);
+    free(reader->tick);
+    free(reader->action);
+    free(reader->reward);
+    free(reader->done);
+    free(reader->planes);
+    free(reader);
+}
+
+/**
+ * @brief 获取导出文件的游戏池尺寸
+ */
+void export_reader_shape(const ExportReader *reader, int *pool_width, int *pool_height)
+{
+    *pool_width = reader->pool_width;
+    *pool_height = reader->pool_height;
+}
+
+/**
+ * @brief 获取数据块数
+ */
+int export_reader_chunk_count(const ExportReader *reader)
+{
+    return reader->chunk_count;
+}
+
+/**
+ * @brief 获取总步数
+ */
+uint64_t export_reader_step_count(const ExportReader *reader)
+{
+    return reader->steps;
+}
+
+/**
+ * @brief 确保各列至少能容纳steps步
+ */
+static bool reserve_columns(ExportReader *reader, uint32_t steps)
+{
+    if (steps <= reader->capacity_steps)
+    {
+        return true;
+    }
+    free(reader->env);
+    free(reader->tick);
+    free(reader->action);
+    free(reader->reward);
+    free(reader->done);
+    free(reader->planes);
+    reader->env = (uint32_t *)heap_alloc((size_t)steps * sizeof(uint32_t));
+    reader->tick = (uint32_t *)heap_alloc((size_t)steps * sizeof(uint32_t));
+    reader->action = (uint8_t *)heap_alloc(steps);
+    reader->reward = (float *)heap_alloc((size_t)steps * sizeof(float));
+    reader->done = (uint8_t *)heap_alloc(steps);
+    reader->planes = (uint8_t *)heap_alloc((size_t)steps * EXPORT_CHANNELS * reader->plane_bytes);
+    bool ok = reader->env != NULL && reader->tick != NULL && reader->action != NULL && reader->reward != NULL &&
+              reader->done != NULL && reader->planes != NULL;
+    reader->capacity_steps = ok ? steps : 0;
+    return ok;
+}
+
+/**
+ * @brief 读取并解码第chunk块（直接按块索引定位）
+ *
+ * @param reader 读取器
+ * @param chunk 块序号（0～export_reader_chunk_count-1）
+ * @param out 输出：解码后的块（数组归读取器所有，读取下一块前有效）
+ * @return ExportStatus 读取结果
+ */
+ExportStatus export_reader_read_chunk(ExportReader *reader, int chunk, ExportChunk *out)
+{
+    if (chunk < 0 || chunk >= reader->chunk_count)
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+    const ChunkIndexEntry *entry = &reader->index[chunk];
+    unsigned char header[CHUNK_HEADER_SIZE];
+    if (file_seek(reader->file, entry->offset) != 0 || fread(header, 1, sizeof(header), reader->file) != sizeof(header))
+    {
+        return EXPORT_ERROR_IO;
+    }
+    uint32_t steps = get_u32(header + 4);
+    size_t compressed = get_u32(header + 8);
+    if (memcmp(header, CHUNK_MAGIC, 4) != 0 || steps != entry->steps)
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+
+    size_t body = (size_t)steps * CHUNK_STEP_BYTES + compressed;
+    if (body > reader->raw_capacity)
+    {
+        free(reader->raw);
+        reader->raw = (unsigned char *)heap_alloc(body);
+        reader->raw_capacity = reader->raw != NULL ? body : 0;
+    }
+    if (reader->raw == NULL || !reserve_columns(reader, steps))
+    {
+        return EXPORT_ERROR_MEMORY;
+    }
+    if (fread(reader->raw, 1, body, reader->file) != body)
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+
+    const unsigned char *p = reader->raw;
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        reader->env[i] = get_u32(p);
+    }
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        reader->tick[i] = get_u32(p);
+    }
+    memcpy(reader->action, p, steps);
+    p += steps;
+    for (uint32_t i = 0; i < steps; i++, p += 4)
+    {
+        uint32_t bits = get_u32(p);
+        memcpy(&reader->reward[i], &bits, sizeof(bits));
+    }
+    memcpy(reader->done, p, steps);
+    p += steps;
+    size_t plane_total = (size_t)steps * EXPORT_CHANNELS * reader->plane_bytes;
+    if (!export_rle_decode(p, compressed, reader->planes, plane_total))
+    {
+        return EXPORT_ERROR_FORMAT;
+    }
+
+    out->steps = steps;
+    out->env = reader->env;
+    out->tick = reader->tick;
+    out->action = reader->action;
+    out->reward = reader->reward;
+    out->done = reader->done;
+    out->planes = reader->planes;
+    out->plane_bytes = reader->plane_bytes;
+    return EXPORT_OK;
+}
+
+/**
+ * @brief 读取位平面中的一位
+ *
+ * @param chunk 数据块
+ * @param step 块内步号
+ * @param channel 观测通道（0～EXPORT_CHANNELS-1）
+ * @param cell 单元格下标（y × pool_width + x）
+ * @return true 该单元格属于该通道
+ */
+bool export_plane_bit(const ExportChunk *chunk, uint32_t step, int channel, int cell)
+{
+    const uint8_t *plane = chunk->planes + ((size_t)step * EXPORT_CHANNELS + (size_t)channel) * chunk->plane_bytes;
+    return (plane[cell >> 3] >> (cell & 7)) & 1;
+}
+
+/**
+ * @brief 导出文件读写结果 → 描述文字
+ */
+const char *export_status_message(ExportStatus status)
+{
+    switch (status)
+    {
+    case EXPORT_OK:
+        return "成功";
+    case EXPORT_ERROR_IO:
+        return "文件无法打开或读写";
+    case EXPORT_ERROR_FORMAT:
+        return "不是导出文件或内容不合法";
+    case EXPORT_ERROR_VERSION:
+        return "不支持的导出格式版本";
+    case EXPORT_ERROR_MEMORY:
+        return "内存不足";
+    case EXPORT_ERROR_THREAD:
+        return "无法创建后台线程";
+    default:
+        return "未知错误";
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file snake_export.h
+ * @brief 训练数据导出（流水线：模拟线程 → 无锁队列 → 后台打包 → 双缓冲异步写出）
+ *
+ * 每一步记录（步前观测，动作，奖励，是否结束）。模拟线程只把步前的游戏池复制到自己的单生产者单消费者
+ * 无锁队列中（不加锁、不分配内存、不做系统调用）；队列满时丢弃这一步并计数，模拟线程永远不会等待磁盘。
+ * 后台打包线程把各队列中的记录按列组装成数据块，游戏池按观测通道编码为位平面并压缩；
+ * 写出线程写出一个数据块时，打包线程已经在另一个缓冲区中组装下一个。
+ *
+ * 文件布局（所有整数和浮点数均为小端序）：
+ *
+ *     文件头（32字节）
+ *         0      8     魔数"SNAKEXPT"
+ *         8      4     格式版本（EXPORT_VERSION）
+ *         12     4     文件头大小（EXPORT_HEADER_SIZE）
+ *         16     4     游戏池宽度（包括边框，环面布局没有边框）
+ *         20     4     游戏池高度
+ *         24     4     观测通道数（EXPORT_CHANNELS）
+ *         28     4     保留（0）
+ *     数据块（重复）
+ *         0      4     魔数"CHNK"
+ *         4      4     步数n
+ *         8      4     压缩后的位平面字节数
+ *         12     4     保留（0）
+ *         16     4n    环境编号（uint32）
+ *         ..     4n    批次步号（uint32，同一环境按步号排序即为轨迹；块内不同环境之间不保证顺序）
+ *         ..     n     动作（Direction）
+ *         ..     4n    奖励（float）
+ *         ..     n     是否结束（0或1）
+ *         ..     ..    位平面：n × EXPORT_CHANNELS个平面，每个平面按行优先每单元格一位（⌈宽×高/8⌉字节），
+ *                      整列用游程编码压缩（见export_rle_encode）
+ *     块索引（每块24字节）：块偏移（uint64）、首步序号（uint64）、步数（uint32）、保留（uint32）
+ *     文件尾（24字节）：块索引偏移（uint64）、块数（uint32）、保留（uint32）、魔数"SNKINDEX"
+ *
+ * 读取时由文件尾找到块索引，任意一块可以直接定位读取；没有文件尾（写出过程中进程退出）时顺序扫描块头重建索引。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_EXPORT_H
+#define SNAKE_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define EXPORT_MAGIC "SNAKEXPT"              ///< 文件魔数（8字节，不含'\0'）
+#define EXPORT_VERSION 1                     ///< 当前格式版本
+#define EXPORT_HEADER_SIZE 32                ///< 文件头大小（字节）
+#define EXPORT_CHANNELS 5                    ///< 观测通道数：蛇头、蛇身、蛇尾、食物、墙壁（与libsnake的观测一致）
+#define EXPORT_DEFAULT_CHUNK_STEPS 4096      ///< 默认每块步数
+#define EXPORT_DEFAULT_QUEUE_BYTES (8 << 20) ///< 默认每个生产者队列的容量（字节）
+
+/**
+ * @enum ExportStatus
+ * @brief 导出文件读写结果
+ */
+typedef enum
+{
+    EXPORT_OK = 0,        ///< 成功
+    EXPORT_ERROR_IO,      ///< 文件无法打开或读写
+    EXPORT_ERROR_FORMAT,  ///< 不是导出文件，或内容不合法、被截断
+    EXPORT_ERROR_VERSION, ///< 不支持的格式版本
+    EXPORT_ERROR_MEMORY,  ///< 内存不足
+    EXPORT_ERROR_THREAD   ///< 无法创建后台线程（打包或写出）
+} ExportStatus;
+
+/**
+ * @struct ExportStats
+ * @brief 导出统计
+ */
+typedef struct
+{
+    uint64_t pushed;  ///< 进入队列的步数
+    uint64_t dropped; ///< 因队列满（或游戏池尺寸与导出文件不一致）丢弃的步数
+    uint64_t written; ///< 写出的步数
+    uint64_t chunks;  ///< 写出的块数
+    uint64_t bytes;   ///< 文件大小（字节）
+} ExportStats;
+
+/**
+ * @struct ExportChunk
+ * @brief 读出的一个数据块（数组归读取器所有，读取下一块前有效）
+ */
+typedef struct
+{
+    uint32_t steps;        ///< 步数
+    const uint32_t *env;   ///< 环境编号
+    const uint32_t *tick;  ///< 批次步号
+    const uint8_t *action; ///< 动作（Direction）
+    const float *reward;   ///< 奖励
+    const uint8_t *done;   ///< 是否结束
+    const uint8_t *planes; ///< 解压后的位平面（steps × EXPORT_CHANNELS × plane_bytes）
+    size_t plane_bytes;    ///< 每个平面的字节数
+} ExportChunk;
+
+typedef struct TrainingExporter TrainingExporter; ///< 导出器（不透明）
+typedef struct ExportReader ExportReader;         ///< 导出文件读取器（不透明）
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+// 写出
+TrainingExporter *exporter_create(const char *path, int producers, int pool_width, int pool_height,
+                                  int chunk_steps, size_t queue_bytes, ExportStatus *status);
+bool exporter_begin(TrainingExporter *exporter, int producer, const GameContext *ctx);
+void exporter_commit(TrainingExporter *exporter, int producer, uint32_t env, uint32_t tick,
+                     Direction action, float reward, bool done);
+ExportStatus exporter_close(TrainingExporter *exporter, ExportStats *stats);
+
+// 读取
+ExportReader *export_reader_open(const char *path, ExportStatus *status);
+void export_reader_close(ExportReader *reader);
+void export_reader_shape(const ExportReader *reader, int *pool_width, int *pool_height);
+int export_reader_chunk_count(const ExportReader *reader);
+uint64_t export_reader_step_count(const ExportReader *reader);
+ExportStatus export_reader_read_chunk(ExportReader *reader, int chunk, ExportChunk *out);
+bool export_plane_bit(const ExportChunk *chunk, uint32_t step, int channel, int cell);
+
+// 编解码
+size_t export_rle_bound(size_t length);
+size_t export_rle_encode(const uint8_t *src, size_t length, uint8_t *dst);
+bool export_rle_decode(const uint8_t *src, size_t length, uint8_t *dst, size_t expected);
+const char *export_status_message(ExportStatus status);
+
+#endif // SNAKE_EXPORT_H
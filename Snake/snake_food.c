@@ -0,0 +1,212 @@
+/**
+ * @file snake_food.c
+ * @brief 食物索引：按8×8网格分桶的食物位置
+ *
+ * 游戏池按8×8单元格划分为桶，每个桶用一个64位掩码记录桶内哪些单元格是食物：
+ * - 生成和吃掉食物：置位或清除一位，O(1)
+ * - 最近食物查询：从所在的桶开始按切比雪夫距离一圈一圈向外扫描非空的桶，
+ *   找到的食物比下一圈可能的最小距离更近时立即停止。
+ *   食物均匀分布时扫描的桶数约为游戏池桶数 / 食物个数，与食物个数成反比
+ * - 环面布局下桶的坐标和距离都回绕（见cell_distance）
+ *
+ * 与可达区域一样，每局第一次查询时才建立（扫描整个游戏池），此后由set_cell_type增量维护；
+ * 从不查询的上下文没有任何额外开销，从存档映射加载的游戏也不需要在加载时扫描游戏池。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_core.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 单元格坐标 → 所在桶的下标
+ */
+static int bucket_of(const FoodIndex *food, int x, int y)
+{
+    return (y >> FOOD_BUCKET_SHIFT) * food->buckets_x + (x >> FOOD_BUCKET_SHIFT);
+}
+
+/**
+ * @brief 单元格坐标 → 在桶掩码中的位
+ */
+static uint64_t bit_of(int x, int y)
+{
+    return 1ULL << (((y & (FOOD_BUCKET_SIZE - 1)) << FOOD_BUCKET_SHIFT) | (x & (FOOD_BUCKET_SIZE - 1)));
+}
+
+/**
+ * @brief 取出掩码中最低的置位位序号并清除该位
+ */
+static int pop_lowest_bit(uint64_t *mask)
+{
+#if defined(__GNUC__)
+    int bit = __builtin_ctzll(*mask);
+#else
+    int bit = 0;
+    while (!((*mask >> bit) & 1))
+    {
+        bit++;
+    }
+#endif
+    *mask &= *mask - 1;
+    return bit;
+}
+
+/**
+ * @brief 在一个桶中查找离from最近的食物，比best_distance更近时更新结果
+ */
+static void scan_bucket(const GameContext *ctx, int bx, int by, Position from, Position *best, int *best_distance)
+{
+    const FoodIndex *food = &ctx->food;
+    uint64_t mask = food->mask[by * food->buckets_x + bx];
+    while (mask != 0)
+    {
+        int bit = pop_lowest_bit(&mask);
+        Position pos = {(bx << FOOD_BUCKET_SHIFT) + (bit & (FOOD_BUCKET_SIZE - 1)),
+                        (by << FOOD_BUCKET_SHIFT) + (bit >> FOOD_BUCKET_SHIFT)};
+        int distance = cell_distance(ctx, pos, from);
+        if (*best_distance < 0 || distance < *best_distance)
+        {
+            *best = pos;
+            *best_distance = distance;
+        }
+    }
+}
+
+// =============================================
+// 建立和维护
+// =============================================
+
+/**
+ * @brief 扫描整个游戏池重新建立食物索引
+ *
+ * 每局第一次查询时自动调用，此后由set_cell_type增量维护。
+ * 搜索类策略可以在复制局面之前先调用，副本随copy_game_state一起复制索引。
+ *
+ * @param ctx 游戏上下文（食物索引数组必须已分配）
+ */
+void food_index_rebuild(GameContext *ctx)
+{
+    FoodIndex *food = &ctx->food;
+    memset(food->mask, 0, (size_t)food->buckets_x * (size_t)food->buckets_y * sizeof(uint64_t));
+    food->count = 0;
+    for (int y = 0; y < ctx->pool_height; y++)
+    {
+        const CellType *row = ctx->pool + (size_t)y * (size_t)ctx->pool_width;
+        for (int x = 0; x < ctx->pool_width; x++)
+        {
+            if (row[x] == CELL_FOOD)
+            {
+                food->mask[bucket_of(food, x, y)] |= bit_of(x, y);
+                food->count++;
+            }
+        }
+    }
+    food->ready = true;
+}
+
+/**
+ * @brief 单元格变为食物或不再是食物后更新索引（由set_cell_type调用，O(1)）
+ *
+ * @param ctx 游戏上下文
+ * @param pos 单元格位置
+ * @param now_food 单元格现在是否是食物
+ */
+void food_cell_changed(GameContext *ctx, Position pos, bool now_food)
+{
+    FoodIndex *food = &ctx->food;
+    uint64_t *mask = &food->mask[bucket_of(food, pos.x, pos.y)];
+    if (now_food)
+    {
+        assert(!(*mask & bit_of(pos.x, pos.y)));
+        *mask |= bit_of(pos.x, pos.y);
+        food->count++;
+    }
+    else
+    {
+        assert(*mask & bit_of(pos.x, pos.y));
+        *mask &= ~bit_of(pos.x, pos.y);
+        food->count--;
+    }
+}
+
+// =============================================
+// 查询
+// =============================================
+
+/**
+ * @brief 查询游戏池中的食物个数（O(1)，本局第一次查询时先建立索引）
+ */
+int food_count(GameContext *ctx)
+{
+    if (!ctx->food.ready)
+    {
+        food_index_rebuild(ctx);
+    }
+    return ctx->food.count;
+}
+
+/**
+ * @brief 查找离指定位置最近（曼哈顿距离，环面布局下回绕）的食物
+ *
+ * 距离相同时先扫描到的胜出（同一局面的结果总是相同）。
+ * 第r圈的桶与from所在的桶相隔r - 1个桶，其中的单元格离from至少(r - 1) × 8 + 1，
+ * 已找到的食物不比这更远时停止扫描。环面布局下回绕经过的最后一个桶可能不满8列（行），
+ * 下界放宽为(r - 2) × 8 + 1。
+ *
+ * @param ctx 游戏上下文
+ * @param from 起点
+ * @param out 输出：最近的食物位置（没有食物时不修改）
+ * @return int 到最近食物的曼哈顿距离，游戏池中没有食物时返回-1
+ */
+int food_nearest(GameContext *ctx, Position from, Position *out)
+{
+    if (food_count(ctx) == 0)
+    {
+        return -1;
+    }
+
+    const FoodIndex *food = &ctx->food;
+    int cx = from.x >> FOOD_BUCKET_SHIFT;
+    int cy = from.y >> FOOD_BUCKET_SHIFT;
+    int max_ring = food->buckets_x > food->buckets_y ? food->buckets_x : food->buckets_y;
+    int slack = ctx->torus ? 2 : 1;
+    Position best = from;
+    int best_distance = -1;
+
+    for (int r = 0; r <= max_ring; r++)
+    {
+        if (best_distance >= 0 && best_distance <= (r - slack) * FOOD_BUCKET_SIZE)
+        {
+            break;
+        }
+        for (int y = cy - r; y <= cy + r; y++)
+        {
+            int by = ctx->torus ? (y % food->buckets_y + food->buckets_y) % food->buckets_y : y;
+            if (by < 0 || by >= food->buckets_y)
+            {
+                continue;
+            }
+            // 首末两行扫描整行，中间各行只扫描两端的桶（环面布局下圈数较大时同一个桶可能扫描多次，不影响结果）
+            int step = (y == cy - r || y == cy + r) ? 1 : 2 * r;
+            for (int x = cx - r; x <= cx + r; x += step > 0 ? step : 1)
+            {
+                int bx = ctx->torus ? (x % food->buckets_x + food->buckets_x) % food->buckets_x : x;
+                if (bx >= 0 && bx < food->buckets_x && food->mask[by * food->buckets_x + bx] != 0)
+                {
+                    scan_bucket(ctx, bx, by, from, &best, &best_distance);
+                }
+            }
+        }
+    }
+
+    *out = best;
+    return best_distance;
+}
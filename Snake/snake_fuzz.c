@@ -0,0 +1,1007 @@
+/**
+ * @file snake_fuzz.c
+ * @brief 单步函数的不变量检查和差分测试（模糊测试驱动）
+ *
+ * 把任意字节串解释为一局游戏的规则和输入序列，用update_game推进，每一帧之后：
+ * - 检查不变量：从蛇尾沿方向编码走到蛇头的步数等于蛇长、蛇的单元格数等于蛇长、
+ *   恰好一个蛇头和一个蛇尾、食物个数等于规则的食物个数（游戏区域放不下时游戏以填满结束）、
+ *   边框全是墙壁且内部的墙壁不超过规则的障碍物个数（环面布局没有边框）
+ * - 与参考实现逐帧对比：参考实现用显式的身体坐标队列按同一份规则（得分、增长节数、食物个数、障碍物、速度曲线）模拟，
+ *   由它推出的整个游戏池（包括障碍物和每节蛇身的方向编码）、蛇尾方向、得分、速度、待长出的节数
+ *   和随机数状态必须与引擎完全一致
+ * - 按输入抽查增量可达区域（reach_region_size）与洪水填充（reach_flood_fill）的结果
+ * - 按输入抽查食物索引（food_count、food_nearest）与逐单元格扫描的结果
+ * - 按输入对比神经网络策略的AVX2内核与标量内核（随机权重网络，CPU支持AVX2时）的输出
+ * - 按输入把游戏保存后再加载回来（游戏池改为映射存档文件），之后继续逐帧对比；
+ *   同时确认蛇头在边框上或蛇头单元格被改写的存档即使不带SAVE_VERIFY_POOL也无法加载
+ *
+ * 输入格式：
+ *     字节0      游戏区域宽度 4 + b % 29
+ *     字节1      游戏区域高度 1 + b % 32；bit7为1时使用穿墙规则（环面布局，高度至少为3）
+ *     字节2～9   随机数种子（小端序，不足8字节时高位为0）
+ *     字节10～13 规则（不足的字节为0，全为0时为默认规则）：
+ *       字节10   bit0～1 每个食物增长的节数 (1 + v) % 4，bit2～4 食物个数 1 + v，bit5～7 障碍物个数 4v
+ *       字节11   每个食物的得分 (10 + b) % 64
+ *       字节12   bit0～3 加速间隔 (50 + 10v) % 160，bit4～7 每次加速减少的毫秒数 (10 + 5v) % 80
+ *       字节13   bit0～3 初始速度 150 - 8v，bit4～7 最快速度 30 + 8v（大于初始速度时取初始速度，即不加速）
+ *     之后每字节推进一帧：
+ *       bit0～1  方向
+ *       bit2     按bit0～1转向
+ *       bit3     按贪心策略转向（优先于bit2，使蛇能活得更久、长得更长）
+ *       bit6     抽查一个单元格的可达区域和离它最近的食物
+ *       bit4～6  （三位同时为1）再对比网络两个内核的输出
+ *       0xFF     （整个字节）本帧之前保存并重新加载游戏，不转向
+ *     游戏结束后以下一个种子开始新的一局，继续消耗输入。
+ *
+ * 构建方式（CMake选项）：
+ * - SNAKE_BUILD_FUZZ：独立程序，snake_fuzz FILE...逐个运行输入文件（兼容AFL的@@），
+ *   snake_fuzz --random N [--seed S]运行N个随机输入并输出每秒迭代次数
+ * - SNAKE_FUZZ_LIBFUZZER：额外定义LLVMFuzzerTestOneInput并以-fsanitize=fuzzer链接（需要Clang）
+ *
+ * 发现不一致时向stderr输出原因并abort()，模糊测试工具据此保存触发问题的输入。
+ *
+ * 编码: UTF-8
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snake_ai.h"
+#include "snake_core.h"
+#include "snake_nn.h"
+#include "snake_rules.h"
+#include "snake_save.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define FUZZ_HEADER_BYTES 14        ///< 输入中宽度、高度、种子和规则占用的字节数
+#define FUZZ_RULES_OFFSET 10        ///< 规则在输入中的偏移
+#define FUZZ_MAX_WIDTH 32           ///< 最大游戏区域宽度
+#define FUZZ_MAX_HEIGHT 32          ///< 最大游戏区域高度
+#define FUZZ_RANDOM_MAX_LENGTH 1024 ///< 随机输入的最大长度（游戏结束后换种子重开，短输入也覆盖多局）
+#define FUZZ_BIT_TURN 0x04          ///< 输入位：按方向转向
+#define FUZZ_BIT_AI 0x08            ///< 输入位：按贪心策略转向
+#define FUZZ_BIT_REACH 0x40         ///< 输入位：抽查可达区域、食物索引和分块占用摘要
+#define FUZZ_BITS_NN 0x70           ///< 输入位：同时为1时对比网络内核（网络前向计算比其余检查慢得多，只抽八分之一）
+#define FUZZ_BYTE_SAVE 0xFF         ///< 输入字节：保存并重新加载
+#define FUZZ_BIT_TORUS 0x80         ///< 字节1：使用穿墙规则
+#define FUZZ_NN_RADIUS 5            ///< 内核对比用网络的窗口半径（输入补齐后跨多个AVX2寄存器）
+#define FUZZ_NN_HIDDEN 64           ///< 内核对比用网络的隐藏单元数
+#define FUZZ_OBSTACLE_CLEARANCE 3   ///< 开局时蛇头正前方不放障碍物的格数（与引擎相同）
+
+/**
+ * @enum RefCell
+ * @brief 参考实现的单元格（不区分蛇身方向，方向由身体坐标队列推出）
+ */
+typedef enum
+{
+    REF_EMPTY = 0, ///< 空单元格
+    REF_WALL,      ///< 墙壁
+    REF_SNAKE,     ///< 蛇的任意一节
+    REF_FOOD       ///< 食物
+} RefCell;
+
+/**
+ * @struct RefGame
+ * @brief 参考实现：显式保存蛇的每一节坐标
+ *
+ * 只追求直观和正确，不考虑速度；规则（包括障碍物和食物的随机位置）与引擎逐条对应。
+ */
+typedef struct
+{
+    Ruleset rules;            ///< 规则（与引擎使用同一份）
+    int width;                ///< 游戏池宽度（包括边框，环面布局没有边框）
+    int height;               ///< 游戏池高度（包括边框，环面布局没有边框）
+    bool torus;               ///< 环面布局（穿墙规则）
+    uint8_t *grid;            ///< 单元格（RefCell）
+    Position *body;           ///< 环形队列，body[first]是蛇尾，依次到蛇头
+    int capacity;             ///< 环形队列容量（游戏池单元格数）
+    int first;                ///< 蛇尾在队列中的下标
+    int length;               ///< 蛇长
+    Direction direction;      ///< 当前方向
+    Direction next_direction; ///< 下一帧的方向
+    int pending_growth;       ///< 待长出的节数
+    Position food;            ///< 最近生成的食物位置
+    int score;                ///< 得分
+    int speed;                ///< 速度
+    bool game_over;           ///< 游戏是否结束
+    DeathCause death;         ///< 结束原因
+    uint64_t rng;             ///< 随机数生成器状态
+} RefGame;
+
+// =============================================
+// 全局变量
+// =============================================
+
+static char save_path[FILENAME_MAX]; ///< 保存/加载检查使用的临时存档文件
+static long long checked_frames = 0; ///< 已检查的帧数
+static NnNet *fuzz_net = NULL;       ///< 内核对比用的随机权重网络（第一次抽查时创建，进程结束时释放）
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 报告不一致并终止
+ */
+static void fail(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "snake_fuzz: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
+
+static const int dir_dx[4] = {0, 0, -1, 1}; ///< 各方向的x增量
+static const int dir_dy[4] = {-1, 1, 0, 0}; ///< 各方向的y增量
+
+/**
+ * @brief 沿方向移动一格（环面布局下取模回绕；不使用引擎的邻居坐标表）
+ */
+static Position step_on_board(int width, int height, bool torus, Position pos, Direction dir)
+{
+    pos.x += dir_dx[dir];
+    pos.y += dir_dy[dir];
+    if (torus)
+    {
+        pos.x = (pos.x + width) % width;
+        pos.y = (pos.y + height) % height;
+    }
+    return pos;
+}
+
+/**
+ * @brief 两格之间的曼哈顿距离（环面布局下每个方向取较短的一段）
+ */
+static int board_distance(int width, int height, bool torus, Position a, Position b)
+{
+    int dx = abs(a.x - b.x);
+    int dy = abs(a.y - b.y);
+    if (torus)
+    {
+        dx = dx < width - dx ? dx : width - dx;
+        dy = dy < height - dy ? dy : height - dy;
+    }
+    return dx + dy;
+}
+
+/**
+ * @brief 相邻两格之间的方向（from → to）
+ */
+static Direction direction_between(int width, int height, bool torus, Position from, Position to)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        Position next = step_on_board(width, height, torus, from, (Direction)d);
+        if (next.x == to.x && next.y == to.y)
+        {
+            return (Direction)d;
+        }
+    }
+    fail("(%d,%d)与(%d,%d)不相邻", from.x, from.y, to.x, to.y);
+    return DIR_RIGHT;
+}
+
+static bool is_snake_cell(CellType cell)
+{
+    return cell == CELL_SNAKE_HEAD || cell == CELL_SNAKE_TAIL ||
+           (cell >= CELL_SNAKE_BODY_UP && cell <= CELL_SNAKE_BODY_RIGHT);
+}
+
+// =============================================
+// 参考实现
+// =============================================
+
+static bool ref_init(RefGame *ref, int width, int height, const Ruleset *rules)
+{
+    memset(ref, 0, sizeof(*ref));
+    ref->rules = *rules;
+    ref->width = width;
+    ref->height = height;
+    ref->torus = rules->wrap;
+    ref->capacity = width * height;
+    ref->grid = (uint8_t *)malloc((size_t)ref->capacity);
+    ref->body = (Position *)malloc((size_t)ref->capacity * sizeof(Position));
+    return ref->grid != NULL && ref->body != NULL;
+}
+
+static void ref_destroy(RefGame *ref)
+{
+    free(ref->grid);
+    free(ref->body);
+}
+
+static Position ref_segment(const RefGame *ref, int i)
+{
+    return ref->body[(ref->first + i) % ref->capacity];
+}
+
+static Position ref_head(const RefGame *ref)
+{
+    return ref_segment(ref, ref->length - 1);
+}
+
+static uint8_t *ref_cell(RefGame *ref, Position pos)
+{
+    return &ref->grid[pos.y * ref->width + pos.x];
+}
+
+/**
+ * @brief 参考随机数生成器（xorshift64*，与引擎的定义相同）
+ */
+static uint32_t ref_random(RefGame *ref)
+{
+    uint64_t x = ref->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    ref->rng = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief 参考速度曲线：每得满一个加速间隔减少一次，不低于最快速度（初始速度不大于最快速度时不加速）
+ */
+static int ref_speed(const Ruleset *rules, int score)
+{
+    int speed = rules->initial_speed;
+    for (int reached = rules->speed_interval; rules->speed_interval > 0 && reached <= score && speed > rules->min_speed;
+         reached += rules->speed_interval)
+    {
+        speed = speed - rules->speed_step > rules->min_speed ? speed - rules->speed_step : rules->min_speed;
+    }
+    return speed;
+}
+
+/**
+ * @brief 参考障碍物：蛇头正前方最多FUZZ_OBSTACLE_CLEARANCE格空单元格不放，其余随机空单元格放墙壁
+ */
+static void ref_place_obstacles(RefGame *ref)
+{
+    Position ahead[FUZZ_OBSTACLE_CLEARANCE];
+    int clear = 0;
+    for (Position pos = ref_head(ref); clear < FUZZ_OBSTACLE_CLEARANCE; clear++)
+    {
+        pos = step_on_board(ref->width, ref->height, ref->torus, pos, ref->direction);
+        if (*ref_cell(ref, pos) != REF_EMPTY)
+        {
+            break;
+        }
+        ahead[clear] = pos;
+    }
+
+    int placed = 0;
+    for (int attempt = 0; attempt < ref->width * ref->height * 2 && placed < ref->rules.obstacles; attempt++)
+    {
+        Position pos;
+        pos.x = (int)(ref_random(ref) % (uint32_t)ref->width);
+        pos.y = (int)(ref_random(ref) % (uint32_t)ref->height);
+        bool protected = false;
+        for (int i = 0; i < clear; i++)
+        {
+            protected = protected || (pos.x == ahead[i].x && pos.y == ahead[i].y);
+        }
+        if (!protected && *ref_cell(ref, pos) == REF_EMPTY)
+        {
+            *ref_cell(ref, pos) = REF_WALL;
+            placed++;
+        }
+    }
+}
+
+static void ref_generate_food(RefGame *ref)
+{
+    int attempts = 0;
+    Position pos;
+    do
+    {
+        pos.x = (int)(ref_random(ref) % (uint32_t)ref->width);
+        pos.y = (int)(ref_random(ref) % (uint32_t)ref->height);
+        if (++attempts > ref->width * ref->height * 2)
+        {
+            ref->game_over = true; // 没有空位，视为胜利
+            ref->death = DEATH_BOARD_FULL;
+            return;
+        }
+    } while (*ref_cell(ref, pos) != REF_EMPTY);
+
+    ref->food = pos;
+    *ref_cell(ref, pos) = REF_FOOD;
+}
+
+static void ref_reset(RefGame *ref, uint64_t seed)
+{
+    ref->rng = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (ref->rng == 0)
+    {
+        ref->rng = 0x9E3779B97F4A7C15ULL;
+    }
+    ref->score = 0;
+    ref->speed = ref->rules.initial_speed;
+    ref->pending_growth = 0;
+    ref->game_over = false;
+    ref->death = DEATH_NONE;
+    ref->direction = DIR_RIGHT;
+    ref->next_direction = DIR_RIGHT;
+
+    for (int y = 0; y < ref->height; y++)
+    {
+        for (int x = 0; x < ref->width; x++)
+        {
+            bool border = !ref->torus && (x == 0 || y == 0 || x == ref->width - 1 || y == ref->height - 1);
+            ref->grid[y * ref->width + x] = border ? REF_WALL : REF_EMPTY;
+        }
+    }
+
+    // 初始蛇长3格，水平向右，蛇头在游戏池中央
+    int head_x = ref->width / 2 + 1;
+    int y = ref->height / 2;
+    ref->first = 0;
+    ref->length = 3;
+    for (int i = 0; i < 3; i++)
+    {
+        ref->body[i] = (Position){head_x - 2 + i, y};
+        *ref_cell(ref, ref->body[i]) = REF_SNAKE;
+    }
+    ref->food = ref_head(ref); // 放不下任何食物时保持指向蛇头
+    ref_place_obstacles(ref);
+    for (int i = 0; i < ref->rules.food_count && !ref->game_over; i++)
+    {
+        ref_generate_food(ref);
+    }
+}
+
+static void ref_turn(RefGame *ref, Direction dir)
+{
+    static const Direction opposite[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+    if (ref->direction != opposite[dir])
+    {
+        ref->next_direction = dir;
+    }
+}
+
+static void ref_step(RefGame *ref)
+{
+    if (ref->game_over)
+    {
+        return;
+    }
+    ref->direction = ref->next_direction;
+    Position head = ref_head(ref);
+    Position next = step_on_board(ref->width, ref->height, ref->torus, head, ref->direction);
+
+    // 蛇尾在本帧移动之前仍然占据单元格，追着蛇尾走也算撞到自己
+    uint8_t ahead = *ref_cell(ref, next);
+    if (ahead == REF_WALL || ahead == REF_SNAKE)
+    {
+        ref->game_over = true;
+        ref->death = ahead == REF_WALL ? DEATH_WALL : DEATH_SELF;
+        return;
+    }
+
+    // 每帧长出一节待长出的节数；不增长时蛇尾先移走，空出的单元格可以放新食物
+    bool ate = ahead == REF_FOOD;
+    if (ate)
+    {
+        ref->score += ref->rules.food_score;
+        ref->speed = ref_speed(&ref->rules, ref->score);
+        ref->pending_growth += ref->rules.growth;
+    }
+    if (ref->pending_growth > 0)
+    {
+        ref->pending_growth--;
+    }
+    else
+    {
+        *ref_cell(ref, ref_segment(ref, 0)) = REF_EMPTY;
+        ref->first = (ref->first + 1) % ref->capacity;
+        ref->length--;
+    }
+    if (ate)
+    {
+        ref_generate_food(ref); // 新食物生成时新蛇头的单元格仍是旧食物
+    }
+
+    ref->body[(ref->first + ref->length) % ref->capacity] = next;
+    ref->length++;
+    *ref_cell(ref, next) = REF_SNAKE;
+}
+
+// =============================================
+// 检查
+// =============================================
+
+/**
+ * @brief 检查引擎自身的不变量（不依赖参考实现）
+ */
+static void check_invariants(const GameContext *ctx)
+{
+    const GameState *game = &ctx->game;
+    int w = ctx->pool_width, h = ctx->pool_height;
+    int snake_cells = 0, heads = 0, tails = 0, foods = 0, obstacles = 0;
+
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            CellType cell = get_cell_type(ctx, (Position){x, y});
+            bool border = !ctx->torus && (x == 0 || y == 0 || x == w - 1 || y == h - 1);
+            if (border && cell != CELL_WALL)
+            {
+                fail("(%d,%d)：边框必须是墙壁", x, y);
+            }
+            obstacles += !border && cell == CELL_WALL;
+            snake_cells += is_snake_cell(cell);
+            heads += cell == CELL_SNAKE_HEAD;
+            tails += cell == CELL_SNAKE_TAIL;
+            foods += cell == CELL_FOOD;
+            if (cell != CELL_WALL && cell != CELL_EMPTY && cell != CELL_FOOD && !is_snake_cell(cell))
+            {
+                fail("(%d,%d)：非法单元格取值%d", x, y, (int)cell);
+            }
+        }
+    }
+
+    if (snake_cells != game->snake.length || heads != 1 || tails != 1)
+    {
+        fail("蛇长%d，但有%d个蛇的单元格（%d个蛇头、%d个蛇尾）", game->snake.length, snake_cells, heads, tails);
+    }
+    if (obstacles > ctx->rules.obstacles)
+    {
+        fail("游戏区域内有%d个墙壁，规则只放%d个障碍物", obstacles, ctx->rules.obstacles);
+    }
+    // 游戏区域被填满时找不到食物的位置，游戏以胜利结束，最近生成的食物可能已被吃掉
+    bool board_full = game->game_over && game->death == DEATH_BOARD_FULL;
+    if (foods != ctx->rules.food_count && !(board_full && foods < ctx->rules.food_count))
+    {
+        fail("有%d个食物，规则为%d个", foods, ctx->rules.food_count);
+    }
+    if (!board_full && get_cell_type(ctx, game->food) != CELL_FOOD)
+    {
+        fail("食物不在(%d,%d)", game->food.x, game->food.y);
+    }
+    if (get_cell_type(ctx, game->snake.head) != CELL_SNAKE_HEAD ||
+        get_cell_type(ctx, game->snake.tail) != CELL_SNAKE_TAIL)
+    {
+        fail("蛇头或蛇尾的位置与游戏池不一致");
+    }
+
+    // 从蛇尾沿方向编码走到蛇头
+    Position pos = game->snake.tail;
+    Direction dir = game->snake.tail_direction;
+    for (int i = 1; i < game->snake.length; i++)
+    {
+        pos = step_on_board(w, h, ctx->torus, pos, dir);
+        CellType cell = get_cell_type(ctx, pos);
+        if (i == game->snake.length - 1)
+        {
+            if (cell != CELL_SNAKE_HEAD || pos.x != game->snake.head.x || pos.y != game->snake.head.y)
+            {
+                fail("从蛇尾走%d步没有到达蛇头", i);
+            }
+        }
+        else if (cell < CELL_SNAKE_BODY_UP || cell > CELL_SNAKE_BODY_RIGHT)
+        {
+            fail("从蛇尾走%d步到达(%d,%d)，不是蛇身", i, pos.x, pos.y);
+        }
+        else
+        {
+            dir = body_type_to_direction(cell);
+        }
+    }
+}
+
+/**
+ * @brief 与参考实现逐项对比
+ */
+static void check_against_reference(const GameContext *ctx, const RefGame *ref)
+{
+    const GameState *game = &ctx->game;
+    Position tail = ref_segment(ref, 0);
+    Position head = ref_head(ref);
+
+    if (game->game_over != ref->game_over || game->death != ref->death || game->score != ref->score ||
+        game->speed != ref->speed || game->snake.pending_growth != ref->pending_growth ||
+        game->snake.length != ref->length || ctx->rng != ref->rng ||
+        game->snake.direction != ref->direction || game->snake.next_direction != ref->next_direction)
+    {
+        fail("游戏状态不一致：结束%d/%d，原因%d/%d，得分%d/%d，速度%d/%d，待长出%d/%d，蛇长%d/%d",
+             game->game_over, ref->game_over, game->death, ref->death, game->score, ref->score,
+             game->speed, ref->speed, game->snake.pending_growth, ref->pending_growth, game->snake.length, ref->length);
+    }
+    if (game->snake.head.x != head.x || game->snake.head.y != head.y ||
+        game->snake.tail.x != tail.x || game->snake.tail.y != tail.y ||
+        game->food.x != ref->food.x || game->food.y != ref->food.y)
+    {
+        fail("蛇头、蛇尾或食物位置不一致");
+    }
+    if (game->snake.tail_direction != direction_between(ref->width, ref->height, ref->torus, tail, ref_segment(ref, 1)))
+    {
+        fail("蛇尾方向不一致");
+    }
+
+    // 蛇以外的单元格
+    for (int i = 0; i < ref->width * ref->height; i++)
+    {
+        static const CellType expected[] = {
+            [REF_EMPTY] = CELL_EMPTY, [REF_WALL] = CELL_WALL, [REF_SNAKE] = CELL_SNAKE_HEAD, [REF_FOOD] = CELL_FOOD};
+        CellType cell = ctx->pool[i];
+        if (ref->grid[i] == REF_SNAKE ? !is_snake_cell(cell) : cell != expected[ref->grid[i]])
+        {
+            fail("(%d,%d)：引擎%d，参考实现%d", i % ref->width, i / ref->width, (int)cell, ref->grid[i]);
+        }
+    }
+
+    // 蛇的每一节：蛇身的方向编码指向更靠近蛇头的一节
+    for (int i = 0; i < ref->length; i++)
+    {
+        Position pos = ref_segment(ref, i);
+        CellType expected = i == 0 ? CELL_SNAKE_TAIL
+                            : i == ref->length - 1
+                                ? CELL_SNAKE_HEAD
+                                : direction_to_body_type(
+                                      direction_between(ref->width, ref->height, ref->torus, pos, ref_segment(ref, i + 1)));
+        CellType cell = get_cell_type(ctx, pos);
+        if (cell != expected)
+        {
+            fail("第%d节(%d,%d)：引擎%d，参考实现%d", i, pos.x, pos.y, (int)cell, (int)expected);
+        }
+    }
+}
+
+/**
+ * @brief 抽查一个单元格：增量可达区域与洪水填充必须一致
+ */
+static void check_reach(GameContext *ctx, uint32_t hash)
+{
+    Position pos = {(int)(hash % (uint32_t)ctx->pool_width), (int)((hash >> 16) % (uint32_t)ctx->pool_height)};
+    int incremental = reach_region_size(ctx, pos);
+    int reference = reach_flood_fill(ctx, pos);
+    if (incremental != reference)
+    {
+        fail("(%d,%d)的可达区域：增量%d，洪水填充%d", pos.x, pos.y, incremental, reference);
+    }
+}
+
+/**
+ * @brief 抽查一个单元格：食物索引查到的最近食物距离必须与逐单元格扫描一致
+ */
+static void check_food(GameContext *ctx, uint32_t hash)
+{
+    Position from = {(int)(hash % (uint32_t)ctx->pool_width), (int)((hash >> 16) % (uint32_t)ctx->pool_height)};
+    int foods = 0;
+    int reference = -1;
+    for (int y = 0; y < ctx->pool_height; y++)
+    {
+        for (int x = 0; x < ctx->pool_width; x++)
+        {
+            if (get_cell_type(ctx, (Position){x, y}) == CELL_FOOD)
+            {
+                int distance = board_distance(ctx->pool_width, ctx->pool_height, ctx->torus, (Position){x, y}, from);
+                reference = reference < 0 || distance < reference ? distance : reference;
+                foods++;
+            }
+        }
+    }
+
+    Position found = {-1, -1};
+    int distance = food_nearest(ctx, from, &found);
+    if (food_count(ctx) != foods || distance != reference ||
+        (distance >= 0 && (get_cell_type(ctx, found) != CELL_FOOD ||
+                           board_distance(ctx->pool_width, ctx->pool_height, ctx->torus, found, from) != distance)))
+    {
+        fail("(%d,%d)的最近食物：索引(%d,%d)距离%d、共%d个，扫描距离%d、共%d个",
+             from.x, from.y, found.x, found.y, distance, food_count(ctx), reference, foods);
+    }
+}
+
+/**
+ * @brief 抽查一个块：增量维护的分块占用摘要必须与逐单元格计数一致
+ */
+static void check_blocks(GameContext *ctx, uint32_t hash)
+{
+    if (!ctx->lod.ready)
+    {
+        block_summary_rebuild(ctx);
+    }
+    Position block = {(int)(hash % (uint32_t)ctx->lod.blocks_x), (int)((hash >> 16) % (uint32_t)ctx->lod.blocks_y)};
+    int snake = 0;
+    int food = 0;
+    int wall = 0;
+    for (int y = block.y * BLOCK_SIZE; y < (block.y + 1) * BLOCK_SIZE && y < ctx->pool_height; y++)
+    {
+        for (int x = block.x * BLOCK_SIZE; x < (block.x + 1) * BLOCK_SIZE && x < ctx->pool_width; x++)
+        {
+            CellType cell = get_cell_type(ctx, (Position){x, y});
+            snake += cell != CELL_EMPTY && cell != CELL_FOOD && cell != CELL_WALL;
+            food += cell == CELL_FOOD;
+            wall += cell == CELL_WALL;
+        }
+    }
+
+    const BlockCounts *counts = &ctx->lod.blocks[block.y * ctx->lod.blocks_x + block.x];
+    if (counts->snake != snake || counts->food != food || counts->wall != wall)
+    {
+        fail("块(%d,%d)：摘要蛇%d食物%d墙%d，计数蛇%d食物%d墙%d", block.x, block.y,
+             counts->snake, counts->food, counts->wall, snake, food, wall);
+    }
+}
+
+/**
+ * @brief 当前局面下网络的AVX2内核与标量内核的输出必须逐位相同
+ */
+static void check_nn_kernels(GameContext *ctx)
+{
+    if (!nn_kernel_supported(NN_KERNEL_AVX2))
+    {
+        return;
+    }
+    if (fuzz_net == NULL && (fuzz_net = nn_create_random(FUZZ_NN_RADIUS, FUZZ_NN_HIDDEN, 20240601)) == NULL)
+    {
+        fail("内存不足");
+    }
+    uint8_t input[2 * (2 * FUZZ_NN_RADIUS + 1) * (2 * FUZZ_NN_RADIUS + 1) + 2 * NN_OUTPUTS + NN_INPUT_ALIGN];
+    int32_t scalar[NN_OUTPUTS];
+    int32_t avx2[NN_OUTPUTS];
+    nn_encode(fuzz_net, ctx, input);
+    nn_set_kernel(fuzz_net, NN_KERNEL_SCALAR);
+    nn_forward(fuzz_net, input, 1, scalar);
+    nn_set_kernel(fuzz_net, NN_KERNEL_AVX2);
+    nn_forward(fuzz_net, input, 1, avx2);
+    if (memcmp(scalar, avx2, sizeof(scalar)) != 0)
+    {
+        fail("网络输出：标量(%d,%d,%d,%d)，AVX2(%d,%d,%d,%d)", scalar[0], scalar[1], scalar[2], scalar[3],
+             avx2[0], avx2[1], avx2[2], avx2[3]);
+    }
+}
+
+/**
+ * @brief 保存后重新加载（加载后游戏池映射存档文件），状态必须不变
+ */
+static void check_save_round_trip(GameContext *ctx, const RefGame *ref)
+{
+    SaveStatus status = save_game(ctx, save_path);
+    if (status == SAVE_OK)
+    {
+        status = load_game(ctx, save_path, SAVE_VERIFY_POOL);
+    }
+    if (status != SAVE_OK)
+    {
+        fail("保存/加载%s失败：%s", save_path, save_status_message(status));
+    }
+    check_against_reference(ctx, ref);
+}
+
+/**
+ * @brief 蛇头在边框上（环面布局下在游戏池外）或蛇头单元格被改写的存档，不带校验标志加载也必须被拒绝
+ *
+ * 借引擎自己写出这样的存档（文件头校验和仍然正确），写出后恢复原状；加载失败时上下文必须不变。
+ */
+static void check_save_rejects(GameContext *ctx, const RefGame *ref)
+{
+    Snake snake = ctx->game.snake;
+    int head = snake.head.y * ctx->pool_width + snake.head.x;
+    CellType head_cell = ctx->pool[head];
+
+    ctx->game.snake.head = (Position){ctx->torus ? ctx->pool_width : 0, snake.head.y};
+    SaveStatus border = save_game(ctx, save_path);
+    ctx->game.snake = snake;
+    if (border == SAVE_OK)
+    {
+        border = load_game(ctx, save_path, 0);
+    }
+
+    ctx->pool[head] = CELL_EMPTY;
+    SaveStatus cell = save_game(ctx, save_path);
+    ctx->pool[head] = head_cell;
+    if (cell == SAVE_OK)
+    {
+        cell = load_game(ctx, save_path, 0);
+    }
+
+    if (border != SAVE_ERROR_FORMAT || cell != SAVE_ERROR_FORMAT)
+    {
+        fail("损坏的存档：蛇头在边框上时%s，蛇头单元格为空时%s", save_status_message(border),
+             save_status_message(cell));
+    }
+    check_against_reference(ctx, ref);
+}
+
+// =============================================
+// 驱动
+// =============================================
+
+/**
+ * @brief 从输入的字节10～13解析规则（映射见文件说明，全为0时为默认规则）
+ *
+ * 得到的规则总能通过ruleset_valid（与规则文件相同的检查），保存后可以原样加载回来。
+ */
+static void decode_rules(const uint8_t *data, size_t size, bool torus, Ruleset *rules)
+{
+    uint8_t bytes[FUZZ_HEADER_BYTES - FUZZ_RULES_OFFSET] = {0};
+    for (size_t i = FUZZ_RULES_OFFSET; i < FUZZ_HEADER_BYTES && i < size; i++)
+    {
+        bytes[i - FUZZ_RULES_OFFSET] = data[i];
+    }
+    default_ruleset(rules);
+    rules->growth = (1 + (bytes[0] & 3)) % 4;
+    rules->food_count = 1 + ((bytes[0] >> 2) & 7);
+    rules->obstacles = (bytes[0] >> 5) * 4;
+    rules->food_score = (FOOD_SCORE + bytes[1]) % 64;
+    rules->speed_interval = (SPEED_INTERVAL + (bytes[2] & 15) * 10) % 160;
+    rules->speed_step = (SPEED_STEP + (bytes[2] >> 4) * 5) % 80;
+    rules->initial_speed = INITIAL_SPEED - (bytes[3] & 15) * 8;
+    rules->min_speed = MIN_SPEED + (bytes[3] >> 4) * 8;
+    if (rules->min_speed > rules->initial_speed)
+    {
+        rules->min_speed = rules->initial_speed;
+    }
+    rules->wrap = torus;
+}
+
+/**
+ * @brief 运行一个输入
+ *
+ * @param data 输入字节串（格式见文件说明）
+ * @param size 字节数
+ */
+static void run_input(const uint8_t *data, size_t size)
+{
+    if (size < 2)
+    {
+        return;
+    }
+    int width = 4 + data[0] % (FUZZ_MAX_WIDTH - 3);
+    int height = 1 + data[1] % FUZZ_MAX_HEIGHT;
+    bool torus = (data[1] & FUZZ_BIT_TORUS) != 0;
+    if (torus && height < TORUS_MIN_SIZE)
+    {
+        height = TORUS_MIN_SIZE;
+    }
+    uint64_t seed = 0;
+    for (size_t i = 2; i < FUZZ_RULES_OFFSET && i < size; i++)
+    {
+        seed |= (uint64_t)data[i] << (8 * (i - 2));
+    }
+    Ruleset rules;
+    decode_rules(data, size, torus, &rules);
+    if (!ruleset_valid(&rules))
+    {
+        fail("输入解析出的规则不合法");
+    }
+
+    GameContext ctx;
+    RefGame ref;
+    int border = torus ? 0 : 2;
+    if (!init_game_context(&ctx, width, height) || !ref_init(&ref, width + border, height + border, &rules))
+    {
+        fail("内存不足");
+    }
+    if (!apply_ruleset(&ctx, &rules))
+    {
+        fail("%dx%d的游戏区域不能使用穿墙规则", width, height);
+    }
+    init_game_state(&ctx, seed);
+    ref_reset(&ref, seed);
+    check_invariants(&ctx);
+    check_against_reference(&ctx, &ref);
+
+    for (size_t i = FUZZ_HEADER_BYTES; i < size; i++)
+    {
+        uint8_t b = data[i];
+        if (ctx.game.game_over)
+        {
+            seed++;
+            init_game_state(&ctx, seed);
+            ref_reset(&ref, seed);
+        }
+
+        if (b == FUZZ_BYTE_SAVE)
+        {
+            check_save_rejects(&ctx, &ref);
+            check_save_round_trip(&ctx, &ref);
+        }
+        else if (b & FUZZ_BIT_AI)
+        {
+            Direction dir = ai_greedy(&ctx);
+            turn_snake(&ctx, dir);
+            ref_turn(&ref, dir);
+        }
+        else if (b & FUZZ_BIT_TURN)
+        {
+            turn_snake(&ctx, (Direction)(b & 3));
+            ref_turn(&ref, (Direction)(b & 3));
+        }
+
+#ifndef NDEBUG
+        size_t heap_allocs_before = heap_alloc_count;
+#endif
+        update_game(&ctx);
+#ifndef NDEBUG
+        if (heap_alloc_count != heap_allocs_before)
+        {
+            fail("update_game申请了堆内存");
+        }
+#endif
+        ref_step(&ref);
+        check_invariants(&ctx);
+        check_against_reference(&ctx, &ref);
+        if (b & FUZZ_BIT_REACH)
+        {
+            check_reach(&ctx, (uint32_t)i * 2654435761u ^ b);
+            check_food(&ctx, (uint32_t)i * 40503u ^ b);
+            check_blocks(&ctx, (uint32_t)i * 2246822519u ^ b);
+        }
+        if ((b & FUZZ_BITS_NN) == FUZZ_BITS_NN)
+        {
+            check_nn_kernels(&ctx);
+        }
+        checked_frames++;
+    }
+
+    ref_destroy(&ref);
+    destroy_game_context(&ctx);
+}
+
+/**
+ * @brief 确定临时存档文件路径（每个进程一个，多个模糊测试进程可以并行）
+ */
+static void init_save_path(void)
+{
+    if (save_path[0] != '\0')
+    {
+        return;
+    }
+#ifdef _WIN32
+    const char *dir = getenv("TEMP");
+#else
+    const char *dir = getenv("TMPDIR");
+#endif
+    snprintf(save_path, sizeof(save_path), "%s/snake_fuzz_%d.sav", dir != NULL ? dir : ".", (int)getpid());
+}
+
+#ifdef SNAKE_FUZZ_LIBFUZZER
+
+/**
+ * @brief libFuzzer入口
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    init_save_path();
+    run_input(data, size);
+    return 0;
+}
+
+#else
+
+/**
+ * @brief 运行一个输入文件（"-"表示标准输入）
+ */
+static bool run_file(const char *path)
+{
+    static uint8_t buffer[1 << 20];
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "无法打开%s\n", path);
+        return false;
+    }
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+    run_input(buffer, size);
+    return true;
+}
+
+/**
+ * @brief 运行随机输入
+ *
+ * 每个输入的游戏区域、种子和长度随机；大约一半输入的每帧字节偏向贪心策略，使蛇活得更久。
+ */
+static void run_random(long long count, uint64_t seed)
+{
+    uint8_t input[FUZZ_RANDOM_MAX_LENGTH];
+    uint64_t x = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (x == 0)
+    {
+        x = 1;
+    }
+
+    clock_t start = clock();
+    for (long long n = 0; n < count; n++)
+    {
+        size_t size = 0;
+        size_t length = FUZZ_HEADER_BYTES;
+        bool prefer_ai = false;
+        while (size < length)
+        {
+            x ^= x >> 12;
+            x ^= x << 25;
+            x ^= x >> 27;
+            uint64_t r = x * 0x2545F4914F6CDD1DULL;
+            if (size == 0)
+            {
+                length = FUZZ_HEADER_BYTES + (size_t)(r >> 40) % (FUZZ_RANDOM_MAX_LENGTH - FUZZ_HEADER_BYTES);
+                prefer_ai = (r >> 32) & 1;
+            }
+            uint8_t b = (uint8_t)(r >> 56);
+            if (size >= FUZZ_HEADER_BYTES && prefer_ai && (r & 7) != 0 && b != FUZZ_BYTE_SAVE)
+            {
+                b |= FUZZ_BIT_AI;
+            }
+            input[size++] = b;
+        }
+        run_input(input, size);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("输入:     %lld 个，种子 %llu\n", count, (unsigned long long)seed);
+    printf("帧数:     %lld，用时 %.3f 秒，%.0f 帧/秒，%.0f 输入/秒\n", checked_frames, seconds,
+           seconds > 0 ? (double)checked_frames / seconds : 0.0, seconds > 0 ? (double)count / seconds : 0.0);
+}
+
+/**
+ * @brief 主函数
+ *
+ * 用法: snake_fuzz FILE...                   逐个运行输入文件（"-"为标准输入）
+ *       snake_fuzz --random N [--seed S]     运行N个随机输入
+ */
+int main(int argc, char **argv)
+{
+    init_save_path();
+
+    if (argc >= 3 && strcmp(argv[1], "--random") == 0)
+    {
+        long long count = 0;
+        unsigned long long seed = (unsigned long long)time(NULL);
+        if (sscanf(argv[2], "%lld", &count) != 1 || count <= 0 || (argc != 3 && argc != 5) ||
+            (argc == 5 && (strcmp(argv[3], "--seed") != 0 || sscanf(argv[4], "%llu", &seed) != 1)))
+        {
+            fprintf(stderr, "用法: snake_fuzz FILE... | snake_fuzz --random N [--seed S]\n");
+            return 2;
+        }
+        run_random(count, (uint64_t)seed);
+    }
+    else if (argc >= 2)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (!run_file(argv[i]))
+            {
+                return 1;
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "用法: snake_fuzz FILE... | snake_fuzz --random N [--seed S]\n");
+        return 2;
+    }
+
+    remove(save_path);
+    nn_destroy(fuzz_net);
+    return 0;
+}
+
+#endif // SNAKE_FUZZ_LIBFUZZER
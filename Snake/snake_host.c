@@ -0,0 +1,1091 @@
+/**
+ * @file snake_host.c
+ * @brief 多会话主机：一个进程同时服务大量终端会话
+ *
+ * 每个会话是一局独立的游戏，连接在一个本地套接字（Unix域套接字）或一个终端设备（PTY从设备、串口）上，
+ * 用ANSI转义序列绘制（字形和颜色来自snake_render.c，与控制台界面的虚拟终端模式相同）。
+ *
+ * 调度：
+ * - 每个工作线程一个epoll事件循环，监听套接字以EPOLLEXCLUSIVE注册到所有工作线程，新连接只唤醒其中一个
+ * - 每个工作线程一个时间轮（1毫秒一槽），每个会话按自己的速度（game.speed）排在下一帧的槽中，
+ *   事件循环每毫秒醒来一次，只处理到期的槽，与会话总数无关
+ * - 下一帧的预定时刻按上一帧的预定时刻累加，不随处理延迟漂移；统计实际执行时刻相对预定时刻的调度延迟
+ *
+ * 内存：
+ * - 会话只保存紧凑状态：游戏状态、随机数状态和游戏池（默认20x20为1.9KB），以及未写出的输出
+ * - 单步用每个工作线程一个共享的游戏上下文：单步前把会话的游戏池指针、游戏状态和随机数状态换入，
+ *   单步后换出；可达区域、食物索引等按需建立的结构每次换入都作废，内存区域也由所有会话共用
+ * - 输出先合成到工作线程共用的帧缓冲，直接写出；对端读得慢时剩余部分暂存在会话中，
+ *   超过上限时丢弃，改为在可写时整屏重绘，慢客户端占用的内存有上限
+ *
+ * 用法: snake_host [--listen PATH] [--tty DEVICE]... [--threads N] [--board WxH] [--rules FILE]
+ *                  [--ai NAME] [--weights FILE] [--seed S] [--stats SECONDS]
+ *
+ * 连接方式：socat -,raw,echo=0 UNIX-CONNECT:PATH；
+ * --tty把一个已经打开的终端（例如另一个终端窗口的/dev/pts/N，其中运行sleep之类不读输入的程序）设为原始模式后作为会话。
+ * 按键：WASD或方向键转向，P或空格暂停，游戏结束后R重玩，Q退出会话。
+ *
+ * 仅限Linux（epoll）。
+ *
+ * 编码: UTF-8
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_ai.h"
+#include "snake_core.h"
+#include "snake_mcts.h"
+#include "snake_nn.h"
+#include "snake_render.h"
+#include "snake_rules.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define HOST_DEFAULT_SOCKET "snake_host.sock" ///< 默认监听的套接字路径
+#define HOST_MAX_THREADS 64                   ///< 最大工作线程数
+#define HOST_MAX_TTYS 64                      ///< 最多--tty个数
+#define HOST_MAX_EVENTS 256                   ///< 每次epoll_wait最多取得的事件数
+#define HOST_IDLE_TIMEOUT_MS 100              ///< 没有会话排队时epoll_wait的超时（检查退出标志）
+#define HOST_INPUT_CHUNK 64                   ///< 每次读取输入的字节数
+#define HOST_TEXT_BYTES 512                   ///< 每帧除单元格以外的文字（标题、状态行）最多占用的字节数
+#define HOST_PENDING_LIMIT (64 * 1024)        ///< 会话暂存输出的上限（字节），超过时丢弃并在可写时整屏重绘
+
+#define WHEEL_SHIFT 10                  ///< 时间轮槽数的对数
+#define WHEEL_SLOTS (1 << WHEEL_SHIFT)  ///< 时间轮槽数（1毫秒一槽，一圈约1秒，更远的会话在槽中等待多圈）
+#define WHEEL_MASK (WHEEL_SLOTS - 1)    ///< 时刻（毫秒） → 槽下标的掩码
+
+#define JITTER_BUCKET_US 100 ///< 调度延迟直方图每桶宽度（微秒）
+#define JITTER_BUCKETS 64    ///< 调度延迟直方图桶数（最后一桶包含所有更长的延迟）
+
+#define KEY_ESCAPE 0x1b ///< 转义序列开始（方向键为ESC [ A～D）
+#define KEY_CTRL_C 0x03 ///< Ctrl+C（原始模式下不产生信号，按退出处理）
+
+/**
+ * @struct HostOptions
+ * @brief 命令行参数
+ */
+typedef struct
+{
+    const char *listen_path;         ///< 监听的套接字路径（NULL表示不监听）
+    const char *ttys[HOST_MAX_TTYS]; ///< 作为会话的终端设备
+    int tty_count;                   ///< 终端设备个数
+    int threads;                     ///< 工作线程数
+    int board_width;                 ///< 游戏区域宽度
+    int board_height;                ///< 游戏区域高度
+    Ruleset rules;                   ///< 游戏规则
+    AiPolicy ai;                     ///< 自动策略（NULL表示由按键控制；设置后按键只能暂停和退出）
+    const char *weights;             ///< 神经网络策略的权重文件（NULL表示内置权重）
+    uint64_t seed;                   ///< 随机数种子（第n个会话的第k局使用由seed、n、k决定的种子）
+    int stats_seconds;               ///< 统计信息输出间隔（秒，0表示不输出）
+} HostOptions;
+
+/**
+ * @struct Session
+ * @brief 一个会话（一局游戏和它的连接）
+ *
+ * 会话和游戏池在一次分配中，游戏池紧跟在结构体后面。
+ */
+typedef struct Session
+{
+    int fd;                    ///< 连接（套接字或终端设备）
+    struct termios *saved_tty; ///< 终端设备原来的设置（套接字会话为NULL），关闭会话时恢复
+    uint32_t serial;           ///< 会话编号（工作线程内）
+    uint32_t games;            ///< 已开始的局数
+    struct Session *prev;      ///< 时间轮槽内的上一个会话
+    struct Session *next;      ///< 时间轮槽内的下一个会话
+    struct Session *all_prev;  ///< 工作线程会话链表中的上一个会话
+    struct Session *all_next;  ///< 工作线程会话链表中的下一个会话
+    uint64_t due_us;           ///< 下一帧的预定时刻（微秒，单调时钟）
+    uint32_t slot;             ///< 所在的时间轮槽
+    bool scheduled;            ///< 是否在时间轮中（暂停和游戏结束时不在）
+    bool redraw;               ///< 下一次绘制时整屏重绘
+    bool over_drawn;           ///< 游戏结束信息已绘制
+    uint8_t escape;            ///< 方向键转义序列的解析进度（0：无，1：ESC，2：ESC [）
+    int shown_score;           ///< 状态行上显示的得分（-1表示需要重绘状态行）
+    int shown_speed;           ///< 状态行上显示的速度
+    bool shown_paused;         ///< 状态行上显示的暂停状态
+    char *pending;             ///< 暂存的未写出输出（没有时为NULL）
+    size_t pending_length;     ///< 暂存的字节数
+    GameState game;            ///< 游戏状态
+    uint64_t rng;              ///< 随机数状态
+    CellType pool[];           ///< 游戏池（pool_width × pool_height）
+} Session;
+
+/**
+ * @struct Worker
+ * @brief 工作线程：一个事件循环、一个时间轮和单步用的共享上下文
+ */
+typedef struct
+{
+    int index;                       ///< 线程序号
+    int epoll_fd;                    ///< epoll实例
+    pthread_t thread;                ///< 线程
+    GameContext scratch;             ///< 单步用的共享游戏上下文
+    Frame frame;                     ///< 输出合成用的帧缓冲（一次容纳一个会话的整屏重绘）
+    Session *wheel[WHEEL_SLOTS];     ///< 时间轮：各槽的会话链表
+    Session *all;                    ///< 所有会话的链表（包括暂停和游戏结束、不在时间轮中的会话）
+    uint64_t current_ms;             ///< 时间轮已处理到的时刻（毫秒）
+    int sessions;                    ///< 会话数
+    int scheduled;                   ///< 时间轮中的会话数
+    uint32_t next_serial;            ///< 下一个会话编号
+    // 统计（每次输出后清零）
+    uint64_t ticks;                  ///< 执行的帧数
+    uint64_t bytes;                  ///< 写出的字节数
+    uint64_t dropped;                ///< 因对端读得慢丢弃的输出字节数
+    uint32_t jitter[JITTER_BUCKETS]; ///< 调度延迟直方图
+    uint64_t max_jitter_us;          ///< 最大调度延迟（微秒）
+    uint64_t report_us;              ///< 上一次输出统计的时刻
+} Worker;
+
+// =============================================
+// 全局变量
+// =============================================
+
+static HostOptions options;                  ///< 命令行参数
+static int listen_fd = -1;                   ///< 监听套接字（不监听时为-1）
+static Worker *workers = NULL;               ///< 工作线程数组
+static volatile sig_atomic_t stopping = 0;   ///< 收到SIGINT/SIGTERM后置位，各工作线程关闭所有会话后退出
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 单调时钟（微秒）
+ */
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief 信号处理：只设置退出标志
+ */
+static void handle_stop_signal(int signal_number)
+{
+    (void)signal_number;
+    stopping = 1;
+}
+
+/**
+ * @brief 设置文件描述符为非阻塞
+ */
+static bool set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * @brief 单元格数
+ */
+static size_t pool_cells(const Worker *worker)
+{
+    return (size_t)worker->scratch.pool_width * (size_t)worker->scratch.pool_height;
+}
+
+// =============================================
+// 时间轮
+// =============================================
+
+/**
+ * @brief 把会话排入下一帧的预定时刻所在的槽
+ *
+ * 预定时刻不晚于已处理的时刻时排入下一毫秒的槽（已经错过的槽要等一圈才会再处理）。
+ */
+static void wheel_insert(Worker *worker, Session *session)
+{
+    uint64_t due_ms = session->due_us / 1000u;
+    if (due_ms <= worker->current_ms)
+    {
+        due_ms = worker->current_ms + 1;
+    }
+    session->slot = (uint32_t)(due_ms & WHEEL_MASK);
+    Session **slot = &worker->wheel[session->slot];
+    session->prev = NULL;
+    session->next = *slot;
+    if (*slot != NULL)
+    {
+        (*slot)->prev = session;
+    }
+    *slot = session;
+    session->scheduled = true;
+    worker->scheduled++;
+}
+
+/**
+ * @brief 把会话移出时间轮（不在时间轮中时什么也不做）
+ */
+static void wheel_remove(Worker *worker, Session *session)
+{
+    if (!session->scheduled)
+    {
+        return;
+    }
+    if (session->prev != NULL)
+    {
+        session->prev->next = session->next;
+    }
+    else
+    {
+        worker->wheel[session->slot] = session->next;
+    }
+    if (session->next != NULL)
+    {
+        session->next->prev = session->prev;
+    }
+    session->prev = session->next = NULL;
+    session->scheduled = false;
+    worker->scheduled--;
+}
+
+// =============================================
+// 输出
+// =============================================
+
+/**
+ * @brief 把输出写到会话的连接，写不完的部分暂存，等待可写事件
+ *
+ * 暂存超过HOST_PENDING_LIMIT时丢弃全部暂存，改为可写时整屏重绘（增量输出依赖之前的输出全部到达）。
+ */
+static void session_send(Worker *worker, Session *session, const char *data, size_t length)
+{
+    size_t written = 0;
+    if (session->pending == NULL)
+    {
+        ssize_t n = write(session->fd, data, length);
+        written = n > 0 ? (size_t)n : 0;
+        worker->bytes += written;
+        if (written == length)
+        {
+            return;
+        }
+    }
+
+    size_t rest = length - written;
+    if (session->pending_length + rest > HOST_PENDING_LIMIT)
+    {
+        worker->dropped += session->pending_length + rest;
+        free(session->pending);
+        session->pending = NULL;
+        session->pending_length = 0;
+        session->redraw = true;
+    }
+    else
+    {
+        char *grown = (char *)realloc(session->pending, session->pending_length + rest);
+        if (grown == NULL)
+        {
+            session->redraw = true;
+            return;
+        }
+        memcpy(grown + session->pending_length, data + written, rest);
+        session->pending = grown;
+        session->pending_length += rest;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP, .data.ptr = session};
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, session->fd, &event);
+}
+
+/**
+ * @brief 追加状态行文字（格式化结果截断到剩余容量）
+ */
+static void frame_printf(Frame *frame, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void frame_printf(Frame *frame, const char *fmt, ...)
+{
+    char text[HOST_TEXT_BYTES / 2];
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (length > 0)
+    {
+        size_t bytes = (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1;
+        frame_put(frame, text, bytes < frame_available(frame) ? bytes : frame_available(frame));
+    }
+}
+
+/**
+ * @brief 绘制会话：整屏重绘或只绘制这一帧改变的单元格，以及变化了的状态行
+ *
+ * 共享上下文的脏标记是这一帧（或这一局开局）写过的单元格；绘制时全部清除，下一个会话从干净的脏标记开始。
+ */
+static void session_draw(Worker *worker, Session *session)
+{
+    Frame *frame = &worker->frame;
+    GameContext *ctx = &worker->scratch;
+    const GameState *game = &session->game;
+    int width = ctx->pool_width;
+    int cells = (int)pool_cells(worker);
+
+    frame_reset(frame);
+    frame->attributes = -1; // 每个终端的颜色状态各自独立
+    if (session->redraw)
+    {
+        frame_put(frame, "\x1b[0m\x1b[2J\x1b[?25l", 14);
+        frame_move_to(frame, 0, 0);
+        frame_set_attributes(frame, ATTR_FG_GREEN | ATTR_FG_INTENSITY);
+        frame_printf(frame, "贪吃蛇 - 会话 %d.%u", worker->index, session->serial);
+        session->shown_score = -1;
+    }
+
+    for (int i = 0; i < cells; i++)
+    {
+        if (session->redraw || ctx->dirty[i])
+        {
+            frame_move_to(frame, (i % width) * 2, 1 + i / width);
+            frame_put_glyph(frame, CELL_GLYPH(session->pool[i]));
+        }
+        ctx->dirty[i] = false;
+    }
+    session->redraw = false;
+
+    int status_row = 1 + ctx->pool_height;
+    if (game->score != session->shown_score || game->speed != session->shown_speed ||
+        game->paused != session->shown_paused)
+    {
+        frame_move_to(frame, 0, status_row);
+        frame_set_attributes(frame, ATTR_FG_RED | ATTR_FG_GREEN | ATTR_FG_INTENSITY);
+        frame_printf(frame, "得分: %d  速度: %dms  %s\x1b[K", game->score, game->speed,
+                     game->paused ? "暂停" : "进行中");
+        session->shown_score = game->score;
+        session->shown_speed = game->speed;
+        session->shown_paused = game->paused;
+    }
+    if (game->game_over && !session->over_drawn)
+    {
+        frame_move_to(frame, 0, status_row + 1);
+        frame_set_attributes(frame, ATTR_FG_RED | ATTR_FG_INTENSITY);
+        frame_printf(frame, "游戏结束！最终得分 %d，按R重玩，按Q退出", game->score);
+        session->over_drawn = true;
+    }
+    frame_move_to(frame, 0, status_row + 2);
+    session_send(worker, session, frame->data, frame->length);
+}
+
+// =============================================
+// 会话
+// =============================================
+
+/**
+ * @brief 把会话的紧凑状态换入共享上下文
+ *
+ * 游戏池直接使用会话中的数组；按需建立的可达区域、食物索引和分块摘要属于上一个会话，全部作废。
+ */
+static GameContext *session_swap_in(Worker *worker, Session *session)
+{
+    GameContext *ctx = &worker->scratch;
+    ctx->pool = session->pool;
+    ctx->game = session->game;
+    ctx->rng = session->rng;
+    ctx->reach.ready = false;
+    ctx->food.ready = false;
+    ctx->lod.ready = false;
+    return ctx;
+}
+
+/**
+ * @brief 把共享上下文中的游戏状态换出到会话
+ */
+static void session_swap_out(Worker *worker, Session *session)
+{
+    session->game = worker->scratch.game;
+    session->rng = worker->scratch.rng;
+}
+
+/**
+ * @brief 开始新的一局并整屏重绘，按初始速度排入时间轮
+ */
+static void session_new_game(Worker *worker, Session *session)
+{
+    GameContext *ctx = &worker->scratch;
+    uint64_t seed = options.seed + ((uint64_t)session->serial * (uint64_t)options.threads + (uint64_t)worker->index) * 0x9e3779b97f4a7c15ull +
+                    session->games++;
+    init_game_state(ctx, seed); // 在共享上下文的单局内存区域中开局，然后把游戏池复制到会话
+    memcpy(session->pool, ctx->pool, pool_cells(worker) * sizeof(CellType));
+    session_swap_out(worker, session);
+
+    session->redraw = true;
+    session->over_drawn = false;
+    session_draw(worker, session);
+
+    wheel_remove(worker, session);
+    session->due_us = now_us() + (uint64_t)session->game.speed * 1000u;
+    wheel_insert(worker, session);
+}
+
+/**
+ * @brief 创建会话并注册到工作线程（套接字或终端设备）
+ *
+ * @param worker 工作线程
+ * @param fd 连接（会话接管，失败时关闭）
+ * @param saved_tty 终端设备原来的设置（套接字为NULL；会话接管）
+ * @return true 创建成功
+ */
+static bool session_open(Worker *worker, int fd, struct termios *saved_tty)
+{
+    Session *session = (Session *)calloc(1, sizeof(Session) + pool_cells(worker) * sizeof(CellType));
+    struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP};
+    if (session == NULL || !set_nonblocking(fd))
+    {
+        free(session);
+        free(saved_tty);
+        close(fd);
+        return false;
+    }
+    session->fd = fd;
+    session->saved_tty = saved_tty;
+    session->serial = worker->next_serial++;
+    event.data.ptr = session;
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        free(session);
+        free(saved_tty);
+        close(fd);
+        return false;
+    }
+    session->all_next = worker->all;
+    if (worker->all != NULL)
+    {
+        worker->all->all_prev = session;
+    }
+    worker->all = session;
+    worker->sessions++;
+    session_new_game(worker, session);
+    return true;
+}
+
+/**
+ * @brief 关闭会话：移出时间轮，恢复终端设置（终端设备会话），关闭连接并释放内存
+ */
+static void session_close(Worker *worker, Session *session)
+{
+    wheel_remove(worker, session);
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, session->fd, NULL);
+    if (session->saved_tty != NULL)
+    {
+        static const char RESTORE[] = "\x1b[0m\x1b[?25h\r\n";
+        ssize_t ignored = write(session->fd, RESTORE, sizeof(RESTORE) - 1);
+        (void)ignored;
+        tcsetattr(session->fd, TCSANOW, session->saved_tty);
+        free(session->saved_tty);
+    }
+    close(session->fd);
+    if (session->all_prev != NULL)
+    {
+        session->all_prev->all_next = session->all_next;
+    }
+    else
+    {
+        worker->all = session->all_next;
+    }
+    if (session->all_next != NULL)
+    {
+        session->all_next->all_prev = session->all_prev;
+    }
+    free(session->pending);
+    free(session);
+    worker->sessions--;
+}
+
+/**
+ * @brief 执行会话的一帧：换入、（自动策略转向、）单步、换出、增量绘制，按新速度排入下一帧
+ */
+static void session_tick(Worker *worker, Session *session, uint64_t now)
+{
+    uint64_t lateness = now > session->due_us ? now - session->due_us : 0;
+    uint64_t bucket = lateness / JITTER_BUCKET_US;
+    worker->jitter[bucket < JITTER_BUCKETS ? bucket : JITTER_BUCKETS - 1]++;
+    worker->max_jitter_us = lateness > worker->max_jitter_us ? lateness : worker->max_jitter_us;
+    worker->ticks++;
+
+    GameContext *ctx = session_swap_in(worker, session);
+    if (options.ai != NULL)
+    {
+        turn_snake(ctx, options.ai(ctx));
+    }
+    update_game(ctx);
+    session_swap_out(worker, session);
+    session_draw(worker, session);
+
+    if (!session->game.game_over)
+    {
+        // 按预定时刻累加，处理延迟不会累积；落后超过一帧时从现在重新开始计时
+        session->due_us += (uint64_t)session->game.speed * 1000u;
+        if (session->due_us <= now)
+        {
+            session->due_us = now + (uint64_t)session->game.speed * 1000u;
+        }
+        wheel_insert(worker, session);
+    }
+}
+
+/**
+ * @brief 处理会话的一个输入字节
+ *
+ * @return false 会话要求退出
+ */
+static bool session_key(Worker *worker, Session *session, unsigned char key)
+{
+    Direction dir;
+    if (session->escape == 1)
+    {
+        session->escape = key == '[' ? 2 : 0;
+        return true;
+    }
+    if (session->escape == 2)
+    {
+        session->escape = 0;
+        switch (key)
+        {
+        case 'A':
+            dir = DIR_UP;
+            break;
+        case 'B':
+            dir = DIR_DOWN;
+            break;
+        case 'C':
+            dir = DIR_RIGHT;
+            break;
+        case 'D':
+            dir = DIR_LEFT;
+            break;
+        default:
+            return true;
+        }
+    }
+    else
+    {
+        switch (key)
+        {
+        case KEY_ESCAPE:
+            session->escape = 1;
+            return true;
+        case 'w':
+        case 'W':
+            dir = DIR_UP;
+            break;
+        case 's':
+        case 'S':
+            dir = DIR_DOWN;
+            break;
+        case 'a':
+        case 'A':
+            dir = DIR_LEFT;
+            break;
+        case 'd':
+        case 'D':
+            dir = DIR_RIGHT;
+            break;
+        case ' ':
+        case 'p':
+        case 'P':
+            if (!session->game.game_over)
+            {
+                session->game.paused = !session->game.paused;
+                if (session->game.paused)
+                {
+                    wheel_remove(worker, session);
+                }
+                else
+                {
+                    session->due_us = now_us() + (uint64_t)session->game.speed * 1000u;
+                    wheel_insert(worker, session);
+                }
+                session_draw(worker, session);
+            }
+            return true;
+        case 'r':
+        case 'R':
+            if (session->game.game_over)
+            {
+                session_new_game(worker, session);
+            }
+            return true;
+        case 'q':
+        case 'Q':
+        case KEY_CTRL_C:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // 转向只改变输入缓冲，不需要完整换入；自动策略控制时忽略方向键
+    if (options.ai == NULL && !session->game.game_over)
+    {
+        GameContext *ctx = &worker->scratch;
+        ctx->game = session->game;
+        turn_snake(ctx, dir);
+        session->game = ctx->game;
+    }
+    return true;
+}
+
+/**
+ * @brief 处理会话连接上的事件
+ */
+static void session_event(Worker *worker, Session *session, uint32_t events)
+{
+    if (events & EPOLLIN)
+    {
+        unsigned char input[HOST_INPUT_CHUNK];
+        ssize_t n = read(session->fd, input, sizeof(input));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            session_close(worker, session);
+            return;
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (!session_key(worker, session, input[i]))
+            {
+                session_close(worker, session);
+                return;
+            }
+        }
+    }
+    else if (events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+    {
+        session_close(worker, session);
+        return;
+    }
+
+    if ((events & EPOLLOUT) && session->pending != NULL)
+    {
+        ssize_t n = write(session->fd, session->pending, session->pending_length);
+        size_t written = n > 0 ? (size_t)n : 0;
+        worker->bytes += written;
+        memmove(session->pending, session->pending + written, session->pending_length - written);
+        session->pending_length -= written;
+        if (session->pending_length > 0)
+        {
+            return;
+        }
+        free(session->pending);
+        session->pending = NULL;
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = session};
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, session->fd, &event);
+    }
+    if (session->redraw && session->pending == NULL)
+    {
+        // 之前因为对端读得慢丢弃了输出，现在可写了，整屏重绘
+        session_draw(worker, session);
+    }
+}
+
+/**
+ * @brief 打开终端设备作为会话：保存原来的设置并切换到原始模式
+ */
+static bool open_tty_session(Worker *worker, const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    struct termios *saved = (struct termios *)malloc(sizeof(struct termios));
+    if (fd < 0 || saved == NULL || tcgetattr(fd, saved) != 0)
+    {
+        fprintf(stderr, "无法打开终端%s: %s\n", path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        free(saved);
+        return false;
+    }
+    struct termios raw = *saved;
+    cfmakeraw(&raw);
+    tcsetattr(fd, TCSANOW, &raw);
+    return session_open(worker, fd, saved);
+}
+
+// =============================================
+// 工作线程
+// =============================================
+
+/**
+ * @brief 处理所有到期的时间轮槽
+ *
+ * 从上次处理到的时刻起逐毫秒处理到现在；落后超过一圈时每个槽只处理一次（槽中所有到期会话都会执行）。
+ */
+static void wheel_advance(Worker *worker, uint64_t now)
+{
+    uint64_t now_ms = now / 1000u;
+    uint64_t steps = now_ms > worker->current_ms ? now_ms - worker->current_ms : 0;
+    if (steps > WHEEL_SLOTS)
+    {
+        steps = WHEEL_SLOTS;
+    }
+    for (uint64_t step = 1; step <= steps; step++)
+    {
+        Session *session = worker->wheel[(now_ms - steps + step) & WHEEL_MASK];
+        while (session != NULL)
+        {
+            Session *next = session->next;
+            if (session->due_us / 1000u <= now_ms)
+            {
+                wheel_remove(worker, session);
+                session_tick(worker, session, now);
+            }
+            session = next;
+        }
+    }
+    worker->current_ms = now_ms > worker->current_ms ? now_ms : worker->current_ms;
+}
+
+/**
+ * @brief 输出并清零统计信息（调度延迟的分位数按直方图桶的上界估计）
+ */
+static void worker_report(Worker *worker, uint64_t now)
+{
+    double seconds = (double)(now - worker->report_us) * 1e-6;
+    uint64_t total = 0;
+    for (int b = 0; b < JITTER_BUCKETS; b++)
+    {
+        total += worker->jitter[b];
+    }
+
+    double p50 = 0.0, p99 = 0.0;
+    uint64_t seen = 0;
+    for (int b = 0; b < JITTER_BUCKETS && total > 0; b++)
+    {
+        uint64_t before = seen;
+        seen += worker->jitter[b];
+        double upper = (double)((b + 1) * JITTER_BUCKET_US) / 1000.0;
+        if (before < (total + 1) / 2 && seen >= (total + 1) / 2)
+        {
+            p50 = upper;
+        }
+        if (before < total - total / 100 && seen >= total - total / 100)
+        {
+            p99 = upper;
+        }
+    }
+
+    fprintf(stderr, "线程%d: 会话 %d，%.0f 帧/秒，输出 %.2f MB/秒（丢弃 %llu 字节），调度延迟 P50 ≤%.1f ms，P99 ≤%.1f ms，最大 %.2f ms\n",
+            worker->index, worker->sessions, seconds > 0 ? (double)worker->ticks / seconds : 0.0,
+            seconds > 0 ? (double)worker->bytes / seconds / 1e6 : 0.0, (unsigned long long)worker->dropped,
+            p50, p99, (double)worker->max_jitter_us / 1000.0);
+
+    memset(worker->jitter, 0, sizeof(worker->jitter));
+    worker->ticks = worker->bytes = worker->dropped = worker->max_jitter_us = 0;
+    worker->report_us = now;
+}
+
+/**
+ * @brief 工作线程主循环：等待事件（有会话排队时每毫秒醒来一次），处理事件，执行到期的帧
+ */
+static void *worker_main(void *param)
+{
+    Worker *worker = (Worker *)param;
+    struct epoll_event events[HOST_MAX_EVENTS];
+
+    while (!stopping)
+    {
+        int timeout = worker->scheduled > 0 ? 1 : HOST_IDLE_TIMEOUT_MS;
+        int count = epoll_wait(worker->epoll_fd, events, HOST_MAX_EVENTS, timeout);
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr == NULL)
+            {
+                // 新连接（EPOLLEXCLUSIVE：只唤醒一个工作线程，其他线程可能已经接受了它）
+                int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd >= 0)
+                {
+                    session_open(worker, fd, NULL);
+                }
+                continue;
+            }
+            session_event(worker, (Session *)events[i].data.ptr, events[i].events);
+        }
+
+        uint64_t now = now_us();
+        wheel_advance(worker, now);
+        if (options.stats_seconds > 0 && now - worker->report_us >= (uint64_t)options.stats_seconds * 1000000u)
+        {
+            worker_report(worker, now);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 初始化工作线程：epoll实例、共享上下文（应用规则）和帧缓冲
+ */
+static bool worker_init(Worker *worker, int index)
+{
+    memset(worker, 0, sizeof(*worker));
+    worker->index = index;
+    worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (worker->epoll_fd < 0 || !init_game_context(&worker->scratch, options.board_width, options.board_height) ||
+        !apply_ruleset(&worker->scratch, &options.rules))
+    {
+        return false;
+    }
+    size_t capacity = pool_cells(worker) * FRAME_BYTES_PER_CELL + HOST_TEXT_BYTES;
+    if (!frame_init(&worker->frame, capacity))
+    {
+        return false;
+    }
+    worker->current_ms = now_us() / 1000u;
+    worker->report_us = now_us();
+
+    if (listen_fd >= 0)
+    {
+        struct epoll_event event = {.events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = NULL};
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 关闭工作线程的所有会话（在各自的线程退出后由主线程调用），释放共享上下文
+ */
+static void worker_destroy(Worker *worker)
+{
+    while (worker->all != NULL)
+    {
+        session_close(worker, worker->all);
+    }
+    frame_destroy(&worker->frame);
+    destroy_game_context(&worker->scratch);
+    close(worker->epoll_fd);
+}
+
+// =============================================
+// 命令行
+// =============================================
+
+/**
+ * @brief 解析命令行参数
+ *
+ * @return true 参数合法
+ */
+static bool parse_options(int argc, char **argv)
+{
+    options.listen_path = NULL;
+    options.tty_count = 0;
+    options.threads = 1;
+    options.board_width = GAME_WIDTH;
+    options.board_height = GAME_HEIGHT;
+    default_ruleset(&options.rules);
+    options.ai = NULL;
+    options.weights = NULL;
+    options.seed = (uint64_t)time(NULL);
+    options.stats_seconds = 0;
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i += 2)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            ok = false;
+        }
+        else if (strcmp(arg, "--listen") == 0)
+        {
+            options.listen_path = value;
+        }
+        else if (strcmp(arg, "--tty") == 0)
+        {
+            ok = options.tty_count < HOST_MAX_TTYS;
+            if (ok)
+            {
+                options.ttys[options.tty_count++] = value;
+            }
+        }
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            ok = sscanf(value, "%d", &options.threads) == 1 && options.threads > 0 && options.threads <= HOST_MAX_THREADS;
+        }
+        else if (strcmp(arg, "--board") == 0)
+        {
+            ok = sscanf(value, "%dx%d", &options.board_width, &options.board_height) == 2 &&
+                 options.board_width >= 3 && options.board_height >= 3;
+        }
+        else if (strcmp(arg, "--rules") == 0)
+        {
+            char error[RULES_MAX_LINE * 2];
+            if (!load_ruleset(value, &options.rules, error, sizeof(error)))
+            {
+                fprintf(stderr, "%s\n", error);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--ai") == 0)
+        {
+            // MCTS策略使用进程级的搜索状态，不能在多个会话之间共用
+            options.ai = ai_policy_from_name(value);
+            ok = options.ai != NULL && options.ai != ai_mcts;
+        }
+        else if (strcmp(arg, "--weights") == 0)
+        {
+            options.weights = value;
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            unsigned long long seed;
+            ok = sscanf(value, "%llu", &seed) == 1;
+            options.seed = (uint64_t)seed;
+        }
+        else if (strcmp(arg, "--stats") == 0)
+        {
+            ok = sscanf(value, "%d", &options.stats_seconds) == 1 && options.stats_seconds >= 0;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (ok && options.listen_path == NULL && options.tty_count == 0)
+    {
+        options.listen_path = HOST_DEFAULT_SOCKET;
+    }
+
+    // 网络在启动工作线程之前加载，之后各线程只读共享
+    if (ok && options.ai == ai_nn)
+    {
+        NnStatus status;
+        if (!ai_nn_configure(options.weights, &status))
+        {
+            fprintf(stderr, "无法加载权重文件%s: %s\n", options.weights != NULL ? options.weights : "（内置）",
+                    nn_status_message(status));
+            return false;
+        }
+    }
+    if (!ok)
+    {
+        fprintf(stderr,
+                "用法: snake_host [--listen PATH] [--tty DEVICE]... [--threads N] [--board WxH] [--rules FILE] "
+                "[--ai random|greedy|nn] [--weights FILE] [--seed S] [--stats SECONDS]\n");
+    }
+    return ok;
+}
+
+/**
+ * @brief 创建监听套接字（已存在的同名套接字文件先删除）
+ */
+static int open_listen_socket(const char *path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "套接字路径过长: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(path);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, "无法监听%s: %s\n", path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// =============================================
+// 主函数
+// =============================================
+
+int main(int argc, char **argv)
+{
+    if (!parse_options(argc, argv))
+    {
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN); // 对端关闭后的写入返回EPIPE，由读事件关闭会话
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+
+    if (options.listen_path != NULL && (listen_fd = open_listen_socket(options.listen_path)) < 0)
+    {
+        return 1;
+    }
+
+    workers = (Worker *)calloc((size_t)options.threads, sizeof(Worker));
+    if (workers == NULL)
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+    for (int i = 0; i < options.threads; i++)
+    {
+        if (!worker_init(&workers[i], i))
+        {
+            fprintf(stderr, "无法初始化工作线程%d\n", i);
+            return 1;
+        }
+    }
+
+    // 终端设备会话在启动线程之前轮流分配给各工作线程
+    for (int i = 0; i < options.tty_count; i++)
+    {
+        open_tty_session(&workers[i % options.threads], options.ttys[i]);
+    }
+
+    if (options.listen_path != NULL)
+    {
+        fprintf(stderr, "监听 %s（%d 个工作线程）\n", options.listen_path, options.threads);
+    }
+    // 某个工作线程启动失败时，已启动的线程关闭各自的会话后退出，未启动的线程的会话（包括已分配的终端设备）在下面关闭
+    int started = 0;
+    for (; started < options.threads; started++)
+    {
+        int error = pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]);
+        if (error != 0)
+        {
+            fprintf(stderr, "无法启动工作线程%d: %s\n", started, strerror(error));
+            stopping = 1;
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < options.threads; i++)
+    {
+        worker_destroy(&workers[i]);
+    }
+    free(workers);
+    ai_nn_release();
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+        unlink(options.listen_path);
+    }
+    return started == options.threads ? 0 : 1;
+}
@@ -0,0 +1,606 @@
+/**
+ * @file snake_mcts.c
+ * @brief 蒙特卡洛树搜索（MCTS）自动控制策略实现
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_mcts.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define MCTS_MAX_TREE_DEPTH 64     ///< 选择阶段沿树下降的最大深度
+#define MCTS_TIME_CHECK_INTERVAL 8 ///< 模拟阶段每走多少步检查一次时间
+#define MCTS_EXPLORATION 1.0       ///< UCB探索常数
+#define MCTS_DISCOUNT 0.97         ///< 每步的折扣：越早吃到食物越好
+#define MCTS_DEATH_PENALTY 2.0     ///< 撞死的惩罚（以食物个数计）
+#define MCTS_GREEDY_PERCENT 75     ///< 模拟策略走向食物（而不是随机）的百分比
+
+static const Direction opposite[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT}; ///< 各方向的反方向
+
+// =============================================
+// 类型定义
+// =============================================
+
+/**
+ * @struct MctsNode
+ * @brief 树节点（开环：只由从根出发的动作序列确定，不保存游戏池）
+ */
+typedef struct
+{
+    int32_t child[4]; ///< 各方向的子节点下标（-1表示未扩展）
+    uint32_t visits;  ///< 访问次数
+    float value;      ///< 累计回报
+} MctsNode;
+
+/**
+ * @struct MctsTree
+ * @brief 一棵搜索树（根并行时每个分片一棵）
+ *
+ * 补齐到缓存行的整数倍，不同线程更新各自的树时不共享缓存行。
+ */
+typedef union
+{
+    struct
+    {
+        MctsNode *nodes;    ///< 节点数组（MCTS_MAX_NODES个）
+        int node_count;     ///< 已使用的节点数
+        uint64_t rng;       ///< 本棵树的随机数状态（推演种子和模拟策略）
+        long long rollouts; ///< 本次决策的推演次数
+    };
+    unsigned char cache_lines[CACHE_LINE_SIZE];
+} MctsTree;
+
+/**
+ * @struct MctsWorker
+ * @brief 线程私有的推演上下文
+ */
+typedef union
+{
+    GameContext sim; ///< 推演用的游戏上下文，每次推演从根局面复制
+    unsigned char cache_lines[(sizeof(GameContext) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE];
+} MctsWorker;
+
+/**
+ * @struct MctsSearch
+ * @brief 搜索器：线程池、每个线程的推演上下文和每个分片的树
+ */
+struct MctsSearch
+{
+    MctsConfig config;                        ///< 搜索参数
+    int pool_width;                           ///< 游戏池宽度（包括边框，环面布局没有边框）
+    int pool_height;                          ///< 游戏池高度（包括边框，环面布局没有边框）
+    bool torus;                               ///< 环面布局
+    ThreadPool *pool;                         ///< 线程池
+    int tree_count;                           ///< 树的数量（等于线程数）
+    MctsTree trees[PARALLEL_MAX_THREADS];     ///< 各分片的树
+    MctsWorker workers[PARALLEL_MAX_THREADS]; ///< 各线程的推演上下文
+    const GameContext *root;                  ///< 本次决策的根局面
+    double deadline;                          ///< 本次决策的截止时间（秒，0表示不限时间）
+    long long rollouts_per_tree;              ///< 本次决策每棵树的推演次数（0表示按时间）
+    int rollout_depth;                        ///< 模拟阶段的最大步数
+    MctsStats stats;                          ///< 累计统计
+};
+
+// =============================================
+// 全局变量
+// =============================================
+
+static MctsConfig shared_config;         ///< ai_mcts使用的搜索参数
+static bool shared_config_set = false;   ///< 是否调用过ai_mcts_configure
+static MctsSearch *shared_search = NULL; ///< ai_mcts共享的搜索器（按需创建）
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 获取当前时间（秒）
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief splitmix64：由一个种子派生互不相关的随机数（树和推演的种子）
+ */
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief 推进一步并累计回报
+ *
+ * 吃到食物得1（乘以当前折扣），撞死扣MCTS_DEATH_PENALTY。
+ *
+ * @param sim 推演上下文
+ * @param dir 方向
+ * @param reward 累计回报
+ * @param discount 当前折扣，推进后乘以MCTS_DISCOUNT
+ */
+static void simulate_step(GameContext *sim, Direction dir, double *reward, double *discount)
+{
+    int score_before = sim->game.score;
+    turn_snake(sim, dir);
+    update_game(sim);
+    if (sim->game.score > score_before)
+    {
+        *reward += *discount;
+    }
+    if (sim->game.game_over)
+    {
+        *reward -= MCTS_DEATH_PENALTY * *discount;
+    }
+    *discount *= MCTS_DISCOUNT;
+}
+
+/**
+ * @brief 模拟策略：大多数时候在安全方向中走离食物最近的方向，其余随机选择安全方向
+ */
+static Direction rollout_policy(GameContext *sim, uint64_t *rng)
+{
+    const GameState *game = &sim->game;
+    Direction current = game->snake.direction;
+    Direction safe[3];
+    int safe_count = 0;
+
+    for (int d = 0; d < 4; d++)
+    {
+        if (d == (int)opposite[current])
+        {
+            continue;
+        }
+        Position next = neighbor_position(sim, game->snake.head, (Direction)d);
+        if (CELL_IS_OPEN(get_cell_type(sim, next)))
+        {
+            safe[safe_count++] = (Direction)d;
+        }
+    }
+    if (safe_count == 0)
+    {
+        return current; // 无路可走
+    }
+
+    uint64_t r = splitmix64(rng);
+    if ((int)(r % 100) >= MCTS_GREEDY_PERCENT)
+    {
+        return safe[(r >> 32) % (uint64_t)safe_count];
+    }
+
+    Position target = game->food;
+    food_nearest(sim, game->snake.head, &target);
+    Direction best = safe[0];
+    int best_distance = -1;
+    for (int i = 0; i < safe_count; i++)
+    {
+        int distance = cell_distance(sim, target, neighbor_position(sim, game->snake.head, safe[i]));
+        if (best_distance < 0 || distance < best_distance)
+        {
+            best = safe[i];
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 新建节点（节点用完时返回-1）
+ */
+static int32_t new_node(MctsTree *tree)
+{
+    if (tree->node_count >= MCTS_MAX_NODES)
+    {
+        return -1;
+    }
+    MctsNode *node = &tree->nodes[tree->node_count];
+    node->child[0] = node->child[1] = node->child[2] = node->child[3] = -1;
+    node->visits = 0;
+    node->value = 0.0f;
+    return tree->node_count++;
+}
+
+/**
+ * @brief UCB1选择已扩展的子节点
+ *
+ * @return int 方向，没有已扩展的子节点时返回-1
+ */
+static int select_child(const MctsTree *tree, const MctsNode *node, Direction current)
+{
+    double log_visits = log((double)node->visits + 1.0);
+    double best_score = -HUGE_VAL;
+    int best = -1;
+
+    for (int d = 0; d < 4; d++)
+    {
+        int32_t c = node->child[d];
+        if (d == (int)opposite[current] || c < 0)
+        {
+            continue;
+        }
+        const MctsNode *child = &tree->nodes[c];
+        double score = child->value / child->visits + MCTS_EXPLORATION * sqrt(log_visits / child->visits);
+        if (score > best_score)
+        {
+            best_score = score;
+            best = d;
+        }
+    }
+    return best;
+}
+
+// =============================================
+// 搜索
+// =============================================
+
+/**
+ * @brief 在一棵树上做一次推演：选择、扩展、模拟、回传
+ */
+static void run_rollout(MctsSearch *search, MctsTree *tree, GameContext *sim)
+{
+    int32_t path[MCTS_MAX_TREE_DEPTH + 2];
+    int depth = 0;
+    double reward = 0.0;
+    double discount = 1.0;
+
+    // 从根局面开始，推演中的食物位置由每次推演自己的种子决定
+    copy_game_state(sim, search->root);
+    seed_game_random(sim, splitmix64(&tree->rng));
+
+    int32_t node = 0;
+    path[depth++] = node;
+    while (!sim->game.game_over && depth <= MCTS_MAX_TREE_DEPTH)
+    {
+        Direction current = sim->game.snake.direction;
+        MctsNode *n = &tree->nodes[node];
+
+        // 还有未扩展的方向时扩展一个（从随机位置开始找，避免总是先试同一个方向）
+        int expand = -1;
+        int start = (int)(splitmix64(&tree->rng) % 4);
+        for (int i = 0; i < 4 && expand < 0; i++)
+        {
+            int d = (start + i) % 4;
+            if (d != (int)opposite[current] && n->child[d] < 0)
+            {
+                expand = d;
+            }
+        }
+        if (expand >= 0)
+        {
+            int32_t child = new_node(tree);
+            if (child >= 0)
+            {
+                tree->nodes[node].child[expand] = child;
+                simulate_step(sim, (Direction)expand, &reward, &discount);
+                path[depth++] = child;
+            }
+            break;
+        }
+
+        int d = select_child(tree, n, current);
+        if (d < 0)
+        {
+            break;
+        }
+        simulate_step(sim, (Direction)d, &reward, &discount);
+        node = n->child[d];
+        path[depth++] = node;
+    }
+
+    // 模拟：按时间预算时每MCTS_TIME_CHECK_INTERVAL步检查一次截止时间，过了就停下，
+    // 模拟深度因此不超过剩余时间能走的步数（大游戏池上一次推演就可能用完预算），已走的部分照常回传
+    for (int step = 0; step < search->rollout_depth && !sim->game.game_over; step++)
+    {
+        if (step % MCTS_TIME_CHECK_INTERVAL == 0 && search->deadline > 0.0 && now_seconds() >= search->deadline)
+        {
+            break;
+        }
+        simulate_step(sim, rollout_policy(sim, &tree->rng), &reward, &discount);
+    }
+
+    // 回传
+    for (int i = 0; i < depth; i++)
+    {
+        tree->nodes[path[i]].visits++;
+        tree->nodes[path[i]].value += (float)reward;
+    }
+    tree->rollouts++;
+}
+
+/**
+ * @brief 并行任务：在分片[begin, end)的树上推演，直到用完推演次数或时间
+ */
+static void run_trees(void *arg, int begin, int end, int worker)
+{
+    MctsSearch *search = (MctsSearch *)arg;
+    GameContext *sim = &search->workers[worker].sim;
+
+    for (int t = begin; t < end; t++)
+    {
+        MctsTree *tree = &search->trees[t];
+        for (;;)
+        {
+            if (search->rollouts_per_tree > 0)
+            {
+                if (tree->rollouts >= search->rollouts_per_tree)
+                {
+                    break;
+                }
+            }
+            else if (now_seconds() >= search->deadline)
+            {
+                break; // 每次推演之前都检查：一次推演复制整个游戏池，大游戏池上不能先推演几次再看时间
+            }
+            run_rollout(search, tree, sim);
+        }
+    }
+}
+
+// =============================================
+// 搜索器
+// =============================================
+
+/**
+ * @brief 默认搜索参数：自旋线程池、全部CPU核心、按时间预算
+ */
+void mcts_default_config(MctsConfig *config)
+{
+    config->mode = PARALLEL_SPIN_POOL;
+    config->threads = 0;
+    config->rollouts = 0;
+    config->budget_percent = MCTS_DEFAULT_BUDGET_PERCENT;
+    config->rollout_depth = 0;
+}
+
+/**
+ * @brief 创建搜索器
+ *
+ * 所有内存（树节点、推演上下文、线程池）在这里一次性申请，决策时不再申请内存。
+ *
+ * 推演上下文的游戏池尺寸、布局和规则与ctx相同（规则在每次推演复制局面时重新复制）。
+ *
+ * @param ctx 游戏上下文
+ * @param config 搜索参数，NULL表示默认参数
+ * @return MctsSearch* 搜索器，内存不足时返回NULL
+ */
+MctsSearch *mcts_create(const GameContext *ctx, const MctsConfig *config)
+{
+    MctsSearch *search = (MctsSearch *)heap_alloc(sizeof(MctsSearch));
+    if (search == NULL)
+    {
+        return NULL;
+    }
+    memset(search, 0, sizeof(*search));
+    if (config != NULL)
+    {
+        search->config = *config;
+    }
+    else
+    {
+        mcts_default_config(&search->config);
+    }
+    search->pool_width = ctx->pool_width;
+    search->pool_height = ctx->pool_height;
+    search->torus = ctx->torus;
+    int border = ctx->torus ? 0 : 2;
+
+    search->pool = thread_pool_create(search->config.mode, search->config.threads);
+    search->tree_count = thread_pool_size(search->pool);
+
+    bool ok = true;
+    for (int i = 0; i < search->tree_count && ok; i++)
+    {
+        search->trees[i].nodes = (MctsNode *)heap_alloc(MCTS_MAX_NODES * sizeof(MctsNode));
+        ok = search->trees[i].nodes != NULL &&
+             init_game_context(&search->workers[i].sim, ctx->pool_width - border, ctx->pool_height - border) &&
+             apply_ruleset(&search->workers[i].sim, &ctx->rules);
+        if (ok)
+        {
+            init_game_state(&search->workers[i].sim, 0); // 分配游戏池，之后每次推演直接覆盖
+        }
+    }
+    if (!ok)
+    {
+        mcts_destroy(search);
+        return NULL;
+    }
+    return search;
+}
+
+/**
+ * @brief 销毁搜索器
+ */
+void mcts_destroy(MctsSearch *search)
+{
+    if (search == NULL)
+    {
+        return;
+    }
+    thread_pool_destroy(search->pool);
+    for (int i = 0; i < search->tree_count; i++)
+    {
+        free(search->trees[i].nodes);
+        destroy_game_context(&search->workers[i].sim);
+    }
+    free(search);
+}
+
+/**
+ * @brief 选择下一步方向
+ *
+ * 每棵树从同一个根局面独立搜索，最后合并根节点各子节点的访问次数，选择访问次数最多的方向
+ * （相同时选择平均回报较高的）。推演种子取自game_random(ctx)，真实游戏的随机数状态因此前进一步。
+ * 按时间预算时，每次推演之前和模拟阶段每MCTS_TIME_CHECK_INTERVAL步检查截止时间，决策在game.speed × budget_percent%毫秒左右返回
+ * （最多超出一次复制局面和几步推演）；截止时间之前没能开始推演的树不参与合并，所有树都没有推演时保持当前方向。
+ *
+ * @param search 搜索器（游戏池尺寸和布局必须与ctx一致）
+ * @param ctx 游戏上下文
+ * @return Direction 下一步方向
+ */
+Direction mcts_decide(MctsSearch *search, GameContext *ctx)
+{
+    const GameState *game = &ctx->game;
+    Direction current = game->snake.direction;
+    assert(search->pool_width == ctx->pool_width && search->pool_height == ctx->pool_height &&
+           search->torus == ctx->torus);
+    if (game->game_over)
+    {
+        return current;
+    }
+
+    double start = now_seconds();
+    const MctsConfig *config = &search->config;
+    if (!ctx->food.ready)
+    {
+        food_index_rebuild(ctx); // 推演副本随局面一起复制食物索引，不必各自扫描游戏池
+    }
+    search->root = ctx;
+    search->rollout_depth = config->rollout_depth > 0 ? config->rollout_depth : ctx->pool_width + ctx->pool_height;
+    if (config->rollouts > 0)
+    {
+        search->rollouts_per_tree = (config->rollouts + search->tree_count - 1) / search->tree_count;
+        search->deadline = 0.0;
+    }
+    else
+    {
+        search->rollouts_per_tree = 0;
+        search->deadline = start + game->speed * config->budget_percent / 100.0 / 1000.0;
+    }
+
+    uint64_t seed = (uint64_t)game_random(ctx) << 32 | game_random(ctx);
+    for (int i = 0; i < search->tree_count; i++)
+    {
+        MctsTree *tree = &search->trees[i];
+        tree->node_count = 0;
+        new_node(tree);
+        tree->rng = seed + (uint64_t)i * 0xD1B54A32D192ED03ULL;
+        tree->rollouts = 0;
+    }
+
+    thread_pool_run(search->pool, search->tree_count, 1, run_trees, search);
+
+    // 合并各棵树根节点的子节点
+    double visits[4] = {0}, value[4] = {0};
+    long long rollouts = 0;
+    for (int i = 0; i < search->tree_count; i++)
+    {
+        const MctsTree *tree = &search->trees[i];
+        rollouts += tree->rollouts;
+        for (int d = 0; d < 4; d++)
+        {
+            int32_t c = tree->nodes[0].child[d];
+            if (c >= 0)
+            {
+                visits[d] += tree->nodes[c].visits;
+                value[d] += tree->nodes[c].value;
+            }
+        }
+    }
+
+    Direction best = current;
+    double best_visits = 0.0, best_mean = -HUGE_VAL;
+    for (int d = 0; d < 4; d++)
+    {
+        if (d == (int)opposite[current] || visits[d] <= 0.0)
+        {
+            continue;
+        }
+        double mean = value[d] / visits[d];
+        if (visits[d] > best_visits || (visits[d] == best_visits && mean > best_mean))
+        {
+            best = (Direction)d;
+            best_visits = visits[d];
+            best_mean = mean;
+        }
+    }
+
+    double seconds = now_seconds() - start;
+    search->stats.decisions++;
+    search->stats.rollouts += rollouts;
+    search->stats.seconds += seconds;
+    search->stats.max_seconds = seconds > search->stats.max_seconds ? seconds : search->stats.max_seconds;
+    return best;
+}
+
+/**
+ * @brief 获取累计统计（推演次数/用时即为推演速度，可用于跟踪引擎单步性能）
+ */
+MctsStats mcts_stats(const MctsSearch *search)
+{
+    return search->stats;
+}
+
+// =============================================
+// 策略接口
+// =============================================
+
+/**
+ * @brief 设置ai_mcts的搜索参数（释放已有的共享搜索器，下次决策时按新参数创建）
+ */
+void ai_mcts_configure(const MctsConfig *config)
+{
+    ai_mcts_release();
+    shared_config = *config;
+    shared_config_set = true;
+}
+
+/**
+ * @brief MCTS策略（AiPolicy）
+ *
+ * 第一次调用或游戏池尺寸、布局变化时创建共享的搜索器；内存不足时保持当前方向。
+ */
+Direction ai_mcts(GameContext *ctx)
+{
+    if (shared_search != NULL &&
+        (shared_search->pool_width != ctx->pool_width || shared_search->pool_height != ctx->pool_height ||
+         shared_search->torus != ctx->torus))
+    {
+        ai_mcts_release();
+    }
+    if (shared_search == NULL)
+    {
+        if (!shared_config_set)
+        {
+            mcts_default_config(&shared_config);
+            shared_config_set = true;
+        }
+        shared_search = mcts_create(ctx, &shared_config);
+        if (shared_search == NULL)
+        {
+            return ctx->game.snake.direction;
+        }
+    }
+    return mcts_decide(shared_search, ctx);
+}
+
+/**
+ * @brief 获取共享搜索器的累计统计（尚未创建时全为0）
+ */
+MctsStats ai_mcts_stats(void)
+{
+    MctsStats none = {0, 0, 0.0, 0.0};
+    return shared_search != NULL ? mcts_stats(shared_search) : none;
+}
+
+/**
+ * @brief 释放共享的搜索器
+ */
+void ai_mcts_release(void)
+{
+    mcts_destroy(shared_search);
+    shared_search = NULL;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file snake_mcts.h
+ * @brief 蒙特卡洛树搜索（MCTS）自动控制策略
+ *
+ * 每次决策把当前游戏复制到线程私有的推演上下文中，用无界面的update_game推演成千上万次，
+ * 选择访问次数最多的下一步方向：
+ * - 开环UCT：树节点只记录动作序列，不保存游戏池，每次推演从根局面复制后重新走一遍
+ * - 根并行：每个线程独立建一棵树，最后按根节点的子节点合并访问次数
+ * - 每次推演使用独立的随机数种子：推演中的食物位置不是真实游戏将来的食物位置
+ * - 模拟策略：在不会立即撞死的方向中，大多数时候走离食物最近的方向，其余随机
+ *
+ * 决策时间受每帧时间（game.speed毫秒）约束，也可以改为固定推演次数（结果可复现）。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_MCTS_H
+#define SNAKE_MCTS_H
+
+#include "snake_core.h"
+#include "snake_parallel.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define MCTS_DEFAULT_BUDGET_PERCENT 60 ///< 默认决策时间占每帧时间的百分比（其余留给绘制和输入）
+#define MCTS_MAX_NODES 32768           ///< 每棵树的最大节点数，用完后只推演不扩展
+
+/**
+ * @struct MctsConfig
+ * @brief 搜索参数
+ */
+typedef struct
+{
+    ParallelMode mode;  ///< 并行方式
+    int threads;        ///< 线程数（树的数量），0表示CPU核心数
+    int rollouts;       ///< 每次决策的推演次数，0表示按时间预算
+    int budget_percent; ///< 按时间预算时，决策时间占game.speed的百分比
+    int rollout_depth;  ///< 模拟阶段的最大步数，0表示游戏区域宽 + 高
+} MctsConfig;
+
+/**
+ * @struct MctsStats
+ * @brief 搜索统计（自创建以来累计）
+ */
+typedef struct
+{
+    long long decisions; ///< 决策次数
+    long long rollouts;  ///< 推演次数
+    double seconds;      ///< 搜索用时（秒）
+    double max_seconds;  ///< 单次决策的最长用时（秒，按时间预算时应不超过预算太多）
+} MctsStats;
+
+typedef struct MctsSearch MctsSearch; ///< 搜索器（不透明）
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+void mcts_default_config(MctsConfig *config);
+MctsSearch *mcts_create(const GameContext *ctx, const MctsConfig *config);
+void mcts_destroy(MctsSearch *search);
+Direction mcts_decide(MctsSearch *search, GameContext *ctx);
+MctsStats mcts_stats(const MctsSearch *search);
+
+// 作为AiPolicy使用（按首次调用时的游戏池尺寸创建共享的搜索器）
+void ai_mcts_configure(const MctsConfig *config);
+Direction ai_mcts(GameContext *ctx);
+MctsStats ai_mcts_stats(void);
+void ai_mcts_release(void);
+
+#endif // SNAKE_MCTS_H
@@ -0,0 +1,90 @@
+/**
+ * @file snake_mcts_test.c
+ * @brief MCTS决策时间测试（注册为ctest测试mcts_budget）
+ *
+ * 在大游戏池上按默认参数（按时间预算）连续决策若干次，每次决策的用时不得明显超过
+ * game.speed × budget_percent%：一次推演要复制整个游戏池、模拟深度随游戏池边长增长，
+ * 截止时间检查不及时就会超出预算几十倍。
+ *
+ * 用法: snake_mcts_test [--board WxH] [--decisions N]
+ *
+ * 编码: UTF-8
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_mcts.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define TEST_DEFAULT_SIZE 2048    ///< 默认游戏区域边长
+#define TEST_DEFAULT_DECISIONS 5  ///< 默认决策次数
+#define TEST_TOLERANCE_PERCENT 25 ///< 允许超出预算的百分比（截止之后还要复制一次局面、走几步模拟）
+#define TEST_TOLERANCE_MS 10.0    ///< 另外允许超出的毫秒数（计时器精度和线程调度）
+
+// =============================================
+// 主函数
+// =============================================
+
+int main(int argc, char **argv)
+{
+    int width = TEST_DEFAULT_SIZE, height = TEST_DEFAULT_SIZE;
+    int decisions = TEST_DEFAULT_DECISIONS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--board") == 0 && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (strcmp(argv[i], "--decisions") == 0 && i + 1 < argc)
+            decisions = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "用法: snake_mcts_test [--board WxH] [--decisions N]\n");
+            return 2;
+        }
+    }
+
+    GameContext ctx;
+    if (!init_game_context(&ctx, width, height))
+    {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+    init_game_state(&ctx, 1);
+    MctsConfig config;
+    mcts_default_config(&config);
+    MctsSearch *search = mcts_create(&ctx, &config);
+    if (search == NULL)
+    {
+        fprintf(stderr, "内存不足\n");
+        destroy_game_context(&ctx);
+        return 1;
+    }
+
+    // 蛇在开局附近活动，速度不变，每次决策的预算相同
+    double budget_ms = ctx.game.speed * config.budget_percent / 100.0;
+    for (int i = 0; i < decisions && !ctx.game.game_over; i++)
+    {
+        turn_snake(&ctx, mcts_decide(search, &ctx));
+        update_game(&ctx);
+    }
+
+    MctsStats stats = mcts_stats(search);
+    double limit_ms = budget_ms * (100 + TEST_TOLERANCE_PERCENT) / 100.0 + TEST_TOLERANCE_MS;
+    printf("游戏区域: %dx%d，预算 %.1f ms，上限 %.1f ms\n", width, height, budget_ms, limit_ms);
+    printf("决策:     %lld 次，推演 %lld 次，平均 %.1f ms，最长 %.1f ms\n", stats.decisions, stats.rollouts,
+           stats.decisions > 0 ? stats.seconds * 1000.0 / (double)stats.decisions : 0.0, stats.max_seconds * 1000.0);
+
+    bool ok = stats.decisions > 0 && stats.rollouts > 0 && stats.max_seconds * 1000.0 <= limit_ms;
+    if (!ok)
+    {
+        fprintf(stderr, "决策超出时间预算或没有推演\n");
+    }
+    mcts_destroy(search);
+    destroy_game_context(&ctx);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,790 @@
+/**
+ * @file snake_nn.c
+ * @brief 神经网络自动控制策略实现
+ *
+ * 推理的全部运算都是整数：特征编码（查表写0/1）、两次矩阵乘（int8权重 × uint8激活，int32累加）
+ * 和一次重新量化。窗口半径4、隐藏单元32时每次决策约一万次乘加，AVX2内核每个周期做32次，
+ * 单线程每秒可以做出上百万次决策。
+ *
+ * AVX2内核使用_mm256_maddubs_epi16（uint8 × int8，相邻两个乘积相加为int16）和_mm256_madd_epi16（int16对相加为int32）。
+ * 激活不超过127、权重在-128～127之间时两个乘积之和不超过±32512，不会饱和，因此与标量内核的结果逐位相同。
+ * GCC/Clang用target属性只为AVX2内核开启指令集，MSVC直接使用内建函数；运行时检测CPU支持后才会选用。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_nn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NN_HAVE_AVX2 1
+#define NN_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define NN_HAVE_AVX2 1
+#define NN_TARGET_AVX2
+#else
+#define NN_HAVE_AVX2 0
+#endif
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define NN_MAGIC_LENGTH 8                                                             ///< 魔数长度
+#define NN_ALIGN_UP(n) (((n) + NN_INPUT_ALIGN - 1) & ~(NN_INPUT_ALIGN - 1))           ///< 向上补齐到NN_INPUT_ALIGN的整数倍
+#define NN_MAX_WINDOW (2 * NN_MAX_RADIUS + 1)                                         ///< 最大窗口边长
+#define NN_MAX_INPUTS NN_ALIGN_UP(2 * NN_MAX_WINDOW * NN_MAX_WINDOW + 2 * NN_OUTPUTS) ///< 最大输入数（补齐后）
+#define NN_KERNEL_ROWS 4                                                              ///< AVX2内核每次同时计算的输入数（共用一次权重加载）
+
+static const Direction opposite[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT}; ///< 各方向的反方向
+static const int dir_dx[NN_OUTPUTS] = {0, 0, -1, 1};                         ///< 各方向的x增量
+static const int dir_dy[NN_OUTPUTS] = {-1, 1, 0, 0};                         ///< 各方向的y增量
+
+/**
+ * @brief 矩阵乘内核：out[b × rows + r] = Σk weights[r × cols + k] × x[b × cols + k]
+ *
+ * cols是NN_INPUT_ALIGN的整数倍，x的取值为0～127。
+ */
+typedef void (*MatmulKernel)(const int8_t *weights, int rows, int cols, const uint8_t *x, int count, int32_t *out);
+
+/**
+ * @struct NnNet
+ * @brief 网络参数（所有数组在一次分配中，按NN_INPUT_ALIGN对齐）
+ */
+struct NnNet
+{
+    int radius;             ///< 窗口半径
+    int window;             ///< 窗口边长（2r+1）
+    int cells;              ///< 窗口单元格数
+    int inputs;             ///< 输入数（补齐到NN_INPUT_ALIGN）
+    int hidden;             ///< 隐藏单元数
+    int32_t multiplier;     ///< 隐藏层重新量化的乘数
+    int shift;              ///< 隐藏层重新量化的右移位数
+    int32_t *hidden_bias;   ///< 隐藏层偏置（hidden个）
+    int8_t *hidden_weights; ///< 隐藏层权重（hidden × inputs）
+    int32_t *output_bias;   ///< 输出层偏置（NN_OUTPUTS个）
+    int8_t *output_weights; ///< 输出层权重（NN_OUTPUTS × hidden）
+    NnKernel kernel;        ///< 使用的内积内核
+    MatmulKernel matmul;    ///< 内核函数
+    void *allocation;       ///< 参数数组的原始分配地址
+};
+
+static NnNet *shared_net = NULL; ///< ai_nn共享的网络（按需创建）
+
+// =============================================
+// 内核
+// =============================================
+
+/**
+ * @brief 标量矩阵乘内核
+ */
+static void matmul_scalar(const int8_t *weights, int rows, int cols, const uint8_t *x, int count, int32_t *out)
+{
+    for (int b = 0; b < count; b++)
+    {
+        const uint8_t *input = x + (size_t)b * (size_t)cols;
+        for (int r = 0; r < rows; r++)
+        {
+            const int8_t *row = weights + (size_t)r * (size_t)cols;
+            int32_t sum = 0;
+            for (int k = 0; k < cols; k++)
+            {
+                sum += (int32_t)input[k] * (int32_t)row[k];
+            }
+            out[(size_t)b * (size_t)rows + (size_t)r] = sum;
+        }
+    }
+}
+
+#if NN_HAVE_AVX2
+/**
+ * @brief AVX2矩阵乘内核：每行权重加载一次，与NN_KERNEL_ROWS个输入分别做32字节宽的内积
+ */
+NN_TARGET_AVX2 static void matmul_avx2(const int8_t *weights, int rows, int cols, const uint8_t *x, int count,
+                                       int32_t *out)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int b = 0; b < count; b += NN_KERNEL_ROWS)
+    {
+        int n = count - b < NN_KERNEL_ROWS ? count - b : NN_KERNEL_ROWS;
+        // 不足NN_KERNEL_ROWS个输入时多余的通道重复计算第一个输入，结果丢弃
+        const uint8_t *x0 = x + (size_t)b * (size_t)cols;
+        const uint8_t *x1 = n > 1 ? x0 + cols : x0;
+        const uint8_t *x2 = n > 2 ? x0 + 2 * (size_t)cols : x0;
+        const uint8_t *x3 = n > 3 ? x0 + 3 * (size_t)cols : x0;
+
+        for (int r = 0; r < rows; r++)
+        {
+            const int8_t *row = weights + (size_t)r * (size_t)cols;
+            __m256i a0 = _mm256_setzero_si256();
+            __m256i a1 = _mm256_setzero_si256();
+            __m256i a2 = _mm256_setzero_si256();
+            __m256i a3 = _mm256_setzero_si256();
+            for (int k = 0; k < cols; k += NN_INPUT_ALIGN)
+            {
+                __m256i w = _mm256_loadu_si256((const __m256i *)(row + k));
+                a0 = _mm256_add_epi32(a0, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x0 + k)), w), ones));
+                a1 = _mm256_add_epi32(a1, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x1 + k)), w), ones));
+                a2 = _mm256_add_epi32(a2, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x2 + k)), w), ones));
+                a3 = _mm256_add_epi32(a3, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x3 + k)), w), ones));
+            }
+
+            // 两次水平加法后每个128位半边依次是a0～a3各自4个元素的和，两个半边相加即为完整的内积
+            __m256i sums = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+            __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+            int32_t lanes[NN_KERNEL_ROWS];
+            _mm_storeu_si128((__m128i *)lanes, total);
+            for (int t = 0; t < n; t++)
+            {
+                out[(size_t)(b + t) * (size_t)rows + (size_t)r] = lanes[t];
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 检测CPU是否支持AVX2（包括操作系统保存YMM寄存器）
+ */
+static bool cpu_has_avx2(void)
+{
+#if NN_HAVE_AVX2 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif NN_HAVE_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 内核是否可用
+ */
+bool nn_kernel_supported(NnKernel kernel)
+{
+    return kernel == NN_KERNEL_SCALAR || (kernel == NN_KERNEL_AVX2 && cpu_has_avx2());
+}
+
+/**
+ * @brief 指定网络使用的内核（创建时已自动选择CPU支持的最快内核）
+ *
+ * @return false 当前CPU或编译器不支持该内核（不改变）
+ */
+bool nn_set_kernel(NnNet *net, NnKernel kernel)
+{
+    if (!nn_kernel_supported(kernel))
+    {
+        return false;
+    }
+    net->kernel = kernel;
+#if NN_HAVE_AVX2
+    net->matmul = kernel == NN_KERNEL_AVX2 ? matmul_avx2 : matmul_scalar;
+#else
+    net->matmul = matmul_scalar;
+#endif
+    return true;
+}
+
+/**
+ * @brief 获取网络使用的内核
+ */
+NnKernel nn_get_kernel(const NnNet *net)
+{
+    return net->kernel;
+}
+
+/**
+ * @brief 内核名称
+ */
+const char *nn_kernel_name(NnKernel kernel)
+{
+    return kernel == NN_KERNEL_AVX2 ? "avx2" : "scalar";
+}
+
+// =============================================
+// 创建和释放
+// =============================================
+
+/**
+ * @brief 按尺寸分配网络（参数全为0，重新量化为恒等）
+ */
+static NnNet *allocate_net(int radius, int hidden)
+{
+    if (radius < 1 || radius > NN_MAX_RADIUS || hidden < NN_INPUT_ALIGN || hidden > NN_MAX_HIDDEN ||
+        hidden % NN_INPUT_ALIGN != 0)
+    {
+        return NULL;
+    }
+    NnNet *net = (NnNet *)heap_alloc(sizeof(NnNet));
+    if (net == NULL)
+    {
+        return NULL;
+    }
+    net->radius = radius;
+    net->window = 2 * radius + 1;
+    net->cells = net->window * net->window;
+    net->inputs = NN_ALIGN_UP(2 * net->cells + 2 * NN_OUTPUTS);
+    net->hidden = hidden;
+    net->multiplier = 1;
+    net->shift = 0;
+
+    size_t hidden_weights = (size_t)hidden * (size_t)net->inputs;
+    size_t output_weights = (size_t)NN_OUTPUTS * (size_t)hidden;
+    size_t bytes = (size_t)hidden * sizeof(int32_t) + NN_OUTPUTS * sizeof(int32_t) + hidden_weights + output_weights;
+    net->allocation = heap_alloc(bytes + NN_INPUT_ALIGN);
+    if (net->allocation == NULL)
+    {
+        free(net);
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)net->allocation + NN_INPUT_ALIGN - 1) & ~(uintptr_t)(NN_INPUT_ALIGN - 1);
+    memset((void *)aligned, 0, bytes);
+    net->hidden_weights = (int8_t *)aligned;
+    net->output_weights = net->hidden_weights + hidden_weights;
+    net->hidden_bias = (int32_t *)(void *)(net->output_weights + output_weights);
+    net->output_bias = net->hidden_bias + hidden;
+
+    nn_set_kernel(net, nn_kernel_supported(NN_KERNEL_AVX2) ? NN_KERNEL_AVX2 : NN_KERNEL_SCALAR);
+    return net;
+}
+
+/**
+ * @brief 销毁网络（NULL时什么也不做）
+ */
+void nn_destroy(NnNet *net)
+{
+    if (net != NULL)
+    {
+        free(net->allocation);
+        free(net);
+    }
+}
+
+/**
+ * @brief 输入下标：窗口单元格(dx, dy)（相对蛇头）的阻挡特征，食物特征在其后net->cells处
+ */
+static int window_index(const NnNet *net, int dx, int dy)
+{
+    return (dy + net->radius) * net->window + (dx + net->radius);
+}
+
+/**
+ * @brief 创建内置权重的网络
+ *
+ * 人工设定的权重，不需要训练，可作为基线或训练的参照：
+ * - 隐藏单元0～3：最近食物在该方向
+ * - 隐藏单元4～7：该方向相邻的单元格被阻挡
+ * - 隐藏单元8～11：该方向前方2～r格、左右各1格范围内被阻挡的单元格数 × 8（拥挤程度；最多9格，不会饱和，
+ *   否则食物贴着墙时墙壁的惩罚会压过食物）
+ * - 隐藏单元12～15：当前移动方向
+ * 输出 = 食物 × 100 − 相邻阻挡 × 127 − 拥挤 × 127 + 保持方向 × 8（各项都是0～127的隐藏单元）
+ *
+ * @return NnNet* 网络，内存不足返回NULL
+ */
+NnNet *nn_create_builtin(void)
+{
+    NnNet *net = allocate_net(NN_DEFAULT_RADIUS, NN_DEFAULT_HIDDEN);
+    if (net == NULL)
+    {
+        return NULL;
+    }
+    int food_dir = 2 * net->cells;
+    int move_dir = food_dir + NN_OUTPUTS;
+    for (int d = 0; d < NN_OUTPUTS; d++)
+    {
+        int8_t *food = net->hidden_weights + (size_t)d * (size_t)net->inputs;
+        int8_t *adjacent = net->hidden_weights + (size_t)(4 + d) * (size_t)net->inputs;
+        int8_t *crowd = net->hidden_weights + (size_t)(8 + d) * (size_t)net->inputs;
+        int8_t *moving = net->hidden_weights + (size_t)(12 + d) * (size_t)net->inputs;
+        food[food_dir + d] = 127;
+        adjacent[window_index(net, dir_dx[d], dir_dy[d])] = 127;
+        moving[move_dir + d] = 127;
+        for (int ahead = 2; ahead <= net->radius; ahead++)
+        {
+            for (int side = -1; side <= 1; side++)
+            {
+                // 前方沿(dir_dx, dir_dy)，侧向沿其垂直方向(dir_dy, dir_dx)
+                int dx = dir_dx[d] * ahead + dir_dy[d] * side;
+                int dy = dir_dy[d] * ahead + dir_dx[d] * side;
+                crowd[window_index(net, dx, dy)] = 8;
+            }
+        }
+
+        int8_t *output = net->output_weights + (size_t)d * (size_t)net->hidden;
+        output[d] = 100;
+        output[4 + d] = -127;
+        output[8 + d] = -127;
+        output[12 + d] = 8;
+    }
+    return net;
+}
+
+/**
+ * @brief splitmix64（随机权重）
+ */
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief 创建随机权重的网络（覆盖int8的整个取值范围，用于内核差分测试和作为训练的初始值）
+ *
+ * @param radius 窗口半径（1～NN_MAX_RADIUS）
+ * @param hidden 隐藏单元数（NN_INPUT_ALIGN的整数倍，不超过NN_MAX_HIDDEN）
+ * @param seed 随机数种子
+ * @return NnNet* 网络，参数不合法或内存不足返回NULL
+ */
+NnNet *nn_create_random(int radius, int hidden, uint64_t seed)
+{
+    NnNet *net = allocate_net(radius, hidden);
+    if (net == NULL)
+    {
+        return NULL;
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < (size_t)hidden * (size_t)net->inputs; i++)
+    {
+        net->hidden_weights[i] = (int8_t)(splitmix64(&state) & 0xFF);
+    }
+    for (size_t i = 0; i < (size_t)NN_OUTPUTS * (size_t)hidden; i++)
+    {
+        net->output_weights[i] = (int8_t)(splitmix64(&state) & 0xFF);
+    }
+    for (int i = 0; i < hidden; i++)
+    {
+        net->hidden_bias[i] = (int32_t)(splitmix64(&state) % 4096) - 2048;
+    }
+    net->multiplier = 3;
+    net->shift = 8;
+    return net;
+}
+
+// =============================================
+// 权重文件
+// =============================================
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 读取count个小端序int32
+ */
+static bool read_i32(FILE *file, int32_t *out, int count)
+{
+    unsigned char bytes[4];
+    for (int i = 0; i < count; i++)
+    {
+        if (fread(bytes, 1, 4, file) != 4)
+        {
+            return false;
+        }
+        out[i] = (int32_t)get_u32(bytes);
+    }
+    return true;
+}
+
+/**
+ * @brief 写出count个小端序int32
+ */
+static bool write_i32(FILE *file, const int32_t *values, int count)
+{
+    unsigned char bytes[4];
+    for (int i = 0; i < count; i++)
+    {
+        put_u32(bytes, (uint32_t)values[i]);
+        if (fwrite(bytes, 1, 4, file) != 4)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 从权重文件加载网络
+ *
+ * @param path 文件路径
+ * @param status 输出：失败原因，可为NULL
+ * @return NnNet* 网络，失败返回NULL
+ */
+NnNet *nn_load(const char *path, NnStatus *status)
+{
+    NnStatus result = NN_ERROR_IO;
+    NnNet *net = NULL;
+    unsigned char header[NN_HEADER_SIZE];
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        goto done;
+    }
+    result = NN_ERROR_FORMAT;
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, NN_MAGIC, NN_MAGIC_LENGTH) != 0)
+    {
+        goto done;
+    }
+    if (get_u32(header + 8) != NN_VERSION)
+    {
+        result = NN_ERROR_VERSION;
+        goto done;
+    }
+    uint32_t shift = get_u32(header + 24);
+    if (shift > 31)
+    {
+        goto done;
+    }
+    net = allocate_net((int)get_u32(header + 12), (int)get_u32(header + 16));
+    if (net == NULL)
+    {
+        // 尺寸不合法时allocate_net也返回NULL，按格式错误报告
+        goto done;
+    }
+    net->multiplier = (int32_t)get_u32(header + 20);
+    net->shift = (int)shift;
+
+    size_t hidden_weights = (size_t)net->hidden * (size_t)net->inputs;
+    size_t output_weights = (size_t)NN_OUTPUTS * (size_t)net->hidden;
+    if (!read_i32(file, net->hidden_bias, net->hidden) ||
+        fread(net->hidden_weights, 1, hidden_weights, file) != hidden_weights ||
+        !read_i32(file, net->output_bias, NN_OUTPUTS) ||
+        fread(net->output_weights, 1, output_weights, file) != output_weights || fgetc(file) != EOF)
+    {
+        nn_destroy(net);
+        net = NULL;
+        goto done;
+    }
+    result = NN_OK;
+
+done:
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    if (status != NULL)
+    {
+        *status = result;
+    }
+    return net;
+}
+
+/**
+ * @brief 把网络写出为权重文件（可用内置权重生成训练工具的模板）
+ */
+NnStatus nn_save(const NnNet *net, const char *path)
+{
+    unsigned char header[NN_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, NN_MAGIC, NN_MAGIC_LENGTH);
+    put_u32(header + 8, NN_VERSION);
+    put_u32(header + 12, (uint32_t)net->radius);
+    put_u32(header + 16, (uint32_t)net->hidden);
+    put_u32(header + 20, (uint32_t)net->multiplier);
+    put_u32(header + 24, (uint32_t)net->shift);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        return NN_ERROR_IO;
+    }
+    size_t hidden_weights = (size_t)net->hidden * (size_t)net->inputs;
+    size_t output_weights = (size_t)NN_OUTPUTS * (size_t)net->hidden;
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+              write_i32(file, net->hidden_bias, net->hidden) &&
+              fwrite(net->hidden_weights, 1, hidden_weights, file) == hidden_weights &&
+              write_i32(file, net->output_bias, NN_OUTPUTS) &&
+              fwrite(net->output_weights, 1, output_weights, file) == output_weights;
+    ok = fclose(file) == 0 && ok;
+    return ok ? NN_OK : NN_ERROR_IO;
+}
+
+/**
+ * @brief 权重文件读写结果 → 描述文字
+ */
+const char *nn_status_message(NnStatus status)
+{
+    switch (status)
+    {
+    case NN_OK:
+        return "成功";
+    case NN_ERROR_IO:
+        return "文件无法打开或读写";
+    case NN_ERROR_FORMAT:
+        return "不是权重文件或尺寸不合法";
+    case NN_ERROR_VERSION:
+        return "不支持的权重文件版本";
+    case NN_ERROR_MEMORY:
+        return "内存不足";
+    default:
+        return "未知错误";
+    }
+}
+
+// =============================================
+// 推理
+// =============================================
+
+/**
+ * @brief 获取输入数（补齐后，nn_encode和nn_forward的每个输入占这么多字节）
+ */
+int nn_input_count(const NnNet *net)
+{
+    return net->inputs;
+}
+
+/**
+ * @brief 把游戏局面编码为网络输入
+ *
+ * 窗口超出有边框的游戏池的部分视为阻挡；环面布局下窗口回绕。
+ * 最近食物的方向按游戏池中的最短位移计算（环面布局下可以跨过边缘）。
+ *
+ * @param net 网络
+ * @param ctx 游戏上下文（第一次查询最近食物时建立食物索引）
+ * @param input 输出：nn_input_count(net)字节
+ */
+void nn_encode(const NnNet *net, GameContext *ctx, uint8_t *input)
+{
+    int width = ctx->pool_width;
+    int height = ctx->pool_height;
+    Position head = ctx->game.snake.head;
+    uint8_t *blocked = input;
+    uint8_t *food = input + net->cells;
+    memset(input, 0, (size_t)net->inputs);
+
+    for (int dy = -net->radius; dy <= net->radius; dy++)
+    {
+        int y = head.y + dy;
+        if (ctx->torus)
+        {
+            y = ((y % height) + height) % height;
+        }
+        for (int dx = -net->radius; dx <= net->radius; dx++)
+        {
+            int x = head.x + dx;
+            if (ctx->torus)
+            {
+                x = ((x % width) + width) % width;
+            }
+            int index = window_index(net, dx, dy);
+            if (x < 0 || x >= width || y < 0 || y >= height)
+            {
+                blocked[index] = 1;
+                continue;
+            }
+            CellType cell = ctx->pool[(size_t)y * (size_t)width + (size_t)x];
+            if (cell == CELL_FOOD)
+            {
+                food[index] = 1;
+            }
+            else if (cell != CELL_EMPTY)
+            {
+                blocked[index] = 1;
+            }
+        }
+    }
+
+    uint8_t *food_dir = input + 2 * net->cells;
+    Position nearest;
+    if (food_nearest(ctx, head, &nearest) >= 0)
+    {
+        int dx = nearest.x - head.x;
+        int dy = nearest.y - head.y;
+        if (ctx->torus)
+        {
+            dx = dx > width / 2 ? dx - width : dx < -width / 2 ? dx + width : dx;
+            dy = dy > height / 2 ? dy - height : dy < -height / 2 ? dy + height : dy;
+        }
+        food_dir[DIR_UP] = dy < 0;
+        food_dir[DIR_DOWN] = dy > 0;
+        food_dir[DIR_LEFT] = dx < 0;
+        food_dir[DIR_RIGHT] = dx > 0;
+    }
+    food_dir[NN_OUTPUTS + ctx->game.snake.direction] = 1;
+}
+
+/**
+ * @brief 前向计算count个输入的输出
+ *
+ * @param net 网络
+ * @param inputs 输入（count × nn_input_count(net)字节，取值0～127）
+ * @param count 输入个数
+ * @param logits 输出：count × NN_OUTPUTS个int32（按Direction顺序）
+ */
+void nn_forward(const NnNet *net, const uint8_t *inputs, int count, int32_t *logits)
+{
+    int32_t accumulators[NN_BATCH_TILE * NN_MAX_HIDDEN];
+    uint8_t activations[NN_BATCH_TILE * NN_MAX_HIDDEN];
+    for (int begin = 0; begin < count; begin += NN_BATCH_TILE)
+    {
+        int n = count - begin < NN_BATCH_TILE ? count - begin : NN_BATCH_TILE;
+        net->matmul(net->hidden_weights, net->hidden, net->inputs, inputs + (size_t)begin * (size_t)net->inputs, n,
+                    accumulators);
+
+        // 加偏置、ReLU、重新量化到0～127（乘法用64位，累加值再大也不会溢出）
+        for (int i = 0; i < n * net->hidden; i++)
+        {
+            int64_t value = (int64_t)accumulators[i] + net->hidden_bias[i % net->hidden];
+            value = value > 0 ? (value * net->multiplier) >> net->shift : 0;
+            activations[i] = (uint8_t)(value < 0 ? 0 : value > 127 ? 127 : value);
+        }
+
+        int32_t *out = logits + (size_t)begin * NN_OUTPUTS;
+        net->matmul(net->output_weights, NN_OUTPUTS, net->hidden, activations, n, out);
+        for (int i = 0; i < n * NN_OUTPUTS; i++)
+        {
+            out[i] += net->output_bias[i % NN_OUTPUTS];
+        }
+    }
+}
+
+/**
+ * @brief 按输出选择方向：只在不会立即撞死的方向中取最大值（相同时取编号小的方向）
+ *
+ * 没有安全方向时保持当前方向（游戏在下一帧结束）。
+ */
+static Direction choose_direction(const GameContext *ctx, const int32_t *logits)
+{
+    Direction best = ctx->game.snake.direction;
+    bool found = false;
+    for (int d = 0; d < NN_OUTPUTS; d++)
+    {
+        if ((Direction)d == opposite[ctx->game.snake.direction])
+        {
+            continue;
+        }
+        CellType next = get_cell_type(ctx, neighbor_position(ctx, ctx->game.snake.head, (Direction)d));
+        if ((next == CELL_EMPTY || next == CELL_FOOD) && (!found || logits[d] > logits[best]))
+        {
+            best = (Direction)d;
+            found = true;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 为一局游戏做出决策
+ */
+Direction nn_decide(const NnNet *net, GameContext *ctx)
+{
+    uint8_t input[NN_MAX_INPUTS];
+    int32_t logits[NN_OUTPUTS];
+    nn_encode(net, ctx, input);
+    nn_forward(net, input, 1, logits);
+    return choose_direction(ctx, logits);
+}
+
+/**
+ * @brief 批量决策：每NN_BATCH_TILE局的输入排成矩阵一起前向计算
+ *
+ * 只读取网络，可以在多个线程中对不同的游戏同时调用。
+ *
+ * @param net 网络
+ * @param ctxs 游戏上下文指针（count个）
+ * @param count 局数
+ * @param out 输出：每局的方向（count个）
+ */
+void nn_decide_batch(const NnNet *net, GameContext *const *ctxs, int count, Direction *out)
+{
+    uint8_t inputs[NN_BATCH_TILE * NN_MAX_INPUTS];
+    int32_t logits[NN_BATCH_TILE * NN_OUTPUTS];
+    for (int begin = 0; begin < count; begin += NN_BATCH_TILE)
+    {
+        int n = count - begin < NN_BATCH_TILE ? count - begin : NN_BATCH_TILE;
+        for (int i = 0; i < n; i++)
+        {
+            nn_encode(net, ctxs[begin + i], inputs + (size_t)i * (size_t)net->inputs);
+        }
+        nn_forward(net, inputs, n, logits);
+        for (int i = 0; i < n; i++)
+        {
+            out[begin + i] = choose_direction(ctxs[begin + i], logits + (size_t)i * NN_OUTPUTS);
+        }
+    }
+}
+
+// =============================================
+// 策略接口
+// =============================================
+
+/**
+ * @brief 设置ai_nn使用的网络：从权重文件加载，path为NULL时使用内置权重
+ *
+ * 多线程调用ai_nn（如多会话主机）之前应先调用，避免第一次决策时并发创建。
+ *
+ * @param path 权重文件路径，可为NULL
+ * @param status 输出：加载结果，可为NULL
+ * @return true 成功（失败时保留原来的网络）
+ */
+bool ai_nn_configure(const char *path, NnStatus *status)
+{
+    NnStatus result = NN_ERROR_MEMORY;
+    NnNet *net = path != NULL ? nn_load(path, &result) : nn_create_builtin();
+    if (status != NULL)
+    {
+        *status = net != NULL ? NN_OK : result;
+    }
+    if (net == NULL)
+    {
+        return false;
+    }
+    nn_destroy(shared_net);
+    shared_net = net;
+    return true;
+}
+
+/**
+ * @brief 神经网络策略（AiPolicy）
+ *
+ * 没有配置过时第一次调用创建内置权重的网络；内存不足时保持当前方向。
+ */
+Direction ai_nn(GameContext *ctx)
+{
+    if (shared_net == NULL && !ai_nn_configure(NULL, NULL))
+    {
+        return ctx->game.snake.direction;
+    }
+    return nn_decide(shared_net, ctx);
+}
+
+/**
+ * @brief 释放共享的网络
+ */
+void ai_nn_release(void)
+{
+    nn_destroy(shared_net);
+    shared_net = NULL;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file snake_nn.h
+ * @brief 神经网络自动控制策略（int8量化的两层感知机，进程内推理）
+ *
+ * 输入是以蛇头为中心的(2r+1)×(2r+1)局部窗口：每个单元格两个特征（是否阻挡、是否食物），
+ * 加上最近食物相对蛇头的方向（上、下、左、右各一位）和当前移动方向（one-hot），补零到NN_INPUT_ALIGN的整数倍。
+ * 所有特征都是0或1，直接作为uint8输入：
+ *
+ *     隐藏层 h = clamp((W1·x + b1) × multiplier >> shift, 0, 127)   （int8权重，int32累加，ReLU后重新量化为uint8）
+ *     输出   y = W2·h + b2                                         （4个int32，按Direction顺序）
+ *
+ * 选择输出最大的方向（只在不会立即撞死的方向中选择，与其他策略相同）。
+ * 内积内核有AVX2和标量两个版本，运行时按CPU选择；整数运算不会溢出或饱和，两个版本的结果逐位相同。
+ * 批量推理把多局的输入排成矩阵，每行权重只加载一次，与NN_BATCH_TILE局的输入分别相乘。
+ *
+ * 权重文件布局（所有整数均为小端序）：
+ *
+ *     偏移   大小    内容
+ *     0      8       魔数"SNAKENET"
+ *     8      4       格式版本（NN_VERSION）
+ *     12     4       窗口半径r（1～NN_MAX_RADIUS）
+ *     16     4       隐藏单元数H（NN_INPUT_ALIGN的整数倍，不超过NN_MAX_HIDDEN）
+ *     20     4       隐藏层重新量化的乘数（int32）
+ *     24     4       隐藏层重新量化的右移位数（0～31）
+ *     28     4       保留（0）
+ *     32     4H      隐藏层偏置（int32）
+ *     ..     H×K     隐藏层权重（int8，行优先，K为补齐后的输入数）
+ *     ..     4×4     输出层偏置（int32）
+ *     ..     4×H     输出层权重（int8，行优先）
+ *
+ * 没有权重文件时使用内置权重：人工设定的小网络，隐藏单元分别检测各方向的食物、相邻阻挡和前方拥挤程度。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_NN_H
+#define SNAKE_NN_H
+
+#include <stdint.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define NN_MAGIC "SNAKENET"  ///< 权重文件魔数（8字节，不含'\0'）
+#define NN_VERSION 1         ///< 当前格式版本
+#define NN_HEADER_SIZE 32    ///< 权重文件头大小（字节）
+#define NN_OUTPUTS 4         ///< 输出数（每个方向一个）
+#define NN_INPUT_ALIGN 32    ///< 输入数和隐藏单元数的对齐（一个AVX2寄存器的字节数）
+#define NN_DEFAULT_RADIUS 4  ///< 内置权重的窗口半径
+#define NN_DEFAULT_HIDDEN 32 ///< 内置权重的隐藏单元数
+#define NN_MAX_RADIUS 7      ///< 最大窗口半径
+#define NN_MAX_HIDDEN 256    ///< 最大隐藏单元数
+#define NN_BATCH_TILE 16     ///< 批量推理每次一起计算的局数
+
+/**
+ * @enum NnKernel
+ * @brief 内积内核
+ */
+typedef enum
+{
+    NN_KERNEL_SCALAR, ///< 标量实现（所有平台）
+    NN_KERNEL_AVX2    ///< AVX2实现（x86，运行时检测CPU支持）
+} NnKernel;
+
+/**
+ * @enum NnStatus
+ * @brief 权重文件读写结果
+ */
+typedef enum
+{
+    NN_OK = 0,        ///< 成功
+    NN_ERROR_IO,      ///< 文件无法打开或读写
+    NN_ERROR_FORMAT,  ///< 不是权重文件，或尺寸不合法、文件被截断
+    NN_ERROR_VERSION, ///< 不支持的格式版本
+    NN_ERROR_MEMORY   ///< 内存不足
+} NnStatus;
+
+typedef struct NnNet NnNet; ///< 网络（不透明，创建后只读，可在多个线程中同时推理）
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+// 创建和权重文件
+NnNet *nn_create_builtin(void);
+NnNet *nn_create_random(int radius, int hidden, uint64_t seed);
+NnNet *nn_load(const char *path, NnStatus *status);
+NnStatus nn_save(const NnNet *net, const char *path);
+void nn_destroy(NnNet *net);
+const char *nn_status_message(NnStatus status);
+
+// 内核
+bool nn_kernel_supported(NnKernel kernel);
+bool nn_set_kernel(NnNet *net, NnKernel kernel);
+NnKernel nn_get_kernel(const NnNet *net);
+const char *nn_kernel_name(NnKernel kernel);
+
+// 推理
+int nn_input_count(const NnNet *net);
+void nn_encode(const NnNet *net, GameContext *ctx, uint8_t *input);
+void nn_forward(const NnNet *net, const uint8_t *inputs, int count, int32_t *logits);
+Direction nn_decide(const NnNet *net, GameContext *ctx);
+void nn_decide_batch(const NnNet *net, GameContext *const *ctxs, int count, Direction *out);
+
+// 作为AiPolicy使用（共享的网络，默认使用内置权重）
+bool ai_nn_configure(const char *path, NnStatus *status);
+Direction ai_nn(GameContext *ctx);
+void ai_nn_release(void);
+
+#endif // SNAKE_NN_H
@@ -0,0 +1,507 @@
+/**
+ * @file snake_parallel.c
+ * @brief 线程池与并行for实现
+ *
+ * Windows使用Win32线程、SRW锁和条件变量，其他平台使用pthread。
+ * MSVC的C模式没有可靠的<stdatomic.h>，原子操作用Interlocked系列函数实现。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_parallel.h"
+#include "snake_core.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// =============================================
+// 平台抽象：原子操作、自旋提示、线程、互斥锁和条件变量
+// =============================================
+
+#if defined(_MSC_VER)
+typedef volatile LONG atomic_counter;
+#define atomic_counter_load(p) ((int)InterlockedCompareExchange((p), 0, 0))
+#define atomic_counter_store(p, v) ((void)InterlockedExchange((p), (LONG)(v)))
+#define atomic_counter_add(p, v) ((int)InterlockedExchangeAdd((p), (LONG)(v)))
+#else
+#include <stdatomic.h>
+typedef atomic_int atomic_counter;
+#define atomic_counter_load(p) atomic_load(p)
+#define atomic_counter_store(p, v) atomic_store((p), (v))
+#define atomic_counter_add(p, v) atomic_fetch_add((p), (v))
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+#ifdef _WIN32
+typedef HANDLE thread_handle;
+typedef SRWLOCK mutex_type;
+typedef CONDITION_VARIABLE cond_type;
+#define mutex_init(m) InitializeSRWLock(m)
+#define mutex_destroy(m) ((void)(m))
+#define mutex_lock(m) AcquireSRWLockExclusive(m)
+#define mutex_unlock(m) ReleaseSRWLockExclusive(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_destroy(c) ((void)(c))
+#define cond_wait(c, m) SleepConditionVariableSRW((c), (m), INFINITE, 0)
+#define cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_t thread_handle;
+typedef pthread_mutex_t mutex_type;
+typedef pthread_cond_t cond_type;
+#define mutex_init(m) pthread_mutex_init((m), NULL)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init((c), NULL)
+#define cond_destroy(c) pthread_cond_destroy(c)
+#define cond_wait(c, m) pthread_cond_wait((c), (m))
+#define cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define SPIN_LIMIT (1 << 16)  ///< 工作线程阻塞前的最大自旋次数
+#define SHARDS_PER_THREAD 4   ///< 每个线程的目标分片数（分片越多负载越均衡）
+
+// =============================================
+// 类型定义
+// =============================================
+
+/**
+ * @struct PaddedCounter
+ * @brief 独占一个缓存行的原子计数器，避免不同计数器之间的伪共享
+ */
+typedef struct
+{
+    atomic_counter value;                                    ///< 计数值
+    char padding[CACHE_LINE_SIZE - sizeof(atomic_counter)]; ///< 填充到缓存行大小
+} PaddedCounter;
+
+/**
+ * @struct WorkerSlot
+ * @brief 工作线程启动参数（每个工作线程一个）
+ */
+typedef struct
+{
+    ThreadPool *pool;     ///< 所属线程池
+    int index;            ///< 线程编号（从1开始，0为调用线程）
+    thread_handle handle; ///< 线程句柄
+} WorkerSlot;
+
+/**
+ * @struct ThreadPool
+ * @brief 线程池
+ *
+ * 调用线程写好任务描述后递增generation发布任务，工作线程观察到generation变化后
+ * 通过next_shard原子地领取分片，完成后递减pending。调用线程自己也领取分片，
+ * 最后自旋等待pending归零。
+ */
+struct ThreadPool
+{
+    PaddedCounter generation; ///< 任务代数，每发布一个任务加1
+    PaddedCounter next_shard; ///< 下一个待领取的分片
+    PaddedCounter pending;    ///< 尚未完成当前任务的工作线程数
+    PaddedCounter sleepers;   ///< 正在阻塞等待的工作线程数
+    PaddedCounter shutdown;   ///< 非0时工作线程退出
+
+    // 当前任务（发布前由调用线程写入，发布后只读）
+    ParallelTask task; ///< 任务函数
+    void *arg;         ///< 任务参数
+    int count;         ///< 区间长度
+    int shard_size;    ///< 分片大小
+    int shard_count;   ///< 分片数
+
+    ParallelMode mode;      ///< 调度方式
+    int thread_count;       ///< 线程数（包括调用线程）
+    mutex_type mutex;       ///< 保护阻塞等待的互斥锁
+    cond_type wake;         ///< 发布任务时唤醒阻塞的工作线程
+    WorkerSlot *workers;    ///< 工作线程数组（thread_count - 1个）
+    void *allocation;       ///< heap_alloc返回的原始地址（结构体本身按缓存行对齐）
+};
+
+// =============================================
+// 内部函数
+// =============================================
+
+/**
+ * @brief 领取并执行分片，直到所有分片都被领取
+ */
+static void run_shards(ThreadPool *pool, int worker)
+{
+    for (;;)
+    {
+        int shard = atomic_counter_add(&pool->next_shard.value, 1);
+        if (shard >= pool->shard_count)
+        {
+            return;
+        }
+        int begin = shard * pool->shard_size;
+        int end = begin + pool->shard_size;
+        if (end > pool->count)
+        {
+            end = pool->count;
+        }
+        pool->task(pool->arg, begin, end, worker);
+    }
+}
+
+/**
+ * @brief 等待任务代数变化
+ *
+ * 先自旋SPIN_LIMIT次（任务间隔很短时无需任何系统调用即可开始工作），
+ * 仍未等到则登记为阻塞线程并在条件变量上等待。
+ *
+ * @param pool 线程池
+ * @param seen 上一次观察到的代数
+ * @return int 新的代数
+ */
+static int wait_for_generation(ThreadPool *pool, int seen)
+{
+    for (int spin = 0; spin < SPIN_LIMIT; spin++)
+    {
+        int generation = atomic_counter_load(&pool->generation.value);
+        if (generation != seen)
+        {
+            return generation;
+        }
+        cpu_relax();
+    }
+
+    int generation;
+    mutex_lock(&pool->mutex);
+    atomic_counter_add(&pool->sleepers.value, 1);
+    while ((generation = atomic_counter_load(&pool->generation.value)) == seen)
+    {
+        cond_wait(&pool->wake, &pool->mutex);
+    }
+    atomic_counter_add(&pool->sleepers.value, -1);
+    mutex_unlock(&pool->mutex);
+    return generation;
+}
+
+/**
+ * @brief 工作线程主循环
+ */
+static void worker_loop(WorkerSlot *slot)
+{
+    ThreadPool *pool = slot->pool;
+    int seen = 0;
+
+    for (;;)
+    {
+        seen = wait_for_generation(pool, seen);
+        if (atomic_counter_load(&pool->shutdown.value) != 0)
+        {
+            return;
+        }
+        run_shards(pool, slot->index);
+        atomic_counter_add(&pool->pending.value, -1);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_entry(LPVOID param)
+{
+    worker_loop((WorkerSlot *)param);
+    return 0;
+}
+#else
+static void *worker_entry(void *param)
+{
+    worker_loop((WorkerSlot *)param);
+    return NULL;
+}
+#endif
+
+/**
+ * @brief 发布新任务代数，并唤醒已转入阻塞等待的工作线程
+ */
+static void publish_generation(ThreadPool *pool)
+{
+    atomic_counter_add(&pool->generation.value, 1);
+    if (atomic_counter_load(&pool->sleepers.value) != 0)
+    {
+        mutex_lock(&pool->mutex);
+        cond_broadcast(&pool->wake);
+        mutex_unlock(&pool->mutex);
+    }
+}
+
+// =============================================
+// 公共函数
+// =============================================
+
+/**
+ * @brief 获取可用的逻辑CPU数
+ */
+int parallel_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+/**
+ * @brief 按名称解析调度方式（"serial"、"openmp"、"spin"）
+ *
+ * @return true 解析成功
+ * @return false 未知名称
+ */
+bool parallel_mode_from_name(const char *name, ParallelMode *mode)
+{
+    static const ParallelMode modes[] = {PARALLEL_SERIAL, PARALLEL_OPENMP, PARALLEL_SPIN_POOL};
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        if (strcmp(name, parallel_mode_name(modes[i])) == 0)
+        {
+            *mode = modes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 获取调度方式名称
+ */
+const char *parallel_mode_name(ParallelMode mode)
+{
+    switch (mode)
+    {
+    case PARALLEL_OPENMP:
+        return "openmp";
+    case PARALLEL_SPIN_POOL:
+        return "spin";
+    default:
+        return "serial";
+    }
+}
+
+/**
+ * @brief 创建线程池
+ *
+ * 自旋线程池会立即启动thread_count - 1个常驻工作线程（调用线程算作第0个）。
+ * 未启用OpenMP编译时，PARALLEL_OPENMP退化为顺序执行。
+ *
+ * @param mode 调度方式
+ * @param thread_count 线程数（包括调用线程），<=0表示使用全部逻辑CPU；自旋线程池不超过逻辑CPU数
+ * @return ThreadPool* 线程池，失败返回NULL
+ */
+ThreadPool *thread_pool_create(ParallelMode mode, int thread_count)
+{
+    if (thread_count <= 0)
+    {
+        thread_count = parallel_cpu_count();
+    }
+    if (thread_count > PARALLEL_MAX_THREADS)
+    {
+        thread_count = PARALLEL_MAX_THREADS;
+    }
+#ifndef _OPENMP
+    if (mode == PARALLEL_OPENMP)
+    {
+        mode = PARALLEL_SERIAL;
+    }
+#endif
+    if (mode == PARALLEL_SERIAL)
+    {
+        thread_count = 1;
+    }
+    // 自旋等待的线程会抢占正在工作的线程，线程数超过逻辑CPU数只会更慢
+    if (mode == PARALLEL_SPIN_POOL && thread_count > parallel_cpu_count())
+    {
+        thread_count = parallel_cpu_count();
+    }
+
+    // 结构体按缓存行对齐，保证各PaddedCounter独占缓存行
+    void *allocation = heap_alloc(sizeof(ThreadPool) + CACHE_LINE_SIZE);
+    if (allocation == NULL)
+    {
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)allocation + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    ThreadPool *pool = (ThreadPool *)aligned;
+    memset(pool, 0, sizeof(*pool));
+    pool->allocation = allocation;
+    pool->mode = mode;
+    pool->thread_count = thread_count;
+
+    if (mode != PARALLEL_SPIN_POOL || thread_count == 1)
+    {
+        return pool;
+    }
+
+    pool->workers = (WorkerSlot *)heap_alloc((size_t)(thread_count - 1) * sizeof(WorkerSlot));
+    if (pool->workers == NULL)
+    {
+        pool->thread_count = 1;
+        return pool;
+    }
+    mutex_init(&pool->mutex);
+    cond_init(&pool->wake);
+
+    for (int i = 0; i < thread_count - 1; i++)
+    {
+        WorkerSlot *slot = &pool->workers[i];
+        slot->pool = pool;
+        slot->index = i + 1;
+#ifdef _WIN32
+        slot->handle = CreateThread(NULL, 0, worker_entry, slot, 0, NULL);
+        bool started = slot->handle != NULL;
+#else
+        bool started = pthread_create(&slot->handle, NULL, worker_entry, slot) == 0;
+#endif
+        if (!started)
+        {
+            // 线程创建失败时以已启动的线程数继续工作
+            pool->thread_count = i + 1;
+            break;
+        }
+    }
+    return pool;
+}
+
+/**
+ * @brief 销毁线程池，通知并等待所有工作线程退出
+ */
+void thread_pool_destroy(ThreadPool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    if (pool->workers != NULL)
+    {
+        atomic_counter_store(&pool->shutdown.value, 1);
+        atomic_counter_add(&pool->generation.value, 1);
+        mutex_lock(&pool->mutex);
+        cond_broadcast(&pool->wake);
+        mutex_unlock(&pool->mutex);
+
+        for (int i = 0; i < pool->thread_count - 1; i++)
+        {
+#ifdef _WIN32
+            WaitForSingleObject(pool->workers[i].handle, INFINITE);
+            CloseHandle(pool->workers[i].handle);
+#else
+            pthread_join(pool->workers[i].handle, NULL);
+#endif
+        }
+        free(pool->workers);
+        cond_destroy(&pool->wake);
+        mutex_destroy(&pool->mutex);
+    }
+    free(pool->allocation);
+}
+
+/**
+ * @brief 获取线程池的实际调度方式（OpenMP不可用时可能与创建时请求的不同）
+ */
+ParallelMode thread_pool_mode(const ThreadPool *pool)
+{
+    return pool != NULL ? pool->mode : PARALLEL_SERIAL;
+}
+
+/**
+ * @brief 获取线程池的线程数（包括调用线程）
+ */
+int thread_pool_size(const ThreadPool *pool)
+{
+    return pool != NULL ? pool->thread_count : 1;
+}
+
+/**
+ * @brief 并行执行task处理区间[0, count)
+ *
+ * 区间切分为大小为grain整数倍的分片（最后一片除外），函数返回时所有分片均已完成。
+ * pool为NULL或只有一个线程时直接在调用线程上执行。
+ *
+ * @param pool 线程池，可为NULL
+ * @param count 区间长度
+ * @param grain 分片粒度（分片边界对齐到grain的倍数）
+ * @param task 任务函数
+ * @param arg 任务参数
+ */
+void thread_pool_run(ThreadPool *pool, int count, int grain, ParallelTask task, void *arg)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    if (grain < 1)
+    {
+        grain = 1;
+    }
+
+    int threads = thread_pool_size(pool);
+    int target_shards = threads * SHARDS_PER_THREAD;
+    int shard_size = (count + target_shards - 1) / target_shards;
+    shard_size = (shard_size + grain - 1) / grain * grain;
+    int shard_count = (count + shard_size - 1) / shard_size;
+
+    if (threads == 1 || shard_count == 1)
+    {
+        task(arg, 0, count, 0);
+        return;
+    }
+
+    if (pool->mode == PARALLEL_OPENMP)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+        for (int shard = 0; shard < shard_count; shard++)
+        {
+            int begin = shard * shard_size;
+            int end = begin + shard_size < count ? begin + shard_size : count;
+            task(arg, begin, end, omp_get_thread_num());
+        }
+#endif
+        return;
+    }
+
+    // 自旋线程池：写好任务描述后发布，调用线程同样参与领取分片
+    pool->task = task;
+    pool->arg = arg;
+    pool->count = count;
+    pool->shard_size = shard_size;
+    pool->shard_count = shard_count;
+    atomic_counter_store(&pool->next_shard.value, 0);
+    atomic_counter_store(&pool->pending.value, threads - 1);
+    publish_generation(pool);
+
+    run_shards(pool, 0);
+    while (atomic_counter_load(&pool->pending.value) != 0)
+    {
+        cpu_relax();
+    }
+}
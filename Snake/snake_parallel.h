@@ -0,0 +1,67 @@
+/**
+ * @file snake_parallel.h
+ * @brief 线程池与并行for
+ *
+ * 把[0, count)区间切分成若干分片并行执行，分片大小是grain的整数倍，
+ * 调用方据此让不同线程写入的输出落在不同缓存行上，避免伪共享。
+ *
+ * 支持三种调度方式：
+ * - PARALLEL_SERIAL:    在调用线程上顺序执行
+ * - PARALLEL_OPENMP:    OpenMP parallel for（编译器不支持OpenMP时退化为顺序执行）
+ * - PARALLEL_SPIN_POOL: 常驻线程池，工作线程在任务之间自旋等待，小批量任务不受线程唤醒延迟影响；
+ *                       自旋超过上限后转为阻塞等待，空闲时不占用CPU
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_PARALLEL_H
+#define SNAKE_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define CACHE_LINE_SIZE 64      ///< 缓存行大小（字节）
+#define PARALLEL_MAX_THREADS 64 ///< 线程池最大线程数（包括调用线程）
+
+/**
+ * @enum ParallelMode
+ * @brief 并行调度方式
+ */
+typedef enum
+{
+    PARALLEL_SERIAL,   ///< 顺序执行
+    PARALLEL_OPENMP,   ///< OpenMP parallel for
+    PARALLEL_SPIN_POOL ///< 常驻自旋线程池
+} ParallelMode;
+
+/**
+ * @brief 并行任务函数：处理区间[begin, end)
+ *
+ * @param arg 任务参数
+ * @param begin 区间起点（包含）
+ * @param end 区间终点（不包含）
+ * @param worker 执行该分片的线程编号（0为调用线程），可用于索引线程私有数据
+ */
+typedef void (*ParallelTask)(void *arg, int begin, int end, int worker);
+
+typedef struct ThreadPool ThreadPool; ///< 线程池（不透明）
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+int parallel_cpu_count(void);
+bool parallel_mode_from_name(const char *name, ParallelMode *mode);
+const char *parallel_mode_name(ParallelMode mode);
+
+ThreadPool *thread_pool_create(ParallelMode mode, int thread_count);
+void thread_pool_destroy(ThreadPool *pool);
+ParallelMode thread_pool_mode(const ThreadPool *pool);
+int thread_pool_size(const ThreadPool *pool);
+void thread_pool_run(ThreadPool *pool, int count, int grain, ParallelTask task, void *arg);
+
+#endif // SNAKE_PARALLEL_H
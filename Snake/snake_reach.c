@@ -0,0 +1,602 @@
+/**
+ * @file snake_reach.c
+ * @brief 可达区域：开放单元格的增量连通分量
+ *
+ * 开放单元格（空单元格和食物）按四邻接划分为连通分量，每个单元格记录分量编号，
+ * 每个编号记录分量大小。自动策略的安全检查（"走这一步会不会把自己困住"）
+ * 因此只需查询目标单元格所在分量的大小，不再每帧对整个游戏池做洪水填充。
+ *
+ * 每帧通常只有两个单元格改变开放状态（旧蛇尾开放、新蛇头关闭），增量维护的代价：
+ * - 开放：与相邻分量合并，保留最大的分量编号，只重新编号较小的分量
+ * - 关闭：周围8个单元格能把各开放邻居连起来时不可能分裂，O(1)完成；
+ *   否则从各邻居交替进行广度优先搜索，直到只剩一个搜索未结束，
+ *   搜完的部分就是分裂出去的分量。代价与较小部分的大小成正比，而不是整个游戏池
+ *
+ * 每局第一次查询时才建立，从不查询的上下文（如只推进和编码观测的强化学习环境）没有任何额外开销。
+ * 有边框的布局下开放单元格都不在游戏池边缘，邻居就是下标加上固定偏移；
+ * 环面布局下邻居由坐标查邻居坐标表得到（见neighbor_cell）。
+ * 各单元格的数组和搜索队列放在可达区域自己的内存区域中，上下文第一次查询时按有边框布局的尺寸一次申请
+ * （之后改变布局或重玩都不再申请）；搜索队列用完立即归还，增量维护时不申请堆内存。
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_core.h"
+
+#include <assert.h>
+#include <string.h>
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 单元格下标是否开放（越界视为关闭）
+ */
+static bool index_is_open(const GameContext *ctx, int x, int y)
+{
+    return x >= 0 && x < ctx->pool_width && y >= 0 && y < ctx->pool_height &&
+           CELL_IS_OPEN(ctx->pool[y * ctx->pool_width + x]);
+}
+
+/**
+ * @brief 单元格下标 → 上下左右邻居的下标
+ *
+ * @param offsets 有边框的布局下四个方向的下标偏移
+ */
+static inline int neighbor_cell(const GameContext *ctx, int index, const int offsets[4], int d)
+{
+    if (!ctx->torus)
+    {
+        return index + offsets[d];
+    }
+    Position pos = {index % ctx->pool_width, index / ctx->pool_width};
+    pos = neighbor_position(ctx, pos, (Direction)d);
+    return pos.y * ctx->pool_width + pos.x;
+}
+
+/**
+ * @brief 取得一个未使用的分量编号
+ */
+static int32_t label_acquire(Reachability *reach)
+{
+    assert(reach->free_count > 0); // 分量数不超过单元格数
+    return reach->free_labels[--reach->free_count];
+}
+
+/**
+ * @brief 归还一个分量编号
+ */
+static void label_release(Reachability *reach, int32_t label)
+{
+    reach->size[label] = 0;
+    reach->free_labels[reach->free_count++] = label;
+}
+
+/**
+ * @brief 开始新一轮搜索，使之前的全部搜索标记失效
+ *
+ * @return uint32_t 本轮搜索的标记基数（低2位留给搜索序号）
+ */
+static uint32_t next_epoch(GameContext *ctx)
+{
+    Reachability *reach = &ctx->reach;
+    reach->epoch++;
+    if (reach->epoch >= (1u << 30))
+    {
+        // 代数即将溢出：清空标记后重新计数
+        memset(reach->mark, 0, (size_t)ctx->pool_width * (size_t)ctx->pool_height * sizeof(uint32_t));
+        reach->epoch = 1;
+    }
+    return reach->epoch << 2;
+}
+
+/**
+ * @brief 把从start出发、编号为from的整个分量重新编号为to
+ *
+ * @param ctx 游戏上下文
+ * @param start 分量中的任意单元格下标
+ * @param from 原编号
+ * @param to 新编号
+ * @param queue 搜索队列（容量不小于分量大小）
+ * @return int 重新编号的单元格数
+ */
+static int relabel_region(GameContext *ctx, int start, int32_t from, int32_t to, int32_t *queue)
+{
+    int32_t *label = ctx->reach.label;
+    const int offsets[4] = {-ctx->pool_width, ctx->pool_width, -1, 1};
+    int head = 0, tail = 0;
+
+    label[start] = to;
+    queue[tail++] = start;
+    while (head < tail)
+    {
+        int cell = queue[head++];
+        for (int d = 0; d < 4; d++)
+        {
+            int next = neighbor_cell(ctx, cell, offsets, d);
+            if (label[next] == from && CELL_IS_OPEN(ctx->pool[next]))
+            {
+                label[next] = to;
+                queue[tail++] = next;
+            }
+        }
+    }
+    return tail;
+}
+
+// =============================================
+// 增量维护
+// =============================================
+
+/**
+ * @brief 单元格开放：与相邻分量合并
+ *
+ * 保留最大相邻分量的编号，其余相邻分量整体重新编号后并入（代价与较小分量大小成正比）。
+ */
+static void reach_open(GameContext *ctx, int index)
+{
+    Reachability *reach = &ctx->reach;
+    const int offsets[4] = {-ctx->pool_width, ctx->pool_width, -1, 1};
+
+    // 找出最大的相邻分量
+    int32_t keep = -1;
+    for (int d = 0; d < 4; d++)
+    {
+        int32_t l = reach->label[neighbor_cell(ctx, index, offsets, d)];
+        if (l >= 0 && (keep < 0 || reach->size[l] > reach->size[keep]))
+        {
+            keep = l;
+        }
+    }
+
+    if (keep < 0)
+    {
+        // 孤立的单元格：新建分量
+        keep = label_acquire(reach);
+    }
+    reach->label[index] = keep;
+    reach->size[keep]++;
+
+    // 其余相邻分量并入
+    for (int d = 0; d < 4; d++)
+    {
+        int neighbor = neighbor_cell(ctx, index, offsets, d);
+        int32_t l = reach->label[neighbor];
+        if (l >= 0 && l != keep)
+        {
+            size_t saved = arena_save(&ctx->reach.arena);
+            int32_t *queue = (int32_t *)arena_alloc(&ctx->reach.arena, (size_t)reach->size[l] * sizeof(int32_t));
+            assert(queue != NULL); // 容量在init_game_context中按游戏池尺寸计算
+            reach->size[keep] += relabel_region(ctx, neighbor, l, keep, queue);
+            label_release(reach, l);
+            arena_restore(&ctx->reach.arena, saved);
+        }
+    }
+}
+
+/**
+ * @brief 按顺时针顺序检查单元格周围的8个单元格，统计互不相连的开放邻居组
+ *
+ * 环上相邻的两个单元格本身就是四邻接的，所以环上连续的一段开放单元格是一条通路，
+ * 落在同一段里的上下左右邻居不经过中心单元格也相互连通。
+ *
+ * @param ctx 游戏上下文
+ * @param index 中心单元格下标（有边框时不在游戏池边缘，8个邻居都不越界；环面布局下邻居回绕）
+ * @param seeds 输出：每组取一个上下左右邻居的下标
+ * @return int 组数（0～4）
+ */
+static int ring_groups(const GameContext *ctx, int index, int seeds[REACH_MAX_SEARCHES])
+{
+    // 从上方开始顺时针：上、右上、右、右下、下、左下、左、左上；偶数位置是上下左右邻居
+    static const int ring_dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    static const int ring_dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    const int w = ctx->pool_width;
+    const int x = ctx->torus ? index % w : 0; // 只有环面布局需要坐标
+    const int y = ctx->torus ? index / w : 0;
+
+    int ring[8];
+    bool open[8];
+    int start = -1;
+    for (int i = 0; i < 8; i++)
+    {
+        ring[i] = ctx->torus ? ctx->wrap_y[y + ring_dy[i] + 1] * w + ctx->wrap_x[x + ring_dx[i] + 1]
+                             : index + ring_dy[i] * w + ring_dx[i];
+        open[i] = CELL_IS_OPEN(ctx->pool[ring[i]]);
+        if (!open[i])
+        {
+            start = i;
+        }
+    }
+
+    if (start < 0)
+    {
+        // 周围全部开放：只有一组
+        seeds[0] = ring[0];
+        return 1;
+    }
+
+    // 从一个关闭的单元格之后开始绕一圈，每段连续开放单元格中取第一个上下左右邻居
+    int groups = 0;
+    bool seeded = false;
+    for (int k = 1; k <= 8; k++)
+    {
+        int i = (start + k) % 8;
+        if (!open[i])
+        {
+            seeded = false;
+        }
+        else if (i % 2 == 0 && !seeded)
+        {
+            seeds[groups++] = ring[i];
+            seeded = true;
+        }
+    }
+    return groups;
+}
+
+/**
+ * @brief 在小型并查集中查找搜索所属的组
+ */
+static int group_find(int *group, int k)
+{
+    while (group[k] != k)
+    {
+        k = group[k];
+    }
+    return k;
+}
+
+/**
+ * @brief 单元格关闭：检查并处理分量分裂
+ *
+ * 局部检查无法排除分裂时，从每组邻居各发起一个广度优先搜索并交替推进一步。
+ * 两个搜索相遇则合并为一组；一组的全部搜索都耗尽时，该组访问过的单元格就是一个完整的分量。
+ * 只剩一组未结束时停止：它保留原编号，其余已结束的组各自分配新编号。
+ */
+static void reach_close(GameContext *ctx, int index)
+{
+    Reachability *reach = &ctx->reach;
+    const int offsets[4] = {-ctx->pool_width, ctx->pool_width, -1, 1};
+    int32_t region = reach->label[index];
+
+    reach->label[index] = -1;
+    reach->size[region]--;
+    if (reach->size[region] == 0)
+    {
+        label_release(reach, region);
+        return;
+    }
+
+    // 开放邻居不超过一个时不可能分裂（蛇头前进时最常见）
+    int open_neighbors = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        open_neighbors += reach->label[neighbor_cell(ctx, index, offsets, d)] >= 0;
+    }
+    if (open_neighbors <= 1)
+    {
+        return;
+    }
+
+    int seeds[REACH_MAX_SEARCHES];
+    int searches = ring_groups(ctx, index, seeds);
+    if (searches <= 1)
+    {
+        return; // 各开放邻居可以绕过该单元格相互到达，不会分裂
+    }
+
+    size_t saved = arena_save(&ctx->reach.arena);
+    size_t capacity = (size_t)reach->size[region];
+    uint32_t epoch = next_epoch(ctx);
+
+    int32_t *queue[REACH_MAX_SEARCHES];
+    int head[REACH_MAX_SEARCHES], tail[REACH_MAX_SEARCHES];
+    int group[REACH_MAX_SEARCHES];
+    bool exhausted[REACH_MAX_SEARCHES];
+    for (int k = 0; k < searches; k++)
+    {
+        queue[k] = (int32_t *)arena_alloc(&ctx->reach.arena, capacity * sizeof(int32_t));
+        assert(queue[k] != NULL); // 容量在reach_reserve中按游戏池尺寸计算
+        queue[k][0] = seeds[k];
+        reach->mark[seeds[k]] = epoch | (uint32_t)k;
+        head[k] = 0;
+        tail[k] = 1;
+        group[k] = k;
+        exhausted[k] = false;
+    }
+
+    // 交替推进各搜索，直到未结束的组不超过一个
+    bool group_done[REACH_MAX_SEARCHES] = {false};
+    int unfinished = searches;
+    while (unfinished > 1)
+    {
+        for (int k = 0; k < searches && unfinished > 1; k++)
+        {
+            if (exhausted[k])
+            {
+                continue;
+            }
+            if (head[k] == tail[k])
+            {
+                // 该搜索耗尽；组内所有搜索都耗尽时该组结束
+                exhausted[k] = true;
+                int root = group_find(group, k);
+                bool all_exhausted = true;
+                for (int j = 0; j < searches; j++)
+                {
+                    all_exhausted &= group_find(group, j) != root || exhausted[j];
+                }
+                if (all_exhausted)
+                {
+                    group_done[root] = true;
+                    unfinished--;
+                }
+                continue;
+            }
+
+            int cell = queue[k][head[k]++];
+            for (int d = 0; d < 4; d++)
+            {
+                int next = neighbor_cell(ctx, cell, offsets, d);
+                if (reach->label[next] != region)
+                {
+                    continue;
+                }
+                uint32_t mark = reach->mark[next];
+                if ((mark & ~3u) != epoch)
+                {
+                    reach->mark[next] = epoch | (uint32_t)k;
+                    queue[k][tail[k]++] = next;
+                }
+                else
+                {
+                    // 与另一个搜索相遇：两组连通，合并
+                    int a = group_find(group, k);
+                    int b = group_find(group, (int)(mark & 3u));
+                    if (a != b)
+                    {
+                        group[b] = a;
+                        unfinished--;
+                    }
+                }
+            }
+        }
+    }
+
+    // 选出保留原编号的组：未结束的组；全部结束时取最大的组
+    int keep = -1;
+    int keep_size = -1;
+    for (int k = 0; k < searches; k++)
+    {
+        if (group_find(group, k) != k)
+        {
+            continue;
+        }
+        if (!group_done[k])
+        {
+            keep = k;
+            break;
+        }
+        int total = 0;
+        for (int j = 0; j < searches; j++)
+        {
+            total += group_find(group, j) == k ? tail[j] : 0;
+        }
+        if (total > keep_size)
+        {
+            keep = k;
+            keep_size = total;
+        }
+    }
+
+    // 其余已结束的组分裂为新分量
+    for (int k = 0; k < searches; k++)
+    {
+        if (group_find(group, k) != k || k == keep)
+        {
+            continue;
+        }
+        int32_t split = label_acquire(reach);
+        for (int j = 0; j < searches; j++)
+        {
+            if (group_find(group, j) != k)
+            {
+                continue;
+            }
+            for (int i = 0; i < tail[j]; i++)
+            {
+                reach->label[queue[j][i]] = split;
+            }
+            reach->size[split] += tail[j];
+            reach->size[region] -= tail[j];
+        }
+    }
+
+    arena_restore(&ctx->reach.arena, saved);
+}
+
+/**
+ * @brief 确保本局的可达区域数组已分配
+ *
+ * 上下文第一次调用时申请后备存储：4个数组加REACH_MAX_SEARCHES个搜索队列，
+ * 按有边框布局的游戏池计算（环面布局更小），此后每局只重新划分，不再申请。
+ *
+ * @return false 堆内存不足
+ */
+static bool reach_reserve(GameContext *ctx)
+{
+    Reachability *reach = &ctx->reach;
+    if (reach->label != NULL)
+    {
+        return true;
+    }
+    if (reach->arena.base == NULL)
+    {
+        int border = ctx->torus ? 2 : 0;
+        size_t max_cells = (size_t)(ctx->pool_width + border) * (size_t)(ctx->pool_height + border);
+        size_t array_bytes = max_cells * sizeof(int32_t) + ARENA_ALIGNMENT;
+        if (!arena_init(&reach->arena, array_bytes * (4 + REACH_MAX_SEARCHES)))
+        {
+            return false;
+        }
+    }
+
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    arena_reset(&reach->arena);
+    reach->label = (int32_t *)arena_alloc(&reach->arena, cell_count * sizeof(int32_t));
+    reach->size = (int32_t *)arena_alloc(&reach->arena, cell_count * sizeof(int32_t));
+    reach->free_labels = (int32_t *)arena_alloc(&reach->arena, cell_count * sizeof(int32_t));
+    reach->mark = (uint32_t *)arena_alloc(&reach->arena, cell_count * sizeof(uint32_t));
+    assert(reach->label != NULL && reach->size != NULL && reach->free_labels != NULL && reach->mark != NULL);
+    memset(reach->mark, 0, cell_count * sizeof(uint32_t));
+    reach->epoch = 0;
+    return true;
+}
+
+/**
+ * @brief 重新计算全部分量
+ *
+ * 每局第一次查询时自动调用，此后由set_cell_type增量维护。
+ *
+ * @param ctx 游戏上下文
+ * @return false 堆内存不足（可达区域保持未建立）
+ */
+bool reach_rebuild(GameContext *ctx)
+{
+    Reachability *reach = &ctx->reach;
+    int cell_count = ctx->pool_width * ctx->pool_height;
+    if (!reach_reserve(ctx))
+    {
+        return false;
+    }
+
+    // 编号按从小到大的顺序出栈
+    reach->free_count = cell_count;
+    for (int i = 0; i < cell_count; i++)
+    {
+        reach->label[i] = -1;
+        reach->size[i] = 0;
+        reach->free_labels[i] = cell_count - 1 - i;
+    }
+    memset(reach->mark, 0, (size_t)cell_count * sizeof(uint32_t));
+    reach->epoch = 0;
+
+    size_t saved = arena_save(&ctx->reach.arena);
+    int32_t *queue = (int32_t *)arena_alloc(&ctx->reach.arena, (size_t)cell_count * sizeof(int32_t));
+    assert(queue != NULL);
+    for (int i = 0; i < cell_count; i++)
+    {
+        if (reach->label[i] == -1 && CELL_IS_OPEN(ctx->pool[i]))
+        {
+            int32_t l = label_acquire(reach);
+            reach->size[l] = relabel_region(ctx, i, -1, l, queue);
+        }
+    }
+    arena_restore(&ctx->reach.arena, saved);
+    reach->ready = true;
+    return true;
+}
+
+/**
+ * @brief 单元格开放状态改变后更新分量（由set_cell_type调用）
+ *
+ * 有边框时开放状态会改变的单元格都不在边缘，访问上下左右邻居无需越界检查；环面布局下邻居回绕。
+ *
+ * @param ctx 游戏上下文
+ * @param index 单元格下标
+ * @param now_open 单元格现在是否开放
+ */
+void reach_cell_changed(GameContext *ctx, int index, bool now_open)
+{
+    if (now_open)
+    {
+        reach_open(ctx, index);
+    }
+    else
+    {
+        reach_close(ctx, index);
+    }
+}
+
+// =============================================
+// 查询
+// =============================================
+
+/**
+ * @brief 查询单元格所在可达区域的大小（O(1)）
+ *
+ * 本局第一次查询时先建立全部分量（O(游戏池单元格数)）。
+ *
+ * @param ctx 游戏上下文
+ * @param pos 单元格位置
+ * @return int 该单元格所在连通分量的单元格数，非开放单元格（以及无法建立可达区域时）返回0
+ */
+int reach_region_size(GameContext *ctx, Position pos)
+{
+    if (!index_is_open(ctx, pos.x, pos.y) || (!ctx->reach.ready && !reach_rebuild(ctx)))
+    {
+        return 0;
+    }
+    return ctx->reach.size[ctx->reach.label[pos.y * ctx->pool_width + pos.x]];
+}
+
+/**
+ * @brief 判断两个单元格是否相互可达（O(1)，本局第一次查询时先建立全部分量）
+ *
+ * @return true 两个单元格都开放且属于同一连通分量（无法建立可达区域时返回false）
+ */
+bool reach_connected(GameContext *ctx, Position a, Position b)
+{
+    if (!index_is_open(ctx, a.x, a.y) || !index_is_open(ctx, b.x, b.y) ||
+        (!ctx->reach.ready && !reach_rebuild(ctx)))
+    {
+        return false;
+    }
+    return ctx->reach.label[a.y * ctx->pool_width + a.x] == ctx->reach.label[b.y * ctx->pool_width + b.x];
+}
+
+/**
+ * @brief 洪水填充计算可达区域大小（参考实现）
+ *
+ * 每次调用遍历整个分量，只用于校验增量结果；标记和队列使用可达区域的内存区域（不要求已建立）。
+ *
+ * @param ctx 游戏上下文
+ * @param pos 起点
+ * @return int 从起点出发能到达的开放单元格数，起点不开放（或堆内存不足）时返回0
+ */
+int reach_flood_fill(GameContext *ctx, Position pos)
+{
+    if (!index_is_open(ctx, pos.x, pos.y) || !reach_reserve(ctx))
+    {
+        return 0;
+    }
+
+    const int offsets[4] = {-ctx->pool_width, ctx->pool_width, -1, 1};
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    size_t saved = arena_save(&ctx->reach.arena);
+    int32_t *queue = (int32_t *)arena_alloc(&ctx->reach.arena, cell_count * sizeof(int32_t));
+    assert(queue != NULL);
+
+    uint32_t epoch = next_epoch(ctx);
+    int start = pos.y * ctx->pool_width + pos.x;
+    int head = 0, tail = 0;
+    ctx->reach.mark[start] = epoch;
+    queue[tail++] = start;
+    while (head < tail)
+    {
+        int cell = queue[head++];
+        for (int d = 0; d < 4; d++)
+        {
+            int next = neighbor_cell(ctx, cell, offsets, d);
+            if (CELL_IS_OPEN(ctx->pool[next]) && ctx->reach.mark[next] != epoch)
+            {
+                ctx->reach.mark[next] = epoch;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    arena_restore(&ctx->reach.arena, saved);
+    return tail;
+}
@@ -0,0 +1,470 @@
+/**
+ * @file snake_render.c
+ * @brief 渲染查找表与帧合成实现
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_render.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define ATTR_WHITE (ATTR_FG_RED | ATTR_FG_GREEN | ATTR_FG_BLUE) ///< 白色前景
+
+// 蛇身四个方向共用同一个字形
+#define BODY_GLYPH {{0x86C7}, 1, "\xE8\x9B\x87", 3, ATTR_FG_GREEN} ///< "蛇"
+
+/**
+ * @brief 单元格字形表
+ *
+ * 下标为CELL_HASH(单元格类型)，未使用的下标保持全0（不会被访问）。
+ */
+const CellGlyph cell_glyphs[CELL_HASH_SIZE] = {
+    [CELL_HASH(CELL_EMPTY)] = {{0x0020, 0x0020}, 2, "  ", 2, ATTR_WHITE},
+    [CELL_HASH(CELL_FOOD)] = {{0x2605}, 1, "\xE2\x98\x85", 3, ATTR_FG_RED | ATTR_FG_INTENSITY},        // "★"
+    [CELL_HASH(CELL_SNAKE_HEAD)] = {{0x5934}, 1, "\xE5\xA4\xB4", 3, ATTR_FG_GREEN | ATTR_FG_INTENSITY}, // "头"
+    [CELL_HASH(CELL_SNAKE_BODY_UP)] = BODY_GLYPH,
+    [CELL_HASH(CELL_SNAKE_BODY_DOWN)] = BODY_GLYPH,
+    [CELL_HASH(CELL_SNAKE_BODY_LEFT)] = BODY_GLYPH,
+    [CELL_HASH(CELL_SNAKE_BODY_RIGHT)] = BODY_GLYPH,
+    [CELL_HASH(CELL_SNAKE_TAIL)] = {{0x5C3E}, 1, "\xE5\xB0\xBE", 3, ATTR_FG_GREEN}, // "尾"
+    // "墙"：白底黑字（前景色为0表示黑色）
+    [CELL_HASH(CELL_WALL)] = {{0x5899}, 1, "\xE5\xA2\x99", 3, ATTR_BG_RED | ATTR_BG_GREEN | ATTR_BG_BLUE | ATTR_BG_INTENSITY},
+};
+
+/**
+ * @brief 两位数字表："00"、"01"……"99"，每次转换两位
+ */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// =============================================
+// 全局变量
+// =============================================
+
+static AnsiSgr sgr_table[ATTR_COUNT]; ///< 控制台属性 → ANSI颜色序列
+static bool sgr_table_ready = false;  ///< 颜色序列表是否已生成
+
+// =============================================
+// 查找表
+// =============================================
+
+/**
+ * @brief 生成颜色序列表（只在启动时执行一次）
+ *
+ * 控制台属性的颜色位顺序是蓝、绿、红，ANSI颜色编号的位顺序是红、绿、蓝，需要交换第0位和第2位。
+ * 每个序列先重置属性再设置前景和背景，例如白底黑字为"\x1b[0;30;107m"。
+ */
+void render_init(void)
+{
+    if (sgr_table_ready)
+    {
+        return;
+    }
+
+    for (int attr = 0; attr < ATTR_COUNT; attr++)
+    {
+        int fg = ((attr & 1) << 2) | (attr & 2) | ((attr & 4) >> 2);
+        int bg = ((attr & 0x10) >> 2) | ((attr & 0x20) >> 4) | ((attr & 0x40) >> 6);
+        int fg_code = (attr & ATTR_FG_INTENSITY ? 90 : 30) + fg;
+        int bg_code = (attr & ATTR_BG_INTENSITY ? 100 : 40) + bg;
+
+        AnsiSgr *sgr = &sgr_table[attr];
+        char *p = sgr->bytes;
+        memcpy(p, "\x1b[0;", 4);
+        p += 4;
+        p += format_decimal(p, fg_code);
+        *p++ = ';';
+        p += format_decimal(p, bg_code);
+        *p++ = 'm';
+        sgr->length = (uint8_t)(p - sgr->bytes);
+    }
+    sgr_table_ready = true;
+}
+
+/**
+ * @brief 取得控制台属性对应的ANSI颜色序列
+ *
+ * @param attributes 控制台属性（只使用低8位颜色位）
+ * @return const AnsiSgr* 颜色序列（render_init之后有效）
+ */
+const AnsiSgr *ansi_sgr(uint16_t attributes)
+{
+    assert(sgr_table_ready);
+    return &sgr_table[attributes & (ATTR_COUNT - 1)];
+}
+
+/**
+ * @brief 把整数转换为十进制文本（不经过printf）
+ *
+ * 从低位开始每次查两位数字表，结果不以'\0'结尾。
+ *
+ * @param out 输出缓冲区（至少NUMBER_MAX_DIGITS字节）
+ * @param value 整数
+ * @return int 写入的字符数
+ */
+int format_decimal(char *out, int value)
+{
+    char buffer[NUMBER_MAX_DIGITS];
+    char *p = buffer + sizeof(buffer);
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    while (v >= 100)
+    {
+        unsigned int pair = (v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (v >= 10)
+    {
+        *--p = digit_pairs[v * 2 + 1];
+        *--p = digit_pairs[v * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+
+    int length = (int)(buffer + sizeof(buffer) - p);
+    memcpy(out, p, (size_t)length);
+    return length;
+}
+
+/**
+ * @brief 取得整数的文本（带缓存）
+ *
+ * 命中缓存时直接返回上次的转换结果；未命中时转换一次并覆盖对应缓存项。
+ * 返回的指针在同一缓存项被覆盖前有效。
+ *
+ * @param cache 数字文本缓存（初始全0即为空缓存）
+ * @param value 整数
+ * @return const NumberText* 文本
+ */
+const NumberText *number_text(NumberCache *cache, int value)
+{
+    unsigned int slot = ((unsigned int)value * 2654435761u) >> 28; // 乘法散列取高4位
+    NumberText *entry = &cache->entries[slot % NUMBER_CACHE_SIZE];
+
+    if (!entry->valid || entry->value != value)
+    {
+        entry->length = (uint8_t)format_decimal(entry->utf8, value);
+        for (int i = 0; i < entry->length; i++)
+        {
+            entry->utf16[i] = (uint16_t)entry->utf8[i];
+        }
+        entry->value = value;
+        entry->valid = true;
+    }
+    return entry;
+}
+
+// =============================================
+// 帧缓冲
+// =============================================
+
+/**
+ * @brief 初始化帧缓冲（同时生成颜色序列表）
+ *
+ * @param frame 帧缓冲
+ * @param capacity 容量（字节），应不小于一帧的最大输出
+ * @return true 初始化成功
+ * @return false 堆内存不足
+ */
+bool frame_init(Frame *frame, size_t capacity)
+{
+    render_init();
+    frame->data = (char *)heap_alloc(capacity);
+    frame->length = 0;
+    frame->capacity = frame->data != NULL ? capacity : 0;
+    frame->attributes = -1;
+    return frame->data != NULL;
+}
+
+/**
+ * @brief 销毁帧缓冲
+ */
+void frame_destroy(Frame *frame)
+{
+    free(frame->data);
+    frame->data = NULL;
+    frame->length = 0;
+    frame->capacity = 0;
+}
+
+/**
+ * @brief 清空帧缓冲（写出之后调用），当前颜色保持不变
+ */
+void frame_reset(Frame *frame)
+{
+    frame->length = 0;
+}
+
+/**
+ * @brief 帧缓冲剩余容量（字节）
+ */
+size_t frame_available(const Frame *frame)
+{
+    return frame->capacity - frame->length;
+}
+
+/**
+ * @brief 追加字节
+ *
+ * 调用方负责通过frame_available保证容量足够，超出部分被丢弃。
+ */
+void frame_put(Frame *frame, const char *bytes, size_t length)
+{
+    assert(length <= frame_available(frame));
+    if (length > frame_available(frame))
+    {
+        length = frame_available(frame);
+    }
+    memcpy(frame->data + frame->length, bytes, length);
+    frame->length += length;
+}
+
+/**
+ * @brief 追加光标移动序列（"\x1b[行;列H"，行列从1开始）
+ *
+ * @param frame 帧缓冲
+ * @param column 列（从0开始，按半角字符计）
+ * @param row 行（从0开始）
+ */
+void frame_move_to(Frame *frame, int column, int row)
+{
+    char sequence[2 + NUMBER_MAX_DIGITS * 2 + 2];
+    char *p = sequence;
+    *p++ = '\x1b';
+    *p++ = '[';
+    p += format_decimal(p, row + 1);
+    *p++ = ';';
+    p += format_decimal(p, column + 1);
+    *p++ = 'H';
+    frame_put(frame, sequence, (size_t)(p - sequence));
+}
+
+/**
+ * @brief 切换颜色（与当前颜色相同时不输出）
+ */
+void frame_set_attributes(Frame *frame, uint16_t attributes)
+{
+    int attr = attributes & (ATTR_COUNT - 1);
+    if (attr != frame->attributes)
+    {
+        const AnsiSgr *sgr = ansi_sgr((uint16_t)attr);
+        frame_put(frame, sgr->bytes, sgr->length);
+        frame->attributes = attr;
+    }
+}
+
+/**
+ * @brief 追加一个单元格字形（颜色 + UTF-8文字）
+ */
+void frame_put_glyph(Frame *frame, const CellGlyph *glyph)
+{
+    frame_set_attributes(frame, glyph->attributes);
+    frame_put(frame, glyph->utf8, glyph->utf8_length);
+}
+
+// =============================================
+// 视口
+// =============================================
+
+/**
+ * @brief 视口沿一个方向跟随目标，返回新的起点
+ *
+ * 目标进入两侧边距时视口才移动，且只移动到目标刚好回到边距以内，
+ * 蛇头在视口中部移动时画面保持不动。
+ *
+ * @param origin 当前起点
+ * @param target 目标坐标（格）
+ * @param view 视口边长（格数）
+ * @param grid 网格边长（格数）
+ * @param wrap 网格是否回绕（环面布局）
+ */
+static int follow_axis(int origin, int target, int view, int grid, bool wrap)
+{
+    if (grid <= view)
+    {
+        return 0;
+    }
+
+    int margin = view / CAMERA_MARGIN_RATIO;
+    int offset = target - origin;
+    if (wrap)
+    {
+        offset = (offset % grid + grid) % grid;
+    }
+    if (offset < margin)
+    {
+        origin = target - margin;
+    }
+    else if (offset >= view - margin)
+    {
+        origin = target - view + margin + 1;
+    }
+
+    if (wrap)
+    {
+        return (origin % grid + grid) % grid;
+    }
+    return origin < 0 ? 0 : origin > grid - view ? grid - view : origin;
+}
+
+/**
+ * @brief 初始化视口（正常显示，第一帧重绘整个视口）
+ *
+ * @param camera 视口
+ * @param width 视口宽度（格数）
+ * @param height 视口高度（格数）
+ */
+void camera_init(Camera *camera, int width, int height)
+{
+    memset(camera, 0, sizeof(*camera));
+    camera->width = width;
+    camera->height = height;
+    camera->redraw = true;
+}
+
+/**
+ * @brief 在正常显示和缩小显示之间切换
+ */
+void camera_toggle_zoom(Camera *camera)
+{
+    // 视口起点换算到新的网格，缩放前后显示的大致是同一片区域
+    if (camera->shift == 0)
+    {
+        camera->shift = BLOCK_SHIFT;
+        camera->x >>= BLOCK_SHIFT;
+        camera->y >>= BLOCK_SHIFT;
+    }
+    else
+    {
+        camera->shift = 0;
+        camera->x <<= BLOCK_SHIFT;
+        camera->y <<= BLOCK_SHIFT;
+    }
+    camera->redraw = true;
+}
+
+/**
+ * @brief 移动视口使蛇头保持在视口内
+ *
+ * 缩小显示时按需建立分块占用摘要（每局第一次缩小显示时扫描一次游戏池）。
+ * 只计算视口位置，代价与游戏池大小无关。
+ *
+ * @param camera 视口
+ * @param ctx 游戏上下文
+ * @return true 视口移动、缩放改变或网格改变，需要重绘整个视口
+ * @return false 只需要绘制视口内的脏格
+ */
+bool camera_follow(Camera *camera, GameContext *ctx)
+{
+    bool redraw = camera->redraw;
+    camera->redraw = false;
+
+    int grid_width = ctx->pool_width;
+    int grid_height = ctx->pool_height;
+    if (camera->shift > 0)
+    {
+        if (!ctx->lod.ready)
+        {
+            block_summary_rebuild(ctx);
+            redraw = true;
+        }
+        grid_width = ctx->lod.blocks_x;
+        grid_height = ctx->lod.blocks_y;
+    }
+
+    Position head = ctx->game.snake.head;
+    int x = follow_axis(camera->x, head.x >> camera->shift, camera->width, grid_width, ctx->torus);
+    int y = follow_axis(camera->y, head.y >> camera->shift, camera->height, grid_height, ctx->torus);
+    int columns = grid_width < camera->width ? grid_width : camera->width;
+    int rows = grid_height < camera->height ? grid_height : camera->height;
+
+    if (x != camera->x || y != camera->y || columns != camera->columns || rows != camera->rows)
+    {
+        redraw = true;
+    }
+    camera->x = x;
+    camera->y = y;
+    camera->columns = columns;
+    camera->rows = rows;
+    return redraw;
+}
+
+/**
+ * @brief 视口中的一格 → 网格坐标（正常显示时为单元格坐标，缩小显示时为块坐标）
+ *
+ * @param camera 视口（camera_follow之后）
+ * @param ctx 游戏上下文
+ * @param column 视口中的列（小于camera->columns）
+ * @param row 视口中的行（小于camera->rows）
+ */
+Position camera_cell(const Camera *camera, const GameContext *ctx, int column, int row)
+{
+    int grid_width = camera->shift > 0 ? ctx->lod.blocks_x : ctx->pool_width;
+    int grid_height = camera->shift > 0 ? ctx->lod.blocks_y : ctx->pool_height;
+    Position cell = {camera->x + column, camera->y + row};
+    // 只有环面布局会越过网格边缘（有边框的布局下视口总在网格内）
+    if (cell.x >= grid_width)
+    {
+        cell.x -= grid_width;
+    }
+    if (cell.y >= grid_height)
+    {
+        cell.y -= grid_height;
+    }
+    return cell;
+}
+
+/**
+ * @brief 缩小显示时一个块的字形：蛇头 > 蛇 > 食物 > 墙壁 > 空
+ *
+ * 只读块的计数（分块占用摘要必须已建立），与块内单元格数无关。
+ *
+ * @param ctx 游戏上下文
+ * @param block 块坐标
+ */
+const CellGlyph *block_glyph(const GameContext *ctx, Position block)
+{
+    const BlockCounts *counts = &ctx->lod.blocks[block.y * ctx->lod.blocks_x + block.x];
+    Position head = ctx->game.snake.head;
+    if ((head.x >> BLOCK_SHIFT) == block.x && (head.y >> BLOCK_SHIFT) == block.y)
+    {
+        return CELL_GLYPH(CELL_SNAKE_HEAD);
+    }
+    if (counts->snake > 0)
+    {
+        return CELL_GLYPH(CELL_SNAKE_BODY_UP);
+    }
+    if (counts->food > 0)
+    {
+        return CELL_GLYPH(CELL_FOOD);
+    }
+    if (counts->wall > 0)
+    {
+        return CELL_GLYPH(CELL_WALL);
+    }
+    return CELL_GLYPH(CELL_EMPTY);
+}
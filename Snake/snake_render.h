@@ -0,0 +1,175 @@
+/**
+ * @file snake_render.h
+ * @brief 渲染查找表与帧合成
+ *
+ * 与平台无关的渲染辅助：
+ * - 单元格字形表：按CELL_HASH下标直接取得预先编码好的UTF-16/UTF-8字形、控制台属性和ANSI颜色序列
+ * - 属性 → ANSI SGR序列表：控制台属性（FOREGROUND_*和BACKGROUND_*的组合）对应的颜色转义序列
+ * - 数字文本缓存：分数、速度等数字只在变化时转换一次，转换本身也只查两位数字表
+ * - 帧缓冲：把一帧内所有光标移动、颜色和文字拼接成一个字节串，一次写出
+ * - 视口：跟随蛇头的固定大小窗口，可缩小为每格显示一个8×8的块（见snake_blocks.c），
+ *   绘制代价只取决于视口大小，与游戏池大小无关
+ *
+ * 每帧的绘制只做查表和memcpy，不经过printf系列的格式解析。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_RENDER_H
+#define SNAKE_RENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+// 控制台属性位（取值与Windows的FOREGROUND_*/BACKGROUND_*相同，可直接作为WORD使用）
+#define ATTR_FG_BLUE 0x0001      ///< 前景蓝色
+#define ATTR_FG_GREEN 0x0002     ///< 前景绿色
+#define ATTR_FG_RED 0x0004       ///< 前景红色
+#define ATTR_FG_INTENSITY 0x0008 ///< 前景高亮
+#define ATTR_BG_BLUE 0x0010      ///< 背景蓝色
+#define ATTR_BG_GREEN 0x0020     ///< 背景绿色
+#define ATTR_BG_RED 0x0040       ///< 背景红色
+#define ATTR_BG_INTENSITY 0x0080 ///< 背景高亮
+#define ATTR_COUNT 256           ///< 颜色属性组合数（低8位）
+
+#define GLYPH_MAX_UTF16 2    ///< 字形最大UTF-16单元数
+#define GLYPH_MAX_UTF8 6     ///< 字形最大UTF-8字节数
+#define SGR_MAX_LENGTH 16    ///< ANSI颜色序列最大长度（如"\x1b[0;97;107m"）
+#define NUMBER_MAX_DIGITS 11 ///< 十进制整数最大字符数（含负号）
+#define NUMBER_CACHE_SIZE 16 ///< 数字文本缓存项数（直接映射）
+
+// 视口常量
+#define CAMERA_MARGIN_RATIO 4 ///< 视口边距为视口边长的1/4：蛇头进入边距时视口才移动
+
+// 每个单元格在帧缓冲中最多占用的字节数：光标移动 + 颜色 + 字形
+#define FRAME_BYTES_PER_CELL (16 + SGR_MAX_LENGTH + GLYPH_MAX_UTF8)
+
+/**
+ * @struct CellGlyph
+ * @brief 单元格字形（预先编码）
+ *
+ * 每个字形在控制台中占两列（一个全角字符或两个空格）。
+ */
+typedef struct
+{
+    uint16_t utf16[GLYPH_MAX_UTF16]; ///< UTF-16编码（Windows WriteConsoleW）
+    uint8_t utf16_length;            ///< UTF-16单元数
+    char utf8[GLYPH_MAX_UTF8];       ///< UTF-8编码（ANSI终端）
+    uint8_t utf8_length;             ///< UTF-8字节数
+    uint16_t attributes;             ///< 控制台属性（ATTR_*组合）
+} CellGlyph;
+
+/**
+ * @struct AnsiSgr
+ * @brief 一个控制台属性对应的ANSI颜色序列
+ */
+typedef struct
+{
+    char bytes[SGR_MAX_LENGTH]; ///< 转义序列
+    uint8_t length;             ///< 序列长度
+} AnsiSgr;
+
+/**
+ * @struct NumberText
+ * @brief 整数的十进制文本（同时保存ASCII/UTF-8和UTF-16形式）
+ */
+typedef struct
+{
+    int value;                         ///< 数值
+    bool valid;                        ///< 缓存项是否有效
+    uint8_t length;                    ///< 字符数
+    char utf8[NUMBER_MAX_DIGITS];      ///< ASCII数字（也是合法的UTF-8）
+    uint16_t utf16[NUMBER_MAX_DIGITS]; ///< UTF-16数字
+} NumberText;
+
+/**
+ * @struct NumberCache
+ * @brief 数字文本缓存（按数值直接映射）
+ *
+ * 分数、速度和最高分的取值范围很小且反复出现（每局从0分开始），命中时不做任何转换。
+ */
+typedef struct
+{
+    NumberText entries[NUMBER_CACHE_SIZE]; ///< 缓存项
+} NumberCache;
+
+/**
+ * @struct Frame
+ * @brief ANSI帧缓冲
+ *
+ * 一帧的全部输出（光标移动、颜色、UTF-8文字）依次追加到缓冲区，绘制结束后一次写出。
+ * 记住当前颜色，颜色不变时不重复输出颜色序列。
+ */
+typedef struct
+{
+    char *data;      ///< 缓冲区
+    size_t length;   ///< 已写入字节数
+    size_t capacity; ///< 缓冲区容量
+    int attributes;  ///< 当前颜色属性（-1表示未知，下一次必须输出颜色序列）
+} Frame;
+
+/**
+ * @struct Camera
+ * @brief 视口
+ *
+ * 视口以格为单位：正常显示时一格是一个单元格，缩小显示时一格是一个摘要块。
+ * 网格比视口小时不滚动，只显示整个网格；环面布局下视口可以跨过边缘回绕。
+ */
+typedef struct
+{
+    int width;   ///< 视口宽度（格数）
+    int height;  ///< 视口高度（格数）
+    int shift;   ///< 每格边长的对数：0为正常显示，BLOCK_SHIFT为缩小显示
+    int x;       ///< 视口左上角在网格中的列
+    int y;       ///< 视口左上角在网格中的行
+    int columns; ///< 实际显示的列数（不超过网格宽度）
+    int rows;    ///< 实际显示的行数（不超过网格高度）
+    bool redraw; ///< 下一帧必须重绘整个视口
+} Camera;
+
+// =============================================
+// 全局变量
+// =============================================
+
+extern const CellGlyph cell_glyphs[CELL_HASH_SIZE]; ///< 单元格字形表（按CELL_HASH下标）
+
+/**
+ * @brief 取得单元格类型对应的字形
+ */
+#define CELL_GLYPH(cell) (&cell_glyphs[CELL_HASH(cell)])
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+// 查找表
+void render_init(void);
+const AnsiSgr *ansi_sgr(uint16_t attributes);
+int format_decimal(char *out, int value);
+const NumberText *number_text(NumberCache *cache, int value);
+
+// 帧缓冲
+bool frame_init(Frame *frame, size_t capacity);
+void frame_destroy(Frame *frame);
+void frame_reset(Frame *frame);
+size_t frame_available(const Frame *frame);
+void frame_move_to(Frame *frame, int column, int row);
+void frame_set_attributes(Frame *frame, uint16_t attributes);
+void frame_put(Frame *frame, const char *bytes, size_t length);
+void frame_put_glyph(Frame *frame, const CellGlyph *glyph);
+
+// 视口
+void camera_init(Camera *camera, int width, int height);
+void camera_toggle_zoom(Camera *camera);
+bool camera_follow(Camera *camera, GameContext *ctx);
+Position camera_cell(const Camera *camera, const GameContext *ctx, int column, int row);
+const CellGlyph *block_glyph(const GameContext *ctx, Position block);
+
+#endif // SNAKE_RENDER_H
@@ -0,0 +1,428 @@
+/**
+ * @file snake_replay.c
+ * @brief 对局录像实现
+ *
+ * 录制：每帧把生效的方向追加到打包的缓冲区（容量不够时加倍），一局结束后连同记录头一次写出。
+ * 读取：整个文件只读映射（Windows为MapViewOfFile，其他平台为mmap），记录头逐字段解析，
+ * 方向直接引用映射中的字节，重新模拟时按需读取，不复制也不解码。
+ *
+ * 编码: UTF-8
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "snake_replay.h"
+#include "snake_rules.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define REPLAY_MAGIC_LENGTH 8 ///< 魔数长度
+#define REPLAY_RULE_FIELDS 9  ///< 记录头中规则的字段数
+
+// =============================================
+// 辅助函数
+// =============================================
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+/**
+ * @brief 一局记录的总字节数（记录头 + 打包的方向 + 对齐补零）
+ */
+static size_t record_size(uint32_t ticks)
+{
+    size_t size = REPLAY_HEADER_SIZE + ((size_t)ticks + 3) / 4;
+    return (size + REPLAY_RECORD_ALIGNMENT - 1) / REPLAY_RECORD_ALIGNMENT * REPLAY_RECORD_ALIGNMENT;
+}
+
+// =============================================
+// 录制
+// =============================================
+
+/**
+ * @brief 初始化录制器（不分配内存，第一次begin时分配缓冲区）
+ */
+void replay_recorder_init(ReplayRecorder *recorder)
+{
+    memset(recorder, 0, sizeof(*recorder));
+}
+
+/**
+ * @brief 释放录制器的缓冲区
+ */
+void replay_recorder_destroy(ReplayRecorder *recorder)
+{
+    free(recorder->moves);
+    recorder->moves = NULL;
+    recorder->capacity = 0;
+}
+
+/**
+ * @brief 开始录制一局（在init_game_state(ctx, seed)之后、第一帧之前调用）
+ *
+ * 游戏区域尺寸和规则取自ctx。从存档加载的游戏不能录制（开局状态无法由种子复现）。
+ *
+ * @param recorder 录制器
+ * @param ctx 刚刚开局的游戏上下文
+ * @param seed 开局使用的随机数种子
+ */
+void replay_recorder_begin(ReplayRecorder *recorder, const GameContext *ctx, uint64_t seed)
+{
+    int border = ctx->torus ? 0 : 2;
+    recorder->info.width = ctx->pool_width - border;
+    recorder->info.height = ctx->pool_height - border;
+    recorder->info.seed = seed;
+    recorder->info.rules = ctx->rules;
+    recorder->info.ticks = 0;
+    recorder->info.score = 0;
+    recorder->info.death = DEATH_NONE;
+}
+
+/**
+ * @brief 记录一帧（在该帧的update_game之前调用；游戏已结束时不记录）
+ *
+ * @return false 内存不足或帧数超过上限（这一帧没有记录）
+ */
+bool replay_recorder_tick(ReplayRecorder *recorder, const GameContext *ctx)
+{
+    if (ctx->game.game_over)
+    {
+        return true;
+    }
+    uint32_t tick = recorder->info.ticks;
+    if (tick == UINT32_MAX)
+    {
+        return false;
+    }
+    size_t byte = tick >> 2;
+    if (byte >= recorder->capacity)
+    {
+        size_t capacity = recorder->capacity > 0 ? recorder->capacity * 2 : REPLAY_INITIAL_CAPACITY;
+        uint8_t *moves = (uint8_t *)heap_alloc(capacity);
+        if (moves == NULL)
+        {
+            return false;
+        }
+        if (recorder->moves != NULL)
+        {
+            memcpy(moves, recorder->moves, recorder->capacity);
+            free(recorder->moves);
+        }
+        recorder->moves = moves;
+        recorder->capacity = capacity;
+    }
+
+    unsigned int shift = (tick & 3u) * 2u;
+    if (shift == 0)
+    {
+        recorder->moves[byte] = 0;
+    }
+    recorder->moves[byte] |= (uint8_t)((unsigned int)ctx->game.snake.next_direction << shift);
+    recorder->info.ticks = tick + 1;
+    return true;
+}
+
+/**
+ * @brief 把录制的一局追加写入文件（得分和结束原因取自ctx的当前状态）
+ *
+ * @param recorder 录制器
+ * @param ctx 游戏上下文
+ * @param file 以二进制方式打开的输出文件
+ * @return ReplayStatus 写出结果
+ */
+ReplayStatus replay_recorder_write(ReplayRecorder *recorder, const GameContext *ctx, FILE *file)
+{
+    ReplayInfo *info = &recorder->info;
+    info->score = ctx->game.score;
+    info->death = ctx->game.death;
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, REPLAY_MAGIC, REPLAY_MAGIC_LENGTH);
+    put_u32(header + 8, REPLAY_VERSION);
+    put_u32(header + 12, REPLAY_HEADER_SIZE);
+    put_u32(header + 16, (uint32_t)info->width);
+    put_u32(header + 20, (uint32_t)info->height);
+    put_u64(header + 24, info->seed);
+    put_u32(header + 32, info->ticks);
+    put_u32(header + 36, (uint32_t)info->score);
+    header[40] = (unsigned char)info->death;
+    const Ruleset *rules = &info->rules;
+    const int32_t fields[REPLAY_RULE_FIELDS] = {
+        rules->food_score, rules->growth, rules->food_count, rules->obstacles, rules->wrap ? 1 : 0,
+        rules->initial_speed, rules->speed_step, rules->speed_interval, rules->min_speed};
+    for (int i = 0; i < REPLAY_RULE_FIELDS; i++)
+    {
+        put_u32(header + 44 + i * 4, (uint32_t)fields[i]);
+    }
+
+    static const uint8_t padding[REPLAY_RECORD_ALIGNMENT] = {0};
+    size_t move_bytes = ((size_t)info->ticks + 3) / 4;
+    size_t pad = record_size(info->ticks) - REPLAY_HEADER_SIZE - move_bytes;
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+        (move_bytes > 0 && fwrite(recorder->moves, 1, move_bytes, file) != move_bytes) ||
+        (pad > 0 && fwrite(padding, 1, pad, file) != pad))
+    {
+        return REPLAY_ERROR_IO;
+    }
+    return REPLAY_OK;
+}
+
+// =============================================
+// 读取
+// =============================================
+
+/**
+ * @brief 只读映射整个录像文件
+ *
+ * @param path 文件路径
+ * @param file 输出：映射（空文件的data为NULL、size为0）
+ * @return ReplayStatus 映射结果
+ */
+ReplayStatus replay_file_open(const char *path, ReplayFile *file)
+{
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return REPLAY_ERROR_IO;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || (uint64_t)size.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(handle);
+        return REPLAY_ERROR_IO;
+    }
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(handle); // 空文件不能映射，按没有记录处理
+        return REPLAY_OK;
+    }
+    HANDLE object = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle); // 文件映射对象持有文件的引用
+    if (object == NULL)
+    {
+        return REPLAY_ERROR_IO;
+    }
+    void *view = MapViewOfFile(object, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(object);
+        return REPLAY_ERROR_IO;
+    }
+    file->data = (const uint8_t *)view;
+    file->size = (size_t)size.QuadPart;
+    file->handle = object;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return REPLAY_ERROR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        close(fd);
+        return REPLAY_ERROR_IO;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd); // 空文件不能映射，按没有记录处理
+        return REPLAY_OK;
+    }
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 映射持有文件的引用
+    if (view == MAP_FAILED)
+    {
+        return REPLAY_ERROR_IO;
+    }
+    file->data = (const uint8_t *)view;
+    file->size = (size_t)st.st_size;
+#endif
+    return REPLAY_OK;
+}
+
+/**
+ * @brief 解除录像文件的映射
+ */
+void replay_file_close(ReplayFile *file)
+{
+    if (file->data != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile((void *)file->data);
+        CloseHandle((HANDLE)file->handle);
+#else
+        munmap((void *)file->data, file->size);
+#endif
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+/**
+ * @brief 读取offset处的一局记录，并把offset移到下一局
+ *
+ * @param file 录像文件
+ * @param offset 输入输出：记录在文件中的偏移（从0开始）
+ * @param info 输出：开局参数和录制结果
+ * @param moves 输出：指向映射中打包的方向（用REPLAY_MOVE读取）
+ * @return ReplayStatus REPLAY_OK，读完时为REPLAY_END，记录不合法时为错误（offset不变）
+ */
+ReplayStatus replay_file_next(const ReplayFile *file, size_t *offset, ReplayInfo *info, const uint8_t **moves)
+{
+    if (*offset >= file->size)
+    {
+        return REPLAY_END;
+    }
+    if (file->size - *offset < REPLAY_HEADER_SIZE)
+    {
+        return REPLAY_ERROR_FORMAT;
+    }
+    const unsigned char *header = file->data + *offset;
+    if (memcmp(header, REPLAY_MAGIC, REPLAY_MAGIC_LENGTH) != 0)
+    {
+        return REPLAY_ERROR_FORMAT;
+    }
+    if (get_u32(header + 8) != REPLAY_VERSION)
+    {
+        return REPLAY_ERROR_VERSION;
+    }
+
+    uint32_t width = get_u32(header + 16);
+    uint32_t height = get_u32(header + 20);
+    int32_t fields[REPLAY_RULE_FIELDS];
+    for (int i = 0; i < REPLAY_RULE_FIELDS; i++)
+    {
+        fields[i] = (int32_t)get_u32(header + 44 + i * 4);
+    }
+    Ruleset rules;
+    rules.food_score = fields[0];
+    rules.growth = fields[1];
+    rules.food_count = fields[2];
+    rules.obstacles = fields[3];
+    rules.wrap = fields[4] != 0;
+    rules.initial_speed = fields[5];
+    rules.speed_step = fields[6];
+    rules.speed_interval = fields[7];
+    rules.min_speed = fields[8];
+
+    // 规则与规则文件的检查相同（穿墙只能是0或1），录像中的规则因此总能交给apply_ruleset
+    if (get_u32(header + 12) != REPLAY_HEADER_SIZE || width < 3 || height < 3 ||
+        (uint64_t)width * height > REPLAY_MAX_CELLS || header[40] > DEATH_BOARD_FULL ||
+        fields[4] < 0 || fields[4] > 1 || !ruleset_valid(&rules) ||
+        (rules.wrap && (width < TORUS_MIN_SIZE || height < TORUS_MIN_SIZE)))
+    {
+        return REPLAY_ERROR_FORMAT;
+    }
+    uint32_t ticks = get_u32(header + 32);
+    if (record_size(ticks) > file->size - *offset)
+    {
+        return REPLAY_ERROR_FORMAT;
+    }
+
+    info->width = (int)width;
+    info->height = (int)height;
+    info->seed = get_u64(header + 24);
+    info->ticks = ticks;
+    info->score = (int32_t)get_u32(header + 36);
+    info->death = (DeathCause)header[40];
+    info->rules = rules;
+    *moves = header + REPLAY_HEADER_SIZE;
+    *offset += record_size(ticks);
+    return REPLAY_OK;
+}
+
+/**
+ * @brief 按录像的开局参数开局（游戏区域尺寸不同时重新初始化上下文）
+ *
+ * 之后每帧把REPLAY_MOVE(moves, t)写入ctx->game.snake.next_direction再调用update_game，即可复现整局。
+ *
+ * @param ctx 已初始化的游戏上下文（尺寸任意）
+ * @param info 录像的开局参数
+ * @return false 内存不足（上下文已销毁，需要重新初始化后才能再使用）
+ */
+bool replay_prepare(GameContext *ctx, const ReplayInfo *info)
+{
+    int border = ctx->torus ? 0 : 2;
+    if (ctx->pool_width - border != info->width || ctx->pool_height - border != info->height)
+    {
+        destroy_game_context(ctx);
+        if (!init_game_context(ctx, info->width, info->height))
+        {
+            return false;
+        }
+    }
+    // 尺寸已检查过，穿墙规则不会被拒绝；布局改变时apply_ruleset已按ctx->seed（录像的种子）开局
+    bool restarted = ctx->pool != NULL && info->rules.wrap != ctx->torus;
+    ctx->seed = info->seed;
+    apply_ruleset(ctx, &info->rules);
+    if (!restarted)
+    {
+        init_game_state(ctx, info->seed);
+    }
+    return true;
+}
+
+/**
+ * @brief 录像读写结果 → 描述文字
+ */
+const char *replay_status_message(ReplayStatus status)
+{
+    switch (status)
+    {
+    case REPLAY_OK:
+        return "成功";
+    case REPLAY_END:
+        return "没有更多记录";
+    case REPLAY_ERROR_IO:
+        return "文件无法打开、读写或映射";
+    case REPLAY_ERROR_FORMAT:
+        return "不是录像文件或记录不合法";
+    case REPLAY_ERROR_VERSION:
+        return "不支持的录像格式版本";
+    case REPLAY_ERROR_MEMORY:
+        return "内存不足";
+    default:
+        return "未知错误";
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file snake_replay.h
+ * @brief 对局录像（种子 + 规则 + 每帧方向，按原样重新模拟即可复现整局）
+ *
+ * 引擎是确定性的：相同的游戏区域、规则和种子，每帧应用相同的方向，得到完全相同的一局。
+ * 录像因此只保存开局参数和每帧的方向（2位），一局上千帧也只有几百字节；
+ * 一个文件可以依次存放任意多局，读取时整个文件只读映射，逐局定位，不复制。
+ *
+ * 每局的记录布局（所有整数均为小端序，记录按REPLAY_RECORD_ALIGNMENT对齐，后一局紧接着前一局）：
+ *
+ *     偏移   大小    内容
+ *     0      8       魔数"SNAKERPL"
+ *     8      4       格式版本（REPLAY_VERSION）
+ *     12     4       记录头大小（REPLAY_HEADER_SIZE）
+ *     16     4       游戏区域宽度（不包括边框）
+ *     20     4       游戏区域高度
+ *     24     8       随机数种子（init_game_state的参数）
+ *     32     4       帧数n
+ *     36     4       录制结束时的得分
+ *     40     1       录制结束时的结束原因（DeathCause，录制在游戏结束前停止时为DEATH_NONE）
+ *     41     3       保留（0）
+ *     44     4×9     规则：食物得分、增长节数、食物个数、障碍物个数、穿墙（0或1）、
+ *                    初始速度、每次加速减少的毫秒数、加速间隔、最快速度（int32）
+ *     80     16      保留（0）
+ *     96     ⌈n/4⌉   每帧的方向：第t帧在第t/4字节的第2(t%4)～2(t%4)+1位
+ *     ..     ..      补零到REPLAY_RECORD_ALIGNMENT的整数倍
+ *
+ * 第t帧的方向是该帧update_game之前的snake.next_direction（即实际生效的方向），
+ * 重新模拟时直接写回next_direction，不经过turn_snake。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_REPLAY_H
+#define SNAKE_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define REPLAY_MAGIC "SNAKERPL"           ///< 记录魔数（8字节，不含'\0'）
+#define REPLAY_VERSION 1                  ///< 当前格式版本
+#define REPLAY_HEADER_SIZE 96             ///< 记录头大小（字节）
+#define REPLAY_RECORD_ALIGNMENT 8         ///< 记录对齐（字节）
+#define REPLAY_MAX_CELLS (1 << 24)        ///< 游戏区域单元格数上限（读取时拒绝更大的记录）
+#define REPLAY_INITIAL_CAPACITY 1024      ///< 录制缓冲区的初始容量（字节，4096帧）
+#define REPLAY_FILE_EXTENSION ".snakerpl" ///< 录像文件扩展名
+
+/**
+ * @brief 取得第tick帧的方向
+ */
+#define REPLAY_MOVE(moves, tick) ((Direction)(((moves)[(tick) >> 2] >> (((tick) & 3u) * 2u)) & 3u))
+
+/**
+ * @enum ReplayStatus
+ * @brief 录像读写结果
+ */
+typedef enum
+{
+    REPLAY_OK = 0,        ///< 成功
+    REPLAY_END,           ///< 已读完文件中的所有记录
+    REPLAY_ERROR_IO,      ///< 文件无法打开、读写或映射
+    REPLAY_ERROR_FORMAT,  ///< 不是录像文件，或记录头不合法、记录被截断
+    REPLAY_ERROR_VERSION, ///< 不支持的格式版本
+    REPLAY_ERROR_MEMORY   ///< 内存不足
+} ReplayStatus;
+
+/**
+ * @struct ReplayInfo
+ * @brief 一局录像的开局参数和录制结果
+ */
+typedef struct
+{
+    int width;        ///< 游戏区域宽度（不包括边框）
+    int height;       ///< 游戏区域高度
+    uint64_t seed;    ///< 随机数种子
+    Ruleset rules;    ///< 规则
+    uint32_t ticks;   ///< 帧数
+    int32_t score;    ///< 录制结束时的得分
+    DeathCause death; ///< 录制结束时的结束原因
+} ReplayInfo;
+
+/**
+ * @struct ReplayRecorder
+ * @brief 录制器：一次录制一局，写出后可以开始下一局（缓冲区复用）
+ */
+typedef struct
+{
+    ReplayInfo info;  ///< 开局参数（写出时补上得分和结束原因）
+    uint8_t *moves;   ///< 每帧的方向（按录像格式打包）
+    size_t capacity;  ///< moves的容量（字节）
+} ReplayRecorder;
+
+/**
+ * @struct ReplayFile
+ * @brief 只读映射的录像文件
+ */
+typedef struct
+{
+    const uint8_t *data; ///< 映射起始地址（空文件为NULL）
+    size_t size;         ///< 文件字节数
+    void *handle;        ///< 平台句柄（Windows的文件映射对象，其他平台不使用）
+} ReplayFile;
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+// 录制
+void replay_recorder_init(ReplayRecorder *recorder);
+void replay_recorder_destroy(ReplayRecorder *recorder);
+void replay_recorder_begin(ReplayRecorder *recorder, const GameContext *ctx, uint64_t seed);
+bool replay_recorder_tick(ReplayRecorder *recorder, const GameContext *ctx);
+ReplayStatus replay_recorder_write(ReplayRecorder *recorder, const GameContext *ctx, FILE *file);
+
+// 读取和重新模拟
+ReplayStatus replay_file_open(const char *path, ReplayFile *file);
+void replay_file_close(ReplayFile *file);
+ReplayStatus replay_file_next(const ReplayFile *file, size_t *offset, ReplayInfo *info, const uint8_t **moves);
+bool replay_prepare(GameContext *ctx, const ReplayInfo *info);
+const char *replay_status_message(ReplayStatus status);
+
+#endif // SNAKE_REPLAY_H
@@ -0,0 +1,229 @@
+/**
+ * @file snake_rules.c
+ * @brief 规则文件解析实现
+ *
+ * 编码: UTF-8
+ */
+
+#include "snake_rules.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================
+// 规则表
+// =============================================
+
+/**
+ * @struct RuleField
+ * @brief 数值型规则的键名、取值范围和在Ruleset中的位置
+ */
+typedef struct
+{
+    const char *key; ///< 键名
+    int min_value;   ///< 最小值
+    size_t offset;   ///< 在Ruleset中的偏移
+} RuleField;
+
+static const RuleField rule_fields[] = {
+    {"food_score", 0, offsetof(Ruleset, food_score)},
+    {"growth", 0, offsetof(Ruleset, growth)},
+    {"food_count", 1, offsetof(Ruleset, food_count)},
+    {"obstacles", 0, offsetof(Ruleset, obstacles)},
+    {"initial_speed", 1, offsetof(Ruleset, initial_speed)},
+    {"speed_step", 0, offsetof(Ruleset, speed_step)},
+    {"speed_interval", 0, offsetof(Ruleset, speed_interval)},
+    {"min_speed", 1, offsetof(Ruleset, min_speed)},
+};
+
+// =============================================
+// 解析辅助函数
+// =============================================
+
+/**
+ * @brief 去掉字符串首尾的空白（原地修改）
+ */
+static char *trim(char *text)
+{
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && isspace((unsigned char)text[length - 1]))
+    {
+        text[--length] = '\0';
+    }
+    return text;
+}
+
+/**
+ * @brief 解析布尔值（true/false、yes/no、1/0）
+ */
+static bool parse_bool(const char *value, bool *out)
+{
+    if (strcmp(value, "true") == 0 || strcmp(value, "yes") == 0 || strcmp(value, "1") == 0)
+    {
+        *out = true;
+        return true;
+    }
+    if (strcmp(value, "false") == 0 || strcmp(value, "no") == 0 || strcmp(value, "0") == 0)
+    {
+        *out = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 解析一行“键 = 值”
+ *
+ * @return bool 成功返回true；失败时把原因写入error
+ */
+static bool parse_line(char *line, Ruleset *rules, char *error, size_t error_size)
+{
+    char *comment = strchr(line, '#');
+    if (comment != NULL)
+    {
+        *comment = '\0';
+    }
+    line = trim(line);
+    if (*line == '\0')
+    {
+        return true;
+    }
+
+    char *equals = strchr(line, '=');
+    if (equals == NULL)
+    {
+        snprintf(error, error_size, "缺少'='");
+        return false;
+    }
+    *equals = '\0';
+    const char *key = trim(line);
+    const char *value = trim(equals + 1);
+
+    if (strcmp(key, "wrap") == 0)
+    {
+        if (!parse_bool(value, &rules->wrap))
+        {
+            snprintf(error, error_size, "wrap的取值应为true或false: %s", value);
+            return false;
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < sizeof(rule_fields) / sizeof(rule_fields[0]); i++)
+    {
+        if (strcmp(key, rule_fields[i].key) != 0)
+        {
+            continue;
+        }
+        char *end;
+        long number = strtol(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || number < rule_fields[i].min_value || number > RULES_MAX_VALUE)
+        {
+            snprintf(error, error_size, "%s的取值应为%d～%d的整数: %s",
+                     key, rule_fields[i].min_value, RULES_MAX_VALUE, value);
+            return false;
+        }
+        *(int *)((char *)rules + rule_fields[i].offset) = (int)number;
+        return true;
+    }
+
+    snprintf(error, error_size, "未知的规则: %s", key);
+    return false;
+}
+
+// =============================================
+// 规则文件加载
+// =============================================
+
+/**
+ * @brief 检查规则是否是规则文件可以表示的规则
+ *
+ * 各数值在最小值～RULES_MAX_VALUE之间，最快速度不大于初始速度。
+ * 存档和录像文件头中的规则也用它检查，加载文件得到的规则与规则文件接受的规则完全相同。
+ *
+ * @param rules 规则
+ * @return bool 合法返回true
+ */
+bool ruleset_valid(const Ruleset *rules)
+{
+    for (size_t i = 0; i < sizeof(rule_fields) / sizeof(rule_fields[0]); i++)
+    {
+        int value = *(const int *)((const char *)rules + rule_fields[i].offset);
+        if (value < rule_fields[i].min_value || value > RULES_MAX_VALUE)
+        {
+            return false;
+        }
+    }
+    return rules->min_speed <= rules->initial_speed;
+}
+
+/**
+ * @brief 从规则文件加载规则
+ *
+ * 从默认规则开始，逐行覆盖文件中出现的键。任何一行有误都不修改rules。
+ *
+ * @param path 规则文件路径
+ * @param rules 输出：解析后的规则
+ * @param error 输出：失败原因（包括行号），可以为NULL
+ * @param error_size error缓冲区大小
+ * @return bool 成功返回true
+ */
+bool load_ruleset(const char *path, Ruleset *rules, char *error, size_t error_size)
+{
+    char scratch[1];
+    if (error == NULL)
+    {
+        error = scratch;
+        error_size = sizeof(scratch);
+    }
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        snprintf(error, error_size, "无法打开规则文件: %s", path);
+        return false;
+    }
+
+    Ruleset parsed;
+    default_ruleset(&parsed);
+
+    char line[RULES_MAX_LINE];
+    char reason[RULES_MAX_LINE];
+    bool ok = true;
+    for (int line_number = 1; ok && fgets(line, sizeof(line), file) != NULL; line_number++)
+    {
+        if (strchr(line, '\n') == NULL && !feof(file))
+        {
+            snprintf(error, error_size, "%s:%d: 行太长", path, line_number);
+            ok = false;
+        }
+        else if (!parse_line(line, &parsed, reason, sizeof(reason)))
+        {
+            snprintf(error, error_size, "%s:%d: %s", path, line_number, reason);
+            ok = false;
+        }
+    }
+    if (ok && ferror(file))
+    {
+        snprintf(error, error_size, "读取规则文件失败: %s", path);
+        ok = false;
+    }
+    fclose(file);
+
+    if (ok && !ruleset_valid(&parsed)) // 各行已检查取值范围，剩下的只有速度曲线
+    {
+        snprintf(error, error_size, "%s: min_speed不能大于initial_speed", path);
+        ok = false;
+    }
+    if (ok)
+    {
+        *rules = parsed;
+    }
+    return ok;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file snake_rules.h
+ * @brief 规则文件解析
+ *
+ * 规则文件是UTF-8文本，每行一个“键 = 值”，#之后为注释，没有出现的键保持默认规则：
+ *
+ *     # 穿墙、每个食物长3节、同时3个食物
+ *     wrap = true
+ *     growth = 3
+ *     food_count = 3
+ *     obstacles = 20
+ *     food_score = 10
+ *     initial_speed = 150
+ *     speed_step = 10
+ *     speed_interval = 50
+ *     min_speed = 30
+ *
+ * 解析结果交给apply_ruleset编译成单步函数，游戏循环中不再读取规则文件的任何内容。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_RULES_H
+#define SNAKE_RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define RULES_MAX_LINE 256     ///< 规则文件每行的最大长度（字节）
+#define RULES_MAX_VALUE 100000 ///< 数值型规则的上限
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+bool load_ruleset(const char *path, Ruleset *rules, char *error, size_t error_size);
+bool ruleset_valid(const Ruleset *rules);
+
+#endif // SNAKE_RULES_H
@@ -0,0 +1,664 @@
+/**
+ * @file snake_save.c
+ * @brief 游戏存档实现
+ *
+ * 保存：文件头按小端序逐字段编码，游戏池按int32小端序写在页对齐的偏移处。
+ * 加载：整个文件以写时复制方式映射（Windows为MapViewOfFile，其他平台为mmap），
+ * 小端序平台上ctx->pool直接指向映射中的游戏池；大端序平台退回逐单元格转换到单局内存区域。
+ *
+ * 编码: UTF-8
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "snake_save.h"
+#include "snake_rules.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 游戏池按int32存储，要求CellType与int32大小一致
+_Static_assert(sizeof(CellType) == sizeof(int32_t), "CellType must be 32-bit");
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define SAVE_MAGIC_LENGTH 8              ///< 魔数长度
+#define SAVE_RULE_FIELDS 9               ///< 文件头中规则的字段数
+#define FNV32_OFFSET 0x811C9DC5u         ///< FNV-1a 32位初始值
+#define FNV32_PRIME 0x01000193u          ///< FNV-1a 32位乘数
+#define FNV64_OFFSET 0xCBF29CE484222325u ///< FNV-1a 64位初始值
+#define FNV64_PRIME 0x00000100000001B3u  ///< FNV-1a 64位乘数
+#define SAVE_WRITE_CHUNK 4096            ///< 大端序平台转换写出时每批的单元格数
+
+// =============================================
+// 辅助函数
+// =============================================
+
+/**
+ * @brief 当前平台是否为小端序
+ */
+static bool host_is_little_endian(void)
+{
+    const uint32_t probe = 1;
+    unsigned char first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+/**
+ * @brief FNV-1a 32位散列（文件头校验和）
+ */
+static uint32_t fnv1a32(const unsigned char *bytes, size_t length)
+{
+    uint32_t hash = FNV32_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 游戏池校验和：FNV-1a 64位，每次吸收一个单元格的32位取值
+ *
+ * 按取值而不是按字节计算，结果与平台字节序无关。
+ */
+static uint64_t pool_checksum(const CellType *pool, size_t cell_count)
+{
+    uint64_t hash = FNV64_OFFSET;
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        hash = (hash ^ (uint32_t)pool[i]) * FNV64_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 单元格取值是否合法
+ */
+static bool is_valid_cell(CellType cell)
+{
+    switch (cell)
+    {
+    case CELL_EMPTY:
+    case CELL_FOOD:
+    case CELL_SNAKE_HEAD:
+    case CELL_SNAKE_BODY_UP:
+    case CELL_SNAKE_BODY_DOWN:
+    case CELL_SNAKE_BODY_LEFT:
+    case CELL_SNAKE_BODY_RIGHT:
+    case CELL_SNAKE_TAIL:
+    case CELL_WALL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 位置是否在游戏区域内（有边框的布局不包括边框，环面布局为整个游戏池）
+ *
+ * 单步函数读写蛇头、蛇尾的相邻单元格时不做边界检查，两者都必须在游戏区域内。
+ */
+static bool in_game_area(Position pos, int width, int height, bool torus)
+{
+    int border = torus ? 0 : 1;
+    return pos.x >= border && pos.x < width - border && pos.y >= border && pos.y < height - border;
+}
+
+/**
+ * @brief 读取存档游戏池中的一个单元格（按小端序解码，不要求游戏池已装入上下文）
+ */
+static CellType saved_cell(const unsigned char *pool_bytes, int width, Position pos)
+{
+    size_t index = (size_t)pos.y * (size_t)width + (size_t)pos.x;
+    return (CellType)(int32_t)get_u32(pool_bytes + index * sizeof(int32_t));
+}
+
+// =============================================
+// 文件头编码和解析
+// =============================================
+
+/**
+ * @brief 编码文件头
+ */
+static void encode_header(const GameContext *ctx, uint64_t checksum, unsigned char header[SAVE_HEADER_SIZE])
+{
+    const GameState *game = &ctx->game;
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    const int32_t fields[10] = {
+        game->score, game->speed, game->highest_score, game->snake.length,
+        game->snake.head.x, game->snake.head.y, game->snake.tail.x, game->snake.tail.y,
+        game->food.x, game->food.y};
+
+    memset(header, 0, SAVE_HEADER_SIZE);
+    memcpy(header, SAVE_MAGIC, SAVE_MAGIC_LENGTH);
+    put_u32(header + 8, SAVE_VERSION);
+    put_u32(header + 12, SAVE_HEADER_SIZE);
+    put_u32(header + 16, (uint32_t)ctx->pool_width);
+    put_u32(header + 20, (uint32_t)ctx->pool_height);
+    put_u64(header + 24, SAVE_POOL_ALIGNMENT);
+    put_u64(header + 32, (uint64_t)cell_count * sizeof(int32_t));
+    put_u64(header + 40, checksum);
+    put_u64(header + 48, ctx->rng);
+    for (int i = 0; i < 10; i++)
+    {
+        put_u32(header + 56 + i * 4, (uint32_t)fields[i]);
+    }
+    header[96] = (unsigned char)game->snake.direction;
+    header[97] = (unsigned char)game->snake.next_direction;
+    header[98] = (unsigned char)game->snake.tail_direction;
+    header[99] = (unsigned char)((game->game_over ? 1 : 0) | (game->paused ? 2 : 0) | (ctx->torus ? 4 : 0));
+    put_u32(header + 100, (uint32_t)game->snake.pending_growth);
+    header[104] = (unsigned char)game->death;
+    const Ruleset *rules = &ctx->rules;
+    const int32_t rule_fields[SAVE_RULE_FIELDS] = {
+        rules->food_score, rules->growth, rules->food_count, rules->obstacles, rules->wrap ? 1 : 0,
+        rules->initial_speed, rules->speed_step, rules->speed_interval, rules->min_speed};
+    for (int i = 0; i < SAVE_RULE_FIELDS; i++)
+    {
+        put_u32(header + 108 + i * 4, (uint32_t)rule_fields[i]);
+    }
+    put_u32(header + SAVE_HEADER_SIZE - 4, fnv1a32(header, SAVE_HEADER_SIZE - 4));
+}
+
+/**
+ * @brief 解析并检查文件头
+ *
+ * 只检查文件头本身（魔数、版本、校验和以及各字段的取值范围），不访问游戏池数据。
+ * 旧格式（SAVE_LEGACY_VERSION）的文件头按当时的布局解析，规则为默认规则。
+ */
+static SaveStatus decode_header(const unsigned char header[SAVE_HEADER_SIZE], SaveHeader *out)
+{
+    if (memcmp(header, SAVE_MAGIC, SAVE_MAGIC_LENGTH) != 0)
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+    out->version = get_u32(header + 8);
+    if (out->version != SAVE_VERSION && out->version != SAVE_LEGACY_VERSION)
+    {
+        return SAVE_ERROR_VERSION;
+    }
+    bool legacy = out->version == SAVE_LEGACY_VERSION;
+    uint32_t header_size = legacy ? SAVE_LEGACY_HEADER_SIZE : SAVE_HEADER_SIZE;
+    if (get_u32(header + 12) != header_size ||
+        get_u32(header + header_size - 4) != fnv1a32(header, header_size - 4))
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+
+    uint32_t width = get_u32(header + 16);
+    uint32_t height = get_u32(header + 20);
+    out->pool_offset = get_u64(header + 24);
+    out->pool_bytes = get_u64(header + 32);
+    out->pool_checksum = get_u64(header + 40);
+    out->rng = get_u64(header + 48);
+    if (width < 3 || height < 3 || width > INT32_MAX / height ||
+        out->pool_bytes != (uint64_t)width * height * sizeof(int32_t) ||
+        out->pool_offset < SAVE_HEADER_SIZE || out->pool_offset % SAVE_POOL_ALIGNMENT != 0)
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+    out->pool_width = (int)width;
+    out->pool_height = (int)height;
+
+    int32_t fields[10];
+    for (int i = 0; i < 10; i++)
+    {
+        fields[i] = (int32_t)get_u32(header + 56 + i * 4);
+    }
+    GameState *game = &out->game;
+    game->score = fields[0];
+    game->speed = fields[1];
+    game->highest_score = fields[2];
+    game->snake.length = fields[3];
+    game->snake.head = (Position){fields[4], fields[5]};
+    game->snake.tail = (Position){fields[6], fields[7]};
+    game->food = (Position){fields[8], fields[9]};
+    // 旧格式没有环面布局，标志位只有bit0～1
+    unsigned char flag_mask = legacy ? 3 : 7;
+    if (header[96] > DIR_RIGHT || header[97] > DIR_RIGHT || header[98] > DIR_RIGHT || (header[99] & ~flag_mask) != 0 ||
+        (!legacy && header[104] > DEATH_BOARD_FULL))
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+    game->snake.direction = (Direction)header[96];
+    game->snake.next_direction = (Direction)header[97];
+    game->snake.tail_direction = (Direction)header[98];
+    game->game_over = (header[99] & 1) != 0;
+    game->paused = (header[99] & 2) != 0;
+    game->death = legacy ? DEATH_NONE : (DeathCause)header[104]; // 旧格式的偏移104是保留字节
+    out->torus = (header[99] & 4) != 0;
+    game->snake.pending_growth = legacy ? 0 : (int32_t)get_u32(header + 100);
+
+    // 规则的检查与规则文件相同（穿墙必须与布局一致），保证加载后的规则同样可以交给apply_ruleset
+    default_ruleset(&out->rules);
+    if (!legacy)
+    {
+        int32_t rules[SAVE_RULE_FIELDS];
+        for (int i = 0; i < SAVE_RULE_FIELDS; i++)
+        {
+            rules[i] = (int32_t)get_u32(header + 108 + i * 4);
+        }
+        out->rules.food_score = rules[0];
+        out->rules.growth = rules[1];
+        out->rules.food_count = rules[2];
+        out->rules.obstacles = rules[3];
+        out->rules.wrap = rules[4] != 0;
+        out->rules.initial_speed = rules[5];
+        out->rules.speed_step = rules[6];
+        out->rules.speed_interval = rules[7];
+        out->rules.min_speed = rules[8];
+        if (rules[4] != (out->torus ? 1 : 0) || !ruleset_valid(&out->rules))
+        {
+            return SAVE_ERROR_FORMAT;
+        }
+    }
+
+    if (game->snake.length < 1 || game->speed < 0 || game->snake.pending_growth < 0 ||
+        !in_game_area(game->snake.head, out->pool_width, out->pool_height, out->torus) ||
+        !in_game_area(game->snake.tail, out->pool_width, out->pool_height, out->torus) ||
+        !in_game_area(game->food, out->pool_width, out->pool_height, out->torus))
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+    return SAVE_OK;
+}
+
+// =============================================
+// 文件映射（平台相关）
+// =============================================
+
+/**
+ * @brief 以写时复制方式映射整个文件
+ */
+static SaveStatus map_file(const char *path, SaveMapping *mapping)
+{
+    memset(mapping, 0, sizeof(*mapping));
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return SAVE_ERROR_IO;
+    }
+    LARGE_INTEGER size;
+    HANDLE object = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= SAVE_HEADER_SIZE && (uint64_t)size.QuadPart <= SIZE_MAX)
+    {
+        object = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    }
+    CloseHandle(file); // 文件映射对象持有文件的引用
+    if (object == NULL)
+    {
+        return SAVE_ERROR_IO;
+    }
+    void *view = MapViewOfFile(object, FILE_MAP_COPY, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(object);
+        return SAVE_ERROR_IO;
+    }
+    mapping->view = view;
+    mapping->size = (size_t)size.QuadPart;
+    mapping->handle = object;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return SAVE_ERROR_IO;
+    }
+    struct stat st;
+    void *view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= SAVE_HEADER_SIZE && (uint64_t)st.st_size <= SIZE_MAX)
+    {
+        view = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd); // 映射持有文件的引用
+    if (view == MAP_FAILED)
+    {
+        return SAVE_ERROR_IO;
+    }
+    mapping->view = view;
+    mapping->size = (size_t)st.st_size;
+#endif
+    return SAVE_OK;
+}
+
+/**
+ * @brief 用新文件替换存档文件
+ *
+ * POSIX上rename即使目标文件正被映射也能成功（旧映射继续引用原来的文件）；
+ * Windows上目标文件正被映射时替换失败，原存档保持不变。
+ */
+static bool replace_file(const char *from, const char *to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+/**
+ * @brief 解除文件映射
+ */
+static void unmap_file(SaveMapping *mapping)
+{
+    if (mapping->view == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping->view);
+    CloseHandle((HANDLE)mapping->handle);
+#else
+    munmap(mapping->view, mapping->size);
+#endif
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+// =============================================
+// 保存和加载
+// =============================================
+
+/**
+ * @brief 保存游戏
+ *
+ * 写出文件头、补齐到页边界，再写出游戏池。小端序平台上游戏池一次写出，不做转换。
+ * 先写入"<path>.tmp"再替换原文件：不会截断正被映射为游戏池的存档（截断会使映射失效），
+ * 写入中途失败时原存档也保持完整。
+ *
+ * @param ctx 游戏上下文
+ * @param path 存档文件路径（已存在时覆盖）
+ * @return SaveStatus 结果
+ */
+SaveStatus save_game(const GameContext *ctx, const char *path)
+{
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    unsigned char header[SAVE_HEADER_SIZE];
+    encode_header(ctx, pool_checksum(ctx->pool, cell_count), header);
+
+    char temp_path[FILENAME_MAX];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path))
+    {
+        return SAVE_ERROR_IO;
+    }
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL)
+    {
+        return SAVE_ERROR_IO;
+    }
+
+    static const unsigned char padding[SAVE_POOL_ALIGNMENT - SAVE_HEADER_SIZE] = {0};
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+              fwrite(padding, 1, sizeof(padding), file) == sizeof(padding);
+
+    if (ok && host_is_little_endian())
+    {
+        ok = fwrite(ctx->pool, sizeof(int32_t), cell_count, file) == cell_count;
+    }
+    else
+    {
+        unsigned char chunk[SAVE_WRITE_CHUNK * sizeof(int32_t)];
+        for (size_t begin = 0; ok && begin < cell_count; begin += SAVE_WRITE_CHUNK)
+        {
+            size_t count = cell_count - begin < SAVE_WRITE_CHUNK ? cell_count - begin : SAVE_WRITE_CHUNK;
+            for (size_t i = 0; i < count; i++)
+            {
+                put_u32(chunk + i * sizeof(int32_t), (uint32_t)ctx->pool[begin + i]);
+            }
+            ok = fwrite(chunk, sizeof(int32_t), count, file) == count;
+        }
+    }
+
+    if (fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (ok && !replace_file(temp_path, path))
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        remove(temp_path);
+    }
+    return ok ? SAVE_OK : SAVE_ERROR_IO;
+}
+
+/**
+ * @brief 只读取并检查存档文件头
+ *
+ * 用于在加载前得知游戏池尺寸，以便按尺寸创建游戏上下文。
+ *
+ * @param path 存档文件路径
+ * @param header 输出：文件头
+ * @return SaveStatus 结果
+ */
+SaveStatus read_save_header(const char *path, SaveHeader *header)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return SAVE_ERROR_IO;
+    }
+    unsigned char bytes[SAVE_HEADER_SIZE];
+    size_t read = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    if (read != sizeof(bytes))
+    {
+        return SAVE_ERROR_FORMAT;
+    }
+    return decode_header(bytes, header);
+}
+
+/**
+ * @brief 加载游戏
+ *
+ * 映射存档文件并检查文件头，然后把游戏状态和游戏池装入游戏上下文。
+ * 小端序平台上游戏池不复制：ctx->pool直接指向写时复制的映射，修改只产生私有页面，
+ * 映射在下一次init_game_state、load_game或destroy_game_context时释放。
+ * 不论是否带SAVE_VERIFY_POOL，都检查蛇头、蛇尾和食物在游戏区域内，且这几个单元格以及蛇尾前方一节的取值与游戏状态一致（O(1)），
+ * 有边框的布局下还检查四周的边框（O(宽+高)），单步函数不做边界检查所依赖的前提因此总是成立。
+ * 不带SAVE_VERIFY_POOL时不读取整个游戏池：其余单元格（蛇身的方向编码、障碍物等）按存档原样信任，
+ * 只应加载自己保存的存档；来源不可信的存档必须带SAVE_VERIFY_POOL加载。
+ * 存档中的规则（旧格式为默认规则）随游戏状态一起恢复，取代游戏上下文原有的规则。
+ *
+ * @param ctx 游戏上下文（游戏池尺寸必须与存档一致）
+ * @param path 存档文件路径
+ * @param flags 加载标志（SAVE_VERIFY_POOL）
+ * @return SaveStatus 结果，失败时游戏上下文保持不变
+ */
+SaveStatus load_game(GameContext *ctx, const char *path, unsigned int flags)
+{
+    SaveMapping mapping;
+    SaveStatus status = map_file(path, &mapping);
+    if (status != SAVE_OK)
+    {
+        return status;
+    }
+
+    SaveHeader header;
+    const unsigned char *bytes = (const unsigned char *)mapping.view;
+    status = decode_header(bytes, &header);
+    if (status == SAVE_OK &&
+        (header.pool_width != ctx->pool_width || header.pool_height != ctx->pool_height || header.torus != ctx->torus ||
+         header.pool_offset > mapping.size || header.pool_bytes > mapping.size - header.pool_offset))
+    {
+        status = SAVE_ERROR_SIZE;
+    }
+    if (status != SAVE_OK)
+    {
+        unmap_file(&mapping);
+        return status;
+    }
+
+    // 取得游戏池：小端序平台直接使用映射，否则转换到单局内存区域
+    bool in_place = host_is_little_endian();
+    const unsigned char *pool_bytes = bytes + header.pool_offset;
+    size_t cell_count = (size_t)ctx->pool_width * (size_t)ctx->pool_height;
+    CellType *pool = (CellType *)mapping.view; // 仅用于下面的检查，in_place时才是最终的游戏池
+    if (in_place)
+    {
+        pool = (CellType *)(void *)((unsigned char *)mapping.view + header.pool_offset);
+    }
+
+    // 有边框的布局下游戏池四周必须是墙壁（可达区域等代码依赖这一点省去越界检查）
+    int w = ctx->pool_width, h = ctx->pool_height;
+    for (int i = 0; i < (ctx->torus ? 0 : w * 2 + h * 2) && status == SAVE_OK; i++)
+    {
+        int index = i < w ? i : i < w * 2 ? (h - 1) * w + (i - w) : i < w * 2 + h ? (i - w * 2) * w : (i - w * 2 - h) * w + w - 1;
+        CellType cell = (CellType)(int32_t)get_u32(pool_bytes + (size_t)index * sizeof(int32_t));
+        if (cell != CELL_WALL)
+        {
+            status = SAVE_ERROR_FORMAT;
+        }
+    }
+
+    // 蛇头、蛇尾、蛇尾前方的一节（蛇身或蛇头）和食物（游戏结束时可能已被吃掉）必须与游戏状态一致
+    static const int dx[] = {0, 0, -1, 1};
+    static const int dy[] = {-1, 1, 0, 0};
+    const Snake *snake = &header.game.snake;
+    Position next = {snake->tail.x + dx[snake->tail_direction], snake->tail.y + dy[snake->tail_direction]};
+    if (ctx->torus)
+    {
+        next = (Position){(next.x + w) % w, (next.y + h) % h};
+    }
+    CellType next_cell = saved_cell(pool_bytes, w, next);
+    if (status == SAVE_OK &&
+        (saved_cell(pool_bytes, w, snake->head) != CELL_SNAKE_HEAD ||
+         saved_cell(pool_bytes, w, snake->tail) != CELL_SNAKE_TAIL ||
+         (next_cell != CELL_SNAKE_HEAD && (next_cell < CELL_SNAKE_BODY_UP || next_cell > CELL_SNAKE_BODY_RIGHT)) ||
+         (!header.game.game_over && saved_cell(pool_bytes, w, header.game.food) != CELL_FOOD)))
+    {
+        status = SAVE_ERROR_FORMAT;
+    }
+
+    if (status == SAVE_OK && (flags & SAVE_VERIFY_POOL))
+    {
+        uint64_t hash = FNV64_OFFSET;
+        for (size_t i = 0; i < cell_count && status == SAVE_OK; i++)
+        {
+            uint32_t value = get_u32(pool_bytes + i * sizeof(int32_t));
+            hash = (hash ^ value) * FNV64_PRIME;
+            if (!is_valid_cell((CellType)(int32_t)value))
+            {
+                status = SAVE_ERROR_FORMAT;
+            }
+        }
+        if (status == SAVE_OK && hash != header.pool_checksum)
+        {
+            status = SAVE_ERROR_CHECKSUM;
+        }
+    }
+    if (status != SAVE_OK)
+    {
+        unmap_file(&mapping);
+        return status;
+    }
+
+    // 装入游戏上下文（释放上一局的单局内存和存档映射）
+    reset_game_arena(ctx, !in_place);
+    if (in_place)
+    {
+        ctx->pool = pool;
+        ctx->save = mapping;
+    }
+    else
+    {
+        for (size_t i = 0; i < cell_count; i++)
+        {
+            ctx->pool[i] = (CellType)(int32_t)get_u32(pool_bytes + i * sizeof(int32_t));
+        }
+        unmap_file(&mapping);
+    }
+    memset(ctx->dirty, true, cell_count * sizeof(bool)); // 整个游戏池需要重新绘制
+    ctx->game = header.game;
+    ctx->rng = header.rng;
+    apply_ruleset(ctx, &header.rules); // 穿墙与布局一致，不会重新开局
+    return SAVE_OK;
+}
+
+/**
+ * @brief 释放游戏池所在的存档映射
+ *
+ * 由reset_game_arena和destroy_game_context调用；游戏池指向映射时一并清空。
+ *
+ * @param ctx 游戏上下文
+ */
+void release_saved_game(GameContext *ctx)
+{
+    if (ctx->save.view == NULL)
+    {
+        return;
+    }
+    unsigned char *begin = (unsigned char *)ctx->save.view;
+    unsigned char *pool = (unsigned char *)ctx->pool;
+    if (pool >= begin && pool < begin + ctx->save.size)
+    {
+        ctx->pool = NULL;
+    }
+    unmap_file(&ctx->save);
+}
+
+/**
+ * @brief 取得结果的说明文字
+ */
+const char *save_status_message(SaveStatus status)
+{
+    switch (status)
+    {
+    case SAVE_OK:
+        return "成功";
+    case SAVE_ERROR_IO:
+        return "无法读写文件";
+    case SAVE_ERROR_FORMAT:
+        return "不是有效的存档文件";
+    case SAVE_ERROR_VERSION:
+        return "不支持的存档版本";
+    case SAVE_ERROR_SIZE:
+        return "游戏区域尺寸或布局不一致，或文件不完整";
+    case SAVE_ERROR_CHECKSUM:
+        return "存档校验和不一致";
+    case SAVE_ERROR_MEMORY:
+        return "内存不足";
+    }
+    return "未知错误";
+}
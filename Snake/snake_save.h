@@ -0,0 +1,102 @@
+/**
+ * @file snake_save.h
+ * @brief 游戏存档（二进制格式，支持内存映射加载）
+ *
+ * 存档文件布局（所有整数均为小端序）：
+ *
+ *     偏移   大小  内容
+ *     0      8     魔数"SNAKESAV"
+ *     8      4     格式版本（SAVE_VERSION）
+ *     12     4     文件头大小（SAVE_HEADER_SIZE）
+ *     16     4     游戏池宽度（包括边框，环面布局没有边框）
+ *     20     4     游戏池高度（包括边框，环面布局没有边框）
+ *     24     8     游戏池数据偏移（SAVE_POOL_ALIGNMENT的整数倍）
+ *     32     8     游戏池数据字节数（宽 × 高 × 4）
+ *     40     8     游戏池校验和（FNV-1a 64位，按32位字计算）
+ *     48     8     随机数生成器状态
+ *     56     4×10  得分、速度、最高分、蛇长、蛇头x/y、蛇尾x/y、食物x/y（int32）
+ *     96     1×4   方向、下一个方向、蛇尾方向、标志位（bit0游戏结束，bit1暂停，bit2环面布局）
+ *     100    4     蛇待长出的节数（int32，默认规则下总是0）
+ *     104    1     结束原因（DeathCause）
+ *     105    3     保留（0）
+ *     108    4×9   规则：食物得分、增长节数、食物个数、障碍物个数、穿墙（0或1，与bit2一致）、
+ *                  初始速度、每次加速减少的毫秒数、加速间隔、最快速度（int32，与录像格式的顺序相同）
+ *     144    108   保留（0）
+ *     252    4     文件头校验和（FNV-1a 32位，覆盖偏移0～251）
+ *
+ * 加载时存档的规则随游戏一起恢复，覆盖上下文当前的规则（布局必须已经一致），
+ * 因此按自定义规则保存的一局不会在加载后悄悄换成别的增长节数或速度曲线。
+ *
+ * 版本1（SAVE_LEGACY_VERSION）的文件头只有128字节，校验和在偏移124；
+ * 当时只有默认规则，加载时按默认规则恢复，蛇待长出的节数为0，结束原因为DEATH_NONE（偏移100～123是保留字节，不读取）；
+ * 标志位只有bit0～1，带bit2（环面布局）的旧版本存档视为格式错误。
+ * 游戏池数据从页对齐的偏移开始，每个单元格是一个int32（即CellType的取值）。
+ * 小端序平台上整块游戏池可以按写时复制方式映射后直接作为ctx->pool使用，
+ * 加载4096x4096的游戏或成千上万个预制局面都不需要逐单元格解析。
+ *
+ * 编码: UTF-8
+ */
+
+#ifndef SNAKE_SAVE_H
+#define SNAKE_SAVE_H
+
+#include <stdint.h>
+
+#include "snake_core.h"
+
+// =============================================
+// 常量定义
+// =============================================
+
+#define SAVE_MAGIC "SNAKESAV"        ///< 文件魔数（8字节，不含'\0'）
+#define SAVE_VERSION 2               ///< 当前格式版本
+#define SAVE_HEADER_SIZE 256         ///< 文件头大小（字节）
+#define SAVE_LEGACY_VERSION 1        ///< 仍可加载的旧格式版本（默认规则，没有环面布局）
+#define SAVE_LEGACY_HEADER_SIZE 128  ///< 旧格式的文件头大小（字节）
+#define SAVE_POOL_ALIGNMENT 4096     ///< 游戏池数据的对齐（页大小），保证映射后可以直接访问
+#define SAVE_VERIFY_POOL 0x1         ///< 加载标志：校验游戏池校验和并检查每个单元格的取值（需要读取整个游戏池）
+
+/**
+ * @enum SaveStatus
+ * @brief 存档读写结果
+ */
+typedef enum
+{
+    SAVE_OK = 0,         ///< 成功
+    SAVE_ERROR_IO,       ///< 文件无法打开、读写或映射
+    SAVE_ERROR_FORMAT,   ///< 不是存档文件，或文件头校验失败、内容不合法
+    SAVE_ERROR_VERSION,  ///< 不支持的格式版本
+    SAVE_ERROR_SIZE,     ///< 游戏池尺寸或布局与游戏上下文不一致，或文件被截断
+    SAVE_ERROR_CHECKSUM, ///< 游戏池校验和不一致
+    SAVE_ERROR_MEMORY    ///< 内存不足
+} SaveStatus;
+
+/**
+ * @struct SaveHeader
+ * @brief 解析后的存档文件头
+ */
+typedef struct
+{
+    uint32_t version;       ///< 格式版本
+    int pool_width;         ///< 游戏池宽度（包括边框，环面布局没有边框）
+    int pool_height;        ///< 游戏池高度（包括边框，环面布局没有边框）
+    bool torus;             ///< 环面布局（穿墙规则）
+    uint64_t pool_offset;   ///< 游戏池数据偏移
+    uint64_t pool_bytes;    ///< 游戏池数据字节数
+    uint64_t pool_checksum; ///< 游戏池校验和
+    uint64_t rng;           ///< 随机数生成器状态
+    GameState game;         ///< 游戏状态
+    Ruleset rules;          ///< 保存时的游戏规则（旧格式为默认规则）
+} SaveHeader;
+
+// =============================================
+// 函数原型声明
+// =============================================
+
+SaveStatus save_game(const GameContext *ctx, const char *path);
+SaveStatus read_save_header(const char *path, SaveHeader *header);
+SaveStatus load_game(GameContext *ctx, const char *path, unsigned int flags);
+void release_saved_game(GameContext *ctx);
+const char *save_status_message(SaveStatus status);
+
+#endif // SNAKE_SAVE_H